@@ -0,0 +1,223 @@
+#include "station/admission.hpp"
+#include "station/station_types.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <memory>
+
+/**
+ * 启动准入并发测试
+ *
+ * 多个线程模拟批量启动（如全网远程启动活动）：随机挑选连接器与启动方式发起准入，
+ * 每个线程最多持有若干活动会话，超出或被拒绝时停止最早的会话，使站点始终在限额附近竞争。
+ * 对比原实现（全局锁 + switch判断 + 锁内计数）与表驱动引擎（单次CAS + 原子站点预算），
+ * 并独立统计并发会话数/功率的峰值，校验从未突破站点限额。
+ */
+
+namespace {
+
+const size_t kConnectors = 2000;
+const uint32_t kMaxSessions = 400;
+const double kPowerBudgetKw = 2500;
+const size_t kHeldPerThread = 64;
+
+struct Xorshift {
+    uint64_t state;
+    explicit Xorshift(uint64_t seed) : state(seed * 0x9e3779b97f4a7c15ULL + 1) {}
+    uint64_t next() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+};
+
+uint32_t rated_w(size_t connector) {
+    return connector % 4 == 0 ? 22000 : 7000;
+}
+
+// 独立的峰值统计（准入成功后加、释放前减，观测值不会高于实际占用）
+struct Watermark {
+    std::atomic<int64_t> sessions{0};
+    std::atomic<int64_t> power_w{0};
+    std::atomic<int64_t> max_sessions{0};
+    std::atomic<int64_t> max_power_w{0};
+
+    void add(uint32_t w) {
+        update(max_sessions, sessions.fetch_add(1) + 1);
+        update(max_power_w, power_w.fetch_add(w) + w);
+    }
+    void remove(uint32_t w) {
+        sessions.fetch_sub(1);
+        power_w.fetch_sub(w);
+    }
+    static void update(std::atomic<int64_t>& max, int64_t value) {
+        int64_t current = max.load();
+        while (value > current && !max.compare_exchange_weak(current, value)) {
+        }
+    }
+};
+
+// 原实现：全局设备锁内按启动方式逐项检查状态位
+class LegacyAdmission {
+public:
+    explicit LegacyAdmission(size_t connectors) : status_(connectors, 0), sessions_(0), power_w_(0) {}
+
+    void set_status(size_t connector, int pos) { status_[connector] |= 1ULL << pos; }
+
+    bool admit(size_t connector, int type, uint32_t w) {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        uint64_t status = status_[connector];
+        if (status & (1ULL << DEVICE_STATUS_FORRBIDDEN)) return false;
+        if (status & (1ULL << DEVICE_STATUS_BUSY)) return false;
+        switch (type) {
+            case START_TYPE_REMOTE:
+                if (status & (1ULL << DEVICE_STATUS_FORRBIDDEN_REMOTE)) return false;
+                break;
+            case START_TYPE_COMMERCIAL:
+                if (status & (1ULL << DEVICE_STATUS_FORRBIDDEN_COMMERCIAL)) return false;
+                if (status & (1ULL << DEVICE_STATUS_ERROR_CONFIG)) return false;
+                break;
+            default:
+                break;
+        }
+        if (sessions_ + 1 > kMaxSessions) return false;
+        if (power_w_ + w > kPowerBudgetKw * 1000) return false;
+        sessions_++;
+        power_w_ += w;
+        status_[connector] |= 1ULL << DEVICE_STATUS_BUSY;
+        return true;
+    }
+
+    void stop(size_t connector, uint32_t w) {
+        std::lock_guard<std::mutex> lock(device_mutex_);
+        sessions_--;
+        power_w_ -= w;
+        status_[connector] &= ~(1ULL << DEVICE_STATUS_BUSY);
+    }
+
+private:
+    std::mutex device_mutex_;
+    std::vector<uint64_t> status_;
+    uint32_t sessions_;
+    uint64_t power_w_;
+};
+
+// 表驱动引擎：每个连接器一个状态字，站点预算共享
+class TableAdmission {
+public:
+    explicit TableAdmission(size_t connectors) : admission_(&site_) {
+        for (size_t i = 0; i < connectors; i++) {
+            status_.emplace_back(new StatusRegister());
+        }
+        SiteBudget::Limits limits;
+        limits.max_sessions = kMaxSessions;
+        limits.power_kw = kPowerBudgetKw;
+        site_.set_limits(limits);
+    }
+
+    void set_status(size_t connector, int pos) { status_[connector]->set(pos); }
+
+    bool admit(size_t connector, int type, uint32_t w) {
+        return admission_.admit(*status_[connector], type, w) == ADMISSION_OK;
+    }
+
+    void stop(size_t connector, uint32_t w) {
+        admission_.cancel(*status_[connector], w);
+    }
+
+private:
+    SiteBudget site_;
+    AdmissionControl admission_;
+    std::vector<std::unique_ptr<StatusRegister>> status_;
+};
+
+template <typename Engine>
+void run(const char* name, size_t threads, int millis) {
+    Engine engine(kConnectors);
+    // 5%的连接器禁止远程启动，2%配置错误（禁止商用启动）
+    for (size_t i = 0; i < kConnectors; i++) {
+        if (i % 20 == 7) engine.set_status(i, DEVICE_STATUS_FORRBIDDEN_REMOTE);
+        if (i % 50 == 11) engine.set_status(i, DEVICE_STATUS_ERROR_CONFIG);
+    }
+
+    Watermark watermark;
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long long> attempts(0), admitted(0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            Xorshift rng(t + 1);
+            std::deque<size_t> held;
+            unsigned long long local_attempts = 0, local_admitted = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                size_t connector = rng.next() % kConnectors;
+                int type = static_cast<int>(rng.next() % 4);
+                uint32_t w = rated_w(connector);
+                local_attempts++;
+                bool ok = engine.admit(connector, type, w);
+                if (ok) {
+                    local_admitted++;
+                    watermark.add(w);
+                    held.push_back(connector);
+                }
+                // 持有过多或被拒绝时结束最早的会话，避免站点满额后所有线程都无法推进
+                if (!held.empty() && (!ok || held.size() > kHeldPerThread)) {
+                    size_t oldest = held.front();
+                    held.pop_front();
+                    watermark.remove(rated_w(oldest));
+                    engine.stop(oldest, rated_w(oldest));
+                }
+            }
+            for (size_t connector : held) {
+                watermark.remove(rated_w(connector));
+                engine.stop(connector, rated_w(connector));
+            }
+            attempts += local_attempts;
+            admitted += local_admitted;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    stop = true;
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    bool within = watermark.max_sessions.load() <= kMaxSessions &&
+                  watermark.max_power_w.load() <= kPowerBudgetKw * 1000;
+    std::cout << std::left << std::setw(20) << name << std::right
+              << std::setw(6) << threads
+              << std::setw(14) << std::fixed << std::setprecision(0) << attempts.load() * 1000.0 / millis
+              << std::setw(12) << admitted.load() * 1000.0 / millis
+              << std::setw(10) << watermark.max_sessions.load()
+              << std::setw(12) << std::setprecision(1) << watermark.max_power_w.load() / 1000.0
+              << std::setw(8) << (within ? "yes" : "NO")
+              << "\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int millis = argc > 1 ? std::atoi(argv[1]) : 1000;
+    std::cout << "=== 启动准入: " << kConnectors << " 连接器, 站点限额 " << kMaxSessions << " 会话 / "
+              << kPowerBudgetKw << " kW, 每线程最多持有 " << kHeldPerThread << " 个会话 ===\n";
+    std::cout << std::left << std::setw(20) << "engine" << std::right
+              << std::setw(6) << "thr"
+              << std::setw(14) << "admissions/s"
+              << std::setw(12) << "admitted/s"
+              << std::setw(10) << "peak ses"
+              << std::setw(12) << "peak kW"
+              << std::setw(8) << "limits"
+              << "\n";
+    const size_t thread_counts[] = {1, 4, 16};
+    for (size_t threads : thread_counts) {
+        run<LegacyAdmission>("mutex + switch", threads, millis);
+        run<TableAdmission>("table + CAS", threads, millis);
+    }
+    return 0;
+}
@@ -0,0 +1,342 @@
+#include "station/station_runtime.hpp"
+#include "device/async_device.hpp"
+#include "device/fake_device.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <functional>
+
+// 异步设备测试：命令队列串行与超时、关闭取消，以及连接器自检与其他连接器的命令/计量重叠
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+double ms_since(Clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+}
+
+// 记录连接器发出的命令结果（charge_info除外）
+class ResultLog {
+public:
+    struct Entry {
+        std::string device_id;
+        int cmd;
+        int result;
+        std::string describe;
+        Clock::time_point at;
+    };
+
+    void publish(const nlohmann::json& content) {
+        if (content["cmd"].get<int>() == DEVICE_CMD_CHARGE_INFO) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        entries_.push_back({content["device_id"].get<std::string>(), content["cmd"].get<int>(),
+                            content["result"].get<int>(), content["describe"].get<std::string>(), Clock::now()});
+    }
+
+    // 等待device_id的第n条结果（从0起）
+    bool wait(const std::string& device_id, size_t n, Entry& entry, milliseconds timeout = milliseconds(2000)) {
+        auto deadline = Clock::now() + timeout;
+        while (Clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                size_t seen = 0;
+                for (const Entry& e : entries_) {
+                    if (e.device_id == device_id && seen++ == n) {
+                        entry = e;
+                        return true;
+                    }
+                }
+            }
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        return false;
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<Entry> entries_;
+};
+
+Command make_command(const Connector& connector, int cmd) {
+    Command command;
+    command.cmd = cmd;
+    command.device_id = connector.id();
+    command.topic = connector.topic(TOPIC_CMD);
+    return command;
+}
+
+bool wait_until(const std::function<bool()>& done, milliseconds timeout = milliseconds(2000)) {
+    auto deadline = Clock::now() + timeout;
+    while (!done()) {
+        if (Clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return true;
+}
+
+struct Station {
+    ResultLog results;
+    std::vector<FakeDevice*> devices;
+    std::unique_ptr<StationRuntime> runtime;
+
+    Station(const PriceStore& prices, size_t count, bool async) {
+        runtime.reset(new StationRuntime(prices,
+            [this](const std::string&, const nlohmann::json& content, uint8_t, bool) { results.publish(content); }));
+        for (size_t i = 0; i < count; i++) {
+            devices.push_back(new FakeDevice(make_connector_id(i)));
+            runtime->add_connector(make_connector_id(i), std::unique_ptr<DeviceBase>(devices.back()));
+        }
+        if (async) {
+            runtime->enable_async_devices(2);
+        }
+        runtime->start(2, milliseconds(10));
+    }
+
+    Connector& connector(size_t i) { return *runtime->connectors()[i]; }
+};
+
+// 连接器0自检耗时300ms，期间对连接器1下发停止与启动，并统计其他连接器的采样次数
+void run_overlap(const PriceStore& prices, bool async, int& failures) {
+    const size_t kConnectors = 8;
+    Station station(prices, kConnectors, async);
+    for (size_t i = 1; i < kConnectors; i++) {
+        station.runtime->dispatch(make_command(station.connector(i), DEVICE_CMD_COMMERCIAL_START));
+    }
+    bool charging = wait_until([&] {
+        for (size_t i = 1; i < kConnectors; i++) {
+            if (!station.connector(i).is_charging()) {
+                return false;
+            }
+        }
+        return true;
+    });
+
+    FakeDevice::Latency slow;
+    slow.self_check_ms = 300;
+    station.devices[0]->set_latency(slow);
+    uint64_t reads_before = 0;
+    for (size_t i = 1; i < kConnectors; i++) {
+        reads_before += station.devices[i]->power_reads();
+    }
+    auto begin = Clock::now();
+    station.runtime->dispatch(make_command(station.connector(0), DEVICE_CMD_COMMERCIAL_START));
+    double slow_dispatch_ms = ms_since(begin);
+    // 同一执行线程上的下一条命令
+    station.runtime->dispatch(make_command(station.connector(1), DEVICE_CMD_STOP));
+    ResultLog::Entry stop_result;
+    bool stopped = station.results.wait(station.connector(1).id(), 0, stop_result);
+    double other_result_ms = std::chrono::duration<double, std::milli>(stop_result.at - begin).count();
+    // 自检期间（到连接器0开始充电为止）其他连接器的采样
+    bool started = wait_until([&] { return station.connector(0).is_charging(); });
+    uint64_t reads_during = 0;
+    for (size_t i = 1; i < kConnectors; i++) {
+        reads_during += station.devices[i]->power_reads();
+    }
+    reads_during -= reads_before;
+
+    std::cout << std::left << std::setw(8) << (async ? "异步" : "同步") << std::right << std::fixed
+              << std::setprecision(1) << std::setw(14) << slow_dispatch_ms << std::setw(18) << other_result_ms
+              << std::setw(16) << (stopped ? reads_during : 0) << std::endl;
+    if (!charging || !stopped || !started || stop_result.result != RESULT_OK) {
+        std::cout << "   失败: 启动或停止未完成" << std::endl;
+        failures++;
+    }
+    if (async && (slow_dispatch_ms > 50 || other_result_ms > 100)) {
+        std::cout << "   失败: 异步模式下执行线程被自检阻塞" << std::endl;
+        failures++;
+    }
+    station.runtime->stop();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    PriceStore prices;
+    if (prices.load_file(price_path) != PriceStore::RELOAD_OK) {
+        std::cerr << "加载价格表失败: " << price_path << "（用法: " << argv[0] << " <price.json>）\n";
+        return 1;
+    }
+    std::cout << "=== 异步设备测试 ===" << std::endl;
+    int failures = 0;
+    auto check = [&failures](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "   失败: " << what << std::endl;
+            failures++;
+        }
+    };
+
+    // 测试1: 同一设备的命令按FIFO串行执行，不同设备并行
+    std::cout << "\n--- 测试1: 命令队列 ---" << std::endl;
+    {
+        DeviceExecutor executor(4);
+        FakeDevice::Latency latency;
+        latency.start_ms = latency.stop_ms = latency.self_check_ms = 20;
+        std::vector<FakeDevice*> fakes;
+        std::vector<std::unique_ptr<AsyncDevice>> devices;
+        for (int i = 0; i < 4; i++) {
+            fakes.push_back(new FakeDevice(make_connector_id(i), latency));
+            devices.emplace_back(new AsyncDevice(std::unique_ptr<DeviceBase>(fakes.back()), &executor));
+        }
+        auto begin = Clock::now();
+        std::vector<std::future<DeviceReply>> replies;
+        for (auto& device : devices) {
+            replies.push_back(device->self_check(milliseconds(1000)));
+            replies.push_back(device->start(milliseconds(1000)));
+            replies.push_back(device->stop(milliseconds(1000)));
+        }
+        bool ok = true;
+        int64_t last_elapsed = 0;
+        for (size_t i = 0; i < replies.size(); i++) {
+            DeviceReply reply = replies[i].get();
+            ok = ok && reply.result == DEVICE_RESULT_OK;
+            // 同一设备的三条命令依次完成
+            ok = ok && (i % 3 == 0 || reply.elapsed_us > last_elapsed);
+            last_elapsed = reply.elapsed_us;
+        }
+        double wall_ms = ms_since(begin);
+        check(ok, "命令结果或顺序错误");
+        for (FakeDevice* fake : fakes) {
+            check(fake->max_concurrent_commands() == 1 && fake->starts() == 1 && !fake->running(), "同一设备的命令并发执行");
+        }
+        // 4个设备各60ms，串行需240ms
+        check(wall_ms < 200, "不同设备的命令未并行");
+        std::cout << "   4个设备 x 3条命令(各20ms): " << std::fixed << std::setprecision(1) << wall_ms << " ms, 完成"
+                  << std::endl;
+    }
+
+    // 测试2: 超时在截止时间投递，不等待卡住的设备调用；排队中超时的命令不再执行，停止命令除外
+    std::cout << "\n--- 测试2: 超时 ---" << std::endl;
+    {
+        DeviceExecutor executor(1);
+        FakeDevice* fake = new FakeDevice("timeout");
+        AsyncDevice device(std::unique_ptr<DeviceBase>(fake), &executor);
+        FakeDevice::Latency latency;
+        latency.self_check_ms = 300;
+        fake->set_latency(latency);
+        auto begin = Clock::now();
+        std::future<DeviceReply> check_reply = device.self_check(milliseconds(50));
+        std::future<DeviceReply> queued_reply = device.start(milliseconds(100));
+        std::future<DeviceReply> stop_reply = device.stop(milliseconds(150));
+        DeviceReply first = check_reply.get();
+        double first_ms = ms_since(begin);
+        DeviceReply second = queued_reply.get();
+        double second_ms = ms_since(begin);
+        DeviceReply third = stop_reply.get();
+        check(first.result == DEVICE_RESULT_TIMEOUT && first_ms < 150, "执行中的命令未按时超时");
+        check(second.result == DEVICE_RESULT_TIMEOUT && second_ms < 200, "排队中的命令未按时超时");
+        check(third.result == DEVICE_RESULT_TIMEOUT, "排队中的停止命令未按时超时");
+        check(wait_until([&] { return fake->stops() == 1; }), "排队中超时的停止命令未执行");
+        check(fake->self_checks() == 1 && fake->starts() == 0, "排队中超时的命令仍被执行");
+        check(device.device().GetPower() == 0 && !fake->running(), "停止后设备仍在运行");
+        device.close();
+        DeviceExecutor::Statistics stats = executor.get_statistics();
+        check(stats.timeouts == 3 && stats.late == 2 && stats.executed == 0, "超时统计错误");
+        std::cout << "   超时投递: " << std::setprecision(1) << first_ms << " ms / " << second_ms
+                  << " ms（设备调用300ms）, 完成" << std::endl;
+    }
+
+    // 测试3: 队列满时拒绝；关闭时取消排队的命令并等待执行中的命令
+    std::cout << "\n--- 测试3: 队列上限与关闭 ---" << std::endl;
+    {
+        DeviceExecutor executor(1);
+        FakeDevice* fake = new FakeDevice("close");
+        FakeDevice::Latency latency;
+        latency.stop_ms = 50;
+        fake->set_latency(latency);
+        std::unique_ptr<AsyncDevice> device(new AsyncDevice(std::unique_ptr<DeviceBase>(fake), &executor, 2));
+        std::vector<std::future<DeviceReply>> replies;
+        replies.push_back(device->stop(milliseconds(0)));
+        wait_until([&] { return device->queued() == 0; });  // 第一条已开始执行
+        for (int i = 0; i < 4; i++) {
+            replies.push_back(device->stop(milliseconds(0)));
+        }
+        device->close();
+        int results[4] = {0, 0, 0, 0};
+        for (auto& reply : replies) {
+            results[reply.get().result]++;
+        }
+        check(fake->stops() == 1, "关闭时未等待执行中的命令或执行了排队的命令");
+        check(results[DEVICE_RESULT_OK] == 1 && results[DEVICE_RESULT_BUSY] == 2, "队列满时未拒绝");
+        check(results[DEVICE_RESULT_CANCELLED] == 2 && executor.get_statistics().cancelled == 2, "关闭时排队的命令未取消");
+        check(!device->submit([](DeviceBase&, DeviceReply&) {}, milliseconds(0), [](const DeviceReply&) {}),
+              "关闭后仍接受命令");
+        std::cout << "   拒绝 " << results[DEVICE_RESULT_BUSY] << " 条, 取消 " << results[DEVICE_RESULT_CANCELLED]
+                  << " 条, 完成" << std::endl;
+    }
+
+    // 测试4: 连接器的启动超时、启动完成前停止
+    std::cout << "\n--- 测试4: 连接器启动超时与启动中停止 ---" << std::endl;
+    {
+        Station station(prices, 2, true);
+        Connector& first = station.connector(0);
+        Connector& second = station.connector(1);
+        FakeDevice::Latency slow;
+        slow.self_check_ms = 200;
+        station.devices[0]->set_latency(slow);
+        station.devices[1]->set_latency(slow);
+
+        // 超时100ms：启动失败并归还预算，迟到的启动被补发的停止撤销
+        first.set_device_timeout(milliseconds(100));
+        auto begin = Clock::now();
+        station.runtime->dispatch(make_command(first, DEVICE_CMD_COMMERCIAL_START));
+        ResultLog::Entry entry;
+        bool got = station.results.wait(first.id(), 0, entry);
+        double timeout_ms = ms_since(begin);
+        check(got && entry.result == RESULT_FAIL && entry.describe == "device timeout" && timeout_ms < 180,
+              "启动超时未按时报告");
+        check(!first.get_status(DEVICE_STATUS_BUSY), "启动超时后仍为忙碌");
+        check(wait_until([&] { return station.devices[0]->stops() == 1; }) && !station.devices[0]->running(),
+              "超时的启动完成后设备未被停止");
+
+        // 启动完成前收到停止：启动作废，停止在启动之后执行，设备最终停止
+        station.runtime->dispatch(make_command(second, DEVICE_CMD_COMMERCIAL_START));
+        station.runtime->dispatch(make_command(second, DEVICE_CMD_STOP));
+        ResultLog::Entry start_result, stop_result;
+        got = station.results.wait(second.id(), 0, start_result) && station.results.wait(second.id(), 1, stop_result);
+        check(got && start_result.cmd == DEVICE_CMD_COMMERCIAL_START && start_result.result == RESULT_FAIL &&
+                  stop_result.cmd == DEVICE_CMD_STOP && stop_result.result == RESULT_OK,
+              "启动中停止的结果错误");
+        check(!second.is_charging() && !station.devices[1]->running() && station.devices[1]->starts() == 1,
+              "启动中停止后设备仍在运行");
+        SiteBudget::Usage usage = station.runtime->site().usage();
+        check(usage.sessions == 0 && usage.power_kw == 0, "站点预算未归还");
+
+        // 额定功率为0的连接器同样占用并归还站点会话，站点只允许1个会话时可反复启停
+        SiteBudget::Limits limits;
+        limits.max_sessions = 1;
+        station.runtime->set_site_limits(limits);
+        second.set_rated_power(0);
+        bool restarted = true;
+        for (int i = 0; i < 3 && restarted; i++) {
+            station.runtime->dispatch(make_command(second, DEVICE_CMD_COMMERCIAL_START));
+            restarted = wait_until([&] { return second.is_charging(); });
+            station.runtime->dispatch(make_command(second, DEVICE_CMD_STOP));
+            restarted = restarted && wait_until([&] {
+                return !second.is_charging() && station.runtime->site().usage().sessions == 0;
+            });
+        }
+        check(restarted, "额定功率为0时站点会话未归还");
+        std::cout << "   启动超时报告: " << std::setprecision(1) << timeout_ms << " ms, 完成" << std::endl;
+        station.runtime->stop();
+    }
+
+    // 测试5: 一个连接器自检期间，其他连接器的命令与计量
+    std::cout << "\n--- 测试5: 自检与其他连接器重叠 ---" << std::endl;
+    std::cout << std::left << std::setw(8) << "模式" << std::right << std::setw(14) << "慢命令分发ms"
+              << std::setw(18) << "其他连接器结果ms" << std::setw(16) << "期间采样次数" << std::endl;
+    run_overlap(prices, false, failures);
+    run_overlap(prices, true, failures);
+
+    std::cout << "\n=== " << (failures ? "测试失败" : "所有测试通过") << " ===" << std::endl;
+    return failures ? 1 : 0;
+}
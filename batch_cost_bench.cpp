@@ -0,0 +1,204 @@
+#include "config/price_table.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cmath>
+#include <cstdlib>
+#include <time.h>
+
+/**
+ * 批量计费性能测试
+ *
+ * 模拟后台重算历史会话：每个会话是一段按分钟记录的电量序列（30~240分钟，起始时间分布在一年内），
+ * 分别用逐点get_price累加与PriceTable::cost批量计算，比较吞吐并核对结果。
+ * 电价表用命令行给出的price.json与内置的日历电价（工作日/周末/节假日）各测一次；
+ * 会话数据分为能放进缓存的少量会话（重复多轮）与远超缓存的大批会话两种规模。
+ * 最后在有夏令时的时区下核对跟随本地时区的批量计费：冬令时、夏令时与跨越切换时刻的会话
+ * 都应按各自时刻的偏移计费。
+ */
+
+namespace {
+
+const char* kCalendarTariff =
+    "{\"price_list\": [{\"start\": \"00:00\", \"end\": \"07:00\", \"price\": 0.5, \"service_fee\": 0.1},"
+    "                  {\"start\": \"07:00\", \"end\": \"19:00\", \"price\": 0.8, \"service_fee\": 0.1},"
+    "                  {\"start\": \"19:00\", \"end\": \"23:00\", \"price\": 1.0, \"service_fee\": 0.1}],"
+    " \"other_price\": 0.6, \"other_service_fee\": 0.1,"
+    " \"day_types\": {\"weekend\": {\"price_list\": [{\"start\": \"08:00\", \"end\": \"22:00\", \"price\": 0.7, \"service_fee\": 0.1}],"
+    "                               \"other_price\": 0.4, \"other_service_fee\": 0.1},"
+    "               \"holiday\": {\"price_list\": [], \"other_price\": 0.45, \"other_service_fee\": 0.1}},"
+    " \"holidays\": [\"2024-01-01\", \"2024-05-01\", \"2024-10-01\", \"2024-10-02\", \"2024-10-03\"],"
+    " \"rules\": [{\"day_type\": \"holiday\", \"holiday\": true}, {\"day_type\": \"weekend\", \"weekdays\": [0, 6]}]}";
+
+struct Sessions {
+    std::vector<TimeSeries> sessions;
+    size_t samples = 0;
+};
+
+Sessions make_sessions(size_t count, uint32_t seed) {
+    Sessions out;
+    uint64_t state = seed * 0x9e3779b97f4a7c15ULL + 1;
+    auto next = [&state]() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    };
+    const int64_t year_start = 1704067200;  // 2024-01-01 UTC
+    out.sessions.resize(count);
+    for (TimeSeries& series : out.sessions) {
+        int64_t start = year_start + static_cast<int64_t>(next() % (365 * 86400));
+        size_t minutes = 30 + next() % 211;
+        double kw = 3.5 + static_cast<double>(next() % 1800) / 100.0;
+        series.reserve(minutes);
+        for (size_t m = 0; m < minutes; m++) {
+            // 每分钟电量，末段功率递减
+            double taper = m + 20 > minutes ? static_cast<double>(minutes - m) / 20.0 : 1.0;
+            series.push_back(start + static_cast<int64_t>(m) * 60, kw * taper / 60.0);
+        }
+        out.samples += minutes;
+    }
+    return out;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void run(const char* name, const PriceTable& table, const Sessions& data, int rounds) {
+    std::vector<double> scalar(data.sessions.size()), batch(data.sessions.size());
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t s = 0; s < data.sessions.size(); s++) {
+            const TimeSeries& series = data.sessions[s];
+            double total = 0;
+            for (size_t i = 0; i < series.size(); i++) {
+                total += series.kwh[i] * table.get_price(static_cast<time_t>(series.unix_s[i]));
+            }
+            scalar[s] = total;
+        }
+    }
+    double scalar_s = seconds_since(begin) / rounds;
+
+    begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        for (size_t s = 0; s < data.sessions.size(); s++) {
+            batch[s] = table.cost(data.sessions[s]);
+        }
+    }
+    double batch_s = seconds_since(begin) / rounds;
+
+    double max_rel = 0, scalar_total = 0, batch_total = 0;
+    for (size_t s = 0; s < scalar.size(); s++) {
+        scalar_total += scalar[s];
+        batch_total += batch[s];
+        if (scalar[s] != 0) {
+            max_rel = std::max(max_rel, std::fabs(batch[s] - scalar[s]) / scalar[s]);
+        }
+    }
+    std::cout << std::left << std::setw(10) << name << std::right << std::fixed
+              << std::setw(12) << std::setprecision(1) << data.samples / scalar_s / 1e6
+              << std::setw(12) << data.samples / batch_s / 1e6
+              << std::setw(14) << std::setprecision(0) << data.sessions.size() / batch_s
+              << std::setw(9) << std::setprecision(1) << scalar_s / batch_s << "x"
+              << std::setw(16) << std::setprecision(2) << batch_total
+              << std::setw(12) << std::scientific << std::setprecision(1) << max_rel << "\n";
+}
+
+// 欧洲中部时间，2024-03-31 01:00 UTC进入夏令时，2024-10-27 01:00 UTC退出；用POSIX规则，不依赖tzdata
+const char* kDstZone = "CET-1CEST,M3.5.0,M10.5.0/3";
+
+int64_t local_offset(int64_t unix_s) {
+    time_t at = static_cast<time_t>(unix_s);
+    struct tm tm_time;
+    localtime_r(&at, &tm_time);
+    return tm_time.tm_gmtoff;
+}
+
+// 跟随本地时区的表批量计费，与逐点按当时偏移计费比较
+bool check_dst() {
+    setenv("TZ", kDstZone, 1);
+    tzset();
+    PriceTable table, reference;
+    if (!table.parse(kCalendarTariff) || !reference.parse(kCalendarTariff)) {
+        return false;
+    }
+    // 在冬令时刷新偏移，模拟夏天重算冬天之外的历史数据
+    table.refresh_utc_offset(1704067200);
+    struct Case {
+        const char* name;
+        int64_t start;
+        size_t minutes;
+    };
+    const Case cases[] = {{"冬令时", 1706774400, 600},           // 2024-02-01 08:00 UTC
+                          {"夏令时", 1719820800, 600},           // 2024-07-01 08:00 UTC
+                          {"进入夏令时", 1711832400, 600},       // 2024-03-30 21:00 UTC起
+                          {"退出夏令时", 1729983600, 600}};      // 2024-10-26 23:00 UTC起
+    bool ok = true;
+    for (const Case& c : cases) {
+        TimeSeries series;
+        double expected = 0;
+        for (size_t m = 0; m < c.minutes; m++) {
+            int64_t t = c.start + static_cast<int64_t>(m) * 60;
+            series.push_back(t, 0.1);
+            reference.set_utc_offset(static_cast<int32_t>(local_offset(t)));
+            expected += 0.1 * reference.get_price(static_cast<time_t>(t));
+        }
+        double got = table.cost(series);
+        bool match = std::fabs(got - expected) <= 1e-9 * expected;
+        ok = ok && match;
+        std::cout << std::left << std::setw(16) << c.name << std::right << std::fixed << std::setprecision(4)
+                  << std::setw(12) << got << std::setw(12) << expected << (match ? "   一致" : "   不一致") << "\n";
+    }
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <price.json> [sessions=50000] [rounds=3]" << std::endl;
+        return 1;
+    }
+    const size_t session_count = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 50000;
+    const int rounds = argc > 3 ? std::max(1, std::atoi(argv[3])) : 3;
+
+    PriceTable daily;
+    if (!daily.load(argv[1])) {
+        return 1;
+    }
+    PriceTable calendar;
+    if (!calendar.parse(kCalendarTariff)) {
+        return 1;
+    }
+    // 历史数据按固定偏移计费，与运行时的时区无关
+    daily.set_utc_offset(8 * 3600);
+    calendar.set_utc_offset(8 * 3600);
+    std::cout << std::setfill(' ');
+
+    struct Scale {
+        size_t sessions;
+        int rounds;
+    };
+    const Scale scales[] = {{256, 200}, {session_count, rounds}};
+    for (const Scale& scale : scales) {
+        Sessions data = make_sessions(scale.sessions, 1);
+        std::cout << "=== 批量计费: " << data.sessions.size() << " 个会话, " << data.samples << " 个分钟样本 ("
+                  << data.samples * (sizeof(int64_t) + sizeof(double)) / 1024 << " KB), 重复" << scale.rounds
+                  << "次 ===\n";
+        std::cout << std::left << std::setw(10) << "tariff" << std::right
+                  << std::setw(12) << "scalar M/s" << std::setw(12) << "batch M/s"
+                  << std::setw(14) << "sessions/s" << std::setw(10) << "speedup"
+                  << std::setw(16) << "total cost" << std::setw(12) << "max rel" << "\n";
+        run("daily", daily, data, scale.rounds);
+        run("calendar", calendar, data, scale.rounds);
+        std::cout << std::fixed;
+    }
+
+    std::cout << "=== 夏令时: " << kDstZone << " ===\n";
+    std::cout << std::left << std::setw(16) << "session" << std::right << std::setw(12) << "batch"
+              << std::setw(12) << "expected" << "\n";
+    return check_dst() ? 0 : 1;
+}
@@ -1,362 +1,235 @@
 #include "tools/mqtt/mqtt_client_v2.hpp"
-#include "tools/timer/timer.hpp"
 #include <iostream>
 #include <chrono>
 #include <thread>
 #include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <cstring>
+#include <algorithm>
 #include "nlohmann/json.hpp"
 #include "device/device.hpp"
-#include "config/price_table.hpp"
+#include "config/price_store.hpp"
+#include "config/price_watcher.hpp"
+#include "station/command_pipeline.hpp"
+#include "station/station_runtime.hpp"
+#include "station/outbound_queue.hpp"
+#include "tools/trace/trace.hpp"
 #include "elog.h"
 using namespace std;
 
-#define CMD "GreenEnergy/CMD/"
-#define STATUS "GreenEnergy/STATUS/"
-#define HEARTBEAT "GreenEnergy/HEARTBEAT/"
-#define DEVICE_ID "0000-00001"
-
-#define MSG(msg) (string(msg) + DEVICE_ID)
-
 #define CONFIG_PATH "../config/price.json"
+#define JOURNAL_DIR "./journal"
 #define MQTT_SERVER "127.0.0.1"
 #define MQTT_PORT 1883
 
 
 
-struct MQTT_MSG{
-    std::string topic;
-    nlohmann::json content;
-    uint8_t qos;
-    bool retain;
-
-    MQTT_MSG(){
-        this->topic = "";
-        this->content = nlohmann::json();
-        this->qos = 0;
-        this->retain = false;
-    }
-
-    MQTT_MSG(const MQTT_MSG& other){
-        this->topic = other.topic;
-        this->content = other.content;
-        this->qos = other.qos;
-        this->retain = other.retain;
-    }
-
-    MQTT_MSG(std::string topic,nlohmann::json content,uint8_t qos,bool retain){
-        this->topic = topic;
-        this->content = content;
-        this->qos = qos;
-        this->retain = retain;
-    }
-
-    MQTT_MSG &operator=(const MQTT_MSG &msg){
-        this->topic = msg.topic;
-        this->content = msg.content;
-        this->qos = msg.qos;
-        this->retain = msg.retain;
-        return *this;
-    }
-};
-
-
-enum DEVICE_STATUS_CODE{
-    DEVICE_STATUS_ERROR_CONFIG = 0,
-    DEVICE_STATUS_ERROR_EMPTY_CONFIG = 1,
-    DEVICE_STATUS_SELF_CHECK_FAIL = 2,
-    DEVICE_STATUS_START = 3,
-    DEVICE_STATUS_STOP = 4,
-    DEVICE_STATUS_ONLINE = 5, //在线
-    DEVICE_STATUS_BUSY = 6, //忙碌
-    DEVICE_STATUS_FORRBIDDEN = 7, //禁止所有充电
-     DEVICE_STATUS_FORRBIDDEN_REMOTE = 8, //禁止远程充电
-    DEVICE_STATUS_FORRBIDDEN_COMMERCIAL = 9, //禁止商用充电
-};
-
-enum DEVICE_CMD{
-    DEVICE_CMD_REMOTE_START = 1,
-    DEVICE_CMD_COMMERCIAL_START = 2,
-    DEVICE_CMD_STOP = 3,
-    DEVICE_CMD_PAUSE = 4,
-    DEVICE_CMD_CHARGE_INFO = 5, //获取充电信息
-};
-
-enum RESULT_CODE{
-    RESULT_FAIL = 0,
-    RESULT_OK = 1, 
-};
-
-enum START_TYPE{
-    START_TYPE_NFC = 0, //正常NFC启动
-    START_TYPE_BLUETOOTH = 1, //正常蓝牙启动
-    START_TYPE_REMOTE = 2, //远程启动
-    START_TYPE_COMMERCIAL = 3, //商用启动
-};
-
-
-
-struct ChargeInfo{
-    int start_type; //启动类型
-    string describe; //描述
-    string start_time; //开始时间
-    string end_time; //结束时间
-    float total; //价格
-    float all_energy; //总电量
-    std::vector<float> period_stats; // 各时间段充电统计
-
-    ChargeInfo(): period_stats(24, 0.0f){
-        start_type = -1;
-        describe = "";
-        start_time = "";
-        end_time = "";
-        total = 0;
-        all_energy = 0;
-    }
-    ChargeInfo(int start_type,string describe,string start_time,string end_time) : period_stats(24, 0.0f){
-        this->start_type = start_type;
-        this->describe = describe;
-        this->start_time = start_time;
-        this->end_time = end_time;
-        this->total = 0;
-        this->all_energy = 0;
-    }
-
-    void clear(){
-        start_type = -1;
-        describe = "";
-        start_time = "";
-        end_time = "";
-        total = 0;
-        all_energy = 0;
-        //初始化电量统计时间段
-        for(int i = 0;i < period_stats.size();i++){
-            period_stats[i] = 0;
-        }
-    }
-
-    float get_all_energy(){
-        float total = 0;
-        for(int i = 0;i < period_stats.size();i++){
-            total = total + period_stats[i];
-        }
-        all_energy = total;
-        return total;
-    }
-    
-    void add_period_stats(int hour,float energy){
-        period_stats[hour] = period_stats[hour] + energy;
-    }
-    void add_period_stats(time_t unix_time,float energy){
-        int hour = unix_time / 3600 % 24;
-        int minute = (unix_time % 3600) / 60;
-        int second = unix_time % 60;
-        period_stats[hour] = period_stats[hour] + energy;
-    }
-
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(ChargeInfo,start_type, describe, start_time, end_time, total,all_energy,period_stats)
-} charge_info;
-
-static int current_start_type = -1; //当前启动类型
-static std::queue<MQTT_MSG> mqtt_msg_queue;
-static std::mutex mqtt_msg_queue_mutex;
-static std::mutex device_mutex;
-static std::mutex charge_info_mutex;
-static std::unique_ptr<Timer> timer;
+static OutboundQueue outbound_queue;
+static std::unique_ptr<CommandPipeline> command_pipeline;
+static std::unique_ptr<StationRuntime> runtime;
 
-uint64_t DEVICE_STATUS= 0;
-// 创建MQTT客户端
+// 创建MQTT客户端（所有连接器共享一条连接）
 MQTTClientV2 client(MQTT_SERVER, MQTT_PORT);
-DeviceBase *device =  new Device();
-PriceTable table;
+// 电价：price.json变化或收到推送时热更新，进行中的会话从下一分钟起按新电价计费
+PriceStore prices;
+static std::unique_ptr<PriceWatcher> price_watcher;
+static bool price_table_loaded = true;
 // 全局变量用于信号处理
-static bool running = true;
-
-
-void init_price_table(PriceTable &table);
+static std::atomic<bool> running(true);
+static std::atomic<bool> network_online(false);
+// 主循环事件源：出站消息入队或收到信号时写入一个字节
+static int event_pipe[2] = {-1, -1};
+static std::atomic<uint64_t> main_loop_wakeups(0);
+// 跟踪导出请求：SIGUSR1导出Chrome JSON，SIGUSR2导出二进制
+static std::atomic<int> trace_dump_request(0);
+
+
+void init_price_table();
+void init_price_watcher();
+void on_price_reload(PriceStore::ReloadResult result, const PriceSnapshotPtr& snapshot);
+void handle_tariff_push(const std::string& payload);
 void init_log_system();
+void init_runtime(size_t connector_count, int sample_hz, const SiteBudget::Limits& site_limits);
 bool init_network(MQTTClientV2 & client);
-void init_timer();
+void init_command_pipeline(size_t executor_count);
+void init_event_source();
+void notify_main_loop();
+void wait_main_loop_event(std::chrono::steady_clock::time_point deadline);
+void print_wakeup_stats();
+void dump_trace(int format);
 
-void send_result(int cmd,int result,string describe = "" );
-void send_heatbeat();
-void send_charge_info(const ChargeInfo &charge_info);
-bool check_start_condition(int type);
 void msg_handle(const std::string& topic, const std::string& payload, uint8_t qos, bool retain);
-
-void charge_timer_callback();
+void execute_command(const Command &command);
+void print_pipeline_stats();
 
 
 
-void set_device_status(uint64_t pos) { 
-    std::lock_guard<std::mutex> lck(device_mutex); 
-    DEVICE_STATUS = DEVICE_STATUS | 0x1 << pos;
-    }
-void clear_device_status(uint64_t pos) {
-    std::lock_guard<std::mutex> lck(device_mutex); 
-    DEVICE_STATUS = DEVICE_STATUS & ~(0x1 << pos);
-    }
-int  get_device_status(uint64_t pos) {
-    std::lock_guard<std::mutex> lck(device_mutex); 
-    return DEVICE_STATUS & (0x1 << pos) ? 1 : 0;
-    }
 void print_device_status() {
-    log_w("设备状态: %d",DEVICE_STATUS);
-    }
-
-bool check_start_condition(int type){
-
-    if(get_device_status(DEVICE_STATUS_FORRBIDDEN)){
-        log_e("设备禁止充电");
-        return false;
-    }
-    if(get_device_status(DEVICE_STATUS_BUSY)){
-        log_e("设备忙碌中");
-        return false;
-    }
-    // 设置设备状态为忙碌
-    set_device_status(DEVICE_STATUS_BUSY);
-    bool result = true;
-    // 检查设备状态
-    switch(type){
-        case START_TYPE_NFC:
-        case START_TYPE_BLUETOOTH:
-            break;
-        case START_TYPE_REMOTE:
-            if(get_device_status(DEVICE_STATUS_FORRBIDDEN_REMOTE)){
-                log_e("设备禁止远程充电");
-                result = false;
-            }
-            break;
-        case START_TYPE_COMMERCIAL:
-            if(get_device_status(DEVICE_STATUS_FORRBIDDEN_COMMERCIAL)){
-                log_e("设备禁止商用充电");
-                result = false;
-            }
-            else if(get_device_status(DEVICE_STATUS_ERROR_CONFIG)){
-                log_e("设备配置错误，无法商用充电");
-                result = false;
-            }
-            break;
-        default:
-            log_e("未知启动类型");
+    for (const auto& connector : runtime->connectors()) {
+        log_w("设备[%s]状态: %llu",connector->id().c_str(),
+              static_cast<unsigned long long>(connector->status()));
     }
-    if(!result){
-        clear_device_status(DEVICE_STATUS_BUSY);
-        return false;
-    }
-
-    if(device->SelfCheck() > 0){
-        log_e("设备自检失败");
-        clear_device_status(DEVICE_STATUS_BUSY);
-        set_device_status(DEVICE_STATUS_SELF_CHECK_FAIL);
-        return false;
-    }
-    current_start_type = type;
-    //自检成功
-    clear_device_status(DEVICE_STATUS_SELF_CHECK_FAIL);
-    return true;
+    SiteBudget::Usage usage = runtime->site().usage();
+    log_w("站点会话:%u 功率:%.1fkW",usage.sessions,usage.power_kw);
 }
 
-void push_mqtt_msg(MQTT_MSG msg){
-    std::lock_guard<std::mutex> lock(mqtt_msg_queue_mutex);
-    mqtt_msg_queue.push(msg);
+void push_mqtt_msg(const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain){
+    // 在调用线程序列化，主循环只负责发送
+    outbound_queue.push(topic, content, qos, retain);
+    notify_main_loop();
 }
 
 void send_mqtt_msg(){
-    std::lock_guard<std::mutex> lock(mqtt_msg_queue_mutex);
-    MQTT_MSG msg;
+    static std::vector<OutboundMessage> batch;
+    if(!outbound_queue.drain(batch)){
+        return;
+    }
     MQTTClientV2::PublishOptions pub_opts;
-    while(mqtt_msg_queue.size()){
-        msg = mqtt_msg_queue.front();
-        mqtt_msg_queue.pop();
+    for(const auto& msg : batch){
+        TraceSpan span(msg.trace_id ? "publish.flush" : nullptr, msg.trace_id);
         pub_opts.qos = msg.qos;
         pub_opts.retain = msg.retain;
-        client.publish(msg.topic,msg.content.dump(),pub_opts);
+        client.publish(msg.topic,msg.payload,pub_opts);
     }
+    outbound_queue.release(batch);
 }
 
 // 信号处理函数
 void signal_handler(int signal) {
     std::cout << "\n收到信号 " << signal << "，正在退出...\n";
     running = false;
+    notify_main_loop();
 }
 
-void charge_timer_callback(){
-    float power = device->GetPower();//(kw)
-    float total = 0;
-    time_t now = time(nullptr);
-    std::lock_guard<std::mutex> lock(charge_info_mutex);
-    charge_info.add_period_stats(now,power * (1.0 / 3600));
-    if(charge_info.start_type == START_TYPE_COMMERCIAL){
-        for(int i = 0;i < charge_info.period_stats.size();i++){
-            total += charge_info.period_stats[i] * table.get_price(i);  
-        }
-    }
-    charge_info.all_energy =  charge_info.get_all_energy();
-    charge_info.total = total;
-    nlohmann::json json_charge_info = charge_info;
-    send_charge_info(charge_info);
-   
+void trace_signal_handler(int signal) {
+    trace_dump_request = signal == SIGUSR2 ? 2 : 1;
+    notify_main_loop();
 }
-int main() {
+
+int main(int argc, char* argv[]) {
+    // 用法: charging_station [连接器数量] [采样频率Hz] [站点功率预算kW] [站点最大并发会话数]
+    // 连接器数量（默认1个）
+    size_t connector_count = 1;
+    if (argc > 1) {
+        connector_count = std::max(1, atoi(argv[1]));
+    }
+    // 计量采样频率（10~100Hz，默认10Hz）
+    int sample_hz = 10;
+    if (argc > 2) {
+        sample_hz = std::max(10, std::min(100, atoi(argv[2])));
+    }
+    // 站点限额（默认不限）
+    SiteBudget::Limits site_limits;
+    if (argc > 3) {
+        site_limits.power_kw = std::max(0.0, atof(argv[3]));
+    }
+    if (argc > 4) {
+        site_limits.max_sessions = static_cast<uint32_t>(std::max(0, atoi(argv[4])));
+    }
+
     // 设置信号处理
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
+    signal(SIGUSR1, trace_signal_handler);
+    signal(SIGUSR2, trace_signal_handler);
+
+    // 命令链路跟踪常开，记录保存在各线程的环形缓冲区中，收到信号时导出
+    Trace::set_enabled(true);
+    Trace::set_thread_name("main");
 
     //初始化日志系统
     init_log_system();
 
-    //初始化定时器
-    init_timer();
+    //初始化主循环事件源
+    init_event_source();
 
     //初始化电价
-    init_price_table(table);
+    init_price_table();
 
+    //初始化连接器与计量线程
+    init_runtime(connector_count, sample_hz, site_limits);
+
+    //监视价格文件
+    init_price_watcher();
+
+    //初始化命令流水线
+    init_command_pipeline(std::min<size_t>(connector_count, 4));
     
 
     //初始化网路
     if(init_network(client)){
         
-        set_device_status(DEVICE_STATUS_ONLINE);
+        runtime->set_status(DEVICE_STATUS_ONLINE);
         // 订阅主题
         std::cout << "\n正在订阅主题...\n";
         MQTTClientV2::SubscribeOptions sub_opts;
         sub_opts.qos = 1;
         
-        if (!client.subscribe(MSG(CMD), sub_opts)) {
-            std::cerr << "订阅失败: " << client.get_last_error() << "\n";
-        }
+        for (const auto& connector : runtime->connectors()) {
+            if (!client.subscribe(connector->topic(TOPIC_CMD), sub_opts)) {
+                std::cerr << "订阅失败: " << client.get_last_error() << "\n";
+            }
 
-        if (!client.subscribe(MSG(HEARTBEAT), sub_opts)) {
+            if (!client.subscribe(connector->topic(TOPIC_HEARTBEAT), sub_opts)) {
+                std::cerr << "订阅失败: " << client.get_last_error() << "\n";
+            }
+        }
+        if (!client.subscribe(TOPIC_TARIFF, sub_opts)) {
             std::cerr << "订阅失败: " << client.get_last_error() << "\n";
         }
         
         std::vector<std::string> topics = client.get_subscribed_topics();
-        for(int i = 0;i < topics.size();i++){
+        for(size_t i = 0;i < topics.size();i++){
             std::cout << "订阅主题: " << topics[i] << "\n";
         }
 
     }else{
-        clear_device_status(DEVICE_STATUS_ONLINE);
+        runtime->clear_status(DEVICE_STATUS_ONLINE);
     }
     
-    // 主循环
-    int counter = 0;
+    // 主循环：空闲时阻塞在事件源上，只为出站消息、心跳和统计醒来
+    // 网络收发由MQTT客户端的refresher线程负责，主循环不再调用sync()
+    const auto heartbeat_interval = std::chrono::seconds(10);
+    const auto stats_interval = std::chrono::seconds(60);
+    auto next_heartbeat = std::chrono::steady_clock::now();
+    auto next_stats = next_heartbeat + stats_interval;
     
     while (running) {
-        // 打印设备状态
-        print_device_status();
+        auto now = std::chrono::steady_clock::now();
+        bool heartbeat_due = now >= next_heartbeat;
+        if (heartbeat_due) {
+            next_heartbeat = now + heartbeat_interval;
+            // 电价查询使用缓存的UTC偏移，夏令时切换后在这里更新
+            if (prices.refresh_utc_offset()) {
+                log_i("本地时区UTC偏移变为 %d 秒", prices.current()->table.utc_offset());
+            }
+            // 打印设备状态
+            print_device_status();
+            // 空闲连接器的自检缓存即将过期时在设备线程上后台刷新
+            runtime->refresh_self_checks();
+        }
 
-        if(get_device_status(DEVICE_STATUS_ONLINE)){
-            // 网络同步
-            client.sync();
+        if(network_online){
+            // 每10秒为每个连接器发布一次心跳消息
+            if (heartbeat_due) {
+                runtime->send_heartbeats();
+            }
             // 序列化发送MQTT消息
             send_mqtt_msg();
-            // 每10秒发布一次心跳消息
-            if (counter % 10 == 0) {
-                send_heatbeat();
-            }
+        }
+
+        int trace_format = trace_dump_request.exchange(0);
+        if (trace_format) {
+            dump_trace(trace_format);
+        }
 
+        // 每60秒打印一次命令流水线与唤醒统计
+        if (now >= next_stats) {
+            next_stats = now + stats_interval;
+            print_pipeline_stats();
+            print_wakeup_stats();
         }
         
         // 检查错误
@@ -365,13 +238,15 @@ int main() {
             client.clear_error();
         }
         
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        counter++;
+        wait_main_loop_event(std::min(next_heartbeat, next_stats));
     }
     
     // 清理
     log_w("\n正在断开连接...\n");
     client.disconnect();
+    price_watcher->stop();
+    command_pipeline->stop();
+    runtime->stop();
     log_w("\程序退出...\n");
     return 0;
 } 
@@ -394,89 +269,239 @@ void init_log_system() {
     /* start EasyLogger */
     elog_start();
     log_i("EasyLogger init success！");
-    log_i("device id: %s",DEVICE_ID);
 }
 
 
 void msg_handle(const std::string& topic, const std::string& payload, uint8_t qos, bool retain) {
 
-    log_i("receive:%s content:%s Qos:%d",topic.c_str(),payload.c_str(),static_cast<int>(qos));
-
-    if(topic == MSG(HEARTBEAT)){
+    if(topic.compare(0, strlen(TOPIC_HEARTBEAT), TOPIC_HEARTBEAT) == 0){
+        return ;
+    }
+    if(topic == TOPIC_TARIFF){
+        handle_tariff_push(payload);
         return ;
     }
 
-    try{
-        nlohmann::json content = nlohmann::json::parse(payload);
-        int cmd = content["cmd"];
-        std::string timestamp = content["timestamp"];
-        std::string device_id = content["device_id"];
+    // 每条下行命令一个跟踪ID，从网络线程收到报文开始
+    TraceSpan span("mqtt.receive", Trace::next_id());
 
-        if(device_id != DEVICE_ID){
-            log_e("device id not match: %s",device_id.c_str());
+    // 网络线程只负责入队，解析与设备动作在命令流水线中完成
+    if(!command_pipeline->submit(topic, payload)){
+        log_e("command queue full, drop:%s content:%s",topic.c_str(),payload.c_str());
+    }
+}
+
+void execute_command(const Command &command) {
 
-            return;
+    log_i("receive:%s cmd:%d device_id:%s",command.topic.c_str(),command.cmd,command.device_id.c_str());
+
+    // 同一device_id的命令总在同一个执行线程上串行执行
+    if(!runtime->dispatch(command)){
+        log_e("device id not match: %s",command.device_id.c_str());
+    }
+}
+
+void init_runtime(size_t connector_count, int sample_hz, const SiteBudget::Limits& site_limits){
+    runtime.reset(new StationRuntime(prices,
+        [](const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+            push_mqtt_msg(topic, content, qos, retain);
+        }));
+    for (size_t i = 0; i < connector_count; i++) {
+        Connector& connector = runtime->add_connector(make_connector_id(i),
+                                                      std::unique_ptr<DeviceBase>(new Device()));
+        if (!price_table_loaded) {
+            connector.set_status(DEVICE_STATUS_ERROR_CONFIG);
         }
-        if(topic == MSG(CMD)){
-            if(cmd == DEVICE_CMD_REMOTE_START){
-                log_i("start");
-                if(!check_start_condition(START_TYPE_REMOTE)){
-                    log_e("check_start_condition failed");
-                    send_result(cmd,RESULT_FAIL,"self check failed");
-                    return;
-                }
-                else{
-
-                    std::lock_guard<std::mutex> lock(charge_info_mutex);
-                    charge_info.clear();
-                    charge_info.start_time = "";
-                    charge_info.start_type = START_TYPE_REMOTE;
-                    charge_info.describe = "remote start";
-                    timer->restart();
-                    
-                }
-                
-            }
-            if(cmd == DEVICE_CMD_COMMERCIAL_START){
-                log_i("start");
-                
-                if(!check_start_condition(START_TYPE_COMMERCIAL)){
-                    log_e("check_start_condition failed");
-                    send_result(cmd,RESULT_FAIL,"self check failed");
-                    return;
-                }
-                else{
-                    std::lock_guard<std::mutex> lock(charge_info_mutex);
-                    charge_info.clear();
-                    charge_info.start_time = "";
-                    charge_info.start_type = START_TYPE_COMMERCIAL;
-                    charge_info.describe = "commercial start";
-                    timer->restart();
-                }
+    }
+    runtime->set_site_limits(site_limits);
+    // 设备动作（自检、启动、停止）由设备线程异步执行，命令执行线程不等待设备
+    runtime->enable_async_devices(std::min<size_t>(connector_count, 4));
+    // 自检结果60秒内有效，空闲连接器45秒后在后台重新自检，启动命令通常无需等待自检
+    SelfCheckCache::Options self_check;
+    self_check.valid_ms = 60000;
+    self_check.refresh_ms = 45000;
+    runtime->set_self_check_cache(self_check);
+    size_t recovered = runtime->enable_journal(JOURNAL_DIR);
+    if (recovered > 0) {
+        log_w("recovered %zu charging session(s) from %s",recovered,JOURNAL_DIR);
+    }
+    size_t worker_count = std::max(1u, std::min(4u, std::thread::hardware_concurrency()));
+    runtime->start(worker_count, std::chrono::milliseconds(1000 / sample_hz));
+    log_i("init runtime success, connectors:%zu workers:%zu sample:%dHz site limit:%.1fkW/%u sessions (0=unlimited)",
+          runtime->connector_count(),runtime->worker_count(),sample_hz,
+          site_limits.power_kw,site_limits.max_sessions);
+}
+
+void init_command_pipeline(size_t executor_count){
+    command_pipeline.reset(new CommandPipeline(executor_count));
+    command_pipeline->set_executor(execute_command);
+    command_pipeline->set_error_handler([](const std::string& topic, const std::string& error) {
+        log_e("json parse error: %s",error.c_str());
+    });
+    command_pipeline->start();
+    log_i("init command pipeline success");
+}
+
+void print_pipeline_stats(){
+    CommandPipeline::Statistics stats = command_pipeline->get_statistics();
+    auto us = [](std::chrono::nanoseconds ns) {
+        return static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::microseconds>(ns).count());
+    };
+    log_i("pipeline queue:%lluus/%lluus parse:%lluus/%lluus dispatch:%lluus/%lluus execute:%lluus/%lluus (avg/max) count:%llu dropped:%llu errors:%llu",
+          us(stats.queue_wait.average()), us(stats.queue_wait.max),
+          us(stats.parse.average()), us(stats.parse.max),
+          us(stats.dispatch_wait.average()), us(stats.dispatch_wait.max),
+          us(stats.execute.average()), us(stats.execute.max),
+          static_cast<unsigned long long>(stats.execute.count),
+          static_cast<unsigned long long>(stats.dropped),
+          static_cast<unsigned long long>(stats.parse_errors));
+    DeviceExecutor::Statistics device = runtime->device_executor()->get_statistics();
+    log_i("device executed:%llu timeout:%llu late:%llu rejected:%llu max queue:%lldus max elapsed:%lldus",
+          static_cast<unsigned long long>(device.executed),
+          static_cast<unsigned long long>(device.timeouts),
+          static_cast<unsigned long long>(device.late),
+          static_cast<unsigned long long>(device.rejected),
+          static_cast<long long>(device.max_queued_us),
+          static_cast<long long>(device.max_elapsed_us));
+    SelfCheckCache::Statistics self_check = runtime->self_check_statistics();
+    log_i("self check cached:%llu run:%llu background:%llu failed:%llu stale:%llu max:%lldus",
+          static_cast<unsigned long long>(self_check.hits),
+          static_cast<unsigned long long>(self_check.checks),
+          static_cast<unsigned long long>(self_check.refreshes),
+          static_cast<unsigned long long>(self_check.failures),
+          static_cast<unsigned long long>(self_check.stale),
+          static_cast<long long>(self_check.max_check_us));
+    OutboundQueue::Statistics outbound = outbound_queue.get_statistics();
+    log_i("outbound pushed:%llu sent:%llu pending:%zu pool hit:%llu miss:%llu pooled:%zu",
+          static_cast<unsigned long long>(outbound.pushed),
+          static_cast<unsigned long long>(outbound.drained),
+          outbound.pending,
+          static_cast<unsigned long long>(outbound.pool_hits),
+          static_cast<unsigned long long>(outbound.pool_misses),
+          outbound.pooled);
+}
+
+void init_event_source(){
+    if (pipe(event_pipe) != 0) {
+        log_e("create event pipe failed");
+        return;
+    }
+    for (int fd : event_pipe) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    }
+}
+
+// 唤醒主循环（可在信号处理函数中调用）
+void notify_main_loop(){
+    if (event_pipe[1] >= 0) {
+        char c = 1;
+        ssize_t n = write(event_pipe[1], &c, 1);
+        (void)n;
+    }
+}
+
+// 阻塞直到有事件或到达截止时间
+void wait_main_loop_event(std::chrono::steady_clock::time_point deadline){
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    if (left > 0) {
+        struct pollfd pfd;
+        pfd.fd = event_pipe[0];
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+        if (event_pipe[0] < 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(left));
+        } else if (poll(&pfd, 1, static_cast<int>(left) + 1) > 0) {
+            char buf[64];
+            while (read(event_pipe[0], buf, sizeof(buf)) > 0) {
             }
-            else if(cmd == DEVICE_CMD_STOP){
-                log_i("stop");
-                timer->stop();
-                set_device_status(DEVICE_STATUS_STOP);
-                clear_device_status(DEVICE_STATUS_START);
-                clear_device_status(DEVICE_STATUS_BUSY);
-                device->Stop();
-                send_result(cmd,RESULT_OK);
-
-            } 
         }
+    }
+    main_loop_wakeups++;
+}
 
-    }catch(const std::exception& e){
-        log_e("json parse error: %s",e.what());
-        return;
+void dump_trace(int format){
+    static int dump_count = 0;
+    Trace::Snapshot snapshot = Trace::snapshot();
+    char path[64];
+    snprintf(path, sizeof(path), "trace-%d-%d.%s", static_cast<int>(getpid()), ++dump_count,
+             format == 2 ? "bin" : "json");
+    bool ok = format == 2 ? Trace::write_binary(snapshot, path)
+                          : Trace::write_chrome_json(snapshot, path);
+    size_t records = 0;
+    for (const auto& thread : snapshot.threads) {
+        records += thread.records.size();
+    }
+    if (ok) {
+        log_i("trace dumped to %s: %zu threads, %zu records, %llu overwritten",
+              path, snapshot.threads.size(), records,
+              static_cast<unsigned long long>(snapshot.overwritten));
+    } else {
+        log_e("trace dump to %s failed", path);
+    }
+}
+
+void print_wakeup_stats(){
+    static uint64_t last_main = 0;
+    static uint64_t last_mqtt = 0;
+    uint64_t main_wakeups = main_loop_wakeups.load();
+    uint64_t mqtt_wakeups = client.get_wakeup_count();
+    log_i("wakeups/min main:%llu mqtt:%llu",
+          static_cast<unsigned long long>(main_wakeups - last_main),
+          static_cast<unsigned long long>(mqtt_wakeups - last_mqtt));
+    last_main = main_wakeups;
+    last_mqtt = mqtt_wakeups;
+}
+
+void init_price_table(){
+    if (prices.load_file(CONFIG_PATH) == PriceStore::RELOAD_OK) {
+        prices.current()->table.print_all();
+    } else {
+        log_w("加载价格表失败！%s", prices.last_error().c_str());
+        price_table_loaded = false;
     }
+}
 
+void init_price_watcher(){
+    price_watcher.reset(new PriceWatcher(prices, CONFIG_PATH, on_price_reload));
+    if (!price_watcher->start()) {
+        log_w("监视价格文件失败，电价只能通过推送更新: %s", CONFIG_PATH);
+    }
 }
 
-void init_price_table(PriceTable &table){
-    if (!table.load(CONFIG_PATH)) {
-        log_w("加载价格表失败！");
-        set_device_status(DEVICE_STATUS_ERROR_CONFIG);
+// 监视线程或网络线程调用
+void on_price_reload(PriceStore::ReloadResult result, const PriceSnapshotPtr& snapshot){
+    if (result == PriceStore::RELOAD_ERROR) {
+        log_e("电价更新失败（%s），继续使用 v%llu", prices.last_error().c_str(),
+              static_cast<unsigned long long>(snapshot->version));
+        return;
+    }
+    if (result == PriceStore::RELOAD_UNCHANGED) {
+        return;
+    }
+    log_i("电价更新为 v%llu（来源 %s），进行中的会话从下一分钟起按新电价计费",
+          static_cast<unsigned long long>(snapshot->version), snapshot->source.c_str());
+    // 启动时加载失败的配置错误随有效电价一起解除
+    runtime->clear_status(DEVICE_STATUS_ERROR_CONFIG);
+}
+
+void handle_tariff_push(const std::string& payload){
+    PriceStore::ReloadResult result = prices.load_text(payload, TOPIC_TARIFF);
+    on_price_reload(result, prices.current());
+    if (result != PriceStore::RELOAD_OK) {
+        return;
+    }
+    // 原样写回价格文件（先写临时文件再改名），重启后仍使用推送的电价；监视线程随后读到相同内容不会重复发布。
+    // 推送内容可以是JSON或tariffc编译的镜像，加载时按文件头区分
+    std::string tmp_path = std::string(CONFIG_PATH) + ".tmp";
+    FILE* file = fopen(tmp_path.c_str(), "w");
+    bool written = file && fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+    if (file) {
+        written = fclose(file) == 0 && written;
+    }
+    if (!written || rename(tmp_path.c_str(), CONFIG_PATH) != 0) {
+        log_w("推送的电价未能写回 %s", CONFIG_PATH);
+        unlink(tmp_path.c_str());
     }
 }
 
@@ -490,11 +515,17 @@ bool init_network(MQTTClientV2 & client){
         // 设置回调函数
         client.set_connect_callback([](bool success, const std::string& reason) {
             if (success) {
-                log_e("mqtt 连接成功");
-                clear_device_status(DEVICE_STATUS_ONLINE);
+                log_i("mqtt 连接成功");
+                network_online = true;
+                if (runtime) {
+                    runtime->set_status(DEVICE_STATUS_ONLINE);
+                }
             } else {
                 log_e("mqtt 连接失败");
-                set_device_status(DEVICE_STATUS_ONLINE);
+                network_online = false;
+                if (runtime) {
+                    runtime->clear_status(DEVICE_STATUS_ONLINE);
+                }
             }
         });
         
@@ -523,73 +554,3 @@ bool init_network(MQTTClientV2 & client){
         return true;
 
     }
-
-
-
-void init_timer(){
-
-    // 创建定时器
-    timer = std::make_unique<Timer>();
-    
-    // 配置定时器参数
-    timer->setParameters(
-        std::chrono::milliseconds(1000),                                // 间隔1000ms
-        Timer::Mode::LOOP,                // 重复
-        charge_timer_callback, // 回调函数
-        -1                                   // 重复次数
-    );
-    // 启动定时器
-    log_i("init timer success");
-
-}
-
-
-
-void send_heatbeat(){
-    MQTTClientV2::PublishOptions pub_opts;
-    pub_opts.qos = 1;
-    pub_opts.retain = false;
-    nlohmann::json content;
-    content["status"] = DEVICE_STATUS;
-    content["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-                                std::chrono::system_clock::now().time_since_epoch()).count();
-    content["device_id"] = DEVICE_ID;
-    content["describe"] = "heartbeat";
-    std::string heartbeat = content.dump();
-    //push_mqtt_msg(MQTT_MSG(MSG(HEARTBEAT), content, pub_opts.qos, pub_opts.retain));
-    client.publish(MSG(HEARTBEAT), heartbeat, pub_opts);
-}
-
-void send_result(int cmd,int result,string describe ){
-
-    MQTTClientV2::PublishOptions pub_opts;
-    pub_opts.qos = 1;
-    pub_opts.retain = false;
-    nlohmann::json content;
-    content["cmd"] = cmd;
-    content["result"] = result;
-    content["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-                                std::chrono::system_clock::now().time_since_epoch()).count();
-    content["device_id"] = DEVICE_ID;
-    content["describe"] = describe;
-    push_mqtt_msg(MQTT_MSG(MSG(STATUS), content, pub_opts.qos, pub_opts.retain));
-    //client.publish(MSG(STATUS), content.dump(), pub_opts);
-    log_i("send:%s  content:%s",string(MSG(STATUS)).c_str(),content.dump().c_str());
-}
-void send_charge_info(const ChargeInfo &charge_info){
-    MQTTClientV2::PublishOptions pub_opts;
-    pub_opts.qos = 1;
-    pub_opts.retain = false;
-    nlohmann::json content;
-    content["cmd"] = DEVICE_CMD_CHARGE_INFO;
-    content["result"] = RESULT_OK;
-    content["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
-                                std::chrono::system_clock::now().time_since_epoch()).count();
-    content["device_id"] = DEVICE_ID;
-    content["describe"] = "charge info";
-    nlohmann::json charge_info_json = charge_info;
-    content["charge_info"] = charge_info_json;
-    push_mqtt_msg(MQTT_MSG(MSG(STATUS), content, pub_opts.qos, pub_opts.retain));
-    //client.publish(MSG(STATUS), content.dump(), pub_opts);
-    log_i("send:%s  content:%s",string(MSG(STATUS)).c_str(),content.dump().c_str());
-}
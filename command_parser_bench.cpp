@@ -0,0 +1,87 @@
+#include "station/command_parser.hpp"
+#include "nlohmann/json.hpp"
+#include <iostream>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+#include <atomic>
+
+// 统计堆分配次数
+static std::atomic<unsigned long long> g_allocations(0);
+
+void* operator new(std::size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+// 旧路径：构建完整DOM后取字段（与原msg_handle一致）
+static bool parse_command_dom(const std::string& payload, Command& command, std::string& error) {
+    try {
+        nlohmann::json content = nlohmann::json::parse(payload);
+        command.cmd = content["cmd"];
+        command.timestamp = content["timestamp"].get<std::string>();
+        command.device_id = content["device_id"].get<std::string>();
+    } catch (const std::exception& e) {
+        error = e.what();
+        return false;
+    }
+    return true;
+}
+
+template <typename Parser>
+static void run(const char* name, const std::vector<std::string>& payloads, int iterations, Parser parse) {
+    Command command;
+    std::string error;
+    unsigned long long failures = 0;
+    unsigned long long before = g_allocations.load();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        if (!parse(payloads[i % payloads.size()], command, error)) failures++;
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unsigned long long allocations = g_allocations.load() - before;
+
+    std::cout << "  " << name << ": " << static_cast<long long>(iterations / elapsed) << " 条/秒, "
+              << elapsed * 1e9 / iterations << " ns/条, "
+              << static_cast<double>(allocations) / iterations << " 次分配/条"
+              << (failures ? ", 失败 " + std::to_string(failures) : std::string()) << std::endl;
+}
+
+int main(int argc, char** argv) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+    // 典型下行命令报文
+    const std::vector<std::string> payloads = {
+        R"({"cmd":1,"timestamp":"1718000000","device_id":"0000-00001"})",
+        R"({"cmd":2,"timestamp":"1718000001","device_id":"0000-00001","user_id":"u-20240610-0042",)"
+        R"("order_id":"ORD202406101234567890","params":{"max_power":7.0,"max_energy":30.5,"tags":["vip","night"]}})",
+        "{\n  \"device_id\": \"0000-00001\",\n  \"cmd\": 3,\n  \"timestamp\": \"1718000002\",\n  \"reason\": \"user stop\"\n}",
+    };
+
+    std::cout << "=== 命令解析性能对比 (" << iterations << " 条) ===" << std::endl;
+    run("DOM (nlohmann::json::parse)", payloads, iterations, parse_command_dom);
+    run("模式扫描 (parse_command)  ", payloads, iterations,
+        [](const std::string& payload, Command& command, std::string& error) {
+            return parse_command(payload, command, error);
+        });
+
+    // 错误位置示例
+    std::cout << "\n=== 错误定位 ===" << std::endl;
+    const char* bad[] = {
+        R"({"cmd":1,"timestamp":"1718000000" "device_id":"0000-00001"})",
+        R"({"cmd":"1","timestamp":"1718000000","device_id":"0000-00001"})",
+        "{\"cmd\":1,\n\"timestamp\":\"1718000000\"}",
+    };
+    for (const char* payload : bad) {
+        Command command;
+        std::string error;
+        parse_command(payload, command, error);
+        std::cout << "  " << payload << "\n    -> " << error << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,105 @@
+#include "price_store.hpp"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+PriceStore::PriceStore() : current_(std::make_shared<PriceSnapshot>()), version_(0) {
+}
+
+namespace {
+
+// 镜像快照的内容标识
+std::string image_key(uint32_t checksum) {
+    char key[32];
+    snprintf(key, sizeof(key), "tariff-image:%08x", checksum);
+    return key;
+}
+
+}  // namespace
+
+PriceStore::ReloadResult PriceStore::load_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        last_error_ = "无法打开价格表文件: " + path;
+        return RELOAD_ERROR;
+    }
+    char magic[8] = {};
+    in.read(magic, sizeof(magic));
+    if (PriceTable::is_image(magic, static_cast<size_t>(in.gcount()))) {
+        // 二进制镜像直接映射，不读入内存
+        in.close();
+        std::lock_guard<std::mutex> lock(write_mutex_);
+        std::shared_ptr<PriceSnapshot> snapshot = std::make_shared<PriceSnapshot>();
+        if (!snapshot->table.map_image(path)) {
+            last_error_ = snapshot->table.error();
+            return RELOAD_ERROR;
+        }
+        snapshot->text = image_key(snapshot->table.image_checksum());
+        return publish(std::move(snapshot), path);
+    }
+    in.clear();
+    in.seekg(0);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return load_text(buffer.str(), path);
+}
+
+PriceStore::ReloadResult PriceStore::load_text(const std::string& text, const std::string& source) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    std::shared_ptr<PriceSnapshot> snapshot = std::make_shared<PriceSnapshot>();
+    if (PriceTable::is_image(text.data(), text.size())) {
+        // 推送的镜像：复制一份由快照持有，表原地使用
+        std::shared_ptr<std::string> image = std::make_shared<std::string>(text);
+        if (!snapshot->table.load_image(image->data(), image->size(), image)) {
+            last_error_ = snapshot->table.error();
+            return RELOAD_ERROR;
+        }
+        snapshot->text = image_key(snapshot->table.image_checksum());
+        return publish(std::move(snapshot), source);
+    }
+    PriceSnapshotPtr old = std::atomic_load(&current_);
+    if (old->version != 0 && old->text == text) {
+        return RELOAD_UNCHANGED;
+    }
+    if (!snapshot->table.parse(text)) {
+        last_error_ = snapshot->table.error();
+        return RELOAD_ERROR;
+    }
+    snapshot->text = text;
+    return publish(std::move(snapshot), source);
+}
+
+// 调用者持有write_mutex_
+PriceStore::ReloadResult PriceStore::publish(std::shared_ptr<PriceSnapshot> snapshot, const std::string& source) {
+    PriceSnapshotPtr old = std::atomic_load(&current_);
+    if (old->version != 0 && old->text == snapshot->text) {
+        return RELOAD_UNCHANGED;
+    }
+    snapshot->version = old->version + 1;
+    snapshot->source = source;
+    std::atomic_store(&current_, PriceSnapshotPtr(std::move(snapshot)));
+    // 先替换快照再递增版本：读者看到新版本时一定能取到新快照
+    version_.store(old->version + 1, std::memory_order_release);
+    return RELOAD_OK;
+}
+
+bool PriceStore::refresh_utc_offset(time_t now) const {
+    return current()->table.refresh_utc_offset(now);
+}
+
+std::string PriceStore::last_error() const {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    return last_error_;
+}
+
+const char* PriceStore::describe(ReloadResult result) {
+    switch (result) {
+        case RELOAD_OK:
+            return "reloaded";
+        case RELOAD_UNCHANGED:
+            return "unchanged";
+        default:
+            return "parse error";
+    }
+}
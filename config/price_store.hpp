@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "price_table.hpp"
+
+/**
+ * @brief 不可变电价快照
+ *
+ * 发布后只读，持有者（如进行中的会话）可在电价更新后继续使用旧快照。
+ */
+struct PriceSnapshot {
+    PriceTable table;
+    uint64_t version = 0;  // 从1开始递增，0表示尚未加载
+    std::string source;    // 来源：文件路径或推送主题
+    std::string text;      // 原始JSON或镜像校验和，用于判断内容是否变化
+};
+
+using PriceSnapshotPtr = std::shared_ptr<const PriceSnapshot>;
+
+/**
+ * @brief 可热更新的电价表（RCU方式）
+ *
+ * 更新时在旁边构造完整的新快照，再原子地替换共享指针；正在使用旧快照的读者不受影响，
+ * 最后一个持有者释放时旧快照才被回收。
+ * 读者先比较version()（一次原子读），只有版本变化时才取current()，热路径上不加锁。
+ * 写者之间串行；解析失败或内容未变化时不发布新版本。
+ * 文件与推送内容都可以是JSON或tariffc编译的二进制镜像（按文件头区分），镜像文件直接mmap。
+ */
+class PriceStore {
+public:
+    enum ReloadResult {
+        RELOAD_OK = 0,
+        RELOAD_UNCHANGED,
+        RELOAD_ERROR,
+    };
+
+    PriceStore();
+
+    PriceStore(const PriceStore&) = delete;
+    PriceStore& operator=(const PriceStore&) = delete;
+
+    PriceSnapshotPtr current() const { return std::atomic_load(&current_); }
+    uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+    ReloadResult load_file(const std::string& path);
+    ReloadResult load_text(const std::string& text, const std::string& source);
+
+    // 刷新当前快照缓存的UTC偏移（夏令时切换），偏移变化时返回true
+    bool refresh_utc_offset(time_t now = time(nullptr)) const;
+
+    static const char* describe(ReloadResult result);
+    // 最近一次RELOAD_ERROR的原因（如时段重叠的位置）
+    std::string last_error() const;
+
+private:
+    ReloadResult publish(std::shared_ptr<PriceSnapshot> snapshot, const std::string& source);
+
+    mutable std::mutex write_mutex_;
+    std::string last_error_;
+    PriceSnapshotPtr current_;
+    std::atomic<uint64_t> version_;
+};
@@ -3,73 +3,539 @@
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
 
 using json = nlohmann::json;
 
+namespace {
+
+// 公历日期与自1970-01-01的天数互换（H. Hinnant算法）
+int64_t days_from_civil(int64_t y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int64_t era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int64_t>(doe) - 719468;
+}
+
+void civil_from_days(int64_t z, int64_t& y, unsigned& m, unsigned& d) {
+    z += 719468;
+    const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    d = doy - (153 * mp + 2) / 5 + 1;
+    m = mp < 10 ? mp + 3 : mp - 9;
+    y = static_cast<int64_t>(yoe) + era * 400 + (m <= 2);
+}
+
+// "YYYY-MM-DD"
+int64_t parse_date(const std::string& text) {
+    int y = 0, m = 0, d = 0;
+    if (sscanf(text.c_str(), "%d-%d-%d", &y, &m, &d) != 3 || m < 1 || m > 12 || d < 1 || d > 31) {
+        throw std::invalid_argument("日期格式错误: " + text);
+    }
+    return days_from_civil(y, static_cast<unsigned>(m), static_cast<unsigned>(d));
+}
+
+// "MM-DD" -> MMDD
+int parse_month_day(const std::string& text) {
+    int m = 0, d = 0;
+    if (sscanf(text.c_str(), "%d-%d", &m, &d) != 2 || m < 1 || m > 12 || d < 1 || d > 31) {
+        throw std::invalid_argument("月日格式错误: " + text);
+    }
+    return m * 100 + d;
+}
+
+std::string format_minutes(int minutes) {
+    char text[24];  // 两个int各至多11个字符
+    snprintf(text, sizeof(text), "%02d:%02d", minutes / 60, minutes % 60);
+    return text;
+}
+
+std::string format_day(int64_t day) {
+    int64_t y = 0;
+    unsigned m = 0, d = 0;
+    civil_from_days(day, y, m, d);
+    char text[24];
+    snprintf(text, sizeof(text), "%04lld-%02u-%02u", static_cast<long long>(y), m, d);
+    return text;
+}
+
+}  // namespace
+
+const size_t PriceTable::kCostBlock;
+
+PriceTable::PriceTable()
+    : days_(1), period_prices_(nullptr), period_count_(0), minute_periods_(nullptr), minute_prices_(nullptr),
+      image_checksum_(0), day_cache_misses_(0), utc_offset_s_(0), fixed_offset_(false) {
+    days_[0].name = "default";
+    normalize(days_[0], 0, error_);
+    compile();
+    refresh_utc_offset();
+}
+
 int PriceTable::time_str_to_minutes(const std::string& tstr) {
-    int h = 0, m = 0;
-    sscanf(tstr.c_str(), "%d:%d", &h, &m);
+    int h = 0, m = 0, n = 0;
+    if (sscanf(tstr.c_str(), "%d:%d%n", &h, &m, &n) != 2 || n != static_cast<int>(tstr.size()) ||
+        h < 0 || h > 24 || m < 0 || m > 59 || (h == 24 && m != 0)) {
+        return -1;
+    }
     return h * 60 + m;
 }
 
+bool PriceTable::fail(const std::string& error) {
+    error_ = error;
+    std::cerr << error << std::endl;
+    return false;
+}
+
 bool PriceTable::load(const std::string& json_path) {
     std::ifstream in(json_path);
     if (!in) {
-        std::cerr << "无法打开价格表文件: " << json_path << std::endl;
+        return fail("无法打开价格表文件: " + json_path);
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    if (!parse(buffer.str())) {
         return false;
     }
-    json j;
-    in >> j;
-    price_list_.clear();
-    for (const auto& item : j["price_list"]) {
-        PricePeriod p;
-        p.start_minutes = time_str_to_minutes(item["start"]);
-        p.end_minutes = time_str_to_minutes(item["end"]);
-        p.price = item["price"];
-        p.service_fee = item["service_fee"];
-        price_list_.push_back(p);
+    print_all();
+    return true;
+}
+
+bool PriceTable::parse(const std::string& json_text) {
+    json j = json::parse(json_text, nullptr, false);
+    if (j.is_discarded() || !j.is_object()) {
+        return fail("价格表格式错误: 不是有效的JSON对象");
     }
-    other_price_ = j.value("other_price", 0.0);
-    other_service_fee_ = j.value("other_service_fee", 0.0);
+    auto parse_schedule = [](const json& item, DaySchedule& day) {
+        for (const auto& period : item.at("price_list")) {
+            PricePeriod p;
+            const std::string start = period.at("start");
+            const std::string end = period.at("end");
+            p.start_minutes = time_str_to_minutes(start);
+            p.end_minutes = time_str_to_minutes(end);
+            if (p.start_minutes < 0 || p.end_minutes < 0) {
+                throw std::invalid_argument(day.name + ": 第" + std::to_string(day.periods.size() + 1) +
+                                            "项时间格式错误: " + start + "-" + end);
+            }
+            p.price = period.at("price");
+            p.service_fee = period.at("service_fee");
+            day.periods.push_back(p);
+        }
+        day.other_price = item.value("other_price", 0.0);
+        day.other_service_fee = item.value("other_service_fee", 0.0);
+    };
 
-    print_all();
+    std::vector<DaySchedule> days(1);
+    std::vector<CalendarRule> rules;
+    std::vector<int64_t> holidays;
+    try {
+        days[0].name = "default";
+        parse_schedule(j, days[0]);
+        if (j.contains("day_types")) {
+            for (auto it = j.at("day_types").begin(); it != j.at("day_types").end(); ++it) {
+                days.emplace_back();
+                days.back().name = it.key();
+                parse_schedule(it.value(), days.back());
+            }
+        }
+        size_t periods = 0;
+        for (DaySchedule& day : days) {
+            std::string error;
+            if (!normalize(day, static_cast<int>(periods), error)) {
+                throw std::invalid_argument(error);
+            }
+            periods += day.periods.size() + 1;
+        }
+        if (periods > kMaxPeriods) {
+            throw std::invalid_argument("时段总数超过" + std::to_string(kMaxPeriods));
+        }
+        if (j.contains("holidays")) {
+            for (const auto& date : j.at("holidays")) {
+                holidays.push_back(parse_date(date));
+            }
+            std::sort(holidays.begin(), holidays.end());
+            holidays.erase(std::unique(holidays.begin(), holidays.end()), holidays.end());
+        }
+        if (j.contains("rules")) {
+            for (const auto& item : j.at("rules")) {
+                CalendarRule rule;
+                const std::string name = item.at("day_type");
+                auto day = std::find_if(days.begin(), days.end(),
+                                        [&name](const DaySchedule& d) { return d.name == name; });
+                if (day == days.end()) {
+                    throw std::invalid_argument("未定义的日程: " + name);
+                }
+                rule.day_type = static_cast<int>(day - days.begin());
+                if (item.contains("weekdays")) {
+                    rule.weekdays = 0;
+                    for (int weekday : item.at("weekdays")) {
+                        if (weekday < 0 || weekday > 6) {
+                            throw std::invalid_argument("星期须为0-6（0为星期日）");
+                        }
+                        rule.weekdays |= static_cast<uint8_t>(1 << weekday);
+                    }
+                }
+                rule.holiday = item.value("holiday", false);
+                if (item.contains("season")) {
+                    rule.season_from = parse_month_day(item.at("season").at(0));
+                    rule.season_to = parse_month_day(item.at("season").at(1));
+                }
+                if (item.contains("from")) {
+                    rule.from_day = parse_date(item.at("from"));
+                }
+                if (item.contains("to")) {
+                    rule.to_day = parse_date(item.at("to"));
+                }
+                rules.push_back(rule);
+            }
+        }
+    } catch (const std::exception& e) {
+        return fail(std::string("价格表格式错误: ") + e.what());
+    }
+    days_.swap(days);
+    rules_.swap(rules);
+    holidays_.swap(holidays);
+    compile();
+    refresh_utc_offset();
+    error_.clear();
     return true;
 }
 
-double PriceTable::get_price(time_t unix_time) const {
-    struct tm tm_time;
-    localtime_r(&unix_time, &tm_time);
-    int minutes = tm_time.tm_hour * 60 + tm_time.tm_min;
-    for (const auto& p : price_list_) {
-        if (p.start_minutes <= minutes && minutes < p.end_minutes) {
-            return p.price + p.service_fee;
+bool PriceTable::normalize(DaySchedule& day, int base, std::string& error) {
+    struct Segment {
+        int start;
+        int end;
+        size_t item;  // price_list下标
+    };
+    auto describe = [&day](size_t item) {
+        const PricePeriod& p = day.periods[item];
+        return "第" + std::to_string(item + 1) + "项(" + format_minutes(p.start_minutes) + "-" +
+               format_minutes(p.end_minutes) + ")";
+    };
+    auto valid_rate = [](double price, double service_fee) {
+        return std::isfinite(price) && std::isfinite(service_fee) && price >= 0 && service_fee >= 0;
+    };
+    if (!valid_rate(day.other_price, day.other_service_fee)) {
+        error = day.name + ": 其他时段电价或服务费无效";
+        return false;
+    }
+    // 跨午夜的时段拆成两段
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < day.periods.size(); i++) {
+        const PricePeriod& p = day.periods[i];
+        if (p.start_minutes >= kMinutesPerDay) {
+            error = day.name + ": " + describe(i) + "开始时间须早于24:00";
+            return false;
+        }
+        if (p.start_minutes == p.end_minutes) {
+            error = day.name + ": " + describe(i) + "长度为0";
+            return false;
+        }
+        if (!valid_rate(p.price, p.service_fee)) {
+            error = day.name + ": " + describe(i) + "电价或服务费无效";
+            return false;
+        }
+        if (p.start_minutes < p.end_minutes) {
+            segments.push_back({p.start_minutes, p.end_minutes, i});
+        } else {
+            segments.push_back({p.start_minutes, kMinutesPerDay, i});
+            if (p.end_minutes > 0) {
+                segments.push_back({0, p.end_minutes, i});
+            }
+        }
+    }
+    std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) {
+        return a.start != b.start ? a.start < b.start : a.item < b.item;
+    });
+    // 按开始时间排序后，之前的段互不重叠，只需与前一段比较
+    for (size_t k = 1; k < segments.size(); k++) {
+        const Segment& prev = segments[k - 1];
+        const Segment& cur = segments[k];
+        if (cur.start < prev.end) {
+            error = day.name + ": " + describe(std::min(prev.item, cur.item)) + "与" +
+                    describe(std::max(prev.item, cur.item)) + "在" + format_minutes(cur.start) + "-" +
+                    format_minutes(std::min(prev.end, cur.end)) + "重叠";
+            return false;
+        }
+    }
+
+    // 依次分配时段ID（空档先记为-1）；与前一区间首尾相接且费率相同的条目并入前一时段
+    const int gap = -1;
+    std::vector<int> id_of_item(day.periods.size(), gap);
+    std::vector<PricePeriod> periods;
+    std::vector<PriceInterval> intervals;
+    int cursor = 0;
+    for (const Segment& seg : segments) {
+        if (seg.start > cursor) {
+            intervals.push_back({cursor, seg.start, gap});
+        }
+        const PricePeriod& p = day.periods[seg.item];
+        int id = id_of_item[seg.item];
+        if (id == gap) {
+            if (!intervals.empty() && intervals.back().period != gap && intervals.back().end_minutes == seg.start &&
+                periods[intervals.back().period].price == p.price &&
+                periods[intervals.back().period].service_fee == p.service_fee) {
+                id = intervals.back().period;
+            } else {
+                id = static_cast<int>(periods.size());
+                periods.push_back(p);
+            }
+            id_of_item[seg.item] = id;
+        }
+        if (!intervals.empty() && intervals.back().period == id && intervals.back().end_minutes == seg.start) {
+            intervals.back().end_minutes = seg.end;
+        } else {
+            intervals.push_back({seg.start, seg.end, id});
+        }
+        cursor = seg.end;
+    }
+    if (cursor < kMinutesPerDay) {
+        intervals.push_back({cursor, kMinutesPerDay, gap});
+    }
+
+    // 每个时段是一个区间，跨午夜的是[0,x)与[y,1440)两个区间，记为y-x
+    std::vector<bool> seen(periods.size(), false);
+    for (PriceInterval& interval : intervals) {
+        if (interval.period == gap) {
+            interval.period = static_cast<int>(periods.size());
+        } else {
+            PricePeriod& p = periods[interval.period];
+            if (!seen[interval.period]) {
+                p.end_minutes = interval.end_minutes;
+            }
+            p.start_minutes = interval.start_minutes;
+            seen[interval.period] = true;
         }
+        interval.period += base;
     }
-    // 不在任何时间段
-    return other_price_ + other_service_fee_;
+    day.periods.swap(periods);
+    day.intervals.swap(intervals);
+    day.base = base;
+    return true;
 }
 
-double PriceTable::get_price(int hour) const {
-    int minutes = hour * 60;
-    for (const auto& p : price_list_) {
+void PriceTable::compile() {
+    own_period_prices_.clear();
+    own_minute_periods_.assign(days_.size() * kMinutesPerDay, 0);
+    own_minute_prices_.assign(days_.size() * kMinutesPerDay, 0.0);
+    for (size_t d = 0; d < days_.size(); d++) {
+        const DaySchedule& day = days_[d];
+        for (const PricePeriod& p : day.periods) {
+            own_period_prices_.push_back(p.price + p.service_fee);
+        }
+        own_period_prices_.push_back(day.other_price + day.other_service_fee);
+
+        uint16_t* minute_period = &own_minute_periods_[d * kMinutesPerDay];
+        double* minute_price = &own_minute_prices_[d * kMinutesPerDay];
+        for (const PriceInterval& interval : day.intervals) {
+            for (int m = interval.start_minutes; m < interval.end_minutes; m++) {
+                minute_period[m] = static_cast<uint16_t>(interval.period);
+                minute_price[m] = own_period_prices_[interval.period];
+            }
+        }
+    }
+    period_prices_ = own_period_prices_.data();
+    period_count_ = own_period_prices_.size();
+    minute_periods_ = own_minute_periods_.data();
+    minute_prices_ = own_minute_prices_.data();
+    image_.reset();
+    image_checksum_ = 0;
+    clear_day_cache();
+}
+
+void PriceTable::clear_day_cache() {
+    for (size_t i = 0; i < kDayCacheSlots; i++) {
+        day_cache_[i].store(0, std::memory_order_relaxed);
+    }
+    day_cache_misses_.store(0, std::memory_order_relaxed);
+}
+
+int PriceTable::resolve_day(int64_t day) const {
+    int64_t year = 0;
+    unsigned month = 0, mday = 0;
+    civil_from_days(day, year, month, mday);
+    const int month_day = static_cast<int>(month * 100 + mday);
+    const int weekday = static_cast<int>(((day % 7) + 11) % 7);  // 1970-01-01为星期四
+    const bool holiday = std::binary_search(holidays_.begin(), holidays_.end(), day);
+
+    int day_type = 0;
+    for (const CalendarRule& rule : rules_) {
+        if (!((rule.weekdays >> weekday) & 1) || (rule.holiday && !holiday) ||
+            day < rule.from_day || day > rule.to_day) {
+            continue;
+        }
+        if (rule.season_from) {
+            bool in_season = rule.season_from <= rule.season_to
+                                 ? month_day >= rule.season_from && month_day <= rule.season_to
+                                 : month_day >= rule.season_from || month_day <= rule.season_to;
+            if (!in_season) {
+                continue;
+            }
+        }
+        day_type = rule.day_type;
+        break;
+    }
+    if (day >= 0) {
+        uint64_t entry = (static_cast<uint64_t>(day + 1) << 16) | static_cast<uint64_t>(day_type);
+        day_cache_[static_cast<uint64_t>(day) % kDayCacheSlots].store(entry, std::memory_order_relaxed);
+    }
+    day_cache_misses_.fetch_add(1, std::memory_order_relaxed);
+    return day_type;
+}
 
-        if (p.start_minutes <= minutes && minutes < p.end_minutes) {
-            return p.price + p.service_fee;
+// 一块样本的计费：kFull时块长为常数kCostBlock，循环次数固定，便于编译器向量化
+template <bool kFull>
+void PriceTable::cost_block(const int64_t* t, const double* e, size_t count, double sum[4]) const {
+    const size_t m = kFull ? kCostBlock : count;
+    int64_t lo = t[0], hi = t[0];
+    for (size_t i = 0; i < m; i++) {
+        lo = t[i] < lo ? t[i] : lo;
+        hi = t[i] > hi ? t[i] : hi;
+    }
+    // 偏移按块两端的时刻取；夏令时一年只切换两次，32天内首尾相同即整块相同
+    const int64_t offset = utc_offset_at(lo);
+    const int64_t origin_day = local_day(lo + offset);
+    const int64_t span_days = local_day(hi + offset) - origin_day + 1;
+    if (span_days > kCostBlockDays || utc_offset_at(hi) != offset) {
+        // 乱序、跨度很大或跨越夏令时切换的块：逐点按各自时刻的偏移查询
+        for (size_t i = 0; i < m; i++) {
+            sum[0] += e[i] * minute_prices_[minute_index(t[i] + utc_offset_at(t[i]))];
         }
+        return;
+    }
+    // 块内每天的日程只求值一次
+    uint32_t day_base[kCostBlockDays];
+    for (int d = 0; d < span_days; d++) {
+        day_base[d] = static_cast<uint32_t>(day_type_of(origin_day + d) * kMinutesPerDay);
+    }
+    // 相对块起点当地0点的秒数不超过32天，32位无分支换算
+    const int64_t origin = origin_day * 86400 - offset;
+    uint32_t index[kCostBlock];
+    for (size_t i = 0; i < m; i++) {
+        uint32_t rel = static_cast<uint32_t>(t[i] - origin);
+        uint32_t day = rel / 86400;
+        index[i] = day_base[day] + (rel - day * 86400) / 60;
+    }
+    const double* prices = minute_prices_;
+    double s0 = sum[0], s1 = sum[1], s2 = sum[2], s3 = sum[3];
+    size_t i = 0;
+    for (; i + 4 <= m; i += 4) {
+        s0 += e[i] * prices[index[i]];
+        s1 += e[i + 1] * prices[index[i + 1]];
+        s2 += e[i + 2] * prices[index[i + 2]];
+        s3 += e[i + 3] * prices[index[i + 3]];
+    }
+    // kCostBlock是4的倍数，整块没有余数
+    for (; !kFull && i < m; i++) {
+        s0 += e[i] * prices[index[i]];
+    }
+    sum[0] = s0;
+    sum[1] = s1;
+    sum[2] = s2;
+    sum[3] = s3;
+}
+
+double PriceTable::cost(const TimeSeries& series) const {
+    const size_t n = series.size();
+    const int64_t* t = series.unix_s.data();
+    const double* e = series.kwh.data();
+    double sum[4] = {0, 0, 0, 0};
+    size_t begin = 0;
+    for (; begin + kCostBlock <= n; begin += kCostBlock) {
+        cost_block<true>(t + begin, e + begin, kCostBlock, sum);
+    }
+    if (begin < n) {
+        cost_block<false>(t + begin, e + begin, n - begin, sum);
     }
+    return (sum[0] + sum[1]) + (sum[2] + sum[3]);
+}
+
+int64_t PriceTable::utc_offset_at(int64_t unix_time) const {
+    if (fixed_offset_.load(std::memory_order_relaxed)) {
+        return utc_offset_s_.load(std::memory_order_relaxed);
+    }
+    time_t at = static_cast<time_t>(unix_time);
+    struct tm tm_time;
+    localtime_r(&at, &tm_time);
+    return tm_time.tm_gmtoff;
+}
+
+bool PriceTable::refresh_utc_offset(time_t now) const {
+    struct tm tm_time;
+    localtime_r(&now, &tm_time);
+    int32_t offset = static_cast<int32_t>(tm_time.tm_gmtoff);
+    fixed_offset_.store(false, std::memory_order_relaxed);
+    return utc_offset_s_.exchange(offset, std::memory_order_relaxed) != offset;
+}
+
+double PriceTable::get_price(int hour) const {
+    if (hour < 0 || hour >= 24) {
+        return period_prices_[other_period()];
+    }
+    return minute_prices_[hour * 60];
+}
+
+int PriceTable::period_at_minute(int minute_of_day) const {
+    if (minute_of_day < 0 || minute_of_day >= kMinutesPerDay) {
+        return other_period();
+    }
+    return minute_periods_[minute_of_day];
+}
+
+double PriceTable::period_price(int period) const {
+    if (period >= 0 && period < static_cast<int>(period_count_)) {
+        return period_prices_[period];
+    }
+    return period_prices_[other_period()];
 }
 
 void PriceTable::print_all() const {
     std::cout << "充电桩价格表:" << std::endl;
-    for (const auto& p : price_list_) {
-        int sh = p.start_minutes / 60, sm = p.start_minutes % 60;
-        int eh = p.end_minutes / 60, em = p.end_minutes % 60;
-        std::cout << std::setfill('0')
-                  << "时段: " << std::setw(2) << sh << ":" << std::setw(2) << sm
-                  << " - " << std::setw(2) << eh << ":" << std::setw(2) << em
-                  << "  电价: " << p.price
-                  << "  服务费: " << p.service_fee
-                  << std::endl;
-    }
-    std::cout << "其他时段: 电价: " << other_price_ << "  服务费: " << other_service_fee_ << std::endl;
+    for (const DaySchedule& day : days_) {
+        if (days_.size() > 1) {
+            std::cout << "[" << day.name << "]" << std::endl;
+        }
+        for (const auto& p : day.periods) {
+            int sh = p.start_minutes / 60, sm = p.start_minutes % 60;
+            int eh = p.end_minutes / 60, em = p.end_minutes % 60;
+            std::cout << std::setfill('0')
+                      << "时段: " << std::setw(2) << sh << ":" << std::setw(2) << sm
+                      << " - " << std::setw(2) << eh << ":" << std::setw(2) << em
+                      << "  电价: " << p.price
+                      << "  服务费: " << p.service_fee
+                      << std::endl;
+        }
+        std::cout << "其他时段: 电价: " << day.other_price << "  服务费: " << day.other_service_fee << std::endl;
+    }
+    if (!holidays_.empty()) {
+        std::cout << "节假日: " << holidays_.size() << " 天" << std::endl;
+    }
+    for (const CalendarRule& rule : rules_) {
+        std::cout << "规则: " << days_[rule.day_type].name;
+        if (rule.weekdays != 0x7F) {
+            std::cout << " 星期";
+            for (int w = 0; w < 7; w++) {
+                if ((rule.weekdays >> w) & 1) std::cout << w;
+            }
+        }
+        if (rule.holiday) std::cout << " 节假日";
+        if (rule.season_from) {
+            std::cout << " 每年" << std::setfill('0') << std::setw(2) << rule.season_from / 100 << "-"
+                      << std::setw(2) << rule.season_from % 100 << "~" << std::setw(2) << rule.season_to / 100
+                      << "-" << std::setw(2) << rule.season_to % 100;
+        }
+        if (rule.from_day != INT64_MIN || rule.to_day != INT64_MAX) {
+            std::cout << " 日期范围 " << (rule.from_day != INT64_MIN ? format_day(rule.from_day) : "")
+                      << "~" << (rule.to_day != INT64_MAX ? format_day(rule.to_day) : "");
+        }
+        std::cout << std::endl;
+    }
 }
@@ -1,31 +1,213 @@
- #pragma once
+#pragma once
 #include <string>
 #include <vector>
 #include <ctime>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include "time_series.hpp"
 
 struct PricePeriod {
     int start_minutes; // 0-1439
-    int end_minutes;   // 0-1439
+    int end_minutes;   // 1-1440，小于start_minutes时跨午夜
     double price;
     double service_fee;
 };
 
+// 归一化后的区间：按开始时间排序，首尾相接覆盖全天
+struct PriceInterval {
+    int start_minutes;
+    int end_minutes;
+    int period;        // 全局时段ID，空档为所在日程的"其他时段"
+};
+
+/**
+ * @brief 分时电价表（支持日历规则）
+ *
+ * price.json顶层的price_list/other_price为默认日程；可选的day_types定义其他日程（工作日、周末、
+ * 节假日、夏季等），rules按顺序把日期映射到日程（星期、日期范围、每年的月日范围、节假日日历），
+ * 第一条匹配的规则生效，都不匹配时用默认日程：
+ *
+ *   "day_types": {"weekend": {"price_list": [...], "other_price": 0.5, "other_service_fee": 0.1}},
+ *   "holidays": ["2024-10-01", "2024-10-02"],
+ *   "rules": [{"day_type": "weekend", "holiday": true},
+ *             {"day_type": "weekend", "weekdays": [0, 6], "season": ["06-01", "08-31"]},
+ *             {"day_type": "weekend", "from": "2024-02-10", "to": "2024-02-17"}]
+ *
+ * load时每个日程编译成每分钟一项的查找表（时段ID与price+service_fee）；某天使用哪个日程由规则求值得出，
+ * 结果缓存在按日期直接映射的无锁缓存中（多个计量线程共享，不加锁），查询为一次缓存命中加一次下标访问。
+ * 时段ID在所有日程间连续编号：默认日程的price_list下标在前（other_period()紧随其后），
+ * 其余日程按名称顺序依次排列，每个日程最后一个ID为其"其他时段"。
+ * 加载时逐个日程归一化：校验时间与电价，结束早于开始的时段视为跨午夜，按开始时间排序，
+ * 首尾相接且电价、服务费都相同的时段合并为一个，空档以other_price补齐；时段之间重叠时拒绝加载，
+ * error()给出日程、条目序号与重叠的时间范围。时段ID按归一化后的顺序编号，
+ * 对已排序、无重叠、无可合并项的price_list与条目顺序相同。
+ * 逐点查询按缓存的UTC偏移换算本地时间，不调用localtime_r，夏令时切换后需调用refresh_utc_offset()；
+ * 批量计费cost()面向历史数据，每块样本按其所在时刻的偏移换算，跨夏令时的序列也按当时的偏移计费。
+ * set_utc_offset()固定偏移（如按固定时区重算），此后逐点与批量都使用该值，refresh_utc_offset()恢复跟随本地时区。
+ *
+ * 也可以从tariffc编译的二进制镜像加载（格式见tariff_image.cpp）：分钟表与时段电价直接使用映射的内存，
+ * 不解析JSON、不打印，只校验头部与校验和。
+ */
 class PriceTable {
 public:
-    // 加载price.json
+    static const int kMinutesPerDay = 1440;
+    static const size_t kDayCacheSlots = 64;  // 连续64天内的日期不会互相替换
+    static const size_t kMaxPeriods = 256;    // 所有日程的时段总数上限（计量账本按1字节记录时段ID）
+    static const size_t kCostBlock = 256;     // 批量计费每块的样本数
+    static const int kCostBlockDays = 32;     // 块内跨度超过该天数时逐点查询
+
+    PriceTable();
+
+    PriceTable(const PriceTable&) = delete;
+    PriceTable& operator=(const PriceTable&) = delete;
+
+    // 加载price.json并打印
     bool load(const std::string& json_path);
+    // 从JSON文本加载（不打印），格式错误时返回false且不修改当前内容
+    bool parse(const std::string& json_text);
+
+    // 二进制镜像：data以"CSTARIFF"开头
+    static bool is_image(const void* data, size_t size);
+    // 写入镜像（先写临时文件再改名，已映射该文件的进程不受影响）
+    bool write_image(const std::string& path) const;
+    // mmap镜像后原地使用；校验失败时返回false且不修改当前内容
+    bool map_image(const std::string& path);
+    // 原地使用内存中的镜像，owner须保证data在表的生命周期内有效（至少8字节对齐）
+    bool load_image(const void* data, size_t size, std::shared_ptr<const void> owner);
+    // 加载的镜像的校验和，从JSON加载时为0
+    uint32_t image_checksum() const { return image_checksum_; }
+    // 最近一次加载失败的原因
+    const std::string& error() const { return error_; }
 
     // 传入unix时间戳，返回当前电价（price+service_fee）
-    double get_price(time_t unix_time) const;
+    double get_price(time_t unix_time) const {
+        int64_t local = local_seconds(unix_time);
+        return minute_prices_[minute_index(local)];
+    }
+    // 批量计费：Σ kwh[i] × 电价(unix_s[i])，每块按样本时刻的UTC偏移换算；固定偏移时结果与逐点get_price
+    // 累加一致（求和顺序不同，误差在舍入级）
+    // 按块处理：块内时刻换算为相对秒后一次性算出分钟表下标，再集中取价累加，适合重算大量历史会话
+    double cost(const TimeSeries& series) const;
+
+    // 默认日程的整点电价，hour超出0-23时返回其他时段电价
     double get_price(int hour) const;
-    // 打印所有时间段电价及服务费
+
+    // 电价时段ID，不在任何时段时为所在日程的"其他时段"
+    int period_at(time_t unix_time) const {  // 按本地时间
+        int64_t local = local_seconds(unix_time);
+        return minute_periods_[minute_index(local)];
+    }
+    int period_at_minute(int minute_of_day) const;  // 默认日程，0-1439
+    size_t period_count() const { return period_count_; }
+    int other_period() const { return static_cast<int>(days_[0].periods.size()); }  // 默认日程
+    // 时段电价（price+service_fee）
+    double period_price(int period) const;
+    // 日程归一化后的区间
+    const std::vector<PriceInterval>& intervals(int day_type = 0) const { return days_[day_type].intervals; }
+
+    // 日程：0为默认日程
+    size_t day_type_count() const { return days_.size(); }
+    const std::string& day_type_name(int day_type) const { return days_[day_type].name; }
+    int day_type_at(time_t unix_time) const { return day_type_of(local_day(local_seconds(unix_time))); }
+
+    // 本地时间的当日分钟数（0-1439）
+    int minute_of_day(time_t unix_time) const { return minute_of(local_seconds(unix_time)); }
+
+    // 按now所在时刻重新读取本地时区的UTC偏移并恢复跟随本地时区，偏移变化时返回true
+    bool refresh_utc_offset(time_t now = time(nullptr)) const;
+    // 固定UTC偏移，不再随夏令时变化
+    void set_utc_offset(int32_t seconds) const {
+        utc_offset_s_.store(seconds, std::memory_order_relaxed);
+        fixed_offset_.store(true, std::memory_order_relaxed);
+    }
+    int32_t utc_offset() const { return utc_offset_s_.load(std::memory_order_relaxed); }
+
+    // 日程求值的缓存统计
+    uint64_t day_cache_misses() const { return day_cache_misses_.load(std::memory_order_relaxed); }
+
+    // 打印所有日程、时间段电价及服务费与日历规则
     void print_all() const;
 
 private:
-    std::vector<PricePeriod> price_list_;
-    double other_price_ = 0.0;
-    double other_service_fee_ = 0.0;
+    struct DaySchedule {
+        std::string name;
+        std::vector<PricePeriod> periods;       // 归一化后
+        std::vector<PriceInterval> intervals;
+        double other_price = 0.0;
+        double other_service_fee = 0.0;
+        int base = 0;  // 第一个时段的全局ID
+    };
+
+    // 所有给出的条件都满足时匹配
+    struct CalendarRule {
+        int day_type = 0;
+        uint8_t weekdays = 0x7F;       // 按位，0为星期日
+        bool holiday = false;          // 须在节假日日历中
+        int season_from = 0;           // 每年的月日范围MMDD，可跨年（如1101-0228），0表示不限
+        int season_to = 0;
+        int64_t from_day = INT64_MIN;  // 绝对日期范围（自1970-01-01的天数），含两端
+        int64_t to_day = INT64_MAX;
+    };
+
+    std::vector<DaySchedule> days_;       // days_[0]为默认日程
+    std::vector<CalendarRule> rules_;
+    std::vector<int64_t> holidays_;       // 有序
+    // 查询用的表，指向下面自有的存储或映射的镜像
+    const double* period_prices_;     // 全局时段ID -> 电价
+    size_t period_count_;
+    const uint16_t* minute_periods_;  // 编译后的分钟表，所有日程首尾相连：下标为 日程*1440 + 当日分钟
+    const double* minute_prices_;
+    std::vector<double> own_period_prices_;
+    std::vector<uint16_t> own_minute_periods_;
+    std::vector<double> own_minute_prices_;
+    std::shared_ptr<const void> image_;  // 映射的镜像
+    uint32_t image_checksum_;
+    std::string error_;
+
+    mutable std::atomic<uint64_t> day_cache_[kDayCacheSlots];  // (日期+1)<<16 | 日程，0为空
+    mutable std::atomic<uint64_t> day_cache_misses_;
+    mutable std::atomic<int32_t> utc_offset_s_;  // 缓存，发布后的只读表也可刷新
+    mutable std::atomic<bool> fixed_offset_;     // set_utc_offset固定了偏移
+
+    int64_t local_seconds(time_t unix_time) const {
+        return static_cast<int64_t>(unix_time) + utc_offset_s_.load(std::memory_order_relaxed);
+    }
+    static int64_t local_day(int64_t local) {
+        return local >= 0 ? local / 86400 : (local - 86399) / 86400;
+    }
+    static int minute_of(int64_t local) {
+        int64_t second_of_day = local % 86400;
+        if (second_of_day < 0) {
+            second_of_day += 86400;
+        }
+        return static_cast<int>(second_of_day / 60);
+    }
+    size_t minute_index(int64_t local) const {
+        return static_cast<size_t>(day_type_of(local_day(local))) * kMinutesPerDay + minute_of(local);
+    }
+    int day_type_of(int64_t day) const {
+        if (rules_.empty()) {
+            return 0;
+        }
+        uint64_t entry = day_cache_[static_cast<uint64_t>(day) % kDayCacheSlots].load(std::memory_order_relaxed);
+        if (day >= 0 && (entry >> 16) == static_cast<uint64_t>(day + 1)) {
+            return static_cast<int>(entry & 0xFFFF);
+        }
+        return resolve_day(day);
+    }
+    // unix_time时刻的UTC偏移：固定偏移时为缓存值，否则按本地时区（localtime_r）
+    int64_t utc_offset_at(int64_t unix_time) const;
+    template <bool kFull>
+    void cost_block(const int64_t* t, const double* e, size_t count, double sum[4]) const;
+    int resolve_day(int64_t day) const;  // 规则求值并写入缓存（1970年以前的日期不缓存）
+    void compile();
+    void clear_day_cache();
+    bool fail(const std::string& error);
+
+    // 排序、校验并合并day.periods，生成覆盖全天的区间，时段ID从base开始；失败时error给出原因
+    static bool normalize(DaySchedule& day, int base, std::string& error);
 
-    // 辅助：将"HH:MM"转为分钟
+    // 辅助：将"HH:MM"（00:00-24:00）转为分钟，格式错误时返回-1
     static int time_str_to_minutes(const std::string& tstr);
 };
@@ -0,0 +1,90 @@
+#include "price_watcher.hpp"
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cstring>
+
+PriceWatcher::PriceWatcher(PriceStore& store, const std::string& path, Callback callback)
+    : store_(store), path_(path), callback_(std::move(callback)), inotify_fd_(-1), running_(false) {
+    stop_pipe_[0] = stop_pipe_[1] = -1;
+    size_t slash = path_.find_last_of('/');
+    dir_ = slash == std::string::npos ? "." : (slash == 0 ? "/" : path_.substr(0, slash));
+    name_ = slash == std::string::npos ? path_ : path_.substr(slash + 1);
+}
+
+PriceWatcher::~PriceWatcher() {
+    stop();
+}
+
+bool PriceWatcher::start() {
+    if (running_) {
+        return true;
+    }
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ < 0) {
+        return false;
+    }
+    if (inotify_add_watch(inotify_fd_, dir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 ||
+        pipe2(stop_pipe_, O_NONBLOCK | O_CLOEXEC) != 0) {
+        close(inotify_fd_);
+        inotify_fd_ = -1;
+        return false;
+    }
+    running_ = true;
+    thread_ = std::thread(&PriceWatcher::run, this);
+    return true;
+}
+
+void PriceWatcher::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    char byte = 0;
+    ssize_t ignored = write(stop_pipe_[1], &byte, 1);
+    (void)ignored;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    close(inotify_fd_);
+    close(stop_pipe_[0]);
+    close(stop_pipe_[1]);
+    inotify_fd_ = -1;
+    stop_pipe_[0] = stop_pipe_[1] = -1;
+}
+
+void PriceWatcher::run() {
+    alignas(struct inotify_event) char buffer[4096];
+    struct pollfd fds[2];
+    fds[0].fd = inotify_fd_;
+    fds[0].events = POLLIN;
+    fds[1].fd = stop_pipe_[0];
+    fds[1].events = POLLIN;
+    while (running_) {
+        if (poll(fds, 2, -1) <= 0) {
+            continue;
+        }
+        if (fds[1].revents) {
+            break;
+        }
+        // 一批事件中目标文件出现多次时只重新加载一次
+        bool changed = false;
+        ssize_t n;
+        while ((n = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+            for (char* p = buffer; p < buffer + n;) {
+                const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+                if (event->len > 0 && name_ == event->name) {
+                    changed = true;
+                }
+                p += sizeof(struct inotify_event) + event->len;
+            }
+        }
+        if (!changed) {
+            continue;
+        }
+        PriceStore::ReloadResult result = store_.load_file(path_);
+        if (callback_) {
+            callback_(result, store_.current());
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+#include <atomic>
+#include <functional>
+#include <string>
+#include <thread>
+#include "price_store.hpp"
+
+/**
+ * @brief 价格文件监视器
+ *
+ * 用inotify监视price.json所在目录（编辑器常以"写临时文件再改名"的方式保存），
+ * 目标文件写完关闭或被改名替换时重新加载到PriceStore。
+ * 回调在监视线程中执行。
+ */
+class PriceWatcher {
+public:
+    using Callback = std::function<void(PriceStore::ReloadResult result, const PriceSnapshotPtr& snapshot)>;
+
+    PriceWatcher(PriceStore& store, const std::string& path, Callback callback = nullptr);
+    ~PriceWatcher();
+
+    PriceWatcher(const PriceWatcher&) = delete;
+    PriceWatcher& operator=(const PriceWatcher&) = delete;
+
+    bool start();
+    void stop();
+
+private:
+    void run();
+
+    PriceStore& store_;
+    const std::string path_;
+    std::string dir_;
+    std::string name_;
+    Callback callback_;
+    int inotify_fd_;
+    int stop_pipe_[2];
+    std::atomic<bool> running_;
+    std::thread thread_;
+};
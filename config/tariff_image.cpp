@@ -0,0 +1,331 @@
+#include "price_table.hpp"
+#include "tools/checksum/crc32.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * 二进制电价镜像（小端，本机字节序写入，头部记录字节序标记）
+ *
+ *   头部64字节 | 日程 | 时段 | 规则 | 节假日 | 时段电价 | 分钟电价 | 分钟时段ID | 日程名
+ *
+ * 各段紧接排列、按8字节对齐，长度只由头部的计数决定，不需要偏移表。
+ * checksum是头部之后全部字节的CRC-32；格式不兼容地变化时递增kImageVersion。
+ * 分钟表与时段电价加载后原地使用，其余各段很小，解码到PriceTable的成员中；
+ * 加载时重新归一化时段，并与分钟表、时段电价逐项核对，之后的查询不再做范围检查。
+ */
+
+namespace {
+
+const char kImageMagic[8] = {'C', 'S', 'T', 'A', 'R', 'I', 'F', 'F'};
+const uint32_t kImageVersion = 1;
+const uint32_t kByteOrderMark = 0x01020304;
+const size_t kHeaderSize = 64;
+
+struct ImageHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t file_size;
+    uint32_t checksum;
+    uint32_t day_count;
+    uint32_t period_count;   // 全局时段数，含每个日程的"其他时段"
+    uint32_t rule_count;
+    uint32_t holiday_count;
+    uint32_t name_bytes;
+    char padding[kHeaderSize - 48];
+};
+static_assert(sizeof(ImageHeader) == kHeaderSize, "tariff image header must be 64 bytes");
+
+struct ImageDay {
+    uint32_t name_offset;    // 在日程名段中的偏移
+    uint32_t name_length;
+    uint32_t first_period;   // 在时段段中的下标
+    uint32_t period_count;   // 不含"其他时段"
+    double other_price;
+    double other_service_fee;
+};
+static_assert(sizeof(ImageDay) == 32, "tariff image day must be 32 bytes");
+
+struct ImagePeriod {
+    int32_t start_minutes;
+    int32_t end_minutes;
+    double price;
+    double service_fee;
+};
+static_assert(sizeof(ImagePeriod) == 24, "tariff image period must be 24 bytes");
+
+struct ImageRule {
+    int32_t day_type;
+    int32_t season_from;
+    int32_t season_to;
+    uint8_t weekdays;
+    uint8_t holiday;
+    uint8_t reserved[2];
+    int64_t from_day;
+    int64_t to_day;
+};
+static_assert(sizeof(ImageRule) == 32, "tariff image rule must be 32 bytes");
+
+size_t align8(size_t size) {
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+// 各段相对文件开头的偏移
+struct ImageLayout {
+    size_t days, periods, rules, holidays, period_prices, minute_prices, minute_periods, names, total;
+
+    ImageLayout(size_t day_count, size_t defined_periods, size_t rule_count, size_t holiday_count,
+                size_t name_bytes) {
+        const size_t period_count = defined_periods + day_count;
+        const size_t minutes = day_count * PriceTable::kMinutesPerDay;
+        days = kHeaderSize;
+        periods = days + align8(day_count * sizeof(ImageDay));
+        rules = periods + align8(defined_periods * sizeof(ImagePeriod));
+        holidays = rules + align8(rule_count * sizeof(ImageRule));
+        period_prices = holidays + align8(holiday_count * sizeof(int64_t));
+        minute_prices = period_prices + align8(period_count * sizeof(double));
+        minute_periods = minute_prices + align8(minutes * sizeof(double));
+        names = minute_periods + align8(minutes * sizeof(uint16_t));
+        total = names + align8(name_bytes);
+    }
+};
+
+std::string invalid(const char* reason) {
+    return std::string("电价镜像无效: ") + reason;
+}
+
+}  // namespace
+
+bool PriceTable::is_image(const void* data, size_t size) {
+    return size >= sizeof(kImageMagic) && std::memcmp(data, kImageMagic, sizeof(kImageMagic)) == 0;
+}
+
+bool PriceTable::write_image(const std::string& path) const {
+    size_t defined_periods = 0;
+    std::string names;
+    for (const DaySchedule& day : days_) {
+        defined_periods += day.periods.size();
+        names += day.name;
+    }
+    const ImageLayout layout(days_.size(), defined_periods, rules_.size(), holidays_.size(), names.size());
+    std::vector<char> image(layout.total, 0);
+    char* base = image.data();
+
+    ImageDay* days = reinterpret_cast<ImageDay*>(base + layout.days);
+    ImagePeriod* periods = reinterpret_cast<ImagePeriod*>(base + layout.periods);
+    uint32_t name_offset = 0, first_period = 0;
+    for (size_t d = 0; d < days_.size(); d++) {
+        const DaySchedule& day = days_[d];
+        days[d].name_offset = name_offset;
+        days[d].name_length = static_cast<uint32_t>(day.name.size());
+        days[d].first_period = first_period;
+        days[d].period_count = static_cast<uint32_t>(day.periods.size());
+        days[d].other_price = day.other_price;
+        days[d].other_service_fee = day.other_service_fee;
+        for (const PricePeriod& p : day.periods) {
+            ImagePeriod& out = periods[first_period++];
+            out.start_minutes = p.start_minutes;
+            out.end_minutes = p.end_minutes;
+            out.price = p.price;
+            out.service_fee = p.service_fee;
+        }
+        name_offset += days[d].name_length;
+    }
+    ImageRule* rules = reinterpret_cast<ImageRule*>(base + layout.rules);
+    for (size_t i = 0; i < rules_.size(); i++) {
+        rules[i].day_type = rules_[i].day_type;
+        rules[i].season_from = rules_[i].season_from;
+        rules[i].season_to = rules_[i].season_to;
+        rules[i].weekdays = rules_[i].weekdays;
+        rules[i].holiday = rules_[i].holiday ? 1 : 0;
+        rules[i].from_day = rules_[i].from_day;
+        rules[i].to_day = rules_[i].to_day;
+    }
+    const size_t minutes = days_.size() * kMinutesPerDay;
+    std::memcpy(base + layout.holidays, holidays_.data(), holidays_.size() * sizeof(int64_t));
+    std::memcpy(base + layout.period_prices, period_prices_, period_count_ * sizeof(double));
+    std::memcpy(base + layout.minute_prices, minute_prices_, minutes * sizeof(double));
+    std::memcpy(base + layout.minute_periods, minute_periods_, minutes * sizeof(uint16_t));
+    std::memcpy(base + layout.names, names.data(), names.size());
+
+    ImageHeader* header = reinterpret_cast<ImageHeader*>(base);
+    std::memcpy(header->magic, kImageMagic, sizeof(kImageMagic));
+    header->version = kImageVersion;
+    header->byte_order = kByteOrderMark;
+    header->file_size = layout.total;
+    header->day_count = static_cast<uint32_t>(days_.size());
+    header->period_count = static_cast<uint32_t>(period_count_);
+    header->rule_count = static_cast<uint32_t>(rules_.size());
+    header->holiday_count = static_cast<uint32_t>(holidays_.size());
+    header->name_bytes = static_cast<uint32_t>(names.size());
+    header->checksum = crc32(base + kHeaderSize, layout.total - kHeaderSize);
+
+    const std::string tmp_path = path + ".tmp";
+    FILE* file = fopen(tmp_path.c_str(), "wb");
+    bool written = file && fwrite(base, 1, image.size(), file) == image.size();
+    if (file) {
+        written = fclose(file) == 0 && written;
+    }
+    if (!written || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::cerr << "写入电价镜像失败: " << path << ": " << std::strerror(errno) << std::endl;
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool PriceTable::map_image(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return fail("无法打开电价镜像: " + path);
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+        close(fd);
+        return fail(invalid("文件过短"));
+    }
+    const size_t size = static_cast<size_t>(st.st_size);
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return fail("映射电价镜像失败: " + path + ": " + std::strerror(errno));
+    }
+    // 映射随最后一个引用释放；文件被改名替换后旧映射仍然有效
+    std::shared_ptr<const void> owner(map, [size](const void* p) { munmap(const_cast<void*>(p), size); });
+    return load_image(map, size, std::move(owner));
+}
+
+bool PriceTable::load_image(const void* data, size_t size, std::shared_ptr<const void> owner) {
+    const char* base = static_cast<const char*>(data);
+    if (size < kHeaderSize || !is_image(data, size)) {
+        return fail(invalid("缺少文件头"));
+    }
+    if (reinterpret_cast<uintptr_t>(base) % 8 != 0) {
+        return fail(invalid("内存未按8字节对齐"));
+    }
+    const ImageHeader* header = reinterpret_cast<const ImageHeader*>(base);
+    if (header->version != kImageVersion) {
+        return fail(invalid("格式版本不支持"));
+    }
+    if (header->byte_order != kByteOrderMark) {
+        return fail(invalid("字节序不一致"));
+    }
+    if (header->file_size != size) {
+        return fail(invalid("文件长度与头部不符"));
+    }
+    if (header->day_count == 0 || header->period_count > kMaxPeriods ||
+        header->period_count < header->day_count) {
+        return fail(invalid("日程或时段数超出范围"));
+    }
+    // 计数有界之后再算布局，避免溢出
+    if (header->rule_count > size || header->holiday_count > size || header->name_bytes > size) {
+        return fail(invalid("文件长度与头部不符"));
+    }
+    const size_t defined_periods = header->period_count - header->day_count;
+    const ImageLayout layout(header->day_count, defined_periods, header->rule_count,
+                             header->holiday_count, header->name_bytes);
+    if (layout.total != size) {
+        return fail(invalid("文件长度与头部不符"));
+    }
+    if (crc32(base + kHeaderSize, size - kHeaderSize) != header->checksum) {
+        return fail(invalid("校验和错误"));
+    }
+
+    // 解码小段，同时检查下标，之后的查询不再做范围检查
+    const ImageDay* image_days = reinterpret_cast<const ImageDay*>(base + layout.days);
+    const ImagePeriod* image_periods = reinterpret_cast<const ImagePeriod*>(base + layout.periods);
+    const char* names = base + layout.names;
+    std::vector<DaySchedule> days(header->day_count);
+    size_t next_period = 0;
+    for (size_t d = 0; d < days.size(); d++) {
+        const ImageDay& in = image_days[d];
+        if (in.first_period != next_period || in.period_count > defined_periods - next_period ||
+            in.name_offset > header->name_bytes || in.name_length > header->name_bytes - in.name_offset) {
+            return fail(invalid("日程表损坏"));
+        }
+        days[d].name.assign(names + in.name_offset, in.name_length);
+        days[d].other_price = in.other_price;
+        days[d].other_service_fee = in.other_service_fee;
+        days[d].base = static_cast<int>(next_period + d);
+        for (uint32_t i = 0; i < in.period_count; i++) {
+            const ImagePeriod& p = image_periods[next_period + i];
+            days[d].periods.push_back({p.start_minutes, p.end_minutes, p.price, p.service_fee});
+        }
+        next_period += in.period_count;
+        // 写入的时段已经归一化，重新归一化得到区间并确认时段不变
+        std::string error;
+        const size_t count = days[d].periods.size();
+        if (!normalize(days[d], days[d].base, error) || days[d].periods.size() != count) {
+            return fail(invalid("时段未归一化"));
+        }
+    }
+    if (next_period != defined_periods) {
+        return fail(invalid("日程表损坏"));
+    }
+    const ImageRule* image_rules = reinterpret_cast<const ImageRule*>(base + layout.rules);
+    std::vector<CalendarRule> rules(header->rule_count);
+    for (size_t i = 0; i < rules.size(); i++) {
+        const ImageRule& in = image_rules[i];
+        if (in.day_type < 0 || in.day_type >= static_cast<int32_t>(header->day_count)) {
+            return fail(invalid("规则引用了不存在的日程"));
+        }
+        rules[i].day_type = in.day_type;
+        rules[i].weekdays = in.weekdays;
+        rules[i].holiday = in.holiday != 0;
+        rules[i].season_from = in.season_from;
+        rules[i].season_to = in.season_to;
+        rules[i].from_day = in.from_day;
+        rules[i].to_day = in.to_day;
+    }
+    const int64_t* image_holidays = reinterpret_cast<const int64_t*>(base + layout.holidays);
+    std::vector<int64_t> holidays(image_holidays, image_holidays + header->holiday_count);
+    if (!std::is_sorted(holidays.begin(), holidays.end())) {
+        return fail(invalid("节假日未排序"));
+    }
+    const double* period_prices = reinterpret_cast<const double*>(base + layout.period_prices);
+    const double* minute_prices = reinterpret_cast<const double*>(base + layout.minute_prices);
+    const uint16_t* minute_periods = reinterpret_cast<const uint16_t*>(base + layout.minute_periods);
+    for (const DaySchedule& day : days) {
+        for (size_t i = 0; i <= day.periods.size(); i++) {
+            const double rate = i < day.periods.size() ? day.periods[i].price + day.periods[i].service_fee
+                                                       : day.other_price + day.other_service_fee;
+            if (period_prices[day.base + i] != rate) {
+                return fail(invalid("时段电价与时段不一致"));
+            }
+        }
+    }
+    for (size_t d = 0; d < days.size(); d++) {
+        for (const PriceInterval& interval : days[d].intervals) {
+            for (int m = interval.start_minutes; m < interval.end_minutes; m++) {
+                const size_t i = d * kMinutesPerDay + m;
+                if (minute_periods[i] != interval.period || minute_prices[i] != period_prices[interval.period]) {
+                    return fail(invalid("分钟表与时段不一致"));
+                }
+            }
+        }
+    }
+
+    days_.swap(days);
+    rules_.swap(rules);
+    holidays_.swap(holidays);
+    own_period_prices_.clear();
+    own_minute_periods_.clear();
+    own_minute_prices_.clear();
+    period_prices_ = period_prices;
+    period_count_ = header->period_count;
+    minute_prices_ = minute_prices;
+    minute_periods_ = minute_periods;
+    image_ = std::move(owner);
+    image_checksum_ = header->checksum;
+    clear_day_cache();
+    refresh_utc_offset();
+    error_.clear();
+    return true;
+}
@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief 电量时间序列（列式存储）
+ *
+ * 时间戳与电量分列存放，批量计费时按列顺序扫描、按块向量化处理。
+ * unix_s[i]为第i段电量所在的时刻（UTC秒，按其所在分钟定价），kwh[i]为该段电量。
+ */
+struct TimeSeries {
+    std::vector<int64_t> unix_s;
+    std::vector<double> kwh;
+
+    size_t size() const { return unix_s.size() < kwh.size() ? unix_s.size() : kwh.size(); }
+    bool empty() const { return size() == 0; }
+    void reserve(size_t n) {
+        unix_s.reserve(n);
+        kwh.reserve(n);
+    }
+    void clear() {
+        unix_s.clear();
+        kwh.clear();
+    }
+    void push_back(int64_t unix_time, double energy_kwh) {
+        unix_s.push_back(unix_time);
+        kwh.push_back(energy_kwh);
+    }
+};
@@ -0,0 +1,299 @@
+#include "async_device.hpp"
+#include <algorithm>
+#include <cstdio>
+#include "tools/trace/trace.hpp"
+
+struct DeviceExecutor::Pending {
+    AsyncDevice* owner;
+    AsyncDevice::Job job;
+    AsyncDevice::Completion done;
+    std::chrono::steady_clock::time_point submitted;
+    bool run_after_timeout;
+    bool finished;  // 已投递结果（完成、超时或取消），受mutex_保护
+};
+
+namespace {
+
+int64_t micros_since(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - begin).count();
+}
+
+}  // namespace
+
+DeviceExecutor::DeviceExecutor(size_t thread_count) : running_(true) {
+    thread_count = std::max<size_t>(1, thread_count);
+    for (size_t i = 0; i < thread_count; i++) {
+        workers_.emplace_back([this, i] {
+            char name[32];
+            snprintf(name, sizeof(name), "device-%zu", i);
+            Trace::set_thread_name(name);
+            worker_loop();
+        });
+    }
+    watchdog_ = std::thread([this] {
+        Trace::set_thread_name("device-watchdog");
+        watchdog_loop();
+    });
+}
+
+DeviceExecutor::~DeviceExecutor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_ = false;
+    }
+    work_cv_.notify_all();
+    timer_cv_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+    watchdog_.join();
+}
+
+DeviceExecutor::Statistics DeviceExecutor::get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+// 每次从一个设备取一条命令执行，执行完后设备若还有命令则排到ready_末尾，设备之间轮转
+void DeviceExecutor::worker_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        work_cv_.wait(lock, [this] { return !running_ || !ready_.empty(); });
+        if (!running_) {
+            return;
+        }
+        AsyncDevice* device = ready_.front();
+        ready_.pop_front();
+        // 排队期间已超时的命令直接丢弃（须执行的除外）
+        while (!device->queue_.empty() && device->queue_.front()->finished &&
+               !device->queue_.front()->run_after_timeout) {
+            device->queue_.pop_front();
+        }
+        if (device->queue_.empty()) {
+            device->scheduled_ = false;
+            idle_cv_.notify_all();
+            continue;
+        }
+        std::shared_ptr<Pending> pending = std::move(device->queue_.front());
+        device->queue_.pop_front();
+        device->busy_++;
+        lock.unlock();
+
+        DeviceReply reply;
+        reply.queued_us = micros_since(pending->submitted);
+        pending->job(*device->device_, reply);
+        reply.elapsed_us = micros_since(pending->submitted);
+
+        // 看门狗堆中可能还持有pending，提前释放回调捕获的资源；回调由投递结果的一方释放
+        pending->job = nullptr;
+        lock.lock();
+        bool deliver = !pending->finished;
+        pending->finished = true;
+        if (deliver) {
+            stats_.executed++;
+            stats_.max_queued_us = std::max(stats_.max_queued_us, reply.queued_us);
+            stats_.max_elapsed_us = std::max(stats_.max_elapsed_us, reply.elapsed_us);
+            lock.unlock();
+            pending->done(reply);
+            pending->done = nullptr;
+            lock.lock();
+        } else {
+            stats_.late++;
+        }
+        device->busy_--;
+        if (device->queue_.empty()) {
+            device->scheduled_ = false;
+        } else {
+            ready_.push_back(device);
+            work_cv_.notify_one();
+        }
+        idle_cv_.notify_all();
+    }
+}
+
+// 按截止时间投递超时；执行中的设备调用不受影响，返回后结果被丢弃
+void DeviceExecutor::watchdog_loop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (timers_.empty()) {
+            timer_cv_.wait(lock);
+            continue;
+        }
+        auto now = std::chrono::steady_clock::now();
+        if (timers_.front().deadline > now) {
+            timer_cv_.wait_until(lock, timers_.front().deadline);
+            continue;
+        }
+        std::pop_heap(timers_.begin(), timers_.end());
+        std::shared_ptr<Pending> pending = std::move(timers_.back().pending);
+        timers_.pop_back();
+        if (pending->finished) {
+            continue;
+        }
+        pending->finished = true;
+        AsyncDevice* device = pending->owner;
+        device->busy_++;
+        stats_.timeouts++;
+        lock.unlock();
+
+        DeviceReply reply;
+        reply.result = DEVICE_RESULT_TIMEOUT;
+        reply.elapsed_us = micros_since(pending->submitted);
+        reply.queued_us = reply.elapsed_us;
+        pending->done(reply);
+        pending->done = nullptr;
+
+        lock.lock();
+        device->busy_--;
+        idle_cv_.notify_all();
+    }
+}
+
+AsyncDevice::AsyncDevice(std::unique_ptr<DeviceBase> device, DeviceExecutor* executor, size_t queue_limit)
+    : device_(std::move(device)), executor_(executor), queue_limit_(std::max<size_t>(1, queue_limit)),
+      scheduled_(false), busy_(0), closed_(false) {
+}
+
+AsyncDevice::~AsyncDevice() {
+    close();
+}
+
+void AsyncDevice::set_executor(DeviceExecutor* executor) {
+    executor_ = executor;
+}
+
+size_t AsyncDevice::queued() const {
+    if (!executor_) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(executor_->mutex_);
+    return queue_.size();
+}
+
+bool AsyncDevice::submit(Job job, std::chrono::milliseconds timeout, Completion done, bool run_after_timeout) {
+    if (!executor_) {
+        if (closed_) {
+            return false;
+        }
+        auto submitted = std::chrono::steady_clock::now();
+        DeviceReply reply;
+        job(*device_, reply);
+        reply.elapsed_us = micros_since(submitted);
+        if (timeout.count() > 0 && reply.elapsed_us > timeout.count() * 1000) {
+            reply.result = DEVICE_RESULT_TIMEOUT;
+        }
+        done(reply);
+        return true;
+    }
+
+    std::shared_ptr<DeviceExecutor::Pending> pending(new DeviceExecutor::Pending());
+    pending->owner = this;
+    pending->job = std::move(job);
+    pending->done = std::move(done);
+    pending->submitted = std::chrono::steady_clock::now();
+    pending->run_after_timeout = run_after_timeout;
+    pending->finished = false;
+
+    std::lock_guard<std::mutex> lock(executor_->mutex_);
+    // 排队期间已超时的命令不占队列名额
+    queue_.erase(std::remove_if(queue_.begin(), queue_.end(),
+                                [](const std::shared_ptr<DeviceExecutor::Pending>& p) {
+                                    return p->finished && !p->run_after_timeout;
+                                }),
+                 queue_.end());
+    if (closed_ || queue_.size() >= queue_limit_) {
+        executor_->stats_.rejected++;
+        return false;
+    }
+    queue_.push_back(pending);
+    if (!scheduled_) {
+        scheduled_ = true;
+        executor_->ready_.push_back(this);
+        executor_->work_cv_.notify_one();
+    }
+    if (timeout.count() > 0) {
+        auto& timers = executor_->timers_;
+        timers.push_back(DeviceExecutor::Timer{pending->submitted + timeout, pending});
+        std::push_heap(timers.begin(), timers.end());
+        if (timers.front().pending == pending) {
+            executor_->timer_cv_.notify_one();
+        }
+    }
+    return true;
+}
+
+std::future<DeviceReply> AsyncDevice::call(Job job, std::chrono::milliseconds timeout, bool run_after_timeout) {
+    auto promise = std::make_shared<std::promise<DeviceReply>>();
+    std::future<DeviceReply> future = promise->get_future();
+    if (!submit(std::move(job), timeout, [promise](const DeviceReply& reply) { promise->set_value(reply); },
+                run_after_timeout)) {
+        DeviceReply reply;
+        reply.result = DEVICE_RESULT_BUSY;
+        promise->set_value(reply);
+    }
+    return future;
+}
+
+std::future<DeviceReply> AsyncDevice::start(std::chrono::milliseconds timeout) {
+    return call([](DeviceBase& device, DeviceReply& reply) { reply.value = device.Start() ? 1 : 0; }, timeout);
+}
+
+std::future<DeviceReply> AsyncDevice::stop(std::chrono::milliseconds timeout) {
+    return call([](DeviceBase& device, DeviceReply& reply) { reply.value = device.Stop() ? 1 : 0; }, timeout, true);
+}
+
+std::future<DeviceReply> AsyncDevice::pause(std::chrono::milliseconds timeout) {
+    return call([](DeviceBase& device, DeviceReply& reply) { reply.value = device.Pause() ? 1 : 0; }, timeout);
+}
+
+std::future<DeviceReply> AsyncDevice::self_check(std::chrono::milliseconds timeout) {
+    return call([](DeviceBase& device, DeviceReply& reply) { reply.value = device.SelfCheck(); }, timeout);
+}
+
+std::future<DeviceReply> AsyncDevice::read_power(std::chrono::milliseconds timeout) {
+    return call([](DeviceBase& device, DeviceReply& reply) { reply.power = device.GetPower(); }, timeout);
+}
+
+void AsyncDevice::close() {
+    if (!executor_) {
+        closed_ = true;
+        return;
+    }
+    std::unique_lock<std::mutex> lock(executor_->mutex_);
+    closed_ = true;
+    // 回调中可能再次提交（已关闭，会被拒绝），循环到既无排队也无执行中的命令
+    while (true) {
+        std::vector<std::shared_ptr<DeviceExecutor::Pending>> cancelled;
+        for (auto& pending : queue_) {
+            if (!pending->finished) {
+                pending->finished = true;
+                cancelled.push_back(std::move(pending));
+            }
+        }
+        queue_.clear();
+        if (!cancelled.empty()) {
+            executor_->stats_.cancelled += cancelled.size();
+            busy_++;
+            lock.unlock();
+            DeviceReply reply;
+            reply.result = DEVICE_RESULT_CANCELLED;
+            for (auto& pending : cancelled) {
+                reply.elapsed_us = micros_since(pending->submitted);
+                reply.queued_us = reply.elapsed_us;
+                pending->done(reply);
+                pending->job = nullptr;
+                pending->done = nullptr;
+            }
+            lock.lock();
+            busy_--;
+            continue;
+        }
+        if (busy_ == 0) {
+            break;
+        }
+        executor_->idle_cv_.wait(lock);
+    }
+    auto& ready = executor_->ready_;
+    ready.erase(std::remove(ready.begin(), ready.end(), this), ready.end());
+    scheduled_ = false;
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "devicebase.hpp"
+
+// 异步设备命令的结果
+enum DeviceResult {
+    DEVICE_RESULT_OK = 0,         // 已执行，value/power为设备调用的返回值
+    DEVICE_RESULT_TIMEOUT = 1,    // 排队加执行超过期限，设备调用可能仍在进行，其结果将被丢弃
+    DEVICE_RESULT_CANCELLED = 2,  // 设备关闭时仍在排队，未执行
+    DEVICE_RESULT_BUSY = 3,       // 命令队列已满，未入队
+};
+
+struct DeviceReply {
+    int result = DEVICE_RESULT_OK;
+    int value = 0;           // Start/Stop/Pause成功为1，SelfCheck为自检码
+    float power = 0;         // read_power的读数（kW）
+    int64_t queued_us = 0;   // 入队 -> 开始执行
+    int64_t elapsed_us = 0;  // 入队 -> 完成（超时时为入队 -> 超时）
+};
+
+class AsyncDevice;
+
+/**
+ * @brief 设备命令执行器
+ *
+ * 少量线程为所有AsyncDevice执行设备调用：每个设备一个FIFO，同一设备的命令严格串行，
+ * 不同设备的命令并行，一个设备卡住只占用一个线程。
+ * 另有一个看门狗线程按截止时间投递超时，不等待卡住的设备调用返回。
+ * 所有AsyncDevice须在执行器之前关闭或销毁。
+ */
+class DeviceExecutor {
+public:
+    struct Statistics {
+        uint64_t executed = 0;    // 执行完成并投递了结果
+        uint64_t timeouts = 0;    // 投递了超时
+        uint64_t late = 0;        // 超时后才返回的设备调用（结果丢弃）
+        uint64_t cancelled = 0;   // 关闭时取消的排队命令
+        uint64_t rejected = 0;    // 队列满被拒绝
+        int64_t max_queued_us = 0;
+        int64_t max_elapsed_us = 0;
+    };
+
+    explicit DeviceExecutor(size_t thread_count);
+    ~DeviceExecutor();
+
+    DeviceExecutor(const DeviceExecutor&) = delete;
+    DeviceExecutor& operator=(const DeviceExecutor&) = delete;
+
+    size_t thread_count() const { return workers_.size(); }
+    Statistics get_statistics() const;
+
+private:
+    friend class AsyncDevice;
+    struct Pending;
+    struct Timer {
+        std::chrono::steady_clock::time_point deadline;
+        std::shared_ptr<Pending> pending;
+        bool operator<(const Timer& other) const { return deadline > other.deadline; }  // 最小堆
+    };
+
+    void worker_loop();
+    void watchdog_loop();
+
+    mutable std::mutex mutex_;  // 保护执行器与所有AsyncDevice的队列状态
+    std::condition_variable work_cv_;
+    std::condition_variable timer_cv_;
+    std::condition_variable idle_cv_;  // AsyncDevice::close等待执行中的命令
+    std::deque<AsyncDevice*> ready_;   // 有待执行命令的设备
+    std::vector<Timer> timers_;
+    std::vector<std::thread> workers_;
+    std::thread watchdog_;
+    Statistics stats_;
+    bool running_;
+};
+
+/**
+ * @brief 异步设备
+ *
+ * 包装同步的DeviceBase，命令入队后立即返回，由DeviceExecutor执行，
+ * 完成、超时或取消时调用完成回调（执行器线程或看门狗线程上），每条命令恰好回调一次。
+ * 超时从入队起计算（包含排队时间）；超时的设备调用仍会执行完，后续命令在其后排队；
+ * 排队期间已超时的命令默认不再执行，stop()除外。
+ * 没有执行器时命令在调用线程上同步执行，回调返回后submit才返回，超过期限的结果记为超时。
+ * 计量采样等非命令调用可经device()直接同步访问。
+ */
+class AsyncDevice {
+public:
+    using Job = std::function<void(DeviceBase& device, DeviceReply& reply)>;
+    using Completion = std::function<void(const DeviceReply& reply)>;
+
+    static const size_t kDefaultQueueLimit = 8;
+
+    explicit AsyncDevice(std::unique_ptr<DeviceBase> device, DeviceExecutor* executor = nullptr,
+                         size_t queue_limit = kDefaultQueueLimit);
+    ~AsyncDevice();
+
+    AsyncDevice(const AsyncDevice&) = delete;
+    AsyncDevice& operator=(const AsyncDevice&) = delete;
+
+    // 切换执行器（nullptr为同步执行），须在没有未完成命令时调用
+    void set_executor(DeviceExecutor* executor);
+    DeviceExecutor* executor() const { return executor_; }
+
+    // 入队，timeout为0表示不限时；队列满时返回false且不调用done
+    // run_after_timeout为true时，排队期间超时仍会执行（停止类命令须最终到达设备），只是结果不再投递
+    bool submit(Job job, std::chrono::milliseconds timeout, Completion done, bool run_after_timeout = false);
+
+    std::future<DeviceReply> start(std::chrono::milliseconds timeout);
+    std::future<DeviceReply> stop(std::chrono::milliseconds timeout);
+    std::future<DeviceReply> pause(std::chrono::milliseconds timeout);
+    std::future<DeviceReply> self_check(std::chrono::milliseconds timeout);
+    std::future<DeviceReply> read_power(std::chrono::milliseconds timeout);
+
+    // 取消排队的命令（回调CANCELLED），等待执行中的命令与回调结束；之后的submit返回false
+    void close();
+
+    DeviceBase& device() { return *device_; }
+    size_t queued() const;
+
+private:
+    friend class DeviceExecutor;
+
+    std::future<DeviceReply> call(Job job, std::chrono::milliseconds timeout, bool run_after_timeout = false);
+
+    std::unique_ptr<DeviceBase> device_;
+    DeviceExecutor* executor_;
+    const size_t queue_limit_;
+
+    // 以下由executor_->mutex_保护
+    std::deque<std::shared_ptr<DeviceExecutor::Pending>> queue_;
+    bool scheduled_;  // 已在执行器的ready_中或正在执行
+    int busy_;        // 执行中的命令与正在进行的回调
+    bool closed_;
+};
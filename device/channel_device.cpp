@@ -0,0 +1,47 @@
+#include "channel_device.hpp"
+#include <chrono>
+
+ChannelDevice::ChannelDevice(std::shared_ptr<ChannelController> controller, uint32_t channel)
+    : controller_(std::move(controller)), channel_(channel)
+{
+}
+
+bool ChannelDevice::Stop()
+{
+    return controller_->Stop(channel_);
+}
+
+bool ChannelDevice::Start()
+{
+    return controller_->Start(channel_);
+}
+
+bool ChannelDevice::Pause()
+{
+    return controller_->Pause(channel_);
+}
+
+int ChannelDevice::SelfCheck()
+{
+    return controller_->SelfCheck(channel_);
+}
+
+float ChannelDevice::GetPower()
+{
+    float voltage = 0, current = 0, power = 0;
+    int64_t timestamp = 0;
+    SampleSpan one{1, &channel_, &voltage, &current, &power, &timestamp};
+    int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    return controller_->ReadSamples(one, now_ms) ? power : 0.0f;
+}
+
+std::string ChannelDevice::GetDeviceId()
+{
+    return controller_->GetId() + ":" + std::to_string(channel_);
+}
+
+bool ChannelDevice::ReadSamples(const SampleSpan& samples, int64_t now_ms)
+{
+    return controller_->ReadSamples(samples, now_ms);
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "devicebase.hpp"
+
+/**
+ * @brief 多通道控制器（一个控制器/总线带多路连接器或电表）
+ *
+ * 每个通道的命令单独执行，采样则一次读取多个通道（一次总线事务）。
+ * 命令在设备线程上调用，ReadSamples在计量线程上调用，实现需自行保证线程安全。
+ */
+class ChannelController {
+public:
+    virtual ~ChannelController() {}
+    virtual size_t ChannelCount() = 0;
+    virtual bool Start(uint32_t channel) = 0;
+    virtual bool Stop(uint32_t channel) = 0;
+    virtual bool Pause(uint32_t channel) = 0;
+    virtual int SelfCheck(uint32_t channel) = 0;
+    virtual bool ReadSamples(const SampleSpan& samples, int64_t now_ms) = 0;
+    virtual std::string GetId() = 0;
+};
+
+/**
+ * @brief 控制器上的一个通道，作为连接器的DeviceBase
+ *
+ * 命令转给控制器；同一控制器的各通道属于同一采样分组，运行时合并为一次ReadSamples。
+ * GetPower单独读取本通道（一次事务），仅供不走批量采样的调用方使用。
+ */
+class ChannelDevice : public DeviceBase
+{
+public:
+    ChannelDevice(std::shared_ptr<ChannelController> controller, uint32_t channel);
+
+    virtual bool Stop() ;
+    virtual bool Start() ;
+    virtual bool Pause() ;
+    virtual int SelfCheck() ;
+    virtual float GetPower() ;
+    virtual std::string GetDeviceId() ;
+
+    virtual const void* SampleGroup() { return controller_.get(); }
+    virtual uint32_t SampleChannel() { return channel_; }
+    virtual bool ReadSamples(const SampleSpan& samples, int64_t now_ms);
+
+    ChannelController& controller() { return *controller_; }
+
+private:
+    std::shared_ptr<ChannelController> controller_;
+    const uint32_t channel_;
+};
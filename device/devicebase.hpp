@@ -1,4 +1,6 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include "iostream"
 enum DeviceStatus{
     DEVICE_ERROR = 1,
@@ -17,12 +19,47 @@ enum SelfCheckCode{
     SELFCHECK_SUCCESS = 1,
 };
 
+/**
+ * 多通道采样的结构数组视图：channel由调用方填写，其余由ReadSamples填写
+ */
+struct SampleSpan {
+    size_t size;
+    const uint32_t* channel;
+    float* voltage_v;
+    float* current_a;
+    float* power_kw;
+    int64_t* timestamp_ms;  // 采样时间（UTC毫秒），设备没有自己的时间戳时为调用方给出的now_ms；-1表示该通道本次未读到
+};
+
 class DeviceBase{
 public:
+    virtual ~DeviceBase() {}
     virtual bool Stop() = 0;
     virtual bool Start() = 0;
     virtual bool Pause() = 0;
     virtual int SelfCheck() = 0;
     virtual float GetPower() = 0;
     virtual std::string GetDeviceId() = 0;
+
+    // 自检可拆分为互相独立的子系统（绝缘、继电器、急停、通信等）时返回子系统数，各项由SelfCheckCache::run并发执行；
+    // 默认1，即整个SelfCheck
+    virtual size_t SelfCheckParts() { return 1; }
+    // 单个子系统的自检，返回值同SelfCheck；SelfCheckParts大于1时须允许各项并发调用
+    virtual int SelfCheckPart(size_t /*part*/) { return SelfCheck(); }
+
+    // 批量采样分组：返回同一值的设备（同一控制器的各通道）由运行时合并为一次ReadSamples
+    virtual const void* SampleGroup() { return this; }
+    // 本设备在分组内的通道号
+    virtual uint32_t SampleChannel() { return 0; }
+    // 一次读取多个通道，失败返回false（本周期不采样）。
+    // 默认实现逐通道调用GetPower，电压电流为0，单通道设备无需改动
+    virtual bool ReadSamples(const SampleSpan& samples, int64_t now_ms) {
+        for (size_t i = 0; i < samples.size; i++) {
+            samples.voltage_v[i] = 0;
+            samples.current_a[i] = 0;
+            samples.power_kw[i] = GetPower();
+            samples.timestamp_ms[i] = now_ms;
+        }
+        return true;
+    }
 };
@@ -0,0 +1,111 @@
+#include "fake_device.hpp"
+#include <chrono>
+#include <thread>
+
+FakeDevice::FakeDevice(const std::string& id) : FakeDevice(id, Latency())
+{
+}
+
+FakeDevice::FakeDevice(const std::string& id, const Latency& latency)
+    : id_(id), start_ms_(0), stop_ms_(0), pause_ms_(0), self_check_ms_(0), power_ms_(0),
+      self_check_code_(0), start_ok_(true), power_kw_(7.0f), running_(false),
+      starts_(0), stops_(0), self_checks_(0), power_reads_(0), concurrent_(0), max_concurrent_(0),
+      self_check_parts_(1), parts_run_(0), concurrent_parts_(0), max_concurrent_parts_(0)
+{
+    set_latency(latency);
+}
+
+void FakeDevice::set_latency(const Latency& latency)
+{
+    start_ms_ = latency.start_ms;
+    stop_ms_ = latency.stop_ms;
+    pause_ms_ = latency.pause_ms;
+    self_check_ms_ = latency.self_check_ms;
+    power_ms_ = latency.power_ms;
+}
+
+void FakeDevice::delay(int ms)
+{
+    if (ms > 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+}
+
+void FakeDevice::raise_peak(std::atomic<int>& peak, int now)
+{
+    int seen = peak.load();
+    while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+    }
+}
+
+FakeDevice::CommandScope::CommandScope(FakeDevice& device) : device_(device)
+{
+    raise_peak(device_.max_concurrent_, ++device_.concurrent_);
+}
+
+FakeDevice::CommandScope::~CommandScope()
+{
+    --device_.concurrent_;
+}
+
+bool FakeDevice::Stop()
+{
+    CommandScope scope(*this);
+    delay(stop_ms_);
+    running_ = false;
+    stops_++;
+    return true;
+}
+
+bool FakeDevice::Start()
+{
+    CommandScope scope(*this);
+    delay(start_ms_);
+    starts_++;
+    if (!start_ok_) {
+        return false;
+    }
+    running_ = true;
+    return true;
+}
+
+bool FakeDevice::Pause()
+{
+    CommandScope scope(*this);
+    delay(pause_ms_);
+    running_ = false;
+    return true;
+}
+
+int FakeDevice::SelfCheck()
+{
+    CommandScope scope(*this);
+    delay(self_check_ms_ * static_cast<int>(self_check_parts_.load()));
+    self_checks_++;
+    return self_check_code_;
+}
+
+// 子系统自检由SelfCheckCache::run并发调用，单独统计并发数，不计入命令并发
+int FakeDevice::SelfCheckPart(size_t part)
+{
+    raise_peak(max_concurrent_parts_, ++concurrent_parts_);
+    delay(self_check_ms_);
+    parts_run_++;
+    if (part == 0) {
+        self_checks_++;
+    }
+    --concurrent_parts_;
+    return self_check_code_;
+}
+
+float FakeDevice::GetPower()
+{
+    delay(power_ms_);
+    power_reads_++;
+    return running_ ? power_kw_.load() : 0.0f;
+}
+
+std::string FakeDevice::GetDeviceId()
+{
+    return id_;
+}
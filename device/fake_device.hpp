@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include "devicebase.hpp"
+
+/**
+ * @brief 可配置延迟的测试设备
+ *
+ * 每种调用按设定的延迟阻塞（模拟继电器控制、CAN/Modbus读表的往返时间），
+ * 自检码、启动结果与功率可随时修改。记录各调用次数，以及同时进行中的命令调用数的峰值，
+ * 用于验证同一设备的命令是否串行执行。所有设置与计数均为原子量，可在任意线程访问。
+ */
+class FakeDevice : public DeviceBase
+{
+public:
+    struct Latency {
+        int start_ms = 0;
+        int stop_ms = 0;
+        int pause_ms = 0;
+        int self_check_ms = 0;
+        int power_ms = 0;
+    };
+
+    explicit FakeDevice(const std::string& id);
+    FakeDevice(const std::string& id, const Latency& latency);
+
+    virtual bool Stop() ;
+    virtual bool Start() ;
+    virtual bool Pause() ;
+    virtual int SelfCheck() ;
+    virtual float GetPower() ;
+    virtual std::string GetDeviceId() ;
+    virtual size_t SelfCheckParts() { return self_check_parts_; }
+    virtual int SelfCheckPart(size_t part) ;
+
+    void set_latency(const Latency& latency);
+    // 自检码，大于0表示自检失败
+    void set_self_check_code(int code) { self_check_code_ = code; }
+    void set_start_result(bool ok) { start_ok_ = ok; }
+    void set_power(float kw) { power_kw_ = kw; }
+    // 自检分为parts个子系统，每项耗时self_check_ms；SelfCheck依次执行各项
+    void set_self_check_parts(size_t parts) { self_check_parts_ = parts > 0 ? parts : 1; }
+
+    bool running() const { return running_; }
+    uint64_t starts() const { return starts_; }
+    uint64_t stops() const { return stops_; }
+    uint64_t self_checks() const { return self_checks_; }
+    uint64_t power_reads() const { return power_reads_; }
+    int max_concurrent_commands() const { return max_concurrent_; }
+    uint64_t self_check_parts_run() const { return parts_run_; }
+    int max_concurrent_parts() const { return max_concurrent_parts_; }
+
+private:
+    // 命令调用（Start/Stop/Pause/SelfCheck）的并发计数
+    class CommandScope {
+    public:
+        explicit CommandScope(FakeDevice& device);
+        ~CommandScope();
+    private:
+        FakeDevice& device_;
+    };
+
+    static void delay(int ms);
+    static void raise_peak(std::atomic<int>& peak, int now);
+
+    const std::string id_;
+    std::atomic<int> start_ms_, stop_ms_, pause_ms_, self_check_ms_, power_ms_;
+    std::atomic<int> self_check_code_;
+    std::atomic<bool> start_ok_;
+    std::atomic<float> power_kw_;
+    std::atomic<bool> running_;
+    std::atomic<uint64_t> starts_, stops_, self_checks_, power_reads_;
+    std::atomic<int> concurrent_;
+    std::atomic<int> max_concurrent_;
+    std::atomic<size_t> self_check_parts_;
+    std::atomic<uint64_t> parts_run_;
+    std::atomic<int> concurrent_parts_;
+    std::atomic<int> max_concurrent_parts_;
+};
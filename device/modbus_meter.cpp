@@ -0,0 +1,301 @@
+#include "modbus_meter.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+ModbusMeterBus::ModbusMeterBus(int fd, size_t meters, const Options& options)
+    : fd_(fd), options_(options), decoder_(options.framing, false), transaction_(0)
+{
+    // 地址回绕到0即广播，一次写线圈会切换总线上所有电表的继电器
+    if (options.first_unit == MODBUS_BROADCAST_UNIT || meters > MODBUS_MAX_UNIT ||
+        options.first_unit + meters - 1 > MODBUS_MAX_UNIT) {
+        if (fd_ >= 0) {
+            close(fd_);
+        }
+        throw std::invalid_argument("Modbus单元地址超出1-" + std::to_string(MODBUS_MAX_UNIT) + ": 起始" +
+                                    std::to_string(options.first_unit) + "，" + std::to_string(meters) + "块表");
+    }
+    cache_.resize(meters);
+}
+
+ModbusMeterBus::~ModbusMeterBus()
+{
+    if (fd_ >= 0) {
+        close(fd_);
+    }
+}
+
+bool ModbusMeterBus::Start(uint32_t channel)
+{
+    return write_relay(channel, true);
+}
+
+bool ModbusMeterBus::Stop(uint32_t channel)
+{
+    return write_relay(channel, false);
+}
+
+bool ModbusMeterBus::Pause(uint32_t channel)
+{
+    return write_relay(channel, false);
+}
+
+int ModbusMeterBus::SelfCheck(uint32_t channel)
+{
+    uint8_t unit = 0;
+    if (!unit_of(channel, unit)) {
+        return ERRORCODE_NETWORK;
+    }
+    ModbusFrame response;
+    uint16_t code = 0;
+    if (!command(modbus_read_request(unit, MODBUS_READ_INPUT, METER_REG_SELF_CHECK, 1), response) ||
+        !modbus_response_registers(response, 1, &code)) {
+        return ERRORCODE_NETWORK;
+    }
+    return code;
+}
+
+bool ModbusMeterBus::write_relay(uint32_t channel, bool on)
+{
+    uint8_t unit = 0;
+    if (!unit_of(channel, unit)) {
+        return false;
+    }
+    ModbusFrame request = modbus_write_coil_request(unit, METER_COIL_RELAY, on);
+    ModbusFrame response;
+    // 写线圈的正常响应原样回显请求
+    return command(request, response) && !response.is_exception() && response.data == request.data;
+}
+
+bool ModbusMeterBus::unit_of(uint32_t channel, uint8_t& unit) const
+{
+    if (channel >= cache_.size()) {
+        return false;
+    }
+    uint32_t address = options_.first_unit + channel;
+    if (address == MODBUS_BROADCAST_UNIT || address > MODBUS_MAX_UNIT) {
+        return false;
+    }
+    unit = static_cast<uint8_t>(address);
+    return true;
+}
+
+bool ModbusMeterBus::command(const ModbusFrame& request, ModbusFrame& response)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<ModbusFrame> requests(1, request);
+    bool ok = false;
+    exchange(requests, [&](size_t, const ModbusFrame* reply) {
+        if (reply) {
+            response = *reply;
+            ok = true;
+        }
+    });
+    return ok;
+}
+
+bool ModbusMeterBus::ReadSamples(const SampleSpan& samples, int64_t now_ms)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 本周期已轮询过的通道直接取缓存（包括失败结果，避免一块坏表在同一周期内反复等待超时）
+    requests_.clear();
+    polled_.clear();
+    for (size_t i = 0; i < samples.size; i++) {
+        uint32_t channel = samples.channel[i];
+        uint8_t unit = 0;
+        if (!unit_of(channel, unit)) {
+            continue;
+        }
+        Cached& cached = cache_[channel];
+        int64_t age = now_ms - cached.attempt_ms;
+        if (cached.attempted && age >= 0 && age < options_.cache_ms) {
+            if (cached.ok) {
+                stats_.cache_hits++;
+            }
+            continue;
+        }
+        cached.attempt_ms = now_ms;
+        cached.attempted = true;
+        cached.ok = false;
+        requests_.push_back(modbus_read_request(unit, MODBUS_READ_INPUT, 0, METER_REG_COUNT));
+        polled_.push_back(channel);
+    }
+    if (!requests_.empty()) {
+        stats_.polls++;
+        exchange(requests_, [this](size_t index, const ModbusFrame* response) {
+            uint16_t registers[METER_REG_COUNT];
+            if (!response || !modbus_response_registers(*response, METER_REG_COUNT, registers)) {
+                return;
+            }
+            Cached& cached = cache_[polled_[index]];
+            cached.reading.voltage_v = modbus_registers_to_float(registers + METER_REG_VOLTAGE);
+            cached.reading.current_a = modbus_registers_to_float(registers + METER_REG_CURRENT);
+            cached.reading.power_kw = modbus_registers_to_float(registers + METER_REG_POWER);
+            cached.reading.energy_kwh = modbus_registers_to_float(registers + METER_REG_ENERGY);
+            cached.ok = true;
+            cached.valid = true;
+        });
+    }
+
+    size_t read = 0;
+    for (size_t i = 0; i < samples.size; i++) {
+        uint32_t channel = samples.channel[i];
+        if (channel >= cache_.size() || !cache_[channel].ok) {
+            samples.voltage_v[i] = 0;
+            samples.current_a[i] = 0;
+            samples.power_kw[i] = 0;
+            samples.timestamp_ms[i] = -1;
+            continue;
+        }
+        const Cached& cached = cache_[channel];
+        samples.voltage_v[i] = cached.reading.voltage_v;
+        samples.current_a[i] = cached.reading.current_a;
+        samples.power_kw[i] = cached.reading.power_kw;
+        samples.timestamp_ms[i] = cached.attempt_ms;
+        read++;
+    }
+    return read > 0;
+}
+
+bool ModbusMeterBus::reading(uint32_t channel, Reading& reading) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (channel >= cache_.size() || !cache_[channel].valid) {
+        return false;
+    }
+    reading = cache_[channel].reading;
+    return true;
+}
+
+ModbusMeterBus::Statistics ModbusMeterBus::get_statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statistics stats = stats_;
+    stats.decode_errors = decoder_.errors();
+    return stats;
+}
+
+bool ModbusMeterBus::matches(const InFlight& request, const ModbusFrame& response) const
+{
+    if (options_.framing == MODBUS_TCP && response.transaction != request.transaction) {
+        return false;
+    }
+    return response.unit == request.unit && (response.function & 0x7F) == request.function;
+}
+
+void ModbusMeterBus::exchange(std::vector<ModbusFrame>& requests, const Handler& handler)
+{
+    const size_t window = options_.framing == MODBUS_TCP ? std::max<size_t>(1, options_.window) : 1;
+    const auto timeout = std::chrono::milliseconds(options_.timeout_ms);
+    size_t next = 0;
+    in_flight_.clear();
+    ModbusFrame response;
+    while (next < requests.size() || !in_flight_.empty()) {
+        // 补满发送窗口，一次写出
+        out_.clear();
+        auto now = Clock::now();
+        while (in_flight_.size() < window && next < requests.size()) {
+            ModbusFrame& request = requests[next];
+            if (options_.framing == MODBUS_TCP) {
+                request.transaction = ++transaction_;
+            }
+            modbus_encode(options_.framing, request, out_);
+            in_flight_.push_back(InFlight{request.transaction, request.unit, request.function, next, now + timeout});
+            stats_.requests++;
+            next++;
+        }
+        if (!out_.empty() && !write_all(out_.data(), out_.size())) {
+            for (const InFlight& request : in_flight_) {
+                handler(request.index, nullptr);
+            }
+            stats_.timeouts += in_flight_.size();
+            in_flight_.clear();
+            continue;
+        }
+
+        // 至少收完一个响应（或有请求到期）再补窗口
+        bool progressed = false;
+        while (!progressed) {
+            while (decoder_.next(response)) {
+                auto it = std::find_if(in_flight_.begin(), in_flight_.end(),
+                                       [&](const InFlight& request) { return matches(request, response); });
+                if (it == in_flight_.end()) {
+                    stats_.unmatched++;
+                    continue;
+                }
+                stats_.responses++;
+                if (response.is_exception()) {
+                    stats_.exceptions++;
+                }
+                size_t index = it->index;
+                in_flight_.erase(it);
+                handler(index, response.is_exception() ? nullptr : &response);
+                progressed = true;
+            }
+            if (progressed || in_flight_.empty()) {
+                break;
+            }
+            // 按发送顺序排列，队首期限最早
+            if (!read_some(in_flight_.front().deadline)) {
+                auto expired = Clock::now();
+                while (!in_flight_.empty() && in_flight_.front().deadline <= expired) {
+                    handler(in_flight_.front().index, nullptr);
+                    in_flight_.erase(in_flight_.begin());
+                    stats_.timeouts++;
+                }
+                // RTU超时后丢弃半帧重新同步
+                if (options_.framing == MODBUS_RTU) {
+                    decoder_.reset();
+                }
+                progressed = true;
+            }
+        }
+    }
+}
+
+bool ModbusMeterBus::write_all(const uint8_t* data, size_t size)
+{
+    while (size > 0) {
+        ssize_t n = write(fd_, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+bool ModbusMeterBus::read_some(Clock::time_point deadline)
+{
+    while (true) {
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(deadline - Clock::now()).count();
+        if (remaining <= 0) {
+            return false;
+        }
+        struct pollfd pfd = {fd_, POLLIN, 0};
+        int ready = poll(&pfd, 1, static_cast<int>((remaining + 999) / 1000));
+        if (ready < 0 && errno == EINTR) {
+            continue;
+        }
+        if (ready <= 0) {
+            return false;
+        }
+        uint8_t buffer[4096];
+        ssize_t n = read(fd_, buffer, sizeof(buffer));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            // 对端关闭或读错误：等到期限再报超时，避免空转
+            poll(nullptr, 0, static_cast<int>((remaining + 999) / 1000));
+            return false;
+        }
+        decoder_.feed(buffer, static_cast<size_t>(n));
+        return true;
+    }
+}
@@ -0,0 +1,128 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "channel_device.hpp"
+#include "tools/modbus/modbus.hpp"
+
+// 电表寄存器布局：输入寄存器，浮点高字在前
+enum MeterRegister {
+    METER_REG_VOLTAGE = 0,     // V
+    METER_REG_CURRENT = 2,     // A
+    METER_REG_POWER = 4,       // kW
+    METER_REG_ENERGY = 6,      // kWh
+    METER_REG_SELF_CHECK = 8,  // 自检码，0为正常
+    METER_REG_COUNT = 9,
+};
+
+// 继电器线圈
+const uint16_t METER_COIL_RELAY = 0;
+
+/**
+ * @brief Modbus电表总线
+ *
+ * 一条连接（串口/pty上的RTU，或socket上的TCP）挂多块电表，通道i对应单元地址first_unit + i。
+ * 每块表的全部测量值是连续的输入寄存器，一次04读取（批量读寄存器）。
+ * - TCP：按事务ID匹配响应，最多window个请求同时在途（流水线），响应可乱序到达
+ * - RTU：总线半双工，一问一答
+ * 采样结果按通道缓存cache_ms毫秒，同一轮询周期内的重复读取（如批量采样后的GetPower）不再访问总线；
+ * cache_ms应小于采样周期。读取失败的通道timestamp_ms为-1。
+ * 命令与采样在同一把锁下串行使用连接，可分别在设备线程与计量线程上调用。
+ */
+class ModbusMeterBus : public ChannelController {
+public:
+    struct Options {
+        ModbusFraming framing = MODBUS_TCP;
+        uint8_t first_unit = 1;
+        size_t window = 16;     // TCP在途请求上限，RTU固定为1
+        int timeout_ms = 100;   // 单个请求的响应期限
+        int cache_ms = 50;      // 读数有效期
+        std::string id = "modbus";
+    };
+
+    struct Statistics {
+        uint64_t polls = 0;          // 访问了总线的ReadSamples
+        uint64_t requests = 0;
+        uint64_t responses = 0;
+        uint64_t timeouts = 0;
+        uint64_t exceptions = 0;     // 电表返回异常响应
+        uint64_t unmatched = 0;      // 超时后才到达或对不上请求的响应
+        uint64_t decode_errors = 0;
+        uint64_t cache_hits = 0;     // 直接取自缓存的通道读数
+    };
+
+    struct Reading {
+        float voltage_v = 0;
+        float current_a = 0;
+        float power_kw = 0;
+        float energy_kwh = 0;
+    };
+
+    // 接管fd（阻塞模式），析构时关闭。first_unit为0（广播地址）或最后一块表的地址超过247时
+    // 关闭fd并抛出std::invalid_argument
+    ModbusMeterBus(int fd, size_t meters, const Options& options);
+    ~ModbusMeterBus();
+
+    ModbusMeterBus(const ModbusMeterBus&) = delete;
+    ModbusMeterBus& operator=(const ModbusMeterBus&) = delete;
+
+    virtual size_t ChannelCount() { return cache_.size(); }
+    virtual bool Start(uint32_t channel);
+    virtual bool Stop(uint32_t channel);
+    virtual bool Pause(uint32_t channel);
+    // 通信失败返回ERRORCODE_NETWORK
+    virtual int SelfCheck(uint32_t channel);
+    virtual bool ReadSamples(const SampleSpan& samples, int64_t now_ms);
+    virtual std::string GetId() { return options_.id; }
+
+    // 最近一次成功读数，从未读到返回false
+    bool reading(uint32_t channel, Reading& reading) const;
+    Statistics get_statistics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+    using Handler = std::function<void(size_t index, const ModbusFrame* response)>;
+
+    struct Cached {
+        Reading reading;
+        int64_t attempt_ms = 0;  // 最近一次轮询的now_ms
+        bool attempted = false;
+        bool ok = false;         // 最近一次轮询成功
+        bool valid = false;      // 曾经读到过
+    };
+
+    struct InFlight {
+        uint16_t transaction;
+        uint8_t unit;
+        uint8_t function;
+        size_t index;
+        Clock::time_point deadline;
+    };
+
+    // 发出requests并收集响应，每个请求恰好回调一次，失败时response为nullptr；调用方持有mutex_
+    void exchange(std::vector<ModbusFrame>& requests, const Handler& handler);
+    bool matches(const InFlight& request, const ModbusFrame& response) const;
+    bool write_all(const uint8_t* data, size_t size);
+    // 读入可用字节，到期仍无数据返回false
+    bool read_some(Clock::time_point deadline);
+    bool command(const ModbusFrame& request, ModbusFrame& response);
+    bool write_relay(uint32_t channel, bool on);
+    // 通道对应的单元地址，通道不存在或地址超出1-247时返回false，绝不落到广播地址
+    bool unit_of(uint32_t channel, uint8_t& unit) const;
+
+    const int fd_;
+    const Options options_;
+    mutable std::mutex mutex_;
+    ModbusDecoder decoder_;
+    uint16_t transaction_;
+    std::vector<Cached> cache_;
+    std::vector<ModbusFrame> requests_;  // 复用的轮询请求
+    std::vector<uint32_t> polled_;       // requests_对应的通道
+    std::vector<uint8_t> out_;
+    std::vector<InFlight> in_flight_;
+    Statistics stats_;
+};
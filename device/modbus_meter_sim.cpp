@@ -0,0 +1,275 @@
+#include "modbus_meter_sim.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/prctl.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#include "tools/trace/trace.hpp"
+
+namespace {
+
+const float kVoltage = 230.0f;
+
+void write_all(int fd, const uint8_t* data, size_t size) {
+    while (size > 0) {
+        ssize_t n = write(fd, data, size);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;  // 驱动端已关闭
+        }
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+}  // namespace
+
+ModbusMeterSim::ModbusMeterSim(int fd, const Options& options)
+    : fd_(fd), options_(options), meters_(options.meters), decoder_(options.framing, true),
+      bus_free_(Clock::now())
+{
+    auto now = Clock::now();
+    for (size_t i = 0; i < meters_.size(); i++) {
+        meters_[i].power_kw = 3.0f + 0.05f * static_cast<float>(i);
+        meters_[i].updated = now;
+    }
+    if (pipe(stop_pipe_) != 0) {
+        stop_pipe_[0] = stop_pipe_[1] = -1;
+    }
+    thread_ = std::thread([this] {
+        Trace::set_thread_name("modbus-sim");
+        // 默认50us的定时器松弛会淹没微秒级的处理时延
+        prctl(PR_SET_TIMERSLACK, 1UL, 0, 0, 0);
+        run();
+    });
+}
+
+ModbusMeterSim::~ModbusMeterSim()
+{
+    uint8_t byte = 0;
+    if (stop_pipe_[1] >= 0) {
+        write_all(stop_pipe_[1], &byte, 1);
+    }
+    thread_.join();
+    for (int fd : {stop_pipe_[0], stop_pipe_[1], fd_}) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+}
+
+void ModbusMeterSim::set_power(uint32_t meter, float kw)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (meter < meters_.size()) {
+        integrate(meters_[meter], Clock::now());
+        meters_[meter].power_kw = kw;
+    }
+}
+
+void ModbusMeterSim::set_self_check_code(uint32_t meter, uint16_t code)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (meter < meters_.size()) {
+        meters_[meter].self_check = code;
+    }
+}
+
+void ModbusMeterSim::set_silent(uint32_t meter, bool silent)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (meter < meters_.size()) {
+        meters_[meter].silent = silent;
+    }
+}
+
+bool ModbusMeterSim::relay(uint32_t meter) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return meter < meters_.size() && meters_[meter].relay;
+}
+
+float ModbusMeterSim::energy_kwh(uint32_t meter) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return meter < meters_.size() ? meters_[meter].energy_kwh : 0.0f;
+}
+
+ModbusMeterSim::Statistics ModbusMeterSim::get_statistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+bool ModbusMeterSim::open_link(ModbusFraming framing, int& driver_fd, int& sim_fd)
+{
+    if (framing == MODBUS_TCP) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            return false;
+        }
+        driver_fd = fds[0];
+        sim_fd = fds[1];
+        return true;
+    }
+
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0) {
+        return false;
+    }
+    const char* name = nullptr;
+    if (grantpt(master) != 0 || unlockpt(master) != 0 || (name = ptsname(master)) == nullptr) {
+        close(master);
+        return false;
+    }
+    int slave = open(name, O_RDWR | O_NOCTTY);
+    if (slave < 0) {
+        close(master);
+        return false;
+    }
+    // 原始模式：不做行缓冲、回显与字符转换
+    struct termios tio;
+    if (tcgetattr(slave, &tio) != 0) {
+        close(slave);
+        close(master);
+        return false;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(slave, TCSANOW, &tio);
+    driver_fd = slave;
+    sim_fd = master;
+    return true;
+}
+
+void ModbusMeterSim::integrate(Meter& meter, Clock::time_point now)
+{
+    if (meter.relay) {
+        double hours = std::chrono::duration<double>(now - meter.updated).count() / 3600.0;
+        meter.energy_kwh += static_cast<float>(meter.power_kw * hours);
+    }
+    meter.updated = now;
+}
+
+bool ModbusMeterSim::handle(const ModbusFrame& request, ModbusFrame& response)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.requests++;
+    size_t index = static_cast<size_t>(request.unit - options_.first_unit);
+    if (request.unit < options_.first_unit || index >= meters_.size() || meters_[index].silent) {
+        stats_.ignored++;
+        return false;
+    }
+    Meter& meter = meters_[index];
+    uint16_t address = 0, value = 0;
+    if (!modbus_request_fields(request, address, value)) {
+        response = modbus_exception_response(request, MODBUS_ILLEGAL_VALUE);
+    }
+    else if (request.function == MODBUS_READ_INPUT || request.function == MODBUS_READ_HOLDING) {
+        if (value == 0 || address + value > METER_REG_COUNT) {
+            response = modbus_exception_response(request, MODBUS_ILLEGAL_ADDRESS);
+        }
+        else {
+            integrate(meter, Clock::now());
+            float power = meter.relay ? meter.power_kw : 0.0f;
+            uint16_t registers[METER_REG_COUNT];
+            modbus_float_to_registers(kVoltage, registers + METER_REG_VOLTAGE);
+            modbus_float_to_registers(power * 1000.0f / kVoltage, registers + METER_REG_CURRENT);
+            modbus_float_to_registers(power, registers + METER_REG_POWER);
+            modbus_float_to_registers(meter.energy_kwh, registers + METER_REG_ENERGY);
+            registers[METER_REG_SELF_CHECK] = meter.self_check;
+            response = modbus_registers_response(request, registers + address, value);
+        }
+    }
+    else if (request.function == MODBUS_WRITE_COIL) {
+        if (address != METER_COIL_RELAY) {
+            response = modbus_exception_response(request, MODBUS_ILLEGAL_ADDRESS);
+        }
+        else if (value != 0xFF00 && value != 0x0000) {
+            response = modbus_exception_response(request, MODBUS_ILLEGAL_VALUE);
+        }
+        else {
+            integrate(meter, Clock::now());
+            meter.relay = value == 0xFF00;
+            response = request;
+        }
+    }
+    else {
+        response = modbus_exception_response(request, MODBUS_ILLEGAL_FUNCTION);
+    }
+    stats_.responses++;
+    if (response.is_exception()) {
+        stats_.exceptions++;
+    }
+    return true;
+}
+
+void ModbusMeterSim::run()
+{
+    const auto half_rtt = std::chrono::microseconds(options_.rtt_us / 2);
+    const auto processing = std::chrono::microseconds(options_.processing_us);
+    ModbusFrame request, response;
+    std::vector<uint8_t> out;
+    uint8_t buffer[4096];
+    bool link_open = true;
+    while (true) {
+        struct pollfd fds[2] = {{link_open ? fd_ : -1, POLLIN, 0}, {stop_pipe_[0], POLLIN, 0}};
+        struct timespec wait;
+        struct timespec* timeout = nullptr;
+        if (!responses_.empty()) {
+            auto remaining = std::max<int64_t>(0, std::chrono::duration_cast<std::chrono::nanoseconds>(
+                responses_.front().due - Clock::now()).count());
+            wait.tv_sec = static_cast<time_t>(remaining / 1000000000);
+            wait.tv_nsec = static_cast<long>(remaining % 1000000000);
+            timeout = &wait;
+        }
+        if (ppoll(fds, 2, timeout, nullptr) < 0 && errno != EINTR) {
+            break;
+        }
+        if (fds[1].revents & POLLIN) {
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            ssize_t n = read(fd_, buffer, sizeof(buffer));
+            if (n > 0) {
+                decoder_.feed(buffer, static_cast<size_t>(n));
+            }
+            else if (n == 0 || errno != EINTR) {
+                link_open = false;
+            }
+        }
+        else if (fds[0].revents & (POLLHUP | POLLERR)) {
+            link_open = false;  // 驱动端已关闭（pty主端在从端关闭后一直报告POLLHUP）
+        }
+
+        // 请求到达时间加半个往返，网关串行处理，响应再过半个往返送达
+        auto now = Clock::now();
+        while (decoder_.next(request)) {
+            if (!handle(request, response)) {
+                continue;
+            }
+            bus_free_ = std::max(bus_free_, now + half_rtt) + processing;
+            Response pending;
+            pending.due = bus_free_ + half_rtt;
+            modbus_encode(options_.framing, response, pending.bytes);
+            responses_.push_back(std::move(pending));
+        }
+
+        out.clear();
+        now = Clock::now();
+        while (!responses_.empty() && responses_.front().due <= now) {
+            out.insert(out.end(), responses_.front().bytes.begin(), responses_.front().bytes.end());
+            responses_.pop_front();
+        }
+        if (!out.empty() && link_open) {
+            write_all(fd_, out.data(), out.size());
+        }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.decode_errors = decoder_.errors();
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "modbus_meter.hpp"
+
+/**
+ * @brief 模拟Modbus电表（从站一侧）
+ *
+ * 一个线程经fd服务多块电表，单元地址自first_unit起连续，寄存器布局同ModbusMeterBus。
+ * 链路与处理时延：请求经rtt_us/2到达，依次占用processing_us（网关/总线串行处理），
+ * 响应再经rtt_us/2送回；多个在途请求的往返时间可以重叠，处理时间不能。
+ * 继电器闭合时输出设定功率，电能按墙钟时间积分。不在范围内或设为静默的单元不应答。
+ */
+class ModbusMeterSim {
+public:
+    struct Options {
+        ModbusFraming framing = MODBUS_TCP;
+        uint8_t first_unit = 1;
+        size_t meters = 1;
+        int rtt_us = 0;
+        int processing_us = 0;
+    };
+
+    struct Statistics {
+        uint64_t requests = 0;
+        uint64_t responses = 0;
+        uint64_t exceptions = 0;
+        uint64_t ignored = 0;  // 无此单元或静默，未应答
+        uint64_t decode_errors = 0;
+    };
+
+    // 接管fd，启动服务线程；析构时停止线程并关闭fd
+    ModbusMeterSim(int fd, const Options& options);
+    ~ModbusMeterSim();
+
+    ModbusMeterSim(const ModbusMeterSim&) = delete;
+    ModbusMeterSim& operator=(const ModbusMeterSim&) = delete;
+
+    // 默认为3.0 + 0.05 * meter kW
+    void set_power(uint32_t meter, float kw);
+    void set_self_check_code(uint32_t meter, uint16_t code);
+    void set_silent(uint32_t meter, bool silent);
+    bool relay(uint32_t meter) const;
+    float energy_kwh(uint32_t meter) const;
+    Statistics get_statistics() const;
+
+    // 创建一条本地链路：TCP帧用socketpair；RTU帧用pty（原始模式），驱动端为从设备一侧，如同串口设备文件
+    static bool open_link(ModbusFraming framing, int& driver_fd, int& sim_fd);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Meter {
+        float power_kw = 0;
+        float energy_kwh = 0;
+        uint16_t self_check = 0;
+        bool relay = false;
+        bool silent = false;
+        Clock::time_point updated;
+    };
+
+    struct Response {
+        Clock::time_point due;
+        std::vector<uint8_t> bytes;
+    };
+
+    void run();
+    // 处理一个请求，不应答时返回false
+    bool handle(const ModbusFrame& request, ModbusFrame& response);
+    void integrate(Meter& meter, Clock::time_point now);
+
+    const int fd_;
+    const Options options_;
+    int stop_pipe_[2];
+    mutable std::mutex mutex_;  // 保护meters_与stats_
+    std::vector<Meter> meters_;
+    Statistics stats_;
+    // 以下只在服务线程使用
+    ModbusDecoder decoder_;
+    std::deque<Response> responses_;
+    Clock::time_point bus_free_;
+    std::thread thread_;
+};
@@ -0,0 +1,103 @@
+#include "self_check_cache.hpp"
+#include <algorithm>
+#include <future>
+#include <vector>
+
+SelfCheckCache::SelfCheckCache() : passed_(false), refreshing_(false), generation_(0) {
+}
+
+void SelfCheckCache::set_options(const Options& options) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+}
+
+SelfCheckCache::Options SelfCheckCache::options() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return options_;
+}
+
+bool SelfCheckCache::take_passed(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (options_.valid_ms <= 0 || !passed_ || now - passed_at_ >= std::chrono::milliseconds(options_.valid_ms)) {
+        return false;
+    }
+    stats_.hits++;
+    return true;
+}
+
+bool SelfCheckCache::begin_refresh(Clock::time_point now) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (options_.valid_ms <= 0 || refreshing_) {
+        return false;
+    }
+    if (passed_ && now - passed_at_ < std::chrono::milliseconds(options_.refresh_ms)) {
+        return false;
+    }
+    refreshing_ = true;
+    return true;
+}
+
+void SelfCheckCache::cancel_refresh() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refreshing_ = false;
+}
+
+uint64_t SelfCheckCache::generation() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+}
+
+void SelfCheckCache::store(int code, Clock::time_point started, int64_t elapsed_us, bool refresh,
+                           uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.checks++;
+    stats_.max_check_us = std::max(stats_.max_check_us, elapsed_us);
+    if (refresh) {
+        stats_.refreshes++;
+        refreshing_ = false;
+    }
+    // 如超时后才返回的自检：超时时已置为失效，迟到的通过结果不能再让启动跳过自检
+    if (generation != generation_) {
+        stats_.stale++;
+        return;
+    }
+    if (code > 0) {
+        stats_.failures++;
+        passed_ = false;
+        return;
+    }
+    passed_ = true;
+    passed_at_ = started;
+}
+
+void SelfCheckCache::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    passed_ = false;
+    generation_++;
+}
+
+SelfCheckCache::Statistics SelfCheckCache::get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+int SelfCheckCache::run(DeviceBase& device) {
+    size_t parts = device.SelfCheckParts();
+    if (parts <= 1) {
+        return device.SelfCheck();
+    }
+    // 第0项在当前线程执行，其余各起一个线程；自检以秒计，线程创建开销可以忽略
+    std::vector<std::future<int>> others;
+    others.reserve(parts - 1);
+    for (size_t part = 1; part < parts; part++) {
+        others.push_back(std::async(std::launch::async, [&device, part] { return device.SelfCheckPart(part); }));
+    }
+    int code = device.SelfCheckPart(0);
+    for (auto& other : others) {
+        int result = other.get();
+        if (code <= 0 && result > 0) {
+            code = result;
+        }
+    }
+    return code;
+}
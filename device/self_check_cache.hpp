@@ -0,0 +1,66 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include "devicebase.hpp"
+
+/**
+ * @brief 设备自检结果缓存
+ *
+ * 自检（绝缘、继电器、急停、通信等）通常需要数秒，通过的结果在valid_ms内有效，
+ * 期间的启动直接跳过自检；失败结果不缓存，下次启动重新自检，故障排除后即可启动。
+ * 调用方在设备空闲时按begin_refresh发起后台自检（见Connector::refresh_self_check），
+ * 结果超过refresh_ms即刷新，使空闲设备的缓存一直有效。
+ * valid_ms为0时不缓存，每次启动都自检（默认）。所有方法线程安全。
+ */
+class SelfCheckCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Options {
+        int64_t valid_ms = 0;    // 通过结果的有效期，0为不缓存
+        int64_t refresh_ms = 0;  // 结果超过此时长后台刷新，应小于valid_ms
+    };
+
+    struct Statistics {
+        uint64_t hits = 0;        // 启动时使用了缓存的结果
+        uint64_t checks = 0;      // 实际执行的自检（启动前与后台刷新）
+        uint64_t refreshes = 0;   // 其中后台刷新
+        uint64_t failures = 0;
+        uint64_t stale = 0;       // 开始后缓存已失效而被丢弃的结果
+        int64_t max_check_us = 0;
+    };
+
+    SelfCheckCache();
+
+    void set_options(const Options& options);
+    Options options() const;
+
+    // 有效期内有通过的结果时计一次命中并返回true
+    bool take_passed(Clock::time_point now);
+    // 缓存已启用、没有进行中的刷新且结果缺失或已超过refresh_ms时标记刷新中并返回true，
+    // 之后须调用store或cancel_refresh
+    bool begin_refresh(Clock::time_point now);
+    void cancel_refresh();
+    // 当前代数，自检开始前取得，随结果交给store
+    uint64_t generation() const;
+    // 记录一次自检结果，code大于0为失败；有效期从自检开始时计算。
+    // 自检开始后缓存被置为失效（代数已变）的结果只计入统计，不更新缓存
+    void store(int code, Clock::time_point started, int64_t elapsed_us, bool refresh, uint64_t generation);
+    // 使当前结果及进行中的自检结果失效（设备启动失败、超时、会话结束等）
+    void invalidate();
+
+    Statistics get_statistics() const;
+
+    // 并发执行设备各子系统的自检，耗时为最慢的一项；返回第一个失败的自检码，全部通过返回0
+    static int run(DeviceBase& device);
+
+private:
+    mutable std::mutex mutex_;
+    Options options_;
+    Clock::time_point passed_at_;
+    bool passed_;
+    bool refreshing_;
+    uint64_t generation_;
+    Statistics stats_;
+};
@@ -0,0 +1,83 @@
+#include "sim_device.hpp"
+#include <algorithm>
+
+SimDevice::SimDevice(const std::string& id, const SimClock& clock, const Profile& profile, uint32_t seed)
+    : id_(id), clock_(clock), profile_(profile), rng_(seed), check_rng_(seed ^ 0x9e3779b9u),
+      noise_(0.0f, 1.0f), uniform_(0.0f, 1.0f), check_uniform_(0.0f, 1.0f),
+      running_(false), soc_(profile.initial_soc), last_kw_(0), last_ms_(-1),
+      dropout_until_ms_(0), dropouts_(0)
+{
+}
+
+bool SimDevice::Stop()
+{
+    running_ = false;
+    last_kw_ = 0;
+    return true;
+}
+
+bool SimDevice::Start()
+{
+    running_ = true;
+    last_ms_ = -1;
+    last_kw_ = 0;
+    dropout_until_ms_ = 0;
+    return true;
+}
+
+bool SimDevice::Pause()
+{
+    running_ = false;
+    return true;
+}
+
+int SimDevice::SelfCheck()
+{
+    return check_uniform_(check_rng_) < profile_.self_check_fail_rate ? 1 : 0;
+}
+
+// CC/CV曲线：恒流段输出额定功率，恒压段随SoC线性衰减到0
+float SimDevice::curve_kw() const
+{
+    if (soc_ < profile_.cv_soc) {
+        return profile_.max_kw;
+    }
+    float kw = profile_.max_kw * (1.0f - soc_) / (1.0f - profile_.cv_soc);
+    return kw < profile_.max_kw * 0.05f ? 0.0f : kw;
+}
+
+float SimDevice::GetPower()
+{
+    if (!running_) {
+        return 0;
+    }
+    int64_t now = clock_.now();
+    if (last_ms_ >= 0 && now > last_ms_) {
+        // 按上一周期的功率推进SoC
+        float dt_h = (now - last_ms_) / 3600000.0f;
+        soc_ = std::min(1.0f, soc_ + last_kw_ * dt_h / profile_.capacity_kwh);
+
+        // 中断按泊松过程发生
+        if (now >= dropout_until_ms_ && profile_.dropout_per_hour > 0 &&
+            uniform_(rng_) < profile_.dropout_per_hour * dt_h) {
+            dropout_until_ms_ = now + profile_.dropout_ms;
+            dropouts_++;
+        }
+    }
+    last_ms_ = now;
+
+    float kw = 0;
+    if (now >= dropout_until_ms_) {
+        kw = curve_kw();
+        if (kw > 0) {
+            kw = std::max(0.0f, kw + profile_.noise * profile_.max_kw * noise_(rng_));
+        }
+    }
+    last_kw_ = kw;
+    return kw;
+}
+
+std::string SimDevice::GetDeviceId()
+{
+    return id_;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include "devicebase.hpp"
+
+/**
+ * @brief 仿真时钟（UTC毫秒），由仿真主循环推进，设备只读
+ */
+class SimClock {
+public:
+    explicit SimClock(int64_t start_ms) : now_ms_(start_ms) {}
+    int64_t now() const { return now_ms_.load(std::memory_order_relaxed); }
+    void advance(int64_t delta_ms) { now_ms_.fetch_add(delta_ms, std::memory_order_relaxed); }
+private:
+    std::atomic<int64_t> now_ms_;
+};
+
+/**
+ * @brief 仿真充电设备
+ *
+ * 按恒流/恒压（CC/CV）曲线输出功率：SoC低于cv_soc时输出额定功率，
+ * 之后随SoC线性衰减，低于额定功率的5%视为充满，功率归零。
+ * 可叠加高斯噪声、自检失败与充电中断（功率掉零一段时间）。
+ * 所有随机量来自按seed初始化的私有随机数发生器，同一seed的结果可复现。
+ */
+class SimDevice : public DeviceBase
+{
+public:
+    struct Profile {
+        float max_kw = 7.0f;            // 额定功率
+        float capacity_kwh = 60.0f;     // 电池容量
+        float initial_soc = 0.2f;       // 起始SoC（0~1）
+        float cv_soc = 0.8f;            // 转入恒压阶段的SoC
+        float noise = 0.02f;            // 功率噪声（相对额定功率的标准差）
+        float self_check_fail_rate = 0; // 每次自检失败的概率
+        float dropout_per_hour = 0;     // 每小时充电中断次数期望
+        int64_t dropout_ms = 20000;     // 每次中断持续时间
+    };
+
+    SimDevice(const std::string& id, const SimClock& clock, const Profile& profile, uint32_t seed);
+
+    virtual bool Stop() ;
+    virtual bool Start() ;
+    virtual bool Pause() ;
+    virtual int SelfCheck() ;
+    virtual float GetPower() ;
+    virtual std::string GetDeviceId() ;
+
+    float soc() const { return soc_; }
+    uint64_t dropouts() const { return dropouts_; }
+
+private:
+    float curve_kw() const;
+
+    const std::string id_;
+    const SimClock& clock_;
+    const Profile profile_;
+    std::mt19937 rng_;        // 采样线程使用
+    std::mt19937 check_rng_;  // 命令执行线程使用（自检）
+    std::normal_distribution<float> noise_;
+    std::uniform_real_distribution<float> uniform_;
+    std::uniform_real_distribution<float> check_uniform_;
+
+    bool running_;
+    float soc_;
+    float last_kw_;
+    int64_t last_ms_;           // 上一次采样时间，-1表示刚启动
+    int64_t dropout_until_ms_;  // 中断结束时间
+    uint64_t dropouts_;
+};
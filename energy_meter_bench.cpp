@@ -0,0 +1,223 @@
+#include "station/energy_meter.hpp"
+#include "station/connector.hpp"
+#include "device/device.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <vector>
+
+// 测试功率曲线（kW）：基础负载 + 纹波 + 周期性短脉冲
+// 脉冲周期与采样网格不成整数倍，避免采样相位固定造成系统偏差
+static double power_at(int64_t t_ms) {
+    const double kPi = 3.14159265358979323846;
+    double t = t_ms / 1000.0;
+    double p = 7.0 + 1.5 * std::sin(2 * kPi * t / 2.3);
+    if (std::fmod(t, 4.1373) < 0.3517) {
+        p += 3.0;
+    }
+    return p;
+}
+
+static const int64_t kMsPerHour = 3600LL * 1000;
+
+struct Billing {
+    double kwh;
+    double cost;
+};
+
+// 参考值：1ms步长梯形积分，逐毫秒按电价时段计费
+static Billing reference(const PriceTable& table, int64_t start, int64_t end) {
+    Billing b = {0, 0};
+    double prev = power_at(start);
+    int64_t cached_minute = -1;
+    double price = 0;
+    for (int64_t t = start + 1; t <= end; t++) {
+        double p = power_at(t);
+        double e = (prev + p) * 0.5 / 3.6e6;
+        int64_t minute = (t - 1) / 60000;
+        if (minute != cached_minute) {
+            cached_minute = minute;
+            price = table.period_price(table.period_at(static_cast<time_t>(minute * 60)));
+        }
+        b.kwh += e;
+        b.cost += e * price;
+        prev = p;
+    }
+    return b;
+}
+
+// 旧算法：1Hz矩形积分，float累计到UTC小时桶，按整点单价计费
+static Billing rectangle_1hz(const PriceTable& table, int64_t start, int64_t end) {
+    std::vector<float> period_stats(24, 0.0f);
+    for (int64_t t = start + 1000; t <= end; t += 1000) {
+        int hour = static_cast<int>(t / 1000 / 3600 % 24);
+        period_stats[hour] = period_stats[hour] + static_cast<float>(power_at(t)) * (1.0 / 3600);
+    }
+    Billing b = {0, 0};
+    for (int i = 0; i < 24; i++) {
+        if (period_stats[i] == 0) continue;
+        b.kwh += period_stats[i];
+        b.cost += period_stats[i] * table.get_price(i);
+    }
+    return b;
+}
+
+static Billing trapezoid(const PriceTable& table, int64_t start, int64_t end, int hz) {
+    EnergyMeter meter;
+    meter.reset(table, true);
+    for (int64_t t = start; t <= end; t += 1000 / hz) {
+        meter.add_sample(t, power_at(t));
+    }
+    Billing b = {meter.total_kwh(), meter.total_cost()};
+    return b;
+}
+
+static void print_accuracy(const std::string& name, const Billing& b, const Billing& ref) {
+    std::cout << std::setw(14) << name
+              << std::setw(12) << std::fixed << std::setprecision(6) << b.kwh
+              << std::setw(10) << std::setprecision(4) << 100.0 * (b.kwh - ref.kwh) / ref.kwh
+              << std::setw(12) << std::setprecision(6) << b.cost
+              << std::setw(10) << std::setprecision(4) << 100.0 * (b.cost - ref.cost) / ref.cost
+              << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+
+    // 固定时区，保证结果可复现
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    // 带半点边界的电价表：07:30前后单价不同
+    const char* half_hour_path = "/tmp/energy_meter_bench_price.json";
+    {
+        std::ofstream out(half_hour_path);
+        out << "{\"price_list\": ["
+               "{\"start\": \"00:00\", \"end\": \"07:30\", \"price\": 0.3, \"service_fee\": 0.1},"
+               "{\"start\": \"07:30\", \"end\": \"19:00\", \"price\": 0.8, \"service_fee\": 0.1},"
+               "{\"start\": \"19:00\", \"end\": \"23:00\", \"price\": 1.0, \"service_fee\": 0.1}],"
+               "\"other_price\": 0.6, \"other_service_fee\": 0.1}";
+    }
+    PriceTable half_hour;
+    if (!half_hour.load(half_hour_path)) {
+        return 1;
+    }
+
+    // 20分钟充电，跨越07:30，边界不在采样网格上
+    const int64_t boundary = 20000LL * 24 * kMsPerHour + 7 * kMsPerHour + 30 * 60000;
+    const int64_t start = boundary - 600000 - 3;
+    const int64_t end = boundary + 600000 - 3;
+
+    Billing ref = reference(half_hour, start, end);
+    std::cout << std::setfill(' ');
+    std::cout << "\n精度：20分钟充电，跨越07:30电价边界，参考值为1ms步长积分 "
+              << std::fixed << std::setprecision(6) << ref.kwh << " kWh / " << ref.cost << " 元\n";
+    std::cout << std::setw(14) << "method"
+              << std::setw(12) << "kWh"
+              << std::setw(10) << "err %"
+              << std::setw(12) << "cost"
+              << std::setw(10) << "err %"
+              << "\n";
+    print_accuracy("rect 1Hz f32", rectangle_1hz(half_hour, start, end), ref);
+    const int rates[] = {1, 10, 100};
+    for (int hz : rates) {
+        print_accuracy("trap " + std::to_string(hz) + "Hz", trapezoid(half_hour, start, end, hz), ref);
+    }
+
+    // 开销：64个连接器、100Hz采样、1Hz上报（含充电信息JSON构建与序列化）
+    PriceStore prices;
+    if (prices.load_file(price_path) != PriceStore::RELOAD_OK) {
+        return 1;
+    }
+    const PriceTable& table = prices.current()->table;
+    size_t bytes = 0;
+    const size_t connector_count = 64;
+    const int hz = 100;
+    const int seconds = 60;
+    std::vector<std::unique_ptr<Connector>> connectors;
+    for (size_t i = 0; i < connector_count; i++) {
+        connectors.emplace_back(new Connector(make_connector_id(i), std::unique_ptr<DeviceBase>(new Device()), prices,
+            [&](const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+                bytes += content.dump().size();
+            }));
+        Command command;
+        command.cmd = DEVICE_CMD_COMMERCIAL_START;
+        command.device_id = connectors.back()->id();
+        command.topic = connectors.back()->topic(TOPIC_CMD);
+        connectors.back()->handle_command(command);
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    for (int64_t t = start; t < start + seconds * 1000; t += 1000 / hz) {
+        for (auto& connector : connectors) {
+            connector->tick(t);
+        }
+    }
+    double elapsed_us = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count() / 1000.0;
+
+    // 纯积分开销
+    std::vector<EnergyMeter> meters(connector_count);
+    for (auto& meter : meters) {
+        meter.reset(table, true);
+    }
+    auto meter_begin = std::chrono::steady_clock::now();
+    for (int64_t t = start; t < start + seconds * 1000; t += 1000 / hz) {
+        double p = 7.0 + (t & 7) * 0.01;
+        for (auto& meter : meters) {
+            meter.add_sample(t, p);
+        }
+    }
+    double meter_us = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - meter_begin).count() / 1000.0;
+
+    // 计费：旧算法每次上报按24个小时桶逐个查价，新算法读取累计值
+    EnergyMeter billed;
+    billed.reset(table, true);
+    std::vector<double> hour_kwh(24, 0);
+    for (int64_t t = start; t <= end; t += 10) {
+        billed.add_sample(t, power_at(t));
+        hour_kwh[t / kMsPerHour % 24] += power_at(t) * 10 / kMsPerHour;
+    }
+    const int reports = 1000000;
+    volatile double sink = 0;
+    auto full_begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < reports; r++) {
+        double total = 0;
+        for (int i = 0; i < 23; i++) {
+            total += hour_kwh[i] * table.get_price(i);
+        }
+        sink = sink + total;
+    }
+    double full_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - full_begin).count() / static_cast<double>(reports);
+    auto inc_begin = std::chrono::steady_clock::now();
+    for (int r = 0; r < reports; r++) {
+        sink = sink + billed.total_cost() + billed.total_kwh();
+    }
+    double inc_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - inc_begin).count() / static_cast<double>(reports);
+    double recomputed = 0;
+    for (size_t i = 0; i < billed.ledger().period_count(); i++) {
+        recomputed += billed.ledger().period_kwh(static_cast<int>(i)) * table.period_price(static_cast<int>(i));
+    }
+
+    double samples = static_cast<double>(connector_count) * hz * seconds;
+    std::cout << "\n开销：" << connector_count << "个连接器 " << hz << "Hz采样，模拟" << seconds << "秒\n";
+    std::cout << "  积分器          " << std::setprecision(1) << meter_us * 1000 / samples << " ns/采样\n";
+    std::cout << "  连接器tick      " << elapsed_us * 1000 / samples << " ns/采样（含1Hz上报）\n";
+    std::cout << "  单核占用        " << std::setprecision(3) << 100.0 * elapsed_us / (seconds * 1e6) << " %\n";
+    std::cout << "  上报字节        " << bytes << "\n";
+    std::cout << "\n计费：增量 " << std::setprecision(6) << billed.total_cost()
+              << " 元，按时段重算 " << recomputed << " 元\n";
+    std::cout << "  旧算法重算      " << std::setprecision(1) << full_ns << " ns/上报\n";
+    std::cout << "  增量累计        " << inc_ns << " ns/上报\n";
+    std::cout << "\n内存：账本 " << billed.ledger().memory_bytes() << " 字节/连接器（"
+              << billed.ledger().minute_count() << "/" << EnergyLedger::kDefaultWindowMinutes << " 分钟）\n";
+    return 0;
+}
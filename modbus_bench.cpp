@@ -0,0 +1,306 @@
+#include "station/station_runtime.hpp"
+#include "device/modbus_meter.hpp"
+#include "device/modbus_meter_sim.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include <cstdlib>
+#include <time.h>
+
+/**
+ * Modbus电表轮询测试
+ *
+ * 驱动与模拟电表经本地链路相连（RTU走pty，TCP走socketpair），一个线程轮询64块表，
+ * 每块表一次04读取全部测量寄存器。对比每秒可完成的轮询周期：
+ *   RTU：一问一答
+ *   TCP窗口1：同RTU，只是帧格式不同
+ *   TCP流水线：窗口内的请求一次写出，响应按事务ID匹配
+ * 模拟链路往返时延0与rtt_us两档，网关对每个请求的处理时间固定。
+ * 另外核对单元地址范围、读数、缓存、坏表超时与StationRuntime计量。
+ *
+ * 用法: modbus_bench <price.json> [表数=64] [往返时延us=500]
+ */
+
+namespace {
+
+const double kRunSeconds = 0.3;
+const int kProcessingUs = 5;
+const int64_t kStartMs = 1717977600000LL;
+
+struct Link {
+    std::unique_ptr<ModbusMeterSim> sim;
+    std::shared_ptr<ModbusMeterBus> bus;
+};
+
+Link open_link(ModbusFraming framing, size_t meters, size_t window, int rtt_us) {
+    Link link;
+    int driver_fd = -1, sim_fd = -1;
+    if (!ModbusMeterSim::open_link(framing, driver_fd, sim_fd)) {
+        return link;
+    }
+    ModbusMeterSim::Options sim_options;
+    sim_options.framing = framing;
+    sim_options.meters = meters;
+    sim_options.rtt_us = rtt_us;
+    sim_options.processing_us = kProcessingUs;
+    link.sim.reset(new ModbusMeterSim(sim_fd, sim_options));
+    ModbusMeterBus::Options bus_options;
+    bus_options.framing = framing;
+    bus_options.window = window;
+    bus_options.timeout_ms = 50;
+    link.bus = std::make_shared<ModbusMeterBus>(driver_fd, meters, bus_options);
+    return link;
+}
+
+double thread_cpu_us() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+// 64个通道的采样缓冲
+struct Span {
+    explicit Span(size_t n) : channel(n), voltage(n), current(n), power(n), timestamp(n) {
+        for (size_t i = 0; i < n; i++) {
+            channel[i] = static_cast<uint32_t>(i);
+        }
+    }
+    SampleSpan view() {
+        return SampleSpan{channel.size(), channel.data(), voltage.data(), current.data(), power.data(),
+                          timestamp.data()};
+    }
+    std::vector<uint32_t> channel;
+    std::vector<float> voltage, current, power;
+    std::vector<int64_t> timestamp;
+};
+
+struct Rate {
+    double cycles_per_s;
+    double us_per_cycle;
+    double cpu_us_per_cycle;
+    bool complete;  // 每个周期都读到全部表
+};
+
+Rate measure(ModbusFraming framing, size_t meters, size_t window, int rtt_us) {
+    Rate rate = {0, 0, 0, false};
+    Link link = open_link(framing, meters, window, rtt_us);
+    if (!link.bus) {
+        return rate;
+    }
+    Span span(meters);
+    SampleSpan samples = span.view();
+    int64_t now_ms = kStartMs;
+    int cycles = 0;
+    rate.complete = true;
+    double cpu_begin = thread_cpu_us();
+    auto begin = std::chrono::steady_clock::now();
+    double elapsed = 0;
+    while (elapsed < kRunSeconds) {
+        // 每次推进一个缓存期，保证每个周期都访问总线
+        now_ms += 50;
+        link.bus->ReadSamples(samples, now_ms);
+        for (size_t i = 0; i < meters; i++) {
+            rate.complete = rate.complete && span.timestamp[i] == now_ms;
+        }
+        cycles++;
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    rate.cycles_per_s = cycles / elapsed;
+    rate.us_per_cycle = elapsed * 1e6 / cycles;
+    rate.cpu_us_per_cycle = (thread_cpu_us() - cpu_begin) / cycles;
+    return rate;
+}
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "   失败: " << what << std::endl;
+        failures++;
+    }
+}
+
+// 单元地址范围：0是广播地址，最后一块表不能超过247
+bool accepts(uint8_t first_unit, size_t meters) {
+    ModbusMeterBus::Options options;
+    options.first_unit = first_unit;
+    try {
+        ModbusMeterBus bus(-1, meters, options);
+        return bus.ChannelCount() == meters;
+    }
+    catch (const std::invalid_argument&) {
+        return false;
+    }
+}
+
+void check_addresses() {
+    check(accepts(1, MODBUS_MAX_UNIT) && accepts(200, 48), "合法的地址范围被拒绝");
+    check(!accepts(MODBUS_BROADCAST_UNIT, 1), "起始地址为广播地址");
+    check(!accepts(200, 49) && !accepts(1, 256), "地址超过247或回绕到广播地址");
+    std::cout << "   完成" << std::endl;
+}
+
+// 读数、缓存与坏表
+void check_driver(ModbusFraming framing, size_t meters) {
+    Link link = open_link(framing, meters, 16, 0);
+    check(link.bus != nullptr, "无法创建链路");
+    if (!link.bus) {
+        return;
+    }
+    ModbusMeterBus& bus = *link.bus;
+    const char* name = framing == MODBUS_RTU ? "RTU" : "TCP";
+    for (uint32_t i = 0; i < meters; i++) {
+        check(bus.SelfCheck(i) == 0 && bus.Start(i), std::string(name) + " 自检或合闸失败");
+    }
+    check(link.sim->relay(0) && link.sim->relay(static_cast<uint32_t>(meters - 1)), "继电器未闭合");
+
+    Span span(meters);
+    SampleSpan samples = span.view();
+    bool values = bus.ReadSamples(samples, kStartMs);
+    for (size_t i = 0; i < meters; i++) {
+        float kw = 3.0f + 0.05f * static_cast<float>(i);
+        values = values && span.power[i] == kw && span.voltage[i] == 230.0f &&
+                 std::fabs(span.current[i] - kw * 1000.0f / 230.0f) < 1e-3f && span.timestamp[i] == kStartMs;
+    }
+    check(values, std::string(name) + " 读数与模拟电表不符");
+
+    // 同一周期内再次读取全部命中缓存
+    ModbusMeterBus::Statistics before = bus.get_statistics();
+    bus.ReadSamples(samples, kStartMs + 10);
+    ModbusMeterBus::Statistics after = bus.get_statistics();
+    check(after.requests == before.requests && after.cache_hits - before.cache_hits == meters,
+          std::string(name) + " 缓存期内访问了总线");
+
+    // 坏表：本周期超时一次，其余照常；同一周期内不再重复等待
+    link.sim->set_silent(5, true);
+    link.sim->set_self_check_code(7, 3);
+    bus.ReadSamples(samples, kStartMs + 100);
+    bool others = true;
+    for (size_t i = 0; i < meters; i++) {
+        others = others && (i == 5 ? span.timestamp[i] == -1 : span.timestamp[i] == kStartMs + 100);
+    }
+    check(others, std::string(name) + " 坏表影响了其他表或未标记为失败");
+    before = bus.get_statistics();
+    bus.ReadSamples(samples, kStartMs + 110);
+    after = bus.get_statistics();
+    check(before.timeouts == 1 && after.timeouts == 1 && after.requests == before.requests,
+          std::string(name) + " 坏表超时次数不符");
+    check(bus.SelfCheck(5) == ERRORCODE_NETWORK && bus.SelfCheck(7) == 3, std::string(name) + " 自检码不符");
+    link.sim->set_silent(5, false);
+    check(bus.Stop(0) && !link.sim->relay(0), std::string(name) + " 分闸失败");
+    ModbusMeterSim::Statistics sim = link.sim->get_statistics();
+    check(sim.decode_errors == 0 && after.decode_errors == 0, std::string(name) + " 出现解码错误");
+    std::cout << "   " << name << ": 请求 " << after.requests << ", 超时 " << after.timeouts << ", 迟到 "
+              << after.unmatched << ", 缓存命中 " << after.cache_hits << std::endl;
+}
+
+// 经StationRuntime启动、计量与停止，核对计量电量
+void check_runtime(const PriceStore& prices, size_t meters) {
+    std::map<std::string, double> energy;
+    StationRuntime runtime(prices, [&energy](const std::string&, const nlohmann::json& content, uint8_t, bool) {
+        if (content["cmd"].get<int>() == DEVICE_CMD_CHARGE_INFO) {
+            energy[content["device_id"].get<std::string>()] = content["charge_info"]["all_energy"].get<double>();
+        }
+    });
+    Link link = open_link(MODBUS_TCP, meters, 16, 0);
+    for (size_t i = 0; i < meters; i++) {
+        runtime.add_connector(make_connector_id(i),
+                              std::unique_ptr<DeviceBase>(new ChannelDevice(link.bus, static_cast<uint32_t>(i))));
+    }
+    auto dispatch_all = [&runtime](int cmd) {
+        for (const auto& connector : runtime.connectors()) {
+            Command command;
+            command.cmd = cmd;
+            command.device_id = connector->id();
+            command.topic = connector->topic(TOPIC_CMD);
+            runtime.dispatch(command);
+        }
+    };
+    dispatch_all(DEVICE_CMD_COMMERCIAL_START);
+    bool relays = true;
+    for (uint32_t i = 0; i < meters; i++) {
+        relays = relays && link.sim->relay(i);
+    }
+    check(relays, "启动命令未闭合继电器");
+
+    // 采样时间由调用方给出，10个1秒周期
+    const int rounds = 10;
+    for (int round = 0; round < rounds; round++) {
+        runtime.tick(kStartMs + round * 1000);
+    }
+    dispatch_all(DEVICE_CMD_STOP);
+    relays = false;
+    for (uint32_t i = 0; i < meters; i++) {
+        relays = relays || link.sim->relay(i);
+    }
+    check(!relays, "停止命令未断开继电器");
+
+    double total = 0, expected = 0;
+    for (size_t i = 0; i < meters; i++) {
+        expected += (3.0 + 0.05 * i) * (rounds - 1) / 3600.0;
+    }
+    for (const auto& item : energy) {
+        total += item.second;
+    }
+    check(energy.size() == meters && std::fabs(total - expected) < 1e-3 * expected, "计量电量与电表功率不符");
+    std::cout << "   StationRuntime: " << meters << " 路, 计量 " << std::fixed << std::setprecision(4) << total
+              << " kWh, 期望 " << expected << " kWh" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    size_t meters = argc > 2 ? static_cast<size_t>(atoi(argv[2])) : 64;
+    int rtt_us = argc > 3 ? atoi(argv[3]) : 500;
+    PriceStore prices;
+    if (prices.load_file(price_path) != PriceStore::RELOAD_OK || meters == 0 || meters > MODBUS_MAX_UNIT) {
+        return 1;
+    }
+
+    std::cout << "=== Modbus电表轮询: " << meters << " 块表, 单线程, 网关处理 " << kProcessingUs << "us/请求 ===" << std::endl;
+    std::cout << std::setw(8) << "往返us" << std::setw(14) << "方式" << std::setw(12) << "周期/s"
+              << std::setw(12) << "读表/s" << std::setw(12) << "us/周期" << std::setw(14) << "CPU us/周期" << std::endl;
+    struct Mode {
+        const char* name;
+        ModbusFraming framing;
+        size_t window;
+    };
+    const Mode modes[] = {{"RTU", MODBUS_RTU, 1}, {"TCP窗口1", MODBUS_TCP, 1},
+                          {"TCP窗口8", MODBUS_TCP, 8}, {"TCP窗口64", MODBUS_TCP, 64}};
+    for (int rtt : {0, rtt_us}) {
+        double sequential = 0;
+        for (const Mode& mode : modes) {
+            Rate rate = measure(mode.framing, meters, mode.window, rtt);
+            check(rate.complete, std::string(mode.name) + " 有周期未读全");
+            if (mode.framing == MODBUS_TCP && mode.window == 1) {
+                sequential = rate.cycles_per_s;
+            }
+            std::cout << std::fixed << std::setw(8) << rtt << std::setw(14) << mode.name
+                      << std::setw(12) << std::setprecision(0) << rate.cycles_per_s
+                      << std::setw(12) << rate.cycles_per_s * meters
+                      << std::setw(12) << std::setprecision(1) << rate.us_per_cycle
+                      << std::setw(14) << rate.cpu_us_per_cycle;
+            if (mode.window > 1 && sequential > 0) {
+                std::cout << "   " << std::setprecision(1) << rate.cycles_per_s / sequential << "x";
+            }
+            std::cout << std::endl;
+        }
+    }
+
+    std::cout << "\n--- 单元地址范围 ---" << std::endl;
+    check_addresses();
+    std::cout << "\n--- 读数、缓存与坏表 ---" << std::endl;
+    check_driver(MODBUS_RTU, meters);
+    check_driver(MODBUS_TCP, meters);
+    std::cout << "\n--- StationRuntime ---" << std::endl;
+    check_runtime(prices, meters);
+
+    std::cout << "\n=== " << (failures ? "测试失败" : "所有测试通过") << " ===" << std::endl;
+    return failures ? 1 : 0;
+}
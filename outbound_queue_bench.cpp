@@ -0,0 +1,273 @@
+#include "station/outbound_queue.hpp"
+#include "station/station_types.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// 全局分配计数
+static std::atomic<unsigned long long> g_allocations(0);
+static std::atomic<unsigned long long> g_allocated_bytes(0);
+
+void* operator new(size_t size) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    g_allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+// 原实现：json按值存储，入队/出队各拷贝一次，持锁序列化
+struct MQTT_MSG{
+    std::string topic;
+    nlohmann::json content;
+    uint8_t qos;
+    bool retain;
+
+    MQTT_MSG(){
+        this->topic = "";
+        this->content = nlohmann::json();
+        this->qos = 0;
+        this->retain = false;
+    }
+
+    MQTT_MSG(const MQTT_MSG& other){
+        this->topic = other.topic;
+        this->content = other.content;
+        this->qos = other.qos;
+        this->retain = other.retain;
+    }
+
+    MQTT_MSG(std::string topic,nlohmann::json content,uint8_t qos,bool retain){
+        this->topic = topic;
+        this->content = content;
+        this->qos = qos;
+        this->retain = retain;
+    }
+
+    MQTT_MSG &operator=(const MQTT_MSG &msg){
+        this->topic = msg.topic;
+        this->content = msg.content;
+        this->qos = msg.qos;
+        this->retain = msg.retain;
+        return *this;
+    }
+};
+
+// 模拟MQTT客户端把报文拷入发送缓冲区
+struct Sink {
+    char buffer[4096];
+    unsigned long long bytes = 0;
+    void publish(const std::string& topic, const std::string& payload) {
+        size_t n = std::min(payload.size(), sizeof(buffer));
+        std::memcpy(buffer, payload.data(), n);
+        bytes += topic.size() + payload.size();
+    }
+};
+
+class LegacyQueue {
+public:
+    void push(const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+        push_msg(MQTT_MSG(topic, content, qos, retain));
+    }
+    bool send(Sink& sink) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (queue_.empty()) {
+            return false;
+        }
+        MQTT_MSG msg;
+        while (queue_.size()) {
+            msg = queue_.front();
+            queue_.pop();
+            sink.publish(msg.topic, msg.content.dump());
+        }
+        return true;
+    }
+private:
+    void push_msg(MQTT_MSG msg) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queue_.push(msg);
+    }
+    std::mutex mutex_;
+    std::queue<MQTT_MSG> queue_;
+};
+
+class PooledQueue {
+public:
+    void push(const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+        queue_.push(topic, content, qos, retain);
+    }
+    bool send(Sink& sink) {
+        if (!queue_.drain(batch_)) {
+            return false;
+        }
+        for (const auto& msg : batch_) {
+            sink.publish(msg.topic, msg.payload);
+        }
+        queue_.release(batch_);
+        return true;
+    }
+private:
+    OutboundQueue queue_;
+    std::vector<OutboundMessage> batch_;
+};
+
+static nlohmann::json make_charge_info(size_t index) {
+    ChargeInfo info(START_TYPE_COMMERCIAL, "commercial start", "2024-06-10 08:00:00", "");
+    info.total = 12.34f + index;
+    info.all_energy = 23.45f;
+    info.period_stats = {1.5f, 2.25f, 3.125f, 0.0f, 4.0f, 0.5f};
+    return info;
+}
+
+template <typename Queue>
+static void run(const char* name, size_t producers, size_t per_producer) {
+    Queue queue;
+    Sink sink;
+    std::atomic<bool> done(false);
+    std::atomic<unsigned long long> push_ns(0);
+    std::atomic<unsigned long long> push_max_ns(0);
+
+    // 每个生产者（连接器）持有自己的json与主题，与Publisher的const引用接口一致
+    std::vector<nlohmann::json> contents;
+    std::vector<std::string> topics;
+    for (size_t p = 0; p < producers; p++) {
+        contents.push_back(make_charge_info(p));
+        topics.push_back(std::string(TOPIC_STATUS) + make_connector_id(p));
+    }
+
+    unsigned long long allocs_before = g_allocations.load();
+    unsigned long long bytes_before = g_allocated_bytes.load();
+    auto begin = std::chrono::steady_clock::now();
+
+    std::thread consumer([&]() {
+        while (!done.load(std::memory_order_acquire)) {
+            if (!queue.send(sink)) {
+                std::this_thread::yield();
+            }
+        }
+        while (queue.send(sink)) {
+        }
+    });
+
+    std::vector<std::thread> threads;
+    for (size_t p = 0; p < producers; p++) {
+        threads.emplace_back([&, p]() {
+            unsigned long long local_ns = 0;
+            unsigned long long local_max = 0;
+            for (size_t i = 0; i < per_producer; i++) {
+                auto t0 = std::chrono::steady_clock::now();
+                queue.push(topics[p], contents[p], 0, false);
+                unsigned long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - t0).count();
+                local_ns += ns;
+                local_max = std::max(local_max, ns);
+            }
+            push_ns += local_ns;
+            unsigned long long seen = push_max_ns.load();
+            while (local_max > seen && !push_max_ns.compare_exchange_weak(seen, local_max)) {
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count() / 1e6;
+    double total = static_cast<double>(producers * per_producer);
+    std::cout << std::left << std::setw(22) << name << std::right
+              << std::setw(6) << producers
+              << std::setw(14) << std::fixed << std::setprecision(0) << total / seconds
+              << std::setw(12) << std::setprecision(2) << (g_allocations.load() - allocs_before) / total
+              << std::setw(14) << std::setprecision(1) << (g_allocated_bytes.load() - bytes_before) / total
+              << std::setw(12) << std::setprecision(0) << push_ns.load() / total
+              << std::setw(14) << push_max_ns.load() / 1000.0
+              << std::setw(14) << sink.bytes
+              << "\n";
+}
+
+// 稳态：每个周期所有连接器各上报一条，主循环随后一次发送完（与充电桩主循环节奏一致）
+template <typename Queue>
+static void run_steady(const char* name, size_t connectors, size_t rounds) {
+    Queue queue;
+    Sink sink;
+    nlohmann::json content = make_charge_info(0);
+    std::vector<std::string> topics;
+    for (size_t c = 0; c < connectors; c++) {
+        topics.push_back(std::string(TOPIC_STATUS) + make_connector_id(c));
+    }
+    // 预热一轮
+    for (size_t c = 0; c < connectors; c++) {
+        queue.push(topics[c], content, 0, false);
+    }
+    queue.send(sink);
+
+    unsigned long long allocs_before = g_allocations.load();
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t r = 0; r < rounds; r++) {
+        for (size_t c = 0; c < connectors; c++) {
+            queue.push(topics[c], content, 0, false);
+        }
+        queue.send(sink);
+    }
+    double seconds = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - begin).count() / 1e6;
+    double total = static_cast<double>(connectors * rounds);
+    std::cout << std::left << std::setw(22) << name << std::right
+              << std::setw(6) << connectors
+              << std::setw(14) << std::fixed << std::setprecision(0) << total / seconds
+              << std::setw(12) << std::setprecision(2) << (g_allocations.load() - allocs_before) / total
+              << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    size_t per_producer = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 50000;
+
+    std::cout << "=== 出站队列：分配次数与吞吐 (每生产者 " << per_producer << " 条充电信息，生产者不限速) ===\n";
+    std::cout << std::left << std::setw(22) << "queue" << std::right
+              << std::setw(6) << "prod"
+              << std::setw(14) << "msgs/s"
+              << std::setw(12) << "allocs/msg"
+              << std::setw(14) << "bytes/msg"
+              << std::setw(12) << "push ns"
+              << std::setw(14) << "push max us"
+              << std::setw(14) << "sent bytes"
+              << "\n";
+    const size_t producer_counts[] = {1, 4, 16};
+    for (size_t producers : producer_counts) {
+        run<LegacyQueue>("MQTT_MSG (copy)", producers, per_producer);
+        run<PooledQueue>("OutboundQueue (pool)", producers, per_producer);
+    }
+
+    std::cout << "\n=== 稳态（每轮每连接器一条，随后发送）===\n";
+    std::cout << std::left << std::setw(22) << "queue" << std::right
+              << std::setw(6) << "conn"
+              << std::setw(14) << "msgs/s"
+              << std::setw(12) << "allocs/msg"
+              << "\n";
+    const size_t connector_counts[] = {1, 16, 128};
+    for (size_t connectors : connector_counts) {
+        run_steady<LegacyQueue>("MQTT_MSG (copy)", connectors, per_producer / connectors + 1);
+        run_steady<PooledQueue>("OutboundQueue (pool)", connectors, per_producer / connectors + 1);
+    }
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "config/price_table.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+
+/**
+ * 电价查询性能测试
+ *
+ * 原实现每次查询都调用localtime_r并逐项扫描price_list；现在load时编译成每分钟一项的查找表，
+ * 查询按缓存的UTC偏移直接下标访问。先逐分钟核对两种实现在两天内（含跨日）结果一致，
+ * 再各做1000万次查询比较耗时。
+ */
+
+namespace {
+
+// 原实现，作为对照
+struct LegacyPeriod {
+    int start_minutes;
+    int end_minutes;
+    double price;
+};
+
+std::vector<LegacyPeriod> legacy_periods(const PriceTable& table) {
+    std::vector<LegacyPeriod> periods;
+    for (int i = 0; i < table.other_period(); i++) {
+        LegacyPeriod p;
+        p.start_minutes = PriceTable::kMinutesPerDay;
+        p.end_minutes = 0;
+        for (int m = 0; m < PriceTable::kMinutesPerDay; m++) {
+            if (table.period_at_minute(m) == i) {
+                p.start_minutes = std::min(p.start_minutes, m);
+                p.end_minutes = std::max(p.end_minutes, m + 1);
+            }
+        }
+        p.price = table.period_price(i);
+        periods.push_back(p);
+    }
+    return periods;
+}
+
+double legacy_get_price(const std::vector<LegacyPeriod>& periods, double other, time_t unix_time) {
+    struct tm tm_time;
+    localtime_r(&unix_time, &tm_time);
+    int minutes = tm_time.tm_hour * 60 + tm_time.tm_min;
+    for (const auto& p : periods) {
+        if (p.start_minutes <= minutes && minutes < p.end_minutes) {
+            return p.price;
+        }
+    }
+    return other;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0] << " <price.json> [lookups=10000000]" << std::endl;
+        return 1;
+    }
+    PriceTable table;
+    if (!table.load(argv[1])) {
+        return 1;
+    }
+    std::cout << std::setfill(' ');
+    const size_t lookups = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 10000000;
+    const std::vector<LegacyPeriod> periods = legacy_periods(table);
+    const double other = table.period_price(table.other_period());
+
+    // 偏移按测试时段取（与主循环在心跳时刷新相同），测试时段内不跨夏令时切换
+    const time_t base = 1700000000;
+    table.refresh_utc_offset(base);
+    size_t mismatches = 0;
+    for (time_t t = base; t < base + 2 * 86400; t += 60) {
+        if (legacy_get_price(periods, other, t) != table.get_price(t)) {
+            mismatches++;
+        }
+    }
+    std::cout << "=== 电价查询: UTC偏移 " << table.utc_offset() << " 秒, 逐分钟核对两天 "
+              << (mismatches == 0 ? "一致" : "不一致") << " (" << mismatches << " 处差异) ===\n";
+
+    // 查询时间戳：充电会话中按秒推进，带少量抖动，两种实现使用同一序列
+    std::vector<time_t> times(4096);
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < times.size(); i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        times[i] = base + static_cast<time_t>(state % (7 * 86400));
+    }
+
+    auto measure = [&](const char* name, double (*lookup)(const PriceTable&, const std::vector<LegacyPeriod>&, double, time_t)) {
+        double checksum = 0;
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < lookups; i++) {
+            checksum += lookup(table, periods, other, times[i & (times.size() - 1)] + static_cast<time_t>(i));
+        }
+        auto end = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(end - begin).count();
+        std::cout << std::left << std::setw(20) << name << std::right << std::fixed
+                  << std::setprecision(2) << std::setw(10) << ns / lookups << " ns/次"
+                  << std::setprecision(1) << std::setw(12) << lookups / (ns / 1e9) / 1e6 << " M次/s"
+                  << "   checksum " << std::setprecision(3) << checksum << "\n";
+        return ns;
+    };
+
+    double legacy_ns = measure("localtime_r + scan", [](const PriceTable&, const std::vector<LegacyPeriod>& p, double o, time_t t) {
+        return legacy_get_price(p, o, t);
+    });
+    double table_ns = measure("minute table", [](const PriceTable& tb, const std::vector<LegacyPeriod>&, double, time_t t) {
+        return tb.get_price(t);
+    });
+    measure("period_at", [](const PriceTable& tb, const std::vector<LegacyPeriod>&, double, time_t t) {
+        return static_cast<double>(tb.period_at(t));
+    });
+    std::cout << "加速比 " << std::setprecision(1) << legacy_ns / table_ns << "x\n";
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,202 @@
+#include "config/price_store.hpp"
+#include "config/price_watcher.hpp"
+#include "station/energy_meter.hpp"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <unistd.h>
+
+/**
+ * 电价热更新测试
+ *
+ * 1. 计费：恒定功率充电，会话中途切换电价，切换前后的电量分别按各自电价结算
+ * 2. 并发：多个读线程按采样路径读取电价（比较版本号，变化时取快照），写线程不断交替发布两套电价，
+ *    统计读取开销，并校验每个快照内的电价与其版本一致（不会读到半更新的表）
+ * 3. 文件监视：改名替换price.json后，到新版本可见的延迟
+ */
+
+namespace {
+
+const int64_t kMsPerMinute = 60000;
+
+// 全天单一电价，便于核对
+std::string flat_tariff(double price) {
+    char text[160];
+    snprintf(text, sizeof(text),
+             "{\"price_list\": [{\"start\": \"00:00\", \"end\": \"24:00\", \"price\": %.2f, \"service_fee\": 0.1}],"
+             " \"other_price\": 0, \"other_service_fee\": 0}", price);
+    return text;
+}
+
+double elapsed_ms(std::chrono::steady_clock::time_point begin) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void bench_billing() {
+    PriceStore prices;
+    prices.load_text(flat_tariff(0.5), "bench");
+    PriceSnapshotPtr tariff = prices.current();
+
+    // 7kW充电30分钟，第10分钟20秒时更新电价：当前分钟仍按旧价，第11分钟起按新价
+    const int64_t start = 28000000LL * kMsPerMinute;
+    const int64_t switch_at = start + 10 * kMsPerMinute + 20000;
+    const int64_t end = start + 30 * kMsPerMinute;
+    EnergyMeter meter;
+    meter.reset(tariff->table, true);
+    uint64_t seen = prices.version();
+    for (int64_t t = start; t <= end; t += 100) {
+        if (t == switch_at) {
+            prices.load_text(flat_tariff(1.2), "bench");
+        }
+        if (prices.version() != seen) {
+            tariff = prices.current();
+            seen = tariff->version;
+            meter.switch_tariff(tariff->table);
+        }
+        meter.add_sample(t, 7.0);
+    }
+    const double old_kwh = 7.0 * 11 / 60;
+    const double new_kwh = 7.0 * 19 / 60;
+    const double expected = old_kwh * 0.6 + new_kwh * 1.3;
+    std::cout << "计费: 30分钟 " << std::fixed << std::setprecision(4) << meter.total_kwh() << " kWh, 费用 "
+              << meter.total_cost() << " 元, 预期 " << expected << " 元 (11分钟@0.6 + 19分钟@1.3), "
+              << (std::fabs(meter.total_cost() - expected) < 1e-6 ? "一致" : "不一致")
+              << ", 账本时段 " << meter.ledger().period_count() << "\n";
+}
+
+void bench_readers(size_t readers, int reload_hz, int millis) {
+    PriceStore prices;
+    const std::string tariffs[2] = {flat_tariff(0.5), flat_tariff(0.9)};
+    prices.load_text(tariffs[0], "bench");
+
+    std::atomic<bool> stop(false);
+    std::atomic<unsigned long long> reads(0), switches(0), torn(0);
+    std::vector<std::thread> threads;
+    for (size_t r = 0; r < readers; r++) {
+        threads.emplace_back([&]() {
+            PriceSnapshotPtr tariff = prices.current();
+            uint64_t seen = tariff->version;
+            unsigned long long local_reads = 0, local_switches = 0, local_torn = 0;
+            time_t t = 1700000000;
+            while (!stop.load(std::memory_order_relaxed)) {
+                if (prices.version() != seen) {
+                    tariff = prices.current();
+                    seen = tariff->version;
+                    local_switches++;
+                    // 奇数版本为tariffs[0]，偶数版本为tariffs[1]
+                    double expected = (seen % 2 ? 0.5 : 0.9) + 0.1;
+                    if (tariff->table.get_price(t) != expected) {
+                        local_torn++;
+                    }
+                }
+                local_reads++;
+                t += 1;
+            }
+            reads += local_reads;
+            switches += local_switches;
+            torn += local_torn;
+        });
+    }
+    unsigned long long published = 0;
+    auto begin = std::chrono::steady_clock::now();
+    while (elapsed_ms(begin) < millis) {
+        if (reload_hz > 0) {
+            prices.load_text(tariffs[published % 2 ? 0 : 1], "bench");
+            published++;
+            std::this_thread::sleep_for(std::chrono::microseconds(1000000 / reload_hz));
+        } else {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    stop = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    double seconds = millis / 1000.0;
+    std::cout << std::setw(8) << readers << std::setw(10) << reload_hz
+              << std::setw(14) << std::setprecision(1) << reads.load() / seconds / 1e6
+              << std::setw(12) << published
+              << std::setw(12) << switches.load()
+              << std::setw(8) << torn.load() << "\n";
+}
+
+void bench_watcher(int rounds) {
+    char dir_template[] = "/tmp/price_reload_XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        return;
+    }
+    const std::string dir = dir_template;
+    const std::string path = dir + "/price.json";
+    auto write_atomic = [&](const std::string& text) {
+        std::string tmp = path + ".tmp";
+        std::ofstream(tmp) << text;
+        rename(tmp.c_str(), path.c_str());
+    };
+    write_atomic(flat_tariff(0.5));
+
+    PriceStore prices;
+    prices.load_file(path);
+    std::atomic<unsigned long long> errors(0);
+    PriceWatcher watcher(prices, path, [&](PriceStore::ReloadResult result, const PriceSnapshotPtr&) {
+        if (result == PriceStore::RELOAD_ERROR) {
+            errors++;
+        }
+    });
+    if (!watcher.start()) {
+        std::cout << "文件监视: inotify不可用\n";
+        return;
+    }
+    double total_ms = 0, max_ms = 0;
+    int seen = 0;
+    for (int i = 0; i < rounds; i++) {
+        uint64_t before = prices.version();
+        auto begin = std::chrono::steady_clock::now();
+        write_atomic(flat_tariff(0.5 + 0.01 * (i + 1)));
+        while (prices.version() == before && elapsed_ms(begin) < 1000) {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        if (prices.version() != before) {
+            double ms = elapsed_ms(begin);
+            total_ms += ms;
+            max_ms = std::max(max_ms, ms);
+            seen++;
+        }
+    }
+    // 格式错误的文件不发布新版本
+    uint64_t before = prices.version();
+    write_atomic("{\"price_list\": [");
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    bool kept = prices.version() == before;
+    watcher.stop();
+    std::cout << "文件监视: " << seen << "/" << rounds << " 次更新可见, 平均 " << std::setprecision(2)
+              << (seen ? total_ms / seen : 0) << " ms, 最大 " << max_ms << " ms; 损坏文件"
+              << (kept && errors.load() == 1 ? "被拒绝，保留旧版本" : "处理异常") << "\n";
+    unlink(path.c_str());
+    rmdir(dir.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int millis = argc > 1 ? std::atoi(argv[1]) : 1000;
+    std::cout << "=== 电价热更新 ===\n";
+    bench_billing();
+    std::cout << "\n并发读取（每次采样比较版本号，变化时取快照并校验）\n";
+    std::cout << std::setw(8) << "readers" << std::setw(10) << "reload/s"
+              << std::setw(14) << "M reads/s" << std::setw(12) << "published"
+              << std::setw(12) << "switches" << std::setw(8) << "torn" << "\n";
+    const size_t reader_counts[] = {1, 4};
+    for (size_t readers : reader_counts) {
+        bench_readers(readers, 0, millis);
+        bench_readers(readers, 1000, millis);
+    }
+    std::cout << "\n";
+    bench_watcher(50);
+    return 0;
+}
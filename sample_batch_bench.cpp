@@ -0,0 +1,173 @@
+#include "station/station_runtime.hpp"
+#include "device/channel_device.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+
+/**
+ * 批量采样测试
+ *
+ * 一个多通道控制器带N路连接器，每次总线事务有固定往返开销（忙等模拟）加每通道的传输开销。
+ * 对比两种采样方式每个采样周期的耗时：
+ *   逐个：每个连接器单独成组，经DeviceBase默认适配调用GetPower，N次事务
+ *   批量：同一控制器的通道合并为一次ReadSamples，1次事务
+ * 两种方式功率读数相同，核对计量得到的总电量一致。
+ *
+ * 用法: sample_batch_bench <price.json> [事务开销us=100]
+ */
+
+namespace {
+
+const int kRounds = 50;
+const int64_t kStartMs = 1717977600000LL;
+const int64_t kIntervalMs = 100;
+
+void spin_us(double us) {
+    auto until = std::chrono::steady_clock::now() + std::chrono::nanoseconds(static_cast<int64_t>(us * 1000));
+    while (std::chrono::steady_clock::now() < until) {
+    }
+}
+
+// 模拟控制器：每次ReadSamples一次事务，功率只与通道号有关
+class SimBusController : public ChannelController {
+public:
+    SimBusController(size_t channels, double transaction_us)
+        : running_(channels, false), transaction_us_(transaction_us), transactions_(0) {}
+
+    virtual size_t ChannelCount() { return running_.size(); }
+    virtual bool Start(uint32_t channel) { return set_running(channel, true); }
+    virtual bool Stop(uint32_t channel) { return set_running(channel, false); }
+    virtual bool Pause(uint32_t channel) { return set_running(channel, false); }
+    virtual int SelfCheck(uint32_t) { return 0; }
+    virtual std::string GetId() { return "bus"; }
+
+    virtual bool ReadSamples(const SampleSpan& samples, int64_t now_ms) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        transactions_++;
+        spin_us(transaction_us_ * (1.0 + 0.02 * samples.size));  // 往返 + 每通道寄存器
+        for (size_t i = 0; i < samples.size; i++) {
+            uint32_t channel = samples.channel[i];
+            float kw = running_[channel] ? 3.0f + 0.05f * channel : 0.0f;
+            samples.voltage_v[i] = 230.0f;
+            samples.current_a[i] = kw * 1000.0f / 230.0f;
+            samples.power_kw[i] = kw;
+            samples.timestamp_ms[i] = now_ms;
+        }
+        return true;
+    }
+
+    uint64_t transactions() const { return transactions_; }
+
+private:
+    bool set_running(uint32_t channel, bool running) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_[channel] = running;
+        return true;
+    }
+
+    std::mutex mutex_;
+    std::vector<bool> running_;
+    const double transaction_us_;
+    uint64_t transactions_;
+};
+
+// 不合并采样：每个通道单独成组，经DeviceBase的默认适配调用GetPower
+class UnbatchedChannel : public ChannelDevice {
+public:
+    UnbatchedChannel(std::shared_ptr<ChannelController> controller, uint32_t channel)
+        : ChannelDevice(std::move(controller), channel) {}
+    virtual const void* SampleGroup() { return this; }
+    virtual uint32_t SampleChannel() { return 0; }
+    virtual bool ReadSamples(const SampleSpan& samples, int64_t now_ms) {
+        return DeviceBase::ReadSamples(samples, now_ms);
+    }
+};
+
+struct Result {
+    double us_per_tick;
+    double transactions_per_tick;
+    double kwh;
+};
+
+Result run(const PriceStore& prices, size_t channels, double transaction_us, bool batched) {
+    // 停止时的最终充电信息带有会话总电量
+    std::map<std::string, double> energy;
+    StationRuntime runtime(prices, [&energy](const std::string&, const nlohmann::json& content, uint8_t, bool) {
+        if (content["cmd"].get<int>() == DEVICE_CMD_CHARGE_INFO) {
+            energy[content["device_id"].get<std::string>()] = content["charge_info"]["all_energy"].get<double>();
+        }
+    });
+    auto controller = std::make_shared<SimBusController>(channels, transaction_us);
+    for (size_t i = 0; i < channels; i++) {
+        uint32_t channel = static_cast<uint32_t>(i);
+        runtime.add_connector(make_connector_id(i), std::unique_ptr<DeviceBase>(
+            batched ? new ChannelDevice(controller, channel) : new UnbatchedChannel(controller, channel)));
+    }
+    auto dispatch_all = [&runtime](int cmd) {
+        for (const auto& connector : runtime.connectors()) {
+            Command command;
+            command.cmd = cmd;
+            command.device_id = connector->id();
+            command.topic = connector->topic(TOPIC_CMD);
+            runtime.dispatch(command);
+        }
+    };
+    dispatch_all(DEVICE_CMD_COMMERCIAL_START);
+
+    uint64_t before = controller->transactions();
+    auto begin = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; round++) {
+        runtime.tick(kStartMs + round * kIntervalMs);
+    }
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count();
+    Result result;
+    result.us_per_tick = us / kRounds;
+    result.transactions_per_tick = static_cast<double>(controller->transactions() - before) / kRounds;
+
+    dispatch_all(DEVICE_CMD_STOP);
+    result.kwh = 0;
+    for (const auto& item : energy) {
+        result.kwh += item.second;
+    }
+    return result;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    double transaction_us = argc > 2 ? atof(argv[2]) : 100.0;
+    PriceStore prices;
+    if (prices.load_file(price_path) != PriceStore::RELOAD_OK) {
+        return 1;
+    }
+
+    std::cout << "=== 批量采样: " << kRounds << " 个采样周期 ===" << std::endl;
+    std::cout << std::setw(8) << "通道" << std::setw(10) << "事务us" << std::setw(8) << "方式"
+              << std::setw(12) << "事务/周期" << std::setw(12) << "us/周期" << std::setw(14) << "us/连接器"
+              << std::setw(12) << "电量kWh" << std::endl;
+    bool consistent = true;
+    for (double cost : {0.0, transaction_us}) {
+        for (size_t channels : {8, 64, 256}) {
+            Result single = run(prices, channels, cost, false);
+            Result batch = run(prices, channels, cost, true);
+            for (const Result* r : {&single, &batch}) {
+                std::cout << std::fixed << std::setw(8) << channels << std::setw(10) << std::setprecision(0) << cost
+                          << std::setw(8) << (r == &single ? "逐个" : "批量")
+                          << std::setw(12) << std::setprecision(0) << r->transactions_per_tick
+                          << std::setw(12) << std::setprecision(1) << r->us_per_tick
+                          << std::setw(14) << std::setprecision(2) << r->us_per_tick / channels
+                          << std::setw(12) << std::setprecision(4) << r->kwh << std::endl;
+            }
+            std::cout << "        加速比 " << std::setprecision(1) << single.us_per_tick / batch.us_per_tick << "x"
+                      << std::endl;
+            consistent = consistent && single.kwh == batch.kwh && batch.kwh > 0;
+        }
+    }
+    std::cout << "两种方式电量" << (consistent ? "一致" : "不一致") << std::endl;
+    return consistent ? 0 : 1;
+}
@@ -0,0 +1,302 @@
+#include "station/station_runtime.hpp"
+#include "device/fake_device.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <string>
+#include <functional>
+
+/**
+ * 自检缓存测试
+ *
+ * 设备自检分为4个子系统，每项耗时kPartMs。对比启动命令从下发到结果的耗时：
+ *   顺序自检：各子系统依次执行（原行为）
+ *   并发自检：各子系统并发执行
+ *   缓存冷：启用缓存，首次启动仍需自检
+ *   缓存热：空闲时后台刷新过，启动只执行Start
+ * 另外核对失败不缓存、后台刷新更新自检失败状态位、超时后迟到的结果不入缓存、过期后重新自检、充电中不刷新。
+ *
+ * 用法: self_check_bench <price.json>
+ */
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using std::chrono::milliseconds;
+
+const size_t kParts = 4;
+const int kPartMs = 200;
+
+// 不拆分子系统：SelfCheck依次执行各项
+class SequentialDevice : public FakeDevice {
+public:
+    explicit SequentialDevice(const std::string& id) : FakeDevice(id) {}
+    virtual size_t SelfCheckParts() { return 1; }
+};
+
+struct Result {
+    int result = -1;
+    std::string describe;
+    Clock::time_point at;
+};
+
+// 单个连接器的站点，记录命令结果的发出时间
+class Station {
+public:
+    Station(const PriceStore& prices, FakeDevice* device, bool async, int64_t valid_ms, int64_t refresh_ms)
+        : device_(device) {
+        runtime_.reset(new StationRuntime(prices,
+            [this](const std::string&, const nlohmann::json& content, uint8_t, bool) {
+                if (content["cmd"].get<int>() == DEVICE_CMD_CHARGE_INFO) {
+                    return;
+                }
+                std::lock_guard<std::mutex> lock(mutex_);
+                Result result;
+                result.result = content["result"].get<int>();
+                result.describe = content["describe"].get<std::string>();
+                result.at = Clock::now();
+                results_.push_back(result);
+            }));
+        FakeDevice::Latency latency;
+        latency.self_check_ms = kPartMs;
+        device->set_latency(latency);
+        device->set_self_check_parts(kParts);
+        runtime_->add_connector(make_connector_id(0), std::unique_ptr<DeviceBase>(device));
+        if (async) {
+            runtime_->enable_async_devices(1);
+        }
+        SelfCheckCache::Options options;
+        options.valid_ms = valid_ms;
+        options.refresh_ms = refresh_ms;
+        runtime_->set_self_check_cache(options);
+    }
+
+    Connector& connector() { return *runtime_->connectors()[0]; }
+    FakeDevice& device() { return *device_; }
+    StationRuntime& runtime() { return *runtime_; }
+
+    // 下发命令并等待其结果，返回下发到结果的耗时（ms）；启动成功不发结果，以开始充电为准
+    double command(int cmd, Result& result) {
+        size_t seen;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            seen = results_.size();
+        }
+        Command command;
+        command.cmd = cmd;
+        command.device_id = connector().id();
+        command.topic = connector().topic(TOPIC_CMD);
+        auto begin = Clock::now();
+        runtime_->dispatch(command);
+        auto deadline = begin + std::chrono::seconds(5);
+        while (Clock::now() < deadline) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (results_.size() > seen) {
+                    result = results_[seen];
+                    return std::chrono::duration<double, std::milli>(result.at - begin).count();
+                }
+            }
+            if (cmd != DEVICE_CMD_STOP && connector().is_charging()) {
+                result = Result();
+                result.result = RESULT_OK;
+                result.at = Clock::now();
+                return std::chrono::duration<double, std::milli>(result.at - begin).count();
+            }
+            std::this_thread::yield();
+        }
+        result = Result();
+        return -1;
+    }
+
+    // 发起后台刷新并等待完成
+    bool refresh() {
+        uint64_t before = connector().self_check_cache().get_statistics().refreshes;
+        runtime_->refresh_self_checks();
+        auto deadline = Clock::now() + std::chrono::seconds(5);
+        while (Clock::now() < deadline) {
+            if (connector().self_check_cache().get_statistics().refreshes > before &&
+                connector().device().queued() == 0) {
+                // 完成回调（状态位）在结果记入缓存之后执行
+                std::this_thread::sleep_for(milliseconds(5));
+                return true;
+            }
+            std::this_thread::sleep_for(milliseconds(1));
+        }
+        return false;
+    }
+
+private:
+    FakeDevice* device_;
+    std::mutex mutex_;
+    std::vector<Result> results_;
+    std::unique_ptr<StationRuntime> runtime_;  // 先于结果记录销毁
+};
+
+int failures = 0;
+
+void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cout << "   失败: " << what << std::endl;
+        failures++;
+    }
+}
+
+void print_row(const char* mode, const char* executor, double ms, const Result& result) {
+    std::cout << std::left << std::setw(16) << mode << std::setw(10) << executor << std::right << std::fixed
+              << std::setprecision(3) << std::setw(14) << ms << "   " << (result.result == RESULT_OK ? "成功" : result.describe)
+              << std::endl;
+}
+
+// 一次完整的启动与停止，返回启动耗时
+double start_stop(Station& station, Result& result) {
+    double ms = station.command(DEVICE_CMD_COMMERCIAL_START, result);
+    Result stop;
+    station.command(DEVICE_CMD_STOP, stop);
+    return ms;
+}
+
+void latency_table(const PriceStore& prices) {
+    std::cout << std::left << std::setw(16) << "方式" << std::setw(10) << "执行器" << std::right << std::setw(14)
+              << "启动耗时ms" << "   结果" << std::endl;
+    for (bool async : {true, false}) {
+        const char* executor = async ? "异步" : "同步";
+        Result result;
+        {
+            Station station(prices, new SequentialDevice(make_connector_id(0)), async, 0, 0);
+            double ms = start_stop(station, result);
+            print_row("顺序自检", executor, ms, result);
+            check(result.result == RESULT_OK && ms >= kParts * kPartMs, "顺序自检耗时应为各项之和");
+        }
+        {
+            Station station(prices, new FakeDevice(make_connector_id(0)), async, 0, 0);
+            double ms = start_stop(station, result);
+            print_row("并发自检", executor, ms, result);
+            check(result.result == RESULT_OK && ms >= kPartMs && ms < 2 * kPartMs, "并发自检耗时应接近单项");
+            check(station.device().max_concurrent_parts() == static_cast<int>(kParts), "子系统自检未并发执行");
+            check(station.device().max_concurrent_commands() == 1, "同一设备的命令并发执行");
+        }
+        {
+            Station station(prices, new FakeDevice(make_connector_id(0)), async, 60000, 45000);
+            double cold = station.command(DEVICE_CMD_COMMERCIAL_START, result);
+            print_row("缓存冷", executor, cold, result);
+            Result stop;
+            station.command(DEVICE_CMD_STOP, stop);
+            // 会话结束使缓存失效，空闲时后台补上
+            check(station.refresh(), "后台刷新未完成");
+            uint64_t checks = station.device().self_checks();
+            double warm = station.command(DEVICE_CMD_COMMERCIAL_START, result);
+            print_row("缓存热", executor, warm, result);
+            check(result.result == RESULT_OK && station.device().self_checks() == checks, "热缓存启动仍执行了自检");
+            check(warm < 5, "热缓存启动耗时过长");
+            SelfCheckCache::Statistics stats = station.connector().self_check_cache().get_statistics();
+            check(stats.hits == 1 && stats.checks == 2 && stats.refreshes == 1, "缓存统计不符");
+            station.command(DEVICE_CMD_STOP, stop);
+        }
+    }
+}
+
+// 失败不缓存，后台刷新维护自检失败状态位
+void check_failure(const PriceStore& prices) {
+    Station station(prices, new FakeDevice(make_connector_id(0)), true, 60000, 45000);
+    Result result;
+    station.device().set_self_check_code(3);
+    check(station.refresh(), "后台刷新未完成");
+    check(station.connector().get_status(DEVICE_STATUS_SELF_CHECK_FAIL) == 1, "后台自检失败未置状态位");
+    uint64_t checks = station.device().self_checks();
+    station.command(DEVICE_CMD_COMMERCIAL_START, result);
+    check(result.result == RESULT_FAIL && result.describe == "self check failed", "自检失败时启动未被拒绝");
+    check(station.device().self_checks() == checks + 1, "失败结果被缓存");
+
+    station.device().set_self_check_code(0);
+    check(station.refresh(), "后台刷新未完成");
+    check(station.connector().get_status(DEVICE_STATUS_SELF_CHECK_FAIL) == 0, "故障排除后状态位未清除");
+    double ms = station.command(DEVICE_CMD_COMMERCIAL_START, result);
+    check(result.result == RESULT_OK && ms < 5, "故障排除后未使用刷新结果");
+
+    // 充电中不刷新
+    checks = station.device().self_checks();
+    station.runtime().refresh_self_checks();
+    std::this_thread::sleep_for(milliseconds(kPartMs + 50));
+    check(station.device().self_checks() == checks, "充电中执行了后台自检");
+    Result stop;
+    station.command(DEVICE_CMD_STOP, stop);
+    std::cout << "   完成" << std::endl;
+}
+
+// 自检超时：启动失败并使缓存失效，超时后才返回的通过结果不能让下一次启动跳过自检
+void check_timeout(const PriceStore& prices) {
+    Station station(prices, new FakeDevice(make_connector_id(0)), true, 60000, 45000);
+    station.connector().set_device_timeout(milliseconds(kPartMs / 2));
+    Result result;
+    station.command(DEVICE_CMD_COMMERCIAL_START, result);
+    check(result.result == RESULT_FAIL && result.describe == "device timeout", "自检超时未使启动失败");
+    // 等迟到的自检、启动与补偿停止执行完
+    std::this_thread::sleep_for(milliseconds(kPartMs + 100));
+    SelfCheckCache::Statistics stats = station.connector().self_check_cache().get_statistics();
+    check(stats.checks == 1 && stats.stale == 1, "迟到的自检结果未被丢弃");
+    check(station.runtime().self_check_statistics().stale == 1, "站点汇总缺少丢弃的自检结果");
+
+    station.connector().set_device_timeout(milliseconds(Connector::kDeviceTimeoutMs));
+    uint64_t checks = station.device().self_checks();
+    double ms = station.command(DEVICE_CMD_COMMERCIAL_START, result);
+    stats = station.connector().self_check_cache().get_statistics();
+    check(result.result == RESULT_OK && ms >= kPartMs && station.device().self_checks() == checks + 1 &&
+              stats.hits == 0, "超时后的启动使用了迟到的自检结果");
+    Result stop;
+    station.command(DEVICE_CMD_STOP, stop);
+    std::cout << "   完成" << std::endl;
+}
+
+// 过期后重新自检；提前刷新使缓存不过期
+void check_expiry(const PriceStore& prices) {
+    // 有效期须覆盖刷新间隔 + 调用间隔 + 自检耗时（100 + 100 + 200ms）
+    Station station(prices, new FakeDevice(make_connector_id(0)), true, 500, 100);
+    Result result;
+    check(station.refresh(), "后台刷新未完成");
+    std::this_thread::sleep_for(milliseconds(550));
+    uint64_t checks = station.device().self_checks();
+    double ms = station.command(DEVICE_CMD_COMMERCIAL_START, result);
+    check(result.result == RESULT_OK && ms >= kPartMs && station.device().self_checks() == checks + 1,
+          "过期结果仍被使用");
+    Result stop;
+    station.command(DEVICE_CMD_STOP, stop);
+
+    // 每100ms调用一次刷新（结果超过100ms即刷新），持续1秒后缓存仍有效
+    check(station.refresh(), "后台刷新未完成");
+    for (int i = 0; i < 10; i++) {
+        std::this_thread::sleep_for(milliseconds(100));
+        station.runtime().refresh_self_checks();
+    }
+    // 等最后一次刷新结束（启动命令会排在进行中的刷新之后）
+    std::this_thread::sleep_for(milliseconds(kPartMs + 50));
+    checks = station.device().self_checks();
+    ms = station.command(DEVICE_CMD_COMMERCIAL_START, result);
+    check(result.result == RESULT_OK && ms < 5 && station.device().self_checks() == checks, "定期刷新后缓存仍过期");
+    station.command(DEVICE_CMD_STOP, stop);
+    std::cout << "   完成，刷新 " << station.connector().self_check_cache().get_statistics().refreshes << " 次" << std::endl;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    PriceStore prices;
+    if (prices.load_file(price_path) != PriceStore::RELOAD_OK) {
+        return 1;
+    }
+
+    std::cout << "=== 自检缓存: " << kParts << " 个子系统, 每项 " << kPartMs << "ms ===" << std::endl;
+    latency_table(prices);
+    std::cout << "\n--- 失败不缓存与状态位 ---" << std::endl;
+    check_failure(prices);
+    std::cout << "\n--- 超时后迟到的结果 ---" << std::endl;
+    check_timeout(prices);
+    std::cout << "\n--- 过期与定期刷新 ---" << std::endl;
+    check_expiry(prices);
+
+    std::cout << "\n=== " << (failures ? "测试失败" : "所有测试通过") << " ===" << std::endl;
+    return failures ? 1 : 0;
+}
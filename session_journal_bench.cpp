@@ -0,0 +1,151 @@
+#include "station/session_journal.hpp"
+#include "station/energy_meter.hpp"
+#include "station/station_types.hpp"
+#include "config/price_table.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+static double power_at(int64_t t_ms) {
+    return 7.0 + 1.5 * std::sin(t_ms / 2300.0) + ((t_ms / 4137) % 11 == 0 ? 3.0 : 0.0);
+}
+
+// 进程实际提交到存储层的写入字节（/proc/self/io，不可用时返回-1）
+static long long storage_write_bytes() {
+    FILE* f = fopen("/proc/self/io", "r");
+    if (!f) return -1;
+    char line[128];
+    long long value = -1;
+    while (fgets(line, sizeof(line), f)) {
+        if (sscanf(line, "write_bytes: %lld", &value) == 1) break;
+    }
+    fclose(f);
+    return value;
+}
+
+static double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - since).count() / 1000.0;
+}
+
+static void run(const PriceTable& table, const std::string& prefix, int64_t checkpoint_s) {
+    const int hz = 10;
+    // 12小时后再多采377个点，使崩溃点落在两次检查点之间
+    const int64_t samples = 12LL * 3600 * hz + 377;
+    const int64_t start_ms = 1700000000000LL;
+
+    SessionJournal::Options options;
+    options.checkpoint_interval_ms = checkpoint_s * 1000;
+
+    EnergyMeter meter;
+    meter.reset(table, true);
+    long long io_before = storage_write_bytes();
+    auto begin = std::chrono::steady_clock::now();
+    {
+        SessionJournal journal(prefix, options);
+        if (!journal.begin(start_ms, START_TYPE_COMMERCIAL)) {
+            std::cerr << journal.last_error() << "\n";
+            return;
+        }
+        for (int64_t i = 1; i <= samples; i++) {
+            int64_t t = start_ms + i * (1000 / hz);
+            double p = power_at(t);
+            meter.add_sample(t, p);
+            if (!journal.append_sample(t, p, meter)) {
+                std::cerr << journal.last_error() << "\n";
+                return;
+            }
+        }
+        double append_ms = elapsed_ms(begin);
+        long long io_after = storage_write_bytes();
+        const SessionJournal::Statistics& stats = journal.statistics();
+        double payload = samples * (sizeof(int64_t) + sizeof(double));
+        std::cout << std::setw(8) << checkpoint_s
+                  << std::setw(10) << stats.checkpoints
+                  << std::setw(12) << std::fixed << std::setprecision(2) << stats.journal_bytes / 1048576.0
+                  << std::setw(12) << stats.checkpoint_bytes / 1048576.0
+                  << std::setw(10) << (stats.journal_bytes + stats.checkpoint_bytes) / payload;
+        if (io_before >= 0 && io_after >= 0) {
+            std::cout << std::setw(10) << (io_after - io_before) / payload;
+        } else {
+            std::cout << std::setw(10) << "n/a";
+        }
+        std::cout << std::setw(12) << std::setprecision(1) << append_ms * 1e6 / samples;
+        // 模拟崩溃：不调用end，析构只解除映射
+    }
+
+    // 在有效尾部之后写半条记录，模拟崩溃时未写完
+    {
+        int fd = open((prefix + ".journal").c_str(), O_WRONLY);
+        const char garbage[16] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16};
+        pwrite(fd, garbage, sizeof(garbage), 64 + (samples + 1) * 32);
+        close(fd);
+    }
+
+    SessionJournal::RecoveredSession session;
+    EnergyMeter recovered;
+    auto recover_begin = std::chrono::steady_clock::now();
+    bool ok;
+    {
+        SessionJournal journal(prefix, options);
+        ok = journal.recover(table, recovered, session);
+    }
+    double recover_ms = elapsed_ms(recover_begin);
+
+    // 不使用检查点的完整重放
+    unlink((prefix + ".ckpt").c_str());
+    SessionJournal::RecoveredSession full_session;
+    EnergyMeter replayed;
+    auto replay_begin = std::chrono::steady_clock::now();
+    {
+        SessionJournal journal(prefix, options);
+        journal.recover(table, replayed, full_session);
+    }
+    double replay_ms = elapsed_ms(replay_begin);
+
+    bool exact = ok && recovered.total_kwh() == meter.total_kwh() && recovered.total_cost() == meter.total_cost();
+    std::cout << std::setw(10) << std::setprecision(2) << recover_ms
+              << std::setw(10) << session.replayed
+              << std::setw(11) << replay_ms
+              << std::setw(8) << (exact ? "yes" : "NO")
+              << "\n";
+    unlink((prefix + ".journal").c_str());
+}
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    std::string dir = argc > 2 ? argv[2] : "./journal_bench";
+
+    PriceTable table;
+    if (!table.load(price_path)) {
+        return 1;
+    }
+    mkdir(dir.c_str(), 0755);
+
+    std::cout << std::setfill(' ');
+    std::cout << "\n12小时会话，10Hz采样（432000条记录，另在最后一次检查点后37.7s崩溃），有效载荷16字节/采样（时间戳+功率）\n";
+    std::cout << std::setw(8) << "ckpt s"
+              << std::setw(10) << "ckpts"
+              << std::setw(12) << "journal MB"
+              << std::setw(12) << "ckpt MB"
+              << std::setw(10) << "WA"
+              << std::setw(10) << "WA(io)"
+              << std::setw(12) << "ns/append"
+              << std::setw(10) << "recov ms"
+              << std::setw(10) << "replayed"
+              << std::setw(11) << "full ms"
+              << std::setw(8) << "exact"
+              << "\n";
+    const int64_t intervals[] = {10, 60, 300};
+    for (int64_t interval : intervals) {
+        run(table, dir + "/bench-connector", interval);
+    }
+    return 0;
+}
@@ -0,0 +1,150 @@
+#include "admission.hpp"
+#include "station_types.hpp"
+
+namespace {
+
+#define STATUS_BIT(pos) StatusRegister::bit(pos)
+
+// 所有启动方式共同的阻止位
+const uint64_t kBaseBlocked = STATUS_BIT(DEVICE_STATUS_FORRBIDDEN) | STATUS_BIT(DEVICE_STATUS_BUSY);
+
+// 规则表：启动方式 -> 阻止启动的状态位
+const uint64_t kBlockedByStartType[] = {
+    /* START_TYPE_NFC        */ kBaseBlocked,
+    /* START_TYPE_BLUETOOTH  */ kBaseBlocked,
+    /* START_TYPE_REMOTE     */ kBaseBlocked | STATUS_BIT(DEVICE_STATUS_FORRBIDDEN_REMOTE),
+    /* START_TYPE_COMMERCIAL */ kBaseBlocked | STATUS_BIT(DEVICE_STATUS_FORRBIDDEN_COMMERCIAL) |
+                                STATUS_BIT(DEVICE_STATUS_ERROR_CONFIG),
+};
+const int kStartTypeCount = sizeof(kBlockedByStartType) / sizeof(kBlockedByStartType[0]);
+
+// 拒绝原因，按优先级排列
+const struct {
+    uint64_t bit;
+    int result;
+} kReasons[] = {
+    {STATUS_BIT(DEVICE_STATUS_FORRBIDDEN), ADMISSION_FORBIDDEN},
+    {STATUS_BIT(DEVICE_STATUS_BUSY), ADMISSION_BUSY},
+    {STATUS_BIT(DEVICE_STATUS_FORRBIDDEN_REMOTE), ADMISSION_FORBIDDEN_REMOTE},
+    {STATUS_BIT(DEVICE_STATUS_FORRBIDDEN_COMMERCIAL), ADMISSION_FORBIDDEN_COMMERCIAL},
+    {STATUS_BIT(DEVICE_STATUS_ERROR_CONFIG), ADMISSION_CONFIG_ERROR},
+};
+
+#undef STATUS_BIT
+
+}  // namespace
+
+const char* admission_describe(int result) {
+    switch (result) {
+        case ADMISSION_OK: return "ok";
+        case ADMISSION_FORBIDDEN: return "charging forbidden";
+        case ADMISSION_BUSY: return "device busy";
+        case ADMISSION_FORBIDDEN_REMOTE: return "remote start forbidden";
+        case ADMISSION_FORBIDDEN_COMMERCIAL: return "commercial start forbidden";
+        case ADMISSION_CONFIG_ERROR: return "config error";
+        case ADMISSION_SITE_SESSIONS: return "site session limit reached";
+        case ADMISSION_SITE_POWER: return "site power budget exceeded";
+        default: return "rejected";
+    }
+}
+
+void SiteBudget::set_limits(const Limits& limits) {
+    max_sessions_.store(limits.max_sessions, std::memory_order_relaxed);
+    double power_w = limits.power_kw > 0 ? limits.power_kw * 1000.0 : 0;
+    max_power_w_.store(power_w >= 4294967295.0 ? 0xffffffffu : static_cast<uint32_t>(power_w),
+                       std::memory_order_relaxed);
+}
+
+SiteBudget::Limits SiteBudget::limits() const {
+    Limits limits;
+    limits.max_sessions = max_sessions_.load(std::memory_order_relaxed);
+    limits.power_kw = max_power_w_.load(std::memory_order_relaxed) / 1000.0;
+    return limits;
+}
+
+SiteBudget::Usage SiteBudget::usage() const {
+    uint64_t state = state_.load(std::memory_order_acquire);
+    Usage usage;
+    usage.sessions = static_cast<uint32_t>(state >> 32);
+    usage.power_kw = static_cast<uint32_t>(state) / 1000.0;
+    return usage;
+}
+
+int SiteBudget::try_acquire(uint32_t power_w) {
+    uint32_t max_sessions = max_sessions_.load(std::memory_order_relaxed);
+    uint32_t max_power_w = max_power_w_.load(std::memory_order_relaxed);
+    uint64_t current = state_.load(std::memory_order_acquire);
+    for (;;) {
+        uint64_t sessions = current >> 32;
+        uint64_t power = current & 0xffffffffu;
+        if (max_sessions && sessions + 1 > max_sessions) {
+            return ADMISSION_SITE_SESSIONS;
+        }
+        if (max_power_w && power + power_w > max_power_w) {
+            return ADMISSION_SITE_POWER;
+        }
+        if (state_.compare_exchange_weak(current, pack(sessions + 1, power + power_w),
+                                         std::memory_order_acq_rel, std::memory_order_acquire)) {
+            return ADMISSION_OK;
+        }
+    }
+}
+
+void SiteBudget::acquire(uint32_t power_w) {
+    state_.fetch_add(pack(1, power_w), std::memory_order_acq_rel);
+}
+
+void SiteBudget::release(uint32_t power_w) {
+    state_.fetch_sub(pack(1, power_w), std::memory_order_acq_rel);
+}
+
+bool AdmissionControl::known_start_type(int start_type) {
+    return start_type >= 0 && start_type < kStartTypeCount;
+}
+
+// 未知启动方式只受共同阻止位约束
+uint64_t AdmissionControl::blocked_mask(int start_type) {
+    return known_start_type(start_type) ? kBlockedByStartType[start_type] : kBaseBlocked;
+}
+
+int AdmissionControl::reject_reason(int start_type, uint64_t observed) {
+    uint64_t hit = observed & blocked_mask(start_type);
+    for (const auto& reason : kReasons) {
+        if (hit & reason.bit) {
+            return reason.result;
+        }
+    }
+    return ADMISSION_OK;
+}
+
+int AdmissionControl::admit(StatusRegister& status, int start_type, uint32_t power_w) const {
+    uint64_t observed = 0;
+    if (!status.transition(blocked_mask(start_type), StatusRegister::bit(DEVICE_STATUS_BUSY), 0, &observed)) {
+        return reject_reason(start_type, observed);
+    }
+    if (site_) {
+        int result = site_->try_acquire(power_w);
+        if (result != ADMISSION_OK) {
+            status.clear(DEVICE_STATUS_BUSY);
+            return result;
+        }
+    }
+    return ADMISSION_OK;
+}
+
+void AdmissionControl::cancel(StatusRegister& status, uint32_t power_w) const {
+    release(power_w);
+    status.clear(DEVICE_STATUS_BUSY);
+}
+
+void AdmissionControl::release(uint32_t power_w) const {
+    if (site_) {
+        site_->release(power_w);
+    }
+}
+
+void AdmissionControl::restore(uint32_t power_w) const {
+    if (site_) {
+        site_->acquire(power_w);
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include "status_register.hpp"
+
+// 启动准入结果
+enum ADMISSION_RESULT{
+    ADMISSION_OK = 0,
+    ADMISSION_FORBIDDEN = 1,            //禁止所有充电
+    ADMISSION_BUSY = 2,                 //忙碌
+    ADMISSION_FORBIDDEN_REMOTE = 3,     //禁止远程充电
+    ADMISSION_FORBIDDEN_COMMERCIAL = 4, //禁止商用充电
+    ADMISSION_CONFIG_ERROR = 5,         //配置错误，无法商用充电
+    ADMISSION_SITE_SESSIONS = 6,        //站点并发会话数已满
+    ADMISSION_SITE_POWER = 7,           //站点功率预算不足
+};
+
+// 拒绝原因描述（用于命令结果的describe字段）
+const char* admission_describe(int result);
+
+/**
+ * @brief 站点级限额：并发会话数与功率预算
+ *
+ * 会话数与已预留功率打包在一个64位原子字中（高32位会话数，低32位功率W），
+ * 两个限额在同一次CAS中检查并预留，并发启动不会突破任一限额。
+ * 限额为0表示不限，可在运行中调整（只影响之后的准入）。
+ */
+class SiteBudget {
+public:
+    struct Limits {
+        uint32_t max_sessions = 0;  // 最大并发会话数
+        double power_kw = 0;        // 功率预算（kW）
+    };
+
+    struct Usage {
+        uint32_t sessions;
+        double power_kw;
+    };
+
+    SiteBudget() : state_(0), max_sessions_(0), max_power_w_(0) {}
+
+    SiteBudget(const SiteBudget&) = delete;
+    SiteBudget& operator=(const SiteBudget&) = delete;
+
+    void set_limits(const Limits& limits);
+    Limits limits() const;
+    Usage usage() const;
+
+    // 预留一个会话及power_w功率，返回ADMISSION_OK / ADMISSION_SITE_SESSIONS / ADMISSION_SITE_POWER
+    int try_acquire(uint32_t power_w);
+    // 不检查限额直接计入（恢复崩溃前的会话）
+    void acquire(uint32_t power_w);
+    void release(uint32_t power_w);
+
+private:
+    static uint64_t pack(uint64_t sessions, uint64_t power_w) { return (sessions << 32) | power_w; }
+
+    std::atomic<uint64_t> state_;
+    std::atomic<uint32_t> max_sessions_;
+    std::atomic<uint32_t> max_power_w_;
+};
+
+/**
+ * @brief 启动准入引擎
+ *
+ * 每种启动方式对应一条预先计算好的阻止位掩码（见admission.cpp中的规则表），
+ * 准入时对状态字做一次CAS：读取状态、检查掩码并置BUSY在同一原子操作中完成；
+ * 被拒绝时按规则表中的优先级从观察到的状态字得出原因，不再二次读取。
+ * 状态检查通过后再从站点预算中预留会话与功率，预留失败则撤销BUSY。
+ */
+class AdmissionControl {
+public:
+    explicit AdmissionControl(SiteBudget* site = nullptr) : site_(site) {}
+
+    // 成功时状态字已置BUSY且已预留power_w，返回ADMISSION_OK；失败时不改变任何状态
+    int admit(StatusRegister& status, int start_type, uint32_t power_w) const;
+    // 撤销一次成功的admit（设备启动失败等）：清BUSY并归还预算
+    void cancel(StatusRegister& status, uint32_t power_w) const;
+    // 会话结束时归还预算（BUSY由调用方随停止状态一起清除）
+    void release(uint32_t power_w) const;
+    // 恢复会话时计入预算
+    void restore(uint32_t power_w) const;
+
+    static bool known_start_type(int start_type);
+    static uint64_t blocked_mask(int start_type);
+    static int reject_reason(int start_type, uint64_t observed);
+
+private:
+    SiteBudget* site_;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+/**
+ * @brief 定长二进制读写辅助（本机字节序，仅用于本机日志与检查点）
+ */
+class BinaryWriter {
+public:
+    explicit BinaryWriter(std::string& out) : out_(out) {}
+
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        out_.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    void put_bytes(const void* data, size_t size) {
+        out_.append(static_cast<const char*>(data), size);
+    }
+
+private:
+    std::string& out_;
+};
+
+class BinaryReader {
+public:
+    BinaryReader(const char* data, size_t size) : p_(data), end_(data + size), ok_(true) {}
+
+    template <typename T>
+    bool get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "POD only");
+        return get_bytes(&value, sizeof(T));
+    }
+    bool get_bytes(void* data, size_t size) {
+        if (!ok_ || static_cast<size_t>(end_ - p_) < size) {
+            ok_ = false;
+            return false;
+        }
+        std::memcpy(data, p_, size);
+        p_ += size;
+        return true;
+    }
+    bool ok() const { return ok_; }
+    bool done() const { return p_ == end_; }
+
+private:
+    const char* p_;
+    const char* end_;
+    bool ok_;
+};
@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <chrono>
+
+// 解析后的下行命令（固定字段）
+struct Command {
+    int cmd = 0;
+    std::string timestamp;
+    std::string device_id;
+    std::string topic;
+    std::chrono::steady_clock::time_point received_at;  // I/O线程收到报文的时刻
+    uint64_t trace_id = 0;  // 跟踪ID（Trace），0表示未跟踪
+};
@@ -0,0 +1,417 @@
+#include "command_parser.hpp"
+#include <climits>
+#include <cstring>
+
+namespace {
+
+const int kMaxDepth = 64;
+
+// 校验一个多字节UTF-8序列（RFC 3629），返回其长度，非法时返回0
+size_t utf8_sequence_length(const char* p, const char* end) {
+    const unsigned char* u = reinterpret_cast<const unsigned char*>(p);
+    size_t available = static_cast<size_t>(end - p);
+    unsigned char lo = 0x80, hi = 0xBF;
+    size_t length;
+
+    if (u[0] >= 0xC2 && u[0] <= 0xDF) {
+        length = 2;
+    } else if (u[0] >= 0xE0 && u[0] <= 0xEF) {
+        length = 3;
+        if (u[0] == 0xE0) lo = 0xA0;
+        if (u[0] == 0xED) hi = 0x9F;
+    } else if (u[0] >= 0xF0 && u[0] <= 0xF4) {
+        length = 4;
+        if (u[0] == 0xF0) lo = 0x90;
+        if (u[0] == 0xF4) hi = 0x8F;
+    } else {
+        return 0;
+    }
+    if (available < length) return 0;
+    if (u[1] < lo || u[1] > hi) return 0;
+    for (size_t i = 2; i < length; i++) {
+        if (u[i] < 0x80 || u[i] > 0xBF) return 0;
+    }
+    return length;
+}
+
+// 单遍扫描器：只在需要时写入目标字段
+class CommandScanner {
+public:
+    CommandScanner(const char* data, size_t size, CommandParseError& error)
+        : begin_(data), p_(data), end_(data + size), error_(error) {}
+
+    bool scan(Command& command);
+
+private:
+    bool fail(const char* at, const char* message);
+    void skip_ws();
+    bool expect(char c, const char* message);
+    bool scan_string(std::string* out);
+    bool scan_number(long long* value, bool* integral);
+    bool scan_literal(const char* word);
+    bool skip_value(int depth);
+    static bool append_utf8(std::string* out, unsigned long code);
+    bool read_hex4(unsigned long& code);
+
+    const char* begin_;
+    const char* p_;
+    const char* end_;
+    CommandParseError& error_;
+};
+
+bool CommandScanner::fail(const char* at, const char* message) {
+    error_.offset = static_cast<size_t>(at - begin_);
+    error_.line = 1;
+    error_.column = 1;
+    for (const char* c = begin_; c < at; c++) {
+        if (*c == '\n') {
+            error_.line++;
+            error_.column = 1;
+        } else {
+            error_.column++;
+        }
+    }
+    error_.message = message;
+    return false;
+}
+
+void CommandScanner::skip_ws() {
+    while (p_ < end_ && (*p_ == ' ' || *p_ == '\t' || *p_ == '\n' || *p_ == '\r')) {
+        p_++;
+    }
+}
+
+bool CommandScanner::expect(char c, const char* message) {
+    skip_ws();
+    if (p_ >= end_ || *p_ != c) {
+        return fail(p_, message);
+    }
+    p_++;
+    return true;
+}
+
+bool CommandScanner::scan(Command& command) {
+    bool has_cmd = false, has_timestamp = false, has_device_id = false;
+    std::string key;
+
+    if (!expect('{', "expected '{'")) return false;
+    skip_ws();
+    if (p_ < end_ && *p_ == '}') {
+        p_++;
+    } else {
+        for (;;) {
+            skip_ws();
+            if (p_ >= end_ || *p_ != '"') return fail(p_, "expected object key");
+            if (!scan_string(&key)) return false;
+            if (!expect(':', "expected ':'")) return false;
+            skip_ws();
+
+            const char* value_at = p_;
+            if (key == "cmd") {
+                long long value = 0;
+                bool integral = false;
+                if (p_ >= end_ || (*p_ != '-' && (*p_ < '0' || *p_ > '9'))) {
+                    return fail(value_at, "cmd: expected integer");
+                }
+                if (!scan_number(&value, &integral)) return false;
+                if (!integral || value < INT_MIN || value > INT_MAX) {
+                    return fail(value_at, "cmd: expected integer");
+                }
+                command.cmd = static_cast<int>(value);
+                has_cmd = true;
+            } else if (key == "timestamp" || key == "device_id") {
+                if (p_ >= end_ || *p_ != '"') {
+                    return fail(value_at, key == "timestamp" ? "timestamp: expected string"
+                                                             : "device_id: expected string");
+                }
+                if (key == "timestamp") {
+                    if (!scan_string(&command.timestamp)) return false;
+                    has_timestamp = true;
+                } else {
+                    if (!scan_string(&command.device_id)) return false;
+                    has_device_id = true;
+                }
+            } else if (!skip_value(1)) {
+                return false;
+            }
+
+            skip_ws();
+            if (p_ < end_ && *p_ == ',') {
+                p_++;
+                continue;
+            }
+            if (p_ < end_ && *p_ == '}') {
+                p_++;
+                break;
+            }
+            return fail(p_, "expected ',' or '}'");
+        }
+    }
+
+    const char* object_end = p_ - 1;
+    skip_ws();
+    if (p_ != end_) return fail(p_, "unexpected data after object");
+
+    if (!has_cmd) return fail(object_end, "missing field 'cmd'");
+    if (!has_timestamp) return fail(object_end, "missing field 'timestamp'");
+    if (!has_device_id) return fail(object_end, "missing field 'device_id'");
+    return true;
+}
+
+// 扫描字符串（p_指向起始引号）；out为空时只做校验
+bool CommandScanner::scan_string(std::string* out) {
+    const char* start = ++p_;
+    // 快速路径：无转义字符时整段赋值，复用已有容量
+    while (p_ < end_ && *p_ != '"' && *p_ != '\\' && static_cast<unsigned char>(*p_) >= 0x20) {
+        if (static_cast<unsigned char>(*p_) >= 0x80) {
+            size_t length = utf8_sequence_length(p_, end_);
+            if (length == 0) return fail(p_, "invalid UTF-8 in string");
+            p_ += length;
+            continue;
+        }
+        p_++;
+    }
+    if (p_ < end_ && *p_ == '"') {
+        if (out) out->assign(start, p_ - start);
+        p_++;
+        return true;
+    }
+
+    if (out) out->assign(start, p_ - start);
+    while (p_ < end_) {
+        char c = *p_;
+        if (c == '"') {
+            p_++;
+            return true;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) {
+            return fail(p_, "control character in string");
+        }
+        if (static_cast<unsigned char>(c) >= 0x80) {
+            size_t length = utf8_sequence_length(p_, end_);
+            if (length == 0) return fail(p_, "invalid UTF-8 in string");
+            if (out) out->append(p_, length);
+            p_ += length;
+            continue;
+        }
+        if (c != '\\') {
+            if (out) out->push_back(c);
+            p_++;
+            continue;
+        }
+
+        const char* escape_at = p_++;
+        if (p_ >= end_) break;
+        char e = *p_++;
+        char decoded = 0;
+        switch (e) {
+            case '"': decoded = '"'; break;
+            case '\\': decoded = '\\'; break;
+            case '/': decoded = '/'; break;
+            case 'b': decoded = '\b'; break;
+            case 'f': decoded = '\f'; break;
+            case 'n': decoded = '\n'; break;
+            case 'r': decoded = '\r'; break;
+            case 't': decoded = '\t'; break;
+            case 'u': {
+                unsigned long code = 0;
+                if (!read_hex4(code)) return fail(escape_at, "invalid \\u escape");
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    unsigned long low = 0;
+                    if (end_ - p_ < 2 || p_[0] != '\\' || p_[1] != 'u') {
+                        return fail(escape_at, "unpaired surrogate");
+                    }
+                    p_ += 2;
+                    if (!read_hex4(low) || low < 0xDC00 || low > 0xDFFF) {
+                        return fail(escape_at, "unpaired surrogate");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    return fail(escape_at, "unpaired surrogate");
+                }
+                if (out) append_utf8(out, code);
+                continue;
+            }
+            default:
+                return fail(escape_at, "invalid escape");
+        }
+        if (out) out->push_back(decoded);
+    }
+    return fail(p_, "unterminated string");
+}
+
+bool CommandScanner::read_hex4(unsigned long& code) {
+    if (end_ - p_ < 4) return false;
+    code = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = *p_++;
+        code <<= 4;
+        if (c >= '0' && c <= '9') code |= c - '0';
+        else if (c >= 'a' && c <= 'f') code |= c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') code |= c - 'A' + 10;
+        else return false;
+    }
+    return true;
+}
+
+bool CommandScanner::append_utf8(std::string* out, unsigned long code) {
+    if (code < 0x80) {
+        out->push_back(static_cast<char>(code));
+    } else if (code < 0x800) {
+        out->push_back(static_cast<char>(0xC0 | (code >> 6)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else if (code < 0x10000) {
+        out->push_back(static_cast<char>(0xE0 | (code >> 12)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    } else {
+        out->push_back(static_cast<char>(0xF0 | (code >> 18)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 12) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | ((code >> 6) & 0x3F)));
+        out->push_back(static_cast<char>(0x80 | (code & 0x3F)));
+    }
+    return true;
+}
+
+// JSON数字：-?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+bool CommandScanner::scan_number(long long* value, bool* integral) {
+    bool negative = false;
+    bool overflow = false;
+    unsigned long long magnitude = 0;
+
+    if (*p_ == '-') {
+        negative = true;
+        p_++;
+    }
+    if (p_ >= end_ || *p_ < '0' || *p_ > '9') return fail(p_, "invalid number");
+    if (*p_ == '0') {
+        p_++;
+    } else {
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') {
+            if (magnitude > (ULLONG_MAX - 9) / 10) overflow = true;
+            magnitude = magnitude * 10 + (*p_ - '0');
+            p_++;
+        }
+    }
+
+    bool is_integral = true;
+    if (p_ < end_ && *p_ == '.') {
+        is_integral = false;
+        p_++;
+        if (p_ >= end_ || *p_ < '0' || *p_ > '9') return fail(p_, "invalid number");
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') p_++;
+    }
+    if (p_ < end_ && (*p_ == 'e' || *p_ == 'E')) {
+        is_integral = false;
+        p_++;
+        if (p_ < end_ && (*p_ == '+' || *p_ == '-')) p_++;
+        if (p_ >= end_ || *p_ < '0' || *p_ > '9') return fail(p_, "invalid number");
+        while (p_ < end_ && *p_ >= '0' && *p_ <= '9') p_++;
+    }
+
+    if (integral) *integral = is_integral && !overflow && magnitude <= static_cast<unsigned long long>(LLONG_MAX);
+    if (value) {
+        long long v = static_cast<long long>(magnitude & static_cast<unsigned long long>(LLONG_MAX));
+        *value = negative ? -v : v;
+    }
+    return true;
+}
+
+bool CommandScanner::scan_literal(const char* word) {
+    size_t len = strlen(word);
+    if (static_cast<size_t>(end_ - p_) < len || memcmp(p_, word, len) != 0) {
+        return fail(p_, "invalid literal");
+    }
+    p_ += len;
+    return true;
+}
+
+// 跳过任意JSON值（仍做完整语法校验）
+bool CommandScanner::skip_value(int depth) {
+    if (depth > kMaxDepth) return fail(p_, "nesting too deep");
+    skip_ws();
+    if (p_ >= end_) return fail(p_, "unexpected end of input");
+
+    switch (*p_) {
+        case '"':
+            return scan_string(nullptr);
+        case 't':
+            return scan_literal("true");
+        case 'f':
+            return scan_literal("false");
+        case 'n':
+            return scan_literal("null");
+        case '{': {
+            p_++;
+            skip_ws();
+            if (p_ < end_ && *p_ == '}') {
+                p_++;
+                return true;
+            }
+            for (;;) {
+                skip_ws();
+                if (p_ >= end_ || *p_ != '"') return fail(p_, "expected object key");
+                if (!scan_string(nullptr)) return false;
+                if (!expect(':', "expected ':'")) return false;
+                if (!skip_value(depth + 1)) return false;
+                skip_ws();
+                if (p_ < end_ && *p_ == ',') {
+                    p_++;
+                    continue;
+                }
+                if (p_ < end_ && *p_ == '}') {
+                    p_++;
+                    return true;
+                }
+                return fail(p_, "expected ',' or '}'");
+            }
+        }
+        case '[': {
+            p_++;
+            skip_ws();
+            if (p_ < end_ && *p_ == ']') {
+                p_++;
+                return true;
+            }
+            for (;;) {
+                if (!skip_value(depth + 1)) return false;
+                skip_ws();
+                if (p_ < end_ && *p_ == ',') {
+                    p_++;
+                    continue;
+                }
+                if (p_ < end_ && *p_ == ']') {
+                    p_++;
+                    return true;
+                }
+                return fail(p_, "expected ',' or ']'");
+            }
+        }
+        default:
+            if (*p_ == '-' || (*p_ >= '0' && *p_ <= '9')) {
+                return scan_number(nullptr, nullptr);
+            }
+            return fail(p_, "unexpected character");
+    }
+}
+
+} // namespace
+
+std::string CommandParseError::to_string() const {
+    return "parse error at byte " + std::to_string(offset) + " (line " + std::to_string(line) +
+           ", column " + std::to_string(column) + "): " + message;
+}
+
+bool parse_command(const char* data, size_t size, Command& command, CommandParseError& error) {
+    CommandScanner scanner(data, size, error);
+    return scanner.scan(command);
+}
+
+bool parse_command(const std::string& payload, Command& command, std::string& error) {
+    CommandParseError parse_error;
+    if (!parse_command(payload.data(), payload.size(), command, parse_error)) {
+        error = parse_error.to_string();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include "command.hpp"
+
+// 解析错误：offset为出错字节的偏移（从0开始），line/column从1开始
+struct CommandParseError {
+    size_t offset = 0;
+    size_t line = 1;
+    size_t column = 1;
+    std::string message;
+
+    std::string to_string() const;
+};
+
+/**
+ * @brief 按固定模式扫描命令报文，直接填充Command，不构建JSON树
+ *
+ * 报文必须是一个JSON对象，且包含：
+ * - "cmd": 整数
+ * - "timestamp": 字符串
+ * - "device_id": 字符串
+ * 其他字段只做语法校验后跳过。重复字段以最后一次为准。
+ */
+bool parse_command(const char* data, size_t size, Command& command, CommandParseError& error);
+
+// 便捷接口：错误信息包含位置
+bool parse_command(const std::string& payload, Command& command, std::string& error);
@@ -0,0 +1,201 @@
+#include "command_pipeline.hpp"
+#include "command_parser.hpp"
+#include <cstdio>
+#include "tools/trace/trace.hpp"
+
+namespace {
+
+uint64_t trace_ns(std::chrono::steady_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+}  // namespace
+
+void CommandPipeline::Waker::notify() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cv_.notify_one();
+    }
+}
+
+void CommandPipeline::Waker::notify_all() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cv_.notify_all();
+}
+
+void CommandPipeline::StageCounter::record(std::chrono::nanoseconds elapsed) {
+    uint64_t ns = static_cast<uint64_t>(elapsed.count());
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_ns_.fetch_add(ns, std::memory_order_relaxed);
+    uint64_t current = max_ns_.load(std::memory_order_relaxed);
+    while (ns > current && !max_ns_.compare_exchange_weak(current, ns, std::memory_order_relaxed)) {
+    }
+}
+
+CommandPipeline::StageStats CommandPipeline::StageCounter::snapshot() const {
+    StageStats stats;
+    stats.count = count_.load(std::memory_order_relaxed);
+    stats.total = std::chrono::nanoseconds(total_ns_.load(std::memory_order_relaxed));
+    stats.max = std::chrono::nanoseconds(max_ns_.load(std::memory_order_relaxed));
+    return stats;
+}
+
+CommandPipeline::CommandPipeline(size_t executor_count, size_t queue_capacity)
+    : inbound_(queue_capacity), running_(false), parser_done_(false), dropped_(0), parse_errors_(0) {
+    if (executor_count == 0) executor_count = 1;
+    for (size_t i = 0; i < executor_count; i++) {
+        shards_.emplace_back(new Shard(queue_capacity));
+    }
+}
+
+CommandPipeline::~CommandPipeline() {
+    stop();
+}
+
+void CommandPipeline::set_executor(Executor executor) {
+    executor_ = std::move(executor);
+}
+
+void CommandPipeline::set_error_handler(ErrorHandler handler) {
+    error_handler_ = std::move(handler);
+}
+
+void CommandPipeline::start() {
+    if (running_.exchange(true)) {
+        return;
+    }
+    parser_done_ = false;
+    for (size_t i = 0; i < shards_.size(); i++) {
+        Shard* s = shards_[i].get();
+        s->thread = std::thread([this, s, i] { executor_loop(*s, i); });
+    }
+    parser_thread_ = std::thread(&CommandPipeline::parser_loop, this);
+}
+
+// 停止并等待已入队的命令处理完毕
+void CommandPipeline::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    inbound_waker_.notify_all();
+    if (parser_thread_.joinable()) {
+        parser_thread_.join();
+    }
+    parser_done_ = true;
+    for (auto& shard : shards_) {
+        shard->waker.notify_all();
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
+
+bool CommandPipeline::submit(const std::string& topic, const std::string& payload) {
+    RawMessage message;
+    message.topic = topic;
+    message.payload = payload;
+    message.received_at = Clock::now();
+    if (Trace::enabled()) {
+        message.trace_id = Trace::current_id() ? Trace::current_id() : Trace::next_id();
+    }
+    {
+        std::lock_guard<std::mutex> lock(submit_mutex_);
+        if (!inbound_.try_push(std::move(message))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    }
+    inbound_waker_.notify();
+    return true;
+}
+
+// 解析阶段：唯一消费inbound_，也是各执行分片队列的唯一生产者
+void CommandPipeline::parser_loop() {
+    Trace::set_thread_name("cmd-parser");
+    RawMessage message;
+    std::string error;
+    for (;;) {
+        if (!inbound_.try_pop(message)) {
+            if (!running_) {
+                break;
+            }
+            inbound_waker_.wait([this] { return !inbound_.empty() || !running_; });
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        queue_wait_.record(start - message.received_at);
+
+        ParsedCommand parsed;
+        bool ok;
+        {
+            TraceSpan span("command.parse", message.trace_id);
+            ok = parse_command(message.payload, parsed.command, error);
+        }
+        parsed.parsed_at = Clock::now();
+        parse_.record(parsed.parsed_at - start);
+        if (message.trace_id && Trace::enabled()) {
+            Trace::record("command.queue_wait", message.trace_id, trace_ns(message.received_at), trace_ns(start));
+        }
+
+        if (!ok) {
+            parse_errors_.fetch_add(1, std::memory_order_relaxed);
+            if (error_handler_) {
+                error_handler_(message.topic, error);
+            }
+            continue;
+        }
+
+        parsed.command.topic = std::move(message.topic);
+        parsed.command.received_at = message.received_at;
+        parsed.command.trace_id = message.trace_id;
+
+        Shard& shard = *shards_[std::hash<std::string>()(parsed.command.device_id) % shards_.size()];
+        if (!shard.queue.try_push(std::move(parsed))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            continue;
+        }
+        shard.waker.notify();
+    }
+}
+
+// 执行阶段：同一分片内的命令串行执行
+void CommandPipeline::executor_loop(Shard& shard, size_t index) {
+    char name[32];
+    snprintf(name, sizeof(name), "cmd-exec-%zu", index);
+    Trace::set_thread_name(name);
+    ParsedCommand parsed;
+    for (;;) {
+        if (!shard.queue.try_pop(parsed)) {
+            // 解析线程退出后才结束，保证已解析的命令被执行
+            if (parser_done_) {
+                break;
+            }
+            shard.waker.wait([this, &shard] { return !shard.queue.empty() || parser_done_; });
+            continue;
+        }
+
+        Clock::time_point start = Clock::now();
+        dispatch_wait_.record(start - parsed.parsed_at);
+        if (parsed.command.trace_id && Trace::enabled()) {
+            Trace::record("command.dispatch_wait", parsed.command.trace_id, trace_ns(parsed.parsed_at), trace_ns(start));
+        }
+        if (executor_) {
+            TraceSpan span("command.execute", parsed.command.trace_id);
+            executor_(parsed.command);
+        }
+        execute_.record(Clock::now() - start);
+    }
+}
+
+CommandPipeline::Statistics CommandPipeline::get_statistics() const {
+    Statistics stats;
+    stats.queue_wait = queue_wait_.snapshot();
+    stats.parse = parse_.snapshot();
+    stats.dispatch_wait = dispatch_wait_.snapshot();
+    stats.execute = execute_.snapshot();
+    stats.dropped = dropped_.load(std::memory_order_relaxed);
+    stats.parse_errors = parse_errors_.load(std::memory_order_relaxed);
+    return stats;
+}
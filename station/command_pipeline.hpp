@@ -0,0 +1,142 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "command.hpp"
+#include "spsc_queue.hpp"
+
+/**
+ * @brief 下行命令流水线
+ *
+ * I/O线程 --(原始报文)--> 解析线程 --(按连接器分片的SPSC)--> 执行线程
+ *
+ * - submit() 只做拷贝入队，不解析、不调用设备，网络线程不会被设备阻塞
+ * - submit() 可由多个线程调用（sync()可能在其他线程触发回调），入队在submit_mutex_下串行，
+ *   因此入口实际是加锁的多生产者单消费者队列；解析之后的分片队列才是真正的SPSC
+ * - 解析线程把报文解析为Command，按device_id哈希分发到执行分片
+ * - 同一连接器的命令总落在同一执行线程上，设备动作串行执行
+ * - 每个阶段记录次数/平均/最大耗时
+ * - 跟踪开启时，报文继承提交线程的跟踪ID（没有则分配新ID），各阶段的排队与处理时间写入Trace
+ */
+class CommandPipeline {
+public:
+    using Executor = std::function<void(const Command& command)>;
+    using ErrorHandler = std::function<void(const std::string& topic, const std::string& error)>;
+
+    // 单阶段耗时统计
+    struct StageStats {
+        uint64_t count = 0;
+        std::chrono::nanoseconds total{0};
+        std::chrono::nanoseconds max{0};
+
+        std::chrono::nanoseconds average() const {
+            return count ? total / static_cast<int64_t>(count) : std::chrono::nanoseconds(0);
+        }
+    };
+
+    struct Statistics {
+        StageStats queue_wait;     // 入队 -> 解析线程取出
+        StageStats parse;          // 解析耗时
+        StageStats dispatch_wait;  // 解析完成 -> 执行线程取出
+        StageStats execute;        // 执行耗时（设备动作）
+        uint64_t dropped = 0;      // 队列满被丢弃的报文
+        uint64_t parse_errors = 0; // 解析失败的报文
+    };
+
+    explicit CommandPipeline(size_t executor_count = 1, size_t queue_capacity = 256);
+    ~CommandPipeline();
+
+    CommandPipeline(const CommandPipeline&) = delete;
+    CommandPipeline& operator=(const CommandPipeline&) = delete;
+
+    // 启动前设置
+    void set_executor(Executor executor);
+    void set_error_handler(ErrorHandler handler);
+
+    void start();
+    void stop();
+
+    // I/O线程调用：报文入队，队列满时丢弃并返回false
+    bool submit(const std::string& topic, const std::string& payload);
+
+    Statistics get_statistics() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct RawMessage {
+        std::string topic;
+        std::string payload;
+        Clock::time_point received_at;
+        uint64_t trace_id = 0;
+    };
+
+    struct ParsedCommand {
+        Command command;
+        Clock::time_point parsed_at;
+    };
+
+    // 空闲时休眠、有数据时唤醒；生产者仅在消费者休眠时才加锁通知
+    class Waker {
+    public:
+        void notify();
+        void notify_all();
+        template <typename Predicate>
+        void wait(Predicate ready) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            waiting_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            cv_.wait(lock, ready);
+            waiting_.store(false, std::memory_order_relaxed);
+        }
+    private:
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::atomic<bool> waiting_{false};
+    };
+
+    // 无锁阶段计数器
+    class StageCounter {
+    public:
+        void record(std::chrono::nanoseconds elapsed);
+        StageStats snapshot() const;
+    private:
+        std::atomic<uint64_t> count_{0};
+        std::atomic<uint64_t> total_ns_{0};
+        std::atomic<uint64_t> max_ns_{0};
+    };
+
+    struct Shard {
+        explicit Shard(size_t capacity) : queue(capacity) {}
+        SpscQueue<ParsedCommand> queue;
+        Waker waker;
+        std::thread thread;
+    };
+
+    void parser_loop();
+    void executor_loop(Shard& shard, size_t index);
+
+    SpscQueue<RawMessage> inbound_;
+    Waker inbound_waker_;
+    std::mutex submit_mutex_;  // 多个提交线程串行入队，inbound_的生产者唯一
+    std::thread parser_thread_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+
+    Executor executor_;
+    ErrorHandler error_handler_;
+    std::atomic<bool> running_;
+    std::atomic<bool> parser_done_;  // 解析线程已退出，执行线程可在清空队列后退出
+
+    StageCounter queue_wait_;
+    StageCounter parse_;
+    StageCounter dispatch_wait_;
+    StageCounter execute_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> parse_errors_;
+};
@@ -0,0 +1,492 @@
+#include "connector.hpp"
+#include <chrono>
+#include "elog.h"
+#include "tools/trace/trace.hpp"
+
+const int Connector::kDeviceTimeoutMs;
+
+Connector::Connector(const std::string& id, std::unique_ptr<DeviceBase> device,
+                     const PriceStore& prices, Publisher publisher, SiteBudget* site)
+    : id_(id), device_(std::move(device)), device_timeout_(kDeviceTimeoutMs), prices_(prices),
+      publisher_(std::move(publisher)), admission_(site),
+      rated_power_w_(static_cast<uint32_t>(kDefaultRatedKw * 1000)), reserved_power_w_(0),
+      reserved_(false), tariff_version_(0), next_report_ms_(0), charging_(false), current_start_type_(-1),
+      command_seq_(0), session_trace_id_(0) {
+}
+
+// 先等待设备上未完成的命令与回调结束，回调会访问连接器的其他成员
+Connector::~Connector() {
+    device_.close();
+}
+
+void Connector::set_rated_power(double kw) {
+    rated_power_w_ = kw > 0 ? static_cast<uint32_t>(kw * 1000) : 0;
+}
+
+std::string Connector::topic(const char* prefix) const {
+    return std::string(prefix) + id_;
+}
+
+namespace {
+
+int64_t now_unix_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 本地时间 "YYYY-MM-DD HH:MM:SS"
+std::string format_time(int64_t unix_ms) {
+    time_t seconds = static_cast<time_t>(unix_ms / 1000);
+    struct tm tm_time;
+    localtime_r(&seconds, &tm_time);
+    char buf[32];
+    strftime(buf, sizeof(buf), "%Y-%m-%d %H:%M:%S", &tm_time);
+    return buf;
+}
+
+const char* start_describe(int start_type) {
+    switch (start_type) {
+        case START_TYPE_REMOTE: return "remote start";
+        case START_TYPE_COMMERCIAL: return "commercial start";
+        case START_TYPE_NFC: return "nfc start";
+        case START_TYPE_BLUETOOTH: return "bluetooth start";
+        default: return "start";
+    }
+}
+
+// 启动命令（自检+启动）在DeviceReply::value中的结果
+const int kStartOk = 1;
+const int kStartFailed = 0;
+const int kSelfCheckFailed = -1;
+const int kRefreshSkipped = -1;
+
+// 执行一次自检（子系统并发）并记入缓存，返回自检码
+int run_self_check(DeviceBase& device, SelfCheckCache& cache, bool refresh) {
+    uint64_t generation = cache.generation();
+    auto begin = SelfCheckCache::Clock::now();
+    int code = SelfCheckCache::run(device);
+    int64_t elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
+        SelfCheckCache::Clock::now() - begin).count();
+    cache.store(code, begin, elapsed_us, refresh, generation);
+    return code;
+}
+
+}  // namespace
+
+void Connector::set_status(uint64_t pos) {
+    status_.set(pos);
+}
+
+void Connector::clear_status(uint64_t pos) {
+    status_.clear(pos);
+}
+
+int Connector::get_status(uint64_t pos) const {
+    return status_.test(pos) ? 1 : 0;
+}
+
+uint64_t Connector::status() const {
+    return status_.load();
+}
+
+bool Connector::check_start_condition(int type, std::string& describe){
+    TraceSpan span("connector.admission");
+
+    if(!AdmissionControl::known_start_type(type)){
+        log_e("[%s] 未知启动类型",id_.c_str());
+    }
+
+    // 检查禁止位并置忙碌在同一次CAS中完成，并发的两个启动命令只有一个能通过；随后预留站点会话与功率
+    int result = admission_.admit(status_, type, rated_power_w_);
+    if(result != ADMISSION_OK){
+        describe = admission_describe(result);
+        log_e("[%s] 启动被拒绝: %s",id_.c_str(),describe.c_str());
+        return false;
+    }
+    // 设备启动完成前预留即生效，期间收到停止命令时由stop_charging归还
+    hold_reservation(rated_power_w_);
+    return true;
+}
+
+void Connector::hold_reservation(uint32_t power_w){
+    reserved_power_w_ = power_w;
+    reserved_ = true;
+}
+
+bool Connector::take_reservation(uint32_t& power_w){
+    if(!reserved_.exchange(false)){
+        return false;
+    }
+    power_w = reserved_power_w_.exchange(0);
+    return true;
+}
+
+void Connector::handle_command(const Command& command){
+    if(command.topic != topic(TOPIC_CMD)){
+        return;
+    }
+
+    int cmd = command.cmd;
+    if(cmd == DEVICE_CMD_REMOTE_START){
+        log_i("[%s] start",id_.c_str());
+        start_charging(cmd, START_TYPE_REMOTE, "remote start");
+    }
+    else if(cmd == DEVICE_CMD_COMMERCIAL_START){
+        log_i("[%s] start",id_.c_str());
+        start_charging(cmd, START_TYPE_COMMERCIAL, "commercial start");
+    }
+    else if(cmd == DEVICE_CMD_STOP){
+        log_i("[%s] stop",id_.c_str());
+        stop_charging(cmd);
+    }
+}
+
+void Connector::start_charging(int cmd, int start_type, const char* describe){
+    std::string reject;
+    if(!check_start_condition(start_type, reject)){
+        log_e("[%s] check_start_condition failed",id_.c_str());
+        send_result(cmd,RESULT_FAIL,reject);
+        return;
+    }
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(charge_mutex_);
+        seq = ++command_seq_;
+    }
+    // 自检与启动作为一条设备命令执行，跟踪ID随命令带到设备线程；
+    // 缓存中有通过的自检结果时跳过自检（在设备线程上判断，排在前面的后台刷新已完成）
+    uint64_t trace_id = Trace::current_id();
+    bool queued = device_.submit(
+        [this, trace_id](DeviceBase& device, DeviceReply& reply) {
+            if(!self_check_.take_passed(SelfCheckCache::Clock::now())){
+                TraceSpan span("device.self_check", trace_id);
+                if(run_self_check(device, self_check_, false) > 0){
+                    reply.value = kSelfCheckFailed;
+                    return;
+                }
+            }
+            TraceSpan span("device.start", trace_id);
+            reply.value = device.Start() ? kStartOk : kStartFailed;
+        },
+        device_timeout_,
+        [this, cmd, start_type, describe, seq, trace_id](const DeviceReply& reply) {
+            finish_start(cmd, start_type, describe, seq, trace_id, reply);
+        });
+    if(!queued){
+        log_e("[%s] device command queue full",id_.c_str());
+        uint32_t reserved = 0;
+        if(take_reservation(reserved)){
+            admission_.cancel(status_, reserved);
+        }
+        send_result(cmd,RESULT_FAIL,"device busy");
+    }
+}
+
+// 设备线程（或同步执行时的执行线程）
+void Connector::finish_start(int cmd, int start_type, const char* describe, uint64_t seq, uint64_t trace_id,
+                             const DeviceReply& reply){
+    if(reply.result == DEVICE_RESULT_CANCELLED){
+        return;  // 连接器关闭
+    }
+    std::unique_lock<std::mutex> lock(charge_mutex_);
+    if(seq != command_seq_){
+        // 启动完成前已收到停止命令：预留与状态已由stop_charging处理，停止命令排在本命令之后执行
+        lock.unlock();
+        log_w("[%s] start superseded by stop",id_.c_str());
+        send_result(cmd,RESULT_FAIL,"start cancelled by stop");
+        return;
+    }
+    if(reply.result != DEVICE_RESULT_OK || reply.value != kStartOk){
+        const char* reason;
+        uint64_t fail_bits = 0;
+        if(reply.result == DEVICE_RESULT_TIMEOUT){
+            // 超时的设备调用仍可能完成启动，排一条停止命令保证设备最终处于停止状态
+            log_e("[%s] device start timeout after %lldms",id_.c_str(),
+                  static_cast<long long>(reply.elapsed_us / 1000));
+            device_.submit([](DeviceBase& device, DeviceReply& stop_reply) {
+                stop_reply.value = device.Stop() ? 1 : 0;
+            }, device_timeout_, [](const DeviceReply&) {}, true);
+            self_check_.invalidate();
+            reason = "device timeout";
+        }
+        else if(reply.value == kSelfCheckFailed){
+            log_e("[%s] 设备自检失败",id_.c_str());
+            fail_bits = StatusRegister::bit(DEVICE_STATUS_SELF_CHECK_FAIL);
+            reason = "self check failed";
+        }
+        else{
+            log_e("[%s] device start failed",id_.c_str());
+            self_check_.invalidate();
+            clear_status(DEVICE_STATUS_SELF_CHECK_FAIL);
+            reason = "device start failed";
+        }
+        uint32_t reserved = 0;
+        if(take_reservation(reserved)){
+            admission_.release(reserved);
+        }
+        status_.transition(0, fail_bits, StatusRegister::bit(DEVICE_STATUS_BUSY));
+        lock.unlock();
+        send_result(cmd,RESULT_FAIL,reason);
+        return;
+    }
+    //自检成功
+    clear_status(DEVICE_STATUS_SELF_CHECK_FAIL);
+    current_start_type_ = start_type;
+    status_.transition(0, StatusRegister::bit(DEVICE_STATUS_START), StatusRegister::bit(DEVICE_STATUS_STOP));
+
+    int64_t now_ms = now_unix_ms();
+    TraceSpan span("session.restart", trace_id);
+    charge_info_.clear();
+    charge_info_.start_time = format_time(now_ms);
+    charge_info_.start_type = start_type;
+    charge_info_.describe = describe;
+    tariff_ = prices_.current();
+    tariff_version_ = tariff_->version;
+    charge_info_.period_stats.assign(tariff_->table.period_count(), 0.0f);
+    meter_.reset(tariff_->table, start_type == START_TYPE_COMMERCIAL);
+    next_report_ms_ = 0;
+    session_trace_id_ = span.id();
+    if(journal_ && !journal_->begin(now_ms, start_type)){
+        log_e("[%s] journal begin failed: %s",id_.c_str(),journal_->last_error().c_str());
+    }
+    // 下一个采样周期开始累计
+    charging_ = true;
+}
+
+void Connector::stop_charging(int cmd){
+    bool was_charging;
+    {
+        // 序号变化使尚未完成的启动作废
+        std::lock_guard<std::mutex> lock(charge_mutex_);
+        command_seq_++;
+        was_charging = charging_.exchange(false);
+    }
+    uint32_t reserved = 0;
+    if(take_reservation(reserved)){
+        admission_.release(reserved);
+    }
+    status_.transition(0, StatusRegister::bit(DEVICE_STATUS_STOP),
+                       StatusRegister::bit(DEVICE_STATUS_START) | StatusRegister::bit(DEVICE_STATUS_BUSY));
+    // 停止命令在设备队列中排在未完成的启动之后，即使排队超时也会执行，结果在设备执行完成后发送；
+    // 计量此刻已停止，可立即结算
+    uint64_t trace_id = Trace::current_id();
+    bool queued = device_.submit(
+        [trace_id](DeviceBase& device, DeviceReply& reply) {
+            TraceSpan span("device.stop", trace_id);
+            reply.value = device.Stop() ? 1 : 0;
+        },
+        device_timeout_,
+        [this, cmd](const DeviceReply& reply) {
+            if(reply.result == DEVICE_RESULT_CANCELLED){
+                return;
+            }
+            if(reply.result == DEVICE_RESULT_TIMEOUT){
+                log_e("[%s] device stop timeout",id_.c_str());
+                send_result(cmd,RESULT_FAIL,"device timeout");
+                return;
+            }
+            send_result(cmd,RESULT_OK);
+        },
+        true);
+    if(!queued){
+        log_e("[%s] device command queue full",id_.c_str());
+        send_result(cmd,RESULT_FAIL,"device busy");
+    }
+    if(!was_charging){
+        return;
+    }
+    // 充电后设备状态已变化（继电器动作、温升），下次启动前须重新自检，空闲时由后台刷新补上
+    self_check_.invalidate();
+
+    // 结算：上报最终充电信息并关闭日志
+    int64_t now_ms = now_unix_ms();
+    std::lock_guard<std::mutex> lock(charge_mutex_);
+    charge_info_.end_time = format_time(now_ms);
+    sync_period_stats(meter_.take_dirty());
+    charge_info_.all_energy = static_cast<float>(meter_.total_kwh());
+    charge_info_.total = static_cast<float>(meter_.total_cost());
+    send_charge_info();
+    if(journal_ && journal_->is_open() && !journal_->end(now_ms)){
+        log_e("[%s] journal end failed: %s",id_.c_str(),journal_->last_error().c_str());
+    }
+}
+
+void Connector::refresh_self_check(){
+    if(charging_ || status_.test(DEVICE_STATUS_BUSY) || !self_check_.begin_refresh(SelfCheckCache::Clock::now())){
+        return;
+    }
+    bool queued = device_.submit(
+        [this](DeviceBase& device, DeviceReply& reply) {
+            // 入队之后被准入的启动已置忙碌（其设备命令排在本命令之后），不在启动或充电中自检
+            if(charging_ || status_.test(DEVICE_STATUS_BUSY)){
+                self_check_.cancel_refresh();
+                reply.value = kRefreshSkipped;
+                return;
+            }
+            TraceSpan span("device.self_check.refresh");
+            reply.value = run_self_check(device, self_check_, true);
+        },
+        device_timeout_,
+        [this](const DeviceReply& reply) {
+            if(reply.result != DEVICE_RESULT_OK){
+                // 超时的自检返回后仍会记入缓存；排队超时未执行的需在此解除刷新标记
+                self_check_.cancel_refresh();
+                return;
+            }
+            if(reply.value == kRefreshSkipped){
+                return;
+            }
+            if(reply.value > 0){
+                log_w("[%s] background self check failed: %d",id_.c_str(),reply.value);
+                set_status(DEVICE_STATUS_SELF_CHECK_FAIL);
+            }
+            else{
+                clear_status(DEVICE_STATUS_SELF_CHECK_FAIL);
+            }
+        });
+    if(!queued){
+        self_check_.cancel_refresh();
+    }
+}
+
+void Connector::tick(int64_t now_ms){
+    if(!charging_){
+        return;
+    }
+    add_sample(now_ms, device_.device().GetPower());//(kw)
+}
+
+void Connector::add_sample(int64_t sample_ms, double power){
+    std::lock_guard<std::mutex> lock(charge_mutex_);
+    if(!charging_){
+        return;
+    }
+    // 电价更新只比较版本号，未变化时不取快照
+    if(prices_.version() != tariff_version_){
+        switch_tariff();
+    }
+    meter_.add_sample(sample_ms, power);
+    if(journal_ && journal_->is_open() && !journal_->append_sample(sample_ms, power, meter_)){
+        log_e("[%s] journal append failed: %s",id_.c_str(),journal_->last_error().c_str());
+    }
+    if(next_report_ms_ == 0){
+        next_report_ms_ = sample_ms + kReportIntervalMs;
+        return;
+    }
+    if(sample_ms < next_report_ms_){
+        return;
+    }
+    next_report_ms_ += kReportIntervalMs;
+    if(next_report_ms_ <= sample_ms){
+        next_report_ms_ = sample_ms + kReportIntervalMs;
+    }
+
+    // 积分器维护累计电量与费用，这里只同步有变化的时段
+    sync_period_stats(meter_.take_dirty());
+    charge_info_.all_energy = static_cast<float>(meter_.total_kwh());
+    charge_info_.total = static_cast<float>(meter_.total_cost());
+    // 启动后的首条充电信息归入启动命令的跟踪
+    TraceSpan span(session_trace_id_ ? "charge_info.first" : nullptr, session_trace_id_);
+    session_trace_id_ = 0;
+    send_charge_info();
+}
+
+bool Connector::enable_journal(const std::string& path_prefix, const SessionJournal::Options& options){
+    std::lock_guard<std::mutex> lock(charge_mutex_);
+    journal_.reset(new SessionJournal(path_prefix, options));
+
+    SessionJournal::RecoveredSession session;
+    tariff_ = prices_.current();
+    tariff_version_ = tariff_->version;
+    if(!journal_->recover(tariff_->table, meter_, session)){
+        return false;
+    }
+    // 恢复会话：计量从日志末尾继续，设备实际状态由后续采样反映
+    charge_info_.clear();
+    charge_info_.start_type = session.start_type;
+    charge_info_.start_time = format_time(session.start_ms);
+    charge_info_.describe = std::string(start_describe(session.start_type)) + " (recovered)";
+    charge_info_.period_stats.assign(meter_.ledger().period_count(), 0.0f);
+    sync_period_stats(meter_.take_dirty());
+    charge_info_.all_energy = static_cast<float>(meter_.total_kwh());
+    charge_info_.total = static_cast<float>(meter_.total_cost());
+    current_start_type_ = session.start_type;
+    next_report_ms_ = 0;
+    // 恢复的会话照常占用站点预算
+    admission_.restore(rated_power_w_);
+    hold_reservation(rated_power_w_);
+    status_.transition(0, StatusRegister::bit(DEVICE_STATUS_START) | StatusRegister::bit(DEVICE_STATUS_BUSY),
+                       StatusRegister::bit(DEVICE_STATUS_STOP));
+    charging_ = true;
+    log_w("[%s] recovered session started %s: %.3fkWh, %llu records, %llu replayed%s",
+          id_.c_str(),charge_info_.start_time.c_str(),meter_.total_kwh(),
+          static_cast<unsigned long long>(session.records),
+          static_cast<unsigned long long>(session.replayed),
+          session.from_checkpoint ? " after checkpoint" : "");
+    return true;
+}
+
+// 调用方持有charge_mutex_；会话继续持有旧快照直到切换成功
+void Connector::switch_tariff(){
+    PriceSnapshotPtr snapshot = prices_.current();
+    tariff_version_ = snapshot->version;
+    if(!meter_.switch_tariff(snapshot->table)){
+        log_w("[%s] too many tariff changes in one session, keep tariff v%llu",
+              id_.c_str(),static_cast<unsigned long long>(tariff_->version));
+        return;
+    }
+    tariff_ = std::move(snapshot);
+    charge_info_.period_stats.resize(meter_.ledger().period_count(), 0.0f);
+    log_i("[%s] tariff v%llu applies from the next minute",
+          id_.c_str(),static_cast<unsigned long long>(tariff_version_));
+}
+
+// 调用方持有charge_mutex_；period_stats下标为电价时段ID
+void Connector::sync_period_stats(uint64_t dirty){
+    const EnergyLedger& ledger = meter_.ledger();
+    size_t count = charge_info_.period_stats.size();
+    for(size_t i = 0;i < count && dirty;i++){
+        if(dirty & (1ULL << (i < 63 ? i : 63))){
+            charge_info_.period_stats[i] = static_cast<float>(ledger.period_kwh(static_cast<int>(i)));
+        }
+        if(i < 63){
+            dirty &= ~(1ULL << i);
+        }
+    }
+}
+
+void Connector::send_heartbeat(){
+    nlohmann::json content;
+    content["status"] = status();
+    content["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+    content["device_id"] = id_;
+    content["describe"] = "heartbeat";
+    publisher_(topic(TOPIC_HEARTBEAT), content, 1, false);
+}
+
+void Connector::send_result(int cmd,int result,const std::string& describe){
+    nlohmann::json content;
+    content["cmd"] = cmd;
+    content["result"] = result;
+    content["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+    content["device_id"] = id_;
+    content["describe"] = describe;
+    log_i("send:%s  content:%s",topic(TOPIC_STATUS).c_str(),content.dump().c_str());
+    publisher_(topic(TOPIC_STATUS), content, 1, false);
+}
+
+void Connector::send_charge_info(){
+    nlohmann::json content;
+    content["cmd"] = DEVICE_CMD_CHARGE_INFO;
+    content["result"] = RESULT_OK;
+    content["timestamp"] = std::chrono::duration_cast<std::chrono::seconds>(
+                                std::chrono::system_clock::now().time_since_epoch()).count();
+    content["device_id"] = id_;
+    content["describe"] = "charge info";
+    content["charge_info"] = charge_info_;
+    // 每个连接器每秒一条，按调试级别输出
+    log_d("send:%s  content:%s",topic(TOPIC_STATUS).c_str(),content.dump().c_str());
+    publisher_(topic(TOPIC_STATUS), content, 1, false);
+}
@@ -0,0 +1,126 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "command.hpp"
+#include "station_types.hpp"
+#include "status_register.hpp"
+#include "admission.hpp"
+#include "energy_meter.hpp"
+#include "session_journal.hpp"
+#include "device/async_device.hpp"
+#include "device/self_check_cache.hpp"
+#include "config/price_store.hpp"
+
+/**
+ * @brief 充电连接器
+ *
+ * 每个连接器独立持有设备、状态字、充电会话与计量数据。
+ * 命令由命令流水线的执行线程串行调用handle_command，
+ * 准入之后的设备动作（自检+启动、停止）经AsyncDevice排队执行，设置了DeviceExecutor时不阻塞执行线程，
+ * 结果在设备完成或超时时发送；启动完成前收到的停止命令使该次启动作废。
+ * 启用自检缓存后，有效期内通过过自检的启动只执行Start；空闲时由refresh_self_check在后台刷新缓存。
+ * 计量由运行时工作线程按采样周期（10~100Hz）调用tick（或由批量采样调用add_sample），梯形积分后每秒上报一次，
+ * 两者通过内部锁同步。
+ * 启动准入由AdmissionControl完成（状态位规则 + 站点并发会话数/功率预算）。
+ * 会话开始时取当前电价快照；会话中电价更新时，之后的分钟按新快照计费，已计费部分不变，
+ * charge_info的period_stats随之为新快照追加一组时段。
+ * 启用会话日志后，每个采样同时写入日志，进程重启时从日志恢复未结束的会话。
+ * 所有出站消息经Publisher发送，连接器本身不依赖MQTT客户端。
+ */
+class Connector {
+public:
+    static const int64_t kReportIntervalMs = 1000;
+    static const int kDeviceTimeoutMs = 5000;  // 设备命令默认超时（含排队）
+    static constexpr double kDefaultRatedKw = 7.0;  // 默认额定功率（交流桩）
+
+    using Publisher = std::function<void(const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain)>;
+
+    // site为空时不受站点限额约束
+    Connector(const std::string& id, std::unique_ptr<DeviceBase> device,
+              const PriceStore& prices, Publisher publisher, SiteBudget* site = nullptr);
+
+    ~Connector();
+
+    Connector(const Connector&) = delete;
+    Connector& operator=(const Connector&) = delete;
+
+    const std::string& id() const { return id_; }
+    // 额定功率，准入时按此从站点功率预算中预留；需在运行前设置
+    void set_rated_power(double kw);
+    double rated_power() const { return rated_power_w_ / 1000.0; }
+    void set_device_timeout(std::chrono::milliseconds timeout) { device_timeout_ = timeout; }
+    // 设备命令队列；运行前可为其设置执行器
+    AsyncDevice& device() { return device_; }
+    // 自检结果缓存，默认不缓存
+    void set_self_check_cache(const SelfCheckCache::Options& options) { self_check_.set_options(options); }
+    const SelfCheckCache& self_check_cache() const { return self_check_; }
+    // 前缀 + 连接器ID
+    std::string topic(const char* prefix) const;
+
+    // 处理下行命令（执行线程）
+    void handle_command(const Command& command);
+    // 周期采样（工作线程），now_ms为UTC毫秒时间戳
+    void tick(int64_t now_ms);
+    // 批量采样得到的一个采样点（工作线程），不在充电时忽略
+    void add_sample(int64_t sample_ms, double power_kw);
+    void send_heartbeat();
+    // 空闲且自检缓存需要刷新时排一条后台自检，结果更新缓存与自检失败状态位；
+    // 刷新期间到达的启动排在其后，使用其结果。没有设备执行器时在调用线程上同步执行
+    void refresh_self_check();
+    // 启用会话日志（path_prefix不含扩展名）并恢复崩溃前未结束的会话，恢复成功返回true
+    // 需在运行时启动前调用
+    bool enable_journal(const std::string& path_prefix,
+                        const SessionJournal::Options& options = SessionJournal::Options());
+
+    // 状态字（无锁，可在任意线程调用）
+    void set_status(uint64_t pos);
+    void clear_status(uint64_t pos);
+    int get_status(uint64_t pos) const;
+    uint64_t status() const;
+
+    bool is_charging() const { return charging_; }
+
+private:
+    bool check_start_condition(int type, std::string& describe);
+    void start_charging(int cmd, int start_type, const char* describe);
+    void finish_start(int cmd, int start_type, const char* describe, uint64_t seq, uint64_t trace_id,
+                      const DeviceReply& reply);
+    void stop_charging(int cmd);
+    void send_result(int cmd, int result, const std::string& describe = "");
+    // admit/restore成功后记录预留；take_reservation取走预留，未持有时返回false
+    void hold_reservation(uint32_t power_w);
+    bool take_reservation(uint32_t& power_w);
+    void send_charge_info();  // 调用方持有charge_mutex_
+    void sync_period_stats(uint64_t dirty);  // 调用方持有charge_mutex_
+    void switch_tariff();  // 调用方持有charge_mutex_
+
+    const std::string id_;
+    AsyncDevice device_;
+    std::chrono::milliseconds device_timeout_;
+    SelfCheckCache self_check_;
+    const PriceStore& prices_;
+    Publisher publisher_;
+
+    StatusRegister status_;
+    AdmissionControl admission_;
+    uint32_t rated_power_w_;
+    std::atomic<uint32_t> reserved_power_w_;  // 当前会话预留的站点功率（额定功率可为0）
+    std::atomic<bool> reserved_;              // 持有站点会话预留，与功率一起取走
+
+    std::mutex charge_mutex_;
+    ChargeInfo charge_info_;
+    EnergyMeter meter_;
+    PriceSnapshotPtr tariff_;   // 当前会话计费使用的快照
+    uint64_t tariff_version_;   // 最近一次检查过的电价版本
+    std::unique_ptr<SessionJournal> journal_;
+    int64_t next_report_ms_;  // 下一次上报充电信息的时间，0表示尚未开始
+    std::atomic<bool> charging_;
+    int current_start_type_; //当前启动类型
+    uint64_t command_seq_;  // 启动/停止命令序号，启动完成时序号已变则作废；受charge_mutex_保护
+    uint64_t session_trace_id_;  // 启动命令的跟踪ID，首条充电信息发出后清零
+};
@@ -0,0 +1,202 @@
+#include "energy_ledger.hpp"
+#include <algorithm>
+#include <cmath>
+#include "binary_io.hpp"
+
+namespace {
+const double kMwhPerKwh = 1e6;
+const uint32_t kLedgerFormat = 1;
+
+template <typename T>
+void put_vector(BinaryWriter& w, const std::vector<T>& v) {
+    w.put(static_cast<uint32_t>(v.size()));
+    if (!v.empty()) w.put_bytes(v.data(), v.size() * sizeof(T));
+}
+
+template <typename T>
+bool get_vector(BinaryReader& r, std::vector<T>& v, size_t expected) {
+    uint32_t size = 0;
+    if (!r.get(size) || size != expected) return false;
+    v.resize(size);
+    return size == 0 || r.get_bytes(&v[0], size * sizeof(T));
+}
+}  // namespace
+
+EnergyLedger::EnergyLedger(size_t window_minutes)
+    : window_(window_minutes ? window_minutes : 1),
+      minute_mwh_(window_, 0), minute_period_(window_, 0) {
+    reset(1);
+}
+
+void EnergyLedger::reset(size_t period_count) {
+    if (period_count == 0) period_count = 1;
+    head_ = 0;
+    count_ = 0;
+    window_mwh_.assign(period_count, 0);
+    archived_mwh_.assign(period_count, 0);
+    prices_.assign(period_count, 0);
+    total_mwh_ = 0;
+    residual_mwh_ = 0;
+    archived_cost_ = 0;
+    cost_ = 0;
+    dirty_ = 0;
+}
+
+void EnergyLedger::set_prices(const std::vector<double>& prices) {
+    cost_ = archived_cost_;
+    for (size_t i = 0; i < prices_.size(); i++) {
+        prices_[i] = i < prices.size() ? prices[i] : 0;
+        cost_ += window_mwh_[i] / kMwhPerKwh * prices_[i];
+    }
+}
+
+int EnergyLedger::add_periods(const std::vector<double>& prices) {
+    size_t first = window_mwh_.size();
+    if (prices.empty() || first + prices.size() > kMaxPeriods) {
+        return -1;
+    }
+    window_mwh_.resize(first + prices.size(), 0);
+    archived_mwh_.resize(first + prices.size(), 0);
+    prices_.insert(prices_.end(), prices.begin(), prices.end());
+    return static_cast<int>(first);
+}
+
+bool EnergyLedger::in_window(int64_t unix_minute) const {
+    return count_ > 0 && unix_minute <= head_ && unix_minute > head_ - static_cast<int64_t>(count_);
+}
+
+void EnergyLedger::archive(size_t index) {
+    int period = minute_period_[index];
+    int64_t mwh = minute_mwh_[index];
+    window_mwh_[period] -= mwh;
+    archived_mwh_[period] += mwh;
+    archived_cost_ += mwh / kMwhPerKwh * prices_[period];
+    minute_mwh_[index] = 0;
+}
+
+// 推进窗口到unix_minute，中间空缺的分钟记为0
+void EnergyLedger::advance(int64_t unix_minute, int period) {
+    if (count_ == 0 || unix_minute - head_ >= static_cast<int64_t>(window_)) {
+        for (size_t i = 0; i < count_; i++) {
+            archive(slot(head_ - static_cast<int64_t>(i)));
+        }
+        head_ = unix_minute;
+        count_ = 1;
+    } else {
+        for (int64_t minute = head_ + 1; minute <= unix_minute; minute++) {
+            size_t index = slot(minute);
+            if (count_ == window_) {
+                archive(index);
+            } else {
+                count_++;
+            }
+            minute_mwh_[index] = 0;
+            minute_period_[index] = static_cast<uint8_t>(period);
+        }
+        head_ = unix_minute;
+    }
+    size_t index = slot(unix_minute);
+    minute_mwh_[index] = 0;
+    minute_period_[index] = static_cast<uint8_t>(period);
+}
+
+void EnergyLedger::add(int64_t unix_minute, int period, double kwh) {
+    if (period < 0 || period >= static_cast<int>(window_mwh_.size())) {
+        period = static_cast<int>(window_mwh_.size()) - 1;
+    }
+    if (count_ == 0 || unix_minute > head_) {
+        advance(unix_minute, period);
+    }
+
+    double exact = residual_mwh_ + kwh * kMwhPerKwh;
+    int64_t mwh = static_cast<int64_t>(std::floor(exact));
+    residual_mwh_ = exact - static_cast<double>(mwh);
+
+    if (in_window(unix_minute)) {
+        size_t index = slot(unix_minute);
+        minute_mwh_[index] += static_cast<int32_t>(mwh);
+        window_mwh_[minute_period_[index]] += mwh;
+        period = minute_period_[index];
+    } else {
+        // 早于窗口的迟到数据直接归档
+        archived_mwh_[period] += mwh;
+        archived_cost_ += kwh * prices_[period];
+    }
+    total_mwh_ += mwh;
+    cost_ += kwh * prices_[period];
+    mark_dirty(period);
+}
+
+double EnergyLedger::period_kwh(int period) const {
+    if (period < 0 || period >= static_cast<int>(window_mwh_.size())) {
+        return 0;
+    }
+    return (window_mwh_[period] + archived_mwh_[period]) / kMwhPerKwh;
+}
+
+double EnergyLedger::price(int period) const {
+    if (period < 0 || period >= static_cast<int>(prices_.size())) {
+        return 0;
+    }
+    return prices_[period];
+}
+
+double EnergyLedger::total_kwh() const {
+    return (total_mwh_ + residual_mwh_) / kMwhPerKwh;
+}
+
+size_t EnergyLedger::memory_bytes() const {
+    return sizeof(*this) +
+           minute_mwh_.capacity() * sizeof(int32_t) +
+           minute_period_.capacity() * sizeof(uint8_t) +
+           (window_mwh_.capacity() + archived_mwh_.capacity()) * sizeof(int64_t) +
+           prices_.capacity() * sizeof(double);
+}
+
+void EnergyLedger::save(std::string& out) const {
+    BinaryWriter w(out);
+    w.put(kLedgerFormat);
+    w.put(static_cast<uint64_t>(window_));
+    w.put(head_);
+    w.put(static_cast<uint64_t>(count_));
+    for (size_t i = count_; i > 0; i--) {
+        size_t index = slot(head_ - static_cast<int64_t>(i) + 1);
+        w.put(minute_mwh_[index]);
+        w.put(minute_period_[index]);
+    }
+    put_vector(w, window_mwh_);
+    put_vector(w, archived_mwh_);
+    put_vector(w, prices_);
+    w.put(total_mwh_);
+    w.put(residual_mwh_);
+    w.put(archived_cost_);
+    w.put(cost_);
+}
+
+bool EnergyLedger::load(const char* data, size_t size) {
+    BinaryReader r(data, size);
+    uint32_t format = 0;
+    uint64_t window = 0, count = 0;
+    int64_t head = 0;
+    if (!r.get(format) || format != kLedgerFormat || !r.get(window) || window != window_ ||
+        !r.get(head) || !r.get(count) || count > window_) {
+        return false;
+    }
+    std::fill(minute_mwh_.begin(), minute_mwh_.end(), 0);
+    for (uint64_t i = count; i > 0; i--) {
+        size_t index = slot(head - static_cast<int64_t>(i) + 1);
+        if (!r.get(minute_mwh_[index]) || !r.get(minute_period_[index])) return false;
+    }
+    uint32_t periods = 0;
+    BinaryReader peek = r;
+    if (!peek.get(periods) || periods == 0) return false;
+    if (!get_vector(r, window_mwh_, periods) || !get_vector(r, archived_mwh_, periods) ||
+        !get_vector(r, prices_, periods) || !r.get(total_mwh_) || !r.get(residual_mwh_) ||
+        !r.get(archived_cost_) || !r.get(cost_) || !r.done()) {
+        return false;
+    }
+    head_ = head;
+    count_ = static_cast<size_t>(count);
+    dirty_ = ~0ULL;
+    return true;
+}
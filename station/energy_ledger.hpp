@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 按电价时段ID和分钟记录的电量账本
+ *
+ * - 时段累计：每个电价时段一个整数累计值（mWh），费用随增量同步累计，读取O(1)
+ * - 分钟明细：固定容量环形数组，每分钟4字节电量 + 1字节时段ID，默认保留最近24小时
+ * - 亚mWh的零头以double携带到下一次记账，整数部分不会产生累计误差
+ *
+ * 超出窗口的分钟被归档：按归档时的单价计入归档费用，之后set_prices不再重算其费用。
+ * 非线程安全，由调用方加锁。
+ */
+class EnergyLedger {
+public:
+    static const size_t kDefaultWindowMinutes = 24 * 60;
+    static const size_t kMaxPeriods = 256;  // 分钟明细中的时段ID为1字节
+
+    explicit EnergyLedger(size_t window_minutes = kDefaultWindowMinutes);
+
+    // 清空并按时段数重建，单价清零
+    void reset(size_t period_count);
+
+    // 设置各时段单价（元/kWh）并重算窗口内费用
+    void set_prices(const std::vector<double>& prices);
+
+    // 追加一组新时段（单价为prices），已有时段及其费用不变，返回第一个新时段的ID
+    // 时段总数超过kMaxPeriods时不追加，返回-1
+    int add_periods(const std::vector<double>& prices);
+
+    // 计入unix_minute分钟、period时段的电量，均摊O(1)
+    void add(int64_t unix_minute, int period, double kwh);
+
+    size_t period_count() const { return window_mwh_.size(); }
+    double price(int period) const;
+    double period_kwh(int period) const;
+    double total_kwh() const;
+    double total_cost() const { return cost_; }
+
+    // 窗口内的分钟明细
+    size_t minute_count() const { return count_; }
+    int64_t first_minute() const { return head_ - static_cast<int64_t>(count_) + 1; }
+    int64_t last_minute() const { return head_; }
+
+    // 返回上次调用以来累计值有变化的时段位图并清零（ID>=63的时段共用最高位）
+    uint64_t take_dirty() {
+        uint64_t dirty = dirty_;
+        dirty_ = 0;
+        return dirty;
+    }
+
+    size_t memory_bytes() const;
+
+    // 检查点序列化（只写窗口内的有效分钟）
+    void save(std::string& out) const;
+    bool load(const char* data, size_t size);
+
+private:
+    bool in_window(int64_t unix_minute) const;
+    size_t slot(int64_t unix_minute) const { return static_cast<size_t>(unix_minute % window_); }
+    void advance(int64_t unix_minute, int period);
+    void archive(size_t index);
+    void mark_dirty(int period) { dirty_ |= 1ULL << (period < 63 ? period : 63); }
+
+    const size_t window_;
+    std::vector<int32_t> minute_mwh_;   // 环形分钟电量
+    std::vector<uint8_t> minute_period_;
+    int64_t head_;                      // 最新一分钟
+    size_t count_;                      // 窗口内有效分钟数
+
+    std::vector<int64_t> window_mwh_;   // 窗口内各时段电量
+    std::vector<int64_t> archived_mwh_; // 已归档各时段电量
+    std::vector<double> prices_;
+    int64_t total_mwh_;
+    double residual_mwh_;               // 尚未记入整数累计的零头
+    double archived_cost_;
+    double cost_;
+    uint64_t dirty_;
+};
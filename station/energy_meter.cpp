@@ -0,0 +1,135 @@
+#include "energy_meter.hpp"
+#include "config/price_table.hpp"
+#include "binary_io.hpp"
+#include <algorithm>
+
+namespace {
+
+const int64_t kMsPerMinute = 60 * 1000;
+const double kMsPerHour = 3600.0 * 1000;
+
+// kW × ms → kWh
+inline double trapezoid_kwh(double p0, double p1, int64_t dt_ms) {
+    return (p0 + p1) * 0.5 * static_cast<double>(dt_ms) / kMsPerHour;
+}
+
+}  // namespace
+
+EnergyMeter::EnergyMeter(size_t window_minutes)
+    : ledger_(window_minutes), table_(nullptr), billed_(false), period_base_(0), has_last_(false), last_ms_(0), last_kw_(0),
+      samples_(0), cached_minute_(-1), cached_period_(0) {
+}
+
+void EnergyMeter::reset(const PriceTable& table, bool billed) {
+    table_ = &table;
+    billed_ = billed;
+    period_base_ = 0;
+    has_last_ = false;
+    last_ms_ = 0;
+    last_kw_ = 0;
+    samples_ = 0;
+    cached_minute_ = -1;
+    ledger_.reset(table.period_count());
+    ledger_.set_prices(tariff_prices(table));
+}
+
+bool EnergyMeter::switch_tariff(const PriceTable& table) {
+    int base = ledger_.add_periods(tariff_prices(table));
+    if (base < 0) {
+        return false;
+    }
+    table_ = &table;
+    period_base_ = base;
+    cached_minute_ = -1;
+    return true;
+}
+
+std::vector<double> EnergyMeter::tariff_prices(const PriceTable& table) const {
+    std::vector<double> prices(table.period_count(), 0);
+    if (billed_) {
+        for (size_t i = 0; i < prices.size(); i++) {
+            prices[i] = table.period_price(static_cast<int>(i));
+        }
+    }
+    return prices;
+}
+
+int EnergyMeter::period_of(int64_t unix_minute) {
+    if (unix_minute != cached_minute_) {
+        cached_minute_ = unix_minute;
+        cached_period_ = table_ ? period_base_ + table_->period_at(static_cast<time_t>(unix_minute * 60)) : 0;
+    }
+    return cached_period_;
+}
+
+void EnergyMeter::add_sample(int64_t unix_ms, double power_kw) {
+    samples_++;
+    if (has_last_ && unix_ms > last_ms_) {
+        accumulate(last_ms_, last_kw_, unix_ms, power_kw);
+    }
+    has_last_ = true;
+    last_ms_ = unix_ms;
+    last_kw_ = power_kw;
+}
+
+void EnergyMeter::accumulate(int64_t t0, double p0, int64_t t1, double p1) {
+    const double slope = (p1 - p0) / static_cast<double>(t1 - t0);
+    int64_t start = t0;
+    double p_start = p0;
+    // 逐个整分钟切分（采样周期远小于1分钟时通常不切分或切分一次）
+    for (;;) {
+        int64_t minute = start / kMsPerMinute;
+        int64_t boundary = (minute + 1) * kMsPerMinute;
+        int64_t end = boundary < t1 ? boundary : t1;
+        double p_end = end == t1 ? p1 : p0 + slope * static_cast<double>(end - t0);
+        ledger_.add(minute, period_of(minute), trapezoid_kwh(p_start, p_end, end - start));
+        if (end == t1) {
+            break;
+        }
+        start = end;
+        p_start = p_end;
+    }
+}
+
+void EnergyMeter::save(std::string& out) const {
+    BinaryWriter w(out);
+    w.put(static_cast<uint8_t>(has_last_));
+    w.put(last_ms_);
+    w.put(last_kw_);
+    w.put(samples_);
+    ledger_.save(out);
+}
+
+bool EnergyMeter::restore(const PriceTable& table, bool billed, const char* data, size_t size) {
+    BinaryReader r(data, size);
+    uint8_t has_last = 0;
+    int64_t last_ms = 0;
+    double last_kw = 0;
+    uint64_t samples = 0;
+    const size_t header = sizeof(has_last) + sizeof(last_ms) + sizeof(last_kw) + sizeof(samples);
+    if (!r.get(has_last) || !r.get(last_ms) || !r.get(last_kw) || !r.get(samples) ||
+        !ledger_.load(data + header, size - header)) {
+        return false;
+    }
+    table_ = &table;
+    billed_ = billed;
+    // 检查点中最后一组时段与当前电价表一致时继续使用，否则为当前电价表追加一组
+    std::vector<double> prices = tariff_prices(table);
+    int count = static_cast<int>(ledger_.period_count());
+    int tail = count - static_cast<int>(prices.size());
+    bool same = tail >= 0;
+    for (size_t i = 0; same && i < prices.size(); i++) {
+        same = ledger_.price(tail + static_cast<int>(i)) == prices[i];
+    }
+    period_base_ = same ? tail : ledger_.add_periods(prices);
+    if (period_base_ < 0) {
+        // 时段ID已用尽：沿用最后一组时段ID，超出部分由账本并入最后一个时段
+        period_base_ = std::max(tail, 0);
+    }
+    has_last_ = has_last != 0;
+    last_ms_ = last_ms;
+    last_kw_ = last_kw;
+    samples_ = samples;
+    cached_minute_ = -1;
+    return true;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "energy_ledger.hpp"
+
+class PriceTable;
+
+/**
+ * @brief 电能积分器
+ *
+ * 按采样点（毫秒时间戳, 瞬时功率kW）做梯形积分。一个采样区间跨越整分钟时，
+ * 在分界处按线性插值拆段，每段按所在分钟的本地时间归入电价时段，记入EnergyLedger。
+ * 电价时段在分钟内不变，因此半点等非整点的时段边界也能准确计费。
+ * 会话中电价表更新时，账本为新表追加一组时段ID：已开始的分钟保持原单价，
+ * 之后的分钟按新表计费，即每段电量按其所在时刻有效的电价结算。
+ * 非线程安全，由调用方加锁。
+ */
+class EnergyMeter {
+public:
+    explicit EnergyMeter(size_t window_minutes = EnergyLedger::kDefaultWindowMinutes);
+
+    // 开始新会话：按电价表建立时段，billed为false时不计费
+    void reset(const PriceTable& table, bool billed);
+
+    // 切换电价表：下一个尚未开始的分钟起按table计费，已记账的电量与费用不变
+    // table须在会话结束前保持有效；时段ID用尽时返回false，继续按原表计费
+    bool switch_tariff(const PriceTable& table);
+    const PriceTable* tariff() const { return table_; }
+
+    // 时间戳回退的采样只作为新的起点，不计能量
+    void add_sample(int64_t unix_ms, double power_kw);
+
+    double total_kwh() const { return ledger_.total_kwh(); }
+    double total_cost() const { return ledger_.total_cost(); }
+    uint64_t sample_count() const { return samples_; }
+    const EnergyLedger& ledger() const { return ledger_; }
+    uint64_t take_dirty() { return ledger_.take_dirty(); }
+
+    // 检查点：保存/恢复积分状态与账本（已记账部分沿用检查点中的单价，之后按table计费）
+    void save(std::string& out) const;
+    bool restore(const PriceTable& table, bool billed, const char* data, size_t size);
+
+private:
+    void accumulate(int64_t t0, double p0, int64_t t1, double p1);
+    int period_of(int64_t unix_minute);
+    std::vector<double> tariff_prices(const PriceTable& table) const;
+
+    EnergyLedger ledger_;
+    const PriceTable* table_;
+    bool billed_;
+    int period_base_;         // 当前电价表时段0对应的账本时段ID
+    bool has_last_;
+    int64_t last_ms_;
+    double last_kw_;
+    uint64_t samples_;
+    int64_t cached_minute_;   // 时段查询缓存，每分钟最多一次本地时间换算
+    int cached_period_;
+};
@@ -0,0 +1,140 @@
+#include "outbound_queue.hpp"
+#include "tools/trace/trace.hpp"
+#include <ostream>
+#include <streambuf>
+
+namespace {
+
+// 追加写入目标字符串的流缓冲区，序列化结果直接落在池中消息的payload里，复用其容量
+class StringAppendBuf : public std::streambuf {
+public:
+    void bind(std::string* out) { out_ = out; }
+
+protected:
+    int_type overflow(int_type ch) override {
+        if (!traits_type::eq_int_type(ch, traits_type::eof())) {
+            out_->push_back(traits_type::to_char_type(ch));
+        }
+        return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        out_->append(s, static_cast<size_t>(n));
+        return n;
+    }
+
+private:
+    std::string* out_ = nullptr;
+};
+
+// 每个线程一个输出流，通过nlohmann的公开operator<<序列化。
+// json::dump()每次都会新建结果字符串，这里改为写入out原有的缓冲区。
+struct ThreadSerializer {
+    StringAppendBuf buffer;
+    std::ostream stream;
+
+    ThreadSerializer() : stream(&buffer) {}
+
+    void dump(const nlohmann::json& content, std::string& out) {
+        out.clear();
+        buffer.bind(&out);
+        stream << content;
+    }
+};
+
+}  // namespace
+
+OutboundQueue::OutboundQueue()
+    : OutboundQueue(Options()) {
+}
+
+OutboundQueue::OutboundQueue(const Options& options)
+    : options_(options)
+    , pushed_(0)
+    , drained_(0)
+    , pool_hits_(0)
+    , pool_misses_(0) {
+    pool_.reserve(options_.max_pooled);
+}
+
+void OutboundQueue::push(const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+    static thread_local ThreadSerializer serializer;
+
+    // 只跟踪属于某条命令的消息（如命令结果、启动后的首条充电信息）
+    TraceSpan span(Trace::current_id() ? "publish.enqueue" : nullptr);
+    OutboundMessage message = acquire();
+    message.topic.assign(topic);
+    serializer.dump(content, message.payload);
+    message.qos = qos;
+    message.retain = retain;
+    message.trace_id = span.id();
+    push(std::move(message));
+}
+
+OutboundMessage OutboundQueue::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pool_.empty()) {
+        pool_misses_++;
+        return OutboundMessage();
+    }
+    pool_hits_++;
+    OutboundMessage message = std::move(pool_.back());
+    pool_.pop_back();
+    return message;
+}
+
+void OutboundQueue::push(OutboundMessage&& message) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.push_back(std::move(message));
+    pushed_++;
+}
+
+bool OutboundQueue::drain(std::vector<OutboundMessage>& batch) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (pending_.empty()) {
+        return false;
+    }
+    pending_.swap(batch);
+    drained_ += batch.size();
+    return true;
+}
+
+void OutboundQueue::release(std::vector<OutboundMessage>& batch) {
+    // 缓冲区清理在锁外完成，锁内只移动
+    for (auto& message : batch) {
+        if (message.topic.capacity() > options_.max_buffer_capacity) {
+            std::string().swap(message.topic);
+        } else {
+            message.topic.clear();
+        }
+        message.trace_id = 0;
+        if (message.payload.capacity() > options_.max_buffer_capacity) {
+            std::string().swap(message.payload);
+        } else {
+            message.payload.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& message : batch) {
+            if (pool_.size() >= options_.max_pooled) {
+                break;
+            }
+            pool_.push_back(std::move(message));
+        }
+    }
+    // 超出池上限的消息在锁外析构
+    batch.clear();
+}
+
+OutboundQueue::Statistics OutboundQueue::get_statistics() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Statistics stats;
+    stats.pushed = pushed_;
+    stats.drained = drained_;
+    stats.pool_hits = pool_hits_;
+    stats.pool_misses = pool_misses_;
+    stats.pooled = pool_.size();
+    stats.pending = pending_.size();
+    return stats;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+/**
+ * @brief 出站消息（仅可移动）
+ *
+ * 负载在入队前已序列化为字符串，发送线程不再接触json对象。
+ * topic/payload的缓冲区随消息在池中复用。
+ */
+struct OutboundMessage {
+    std::string topic;
+    std::string payload;
+    uint8_t qos = 0;
+    bool retain = false;
+    uint64_t trace_id = 0;  // 入队时所在的跟踪ID，发送时据此记录publish.flush
+
+    OutboundMessage() = default;
+    OutboundMessage(OutboundMessage&&) = default;
+    OutboundMessage& operator=(OutboundMessage&&) = default;
+    OutboundMessage(const OutboundMessage&) = delete;
+    OutboundMessage& operator=(const OutboundMessage&) = delete;
+};
+
+/**
+ * @brief 出站消息队列（多生产者、单消费者）
+ *
+ * - push() 从池中取出消息对象，在锁外序列化json，加锁时只做一次移动入队
+ * - drain() 把待发送数组与调用方的空数组整体交换，发送在锁外进行
+ * - release() 把发送完的消息连同缓冲区一次性归还到池中
+ *
+ * 预热后（池中缓冲区容量足够）每条消息只剩序列化器自身的两次小分配，payload缓冲区不再重新分配。
+ */
+class OutboundQueue {
+public:
+    struct Options {
+        size_t max_pooled = 256;             // 池中最多保留的消息对象
+        size_t max_buffer_capacity = 16384;  // 超过此容量的缓冲区不回收，避免偶发大消息长期占用内存
+    };
+
+    struct Statistics {
+        uint64_t pushed = 0;
+        uint64_t drained = 0;
+        uint64_t pool_hits = 0;    // 从池中取得消息对象
+        uint64_t pool_misses = 0;  // 池为空，新建消息对象
+        size_t pooled = 0;         // 当前池中消息对象数
+        size_t pending = 0;        // 当前待发送消息数
+    };
+
+    OutboundQueue();
+    explicit OutboundQueue(const Options& options);
+
+    OutboundQueue(const OutboundQueue&) = delete;
+    OutboundQueue& operator=(const OutboundQueue&) = delete;
+
+    // 任意线程：序列化并入队
+    void push(const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain);
+
+    // 任意线程：取出空白消息自行填充后入队
+    OutboundMessage acquire();
+    void push(OutboundMessage&& message);
+
+    // 消费线程：取走全部待发送消息，batch需为空（可保留容量），有消息时返回true
+    bool drain(std::vector<OutboundMessage>& batch);
+    // 消费线程：归还发送完的消息并清空batch（保留容量供下次drain交换）
+    void release(std::vector<OutboundMessage>& batch);
+
+    Statistics get_statistics() const;
+
+private:
+    Options options_;
+    mutable std::mutex mutex_;
+    std::vector<OutboundMessage> pending_;
+    std::vector<OutboundMessage> pool_;
+    uint64_t pushed_;
+    uint64_t drained_;
+    uint64_t pool_hits_;
+    uint64_t pool_misses_;
+};
@@ -0,0 +1,366 @@
+#include "session_journal.hpp"
+#include "energy_meter.hpp"
+#include "station_types.hpp"
+#include "tools/checksum/crc32.hpp"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+const char kJournalMagic[8] = {'C', 'S', 'J', 'R', 'N', 'L', '0', '1'};
+const char kCheckpointMagic[8] = {'C', 'S', 'C', 'K', 'P', 'T', '0', '1'};
+const size_t kHeaderSize = 64;
+
+enum RecordType : uint16_t {
+    RECORD_START = 1,
+    RECORD_SAMPLE = 2,
+    RECORD_STOP = 3,
+};
+
+struct JournalHeader {
+    char magic[8];
+    uint32_t record_size;
+    uint32_t reserved;
+    uint64_t session_id;
+    char padding[kHeaderSize - 24];
+};
+static_assert(sizeof(JournalHeader) == kHeaderSize, "journal header must be 64 bytes");
+
+struct CheckpointHeader {
+    char magic[8];
+    uint64_t session_id;
+    uint64_t records;        // 检查点覆盖的记录数
+    uint32_t blob_size;
+    uint32_t blob_crc;
+};
+
+bool write_all(int fd, const void* data, size_t size) {
+    const char* p = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = write(fd, p, size);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        p += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+std::string parent_dir(const std::string& path) {
+    size_t slash = path.find_last_of('/');
+    if (slash == std::string::npos) {
+        return ".";
+    }
+    return slash == 0 ? "/" : path.substr(0, slash);
+}
+
+bool read_file(const std::string& path, std::string& out) {
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    out.clear();
+    char buf[8192];
+    for (;;) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        out.append(buf, static_cast<size_t>(n));
+    }
+    close(fd);
+    return true;
+}
+
+}  // namespace
+
+// 32字节定长记录，crc覆盖其后的28字节
+struct SessionJournal::Record {
+    uint32_t crc;
+    uint16_t type;
+    uint16_t reserved;
+    uint64_t seq;
+    int64_t unix_ms;
+    double value;            // SAMPLE: 功率kW；START: 启动类型
+
+    uint32_t compute_crc() const {
+        return crc32(reinterpret_cast<const char*>(this) + sizeof(crc), sizeof(Record) - sizeof(crc));
+    }
+};
+
+SessionJournal::SessionJournal(const std::string& path_prefix, const Options& options)
+    : journal_path_(path_prefix + ".journal"), checkpoint_path_(path_prefix + ".ckpt"),
+      dir_path_(parent_dir(path_prefix)), options_(options), fd_(-1), map_(nullptr), map_size_(0), capacity_(0), next_(0),
+      synced_(0), session_id_(0), last_checkpoint_ms_(0) {
+    static_assert(sizeof(Record) == 32, "journal record must be 32 bytes");
+    std::memset(&stats_, 0, sizeof(stats_));
+}
+
+SessionJournal::~SessionJournal() {
+    close_journal();
+}
+
+bool SessionJournal::fail(const std::string& error) {
+    last_error_ = error + ": " + std::strerror(errno);
+    return false;
+}
+
+bool SessionJournal::open_journal(bool truncate) {
+    close_journal();
+    int flags = O_RDWR | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0);
+    fd_ = open(journal_path_.c_str(), flags, 0644);
+    if (fd_ < 0) {
+        return fail("open " + journal_path_);
+    }
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        return fail("stat " + journal_path_);
+    }
+    uint64_t existing = st.st_size > static_cast<off_t>(kHeaderSize)
+                            ? (st.st_size - kHeaderSize) / sizeof(Record) : 0;
+    return ensure_capacity(existing > 0 ? existing : 1);
+}
+
+void SessionJournal::close_journal() {
+    if (map_) {
+        munmap(map_, map_size_);
+        map_ = nullptr;
+        map_size_ = 0;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+    capacity_ = 0;
+}
+
+// 按块扩展文件并重新映射
+bool SessionJournal::ensure_capacity(uint64_t records) {
+    if (map_ && records <= capacity_) {
+        return true;
+    }
+    uint64_t grow = options_.grow_records ? options_.grow_records : 1;
+    uint64_t capacity = (records + grow - 1) / grow * grow;
+    size_t size = kHeaderSize + capacity * sizeof(Record);
+    struct stat st;
+    if (fstat(fd_, &st) != 0) {
+        return fail("stat " + journal_path_);
+    }
+    if (static_cast<size_t>(st.st_size) < size && ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+        return fail("ftruncate " + journal_path_);
+    }
+    if (map_) {
+        munmap(map_, map_size_);
+    }
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (map == MAP_FAILED) {
+        map_ = nullptr;
+        map_size_ = 0;
+        return fail("mmap " + journal_path_);
+    }
+    map_ = static_cast<char*>(map);
+    map_size_ = size;
+    capacity_ = capacity;
+    return true;
+}
+
+bool SessionJournal::append(uint16_t type, int64_t unix_ms, double value) {
+    if (!map_) {
+        last_error_ = "journal not open";
+        return false;
+    }
+    if (!ensure_capacity(next_ + 1)) {
+        return false;
+    }
+    Record record;
+    record.type = type;
+    record.reserved = 0;
+    record.seq = next_;
+    record.unix_ms = unix_ms;
+    record.value = value;
+    record.crc = record.compute_crc();
+    std::memcpy(map_ + kHeaderSize + next_ * sizeof(Record), &record, sizeof(Record));
+    next_++;
+    stats_.records++;
+    stats_.journal_bytes += sizeof(Record);
+    return true;
+}
+
+bool SessionJournal::sync_journal() {
+    if (!map_ || synced_ == next_) {
+        return true;
+    }
+    // msync要求页对齐
+    size_t page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    size_t from = (kHeaderSize + synced_ * sizeof(Record)) / page * page;
+    size_t to = kHeaderSize + next_ * sizeof(Record);
+    if (msync(map_ + from, to - from, MS_SYNC) != 0) {
+        return fail("msync " + journal_path_);
+    }
+    synced_ = next_;
+    return true;
+}
+
+// rename/unlink/创建只修改目录项，文件本身的fsync不覆盖，须单独fsync目录
+bool SessionJournal::sync_dir() {
+    int fd = open(dir_path_.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return fail("open " + dir_path_);
+    }
+    bool ok = fsync(fd) == 0;
+    close(fd);
+    return ok || fail("fsync " + dir_path_);
+}
+
+bool SessionJournal::write_checkpoint(const std::string& blob) {
+    CheckpointHeader header;
+    std::memcpy(header.magic, kCheckpointMagic, sizeof(header.magic));
+    header.session_id = session_id_;
+    header.records = next_;
+    header.blob_size = static_cast<uint32_t>(blob.size());
+    header.blob_crc = crc32(blob.data(), blob.size());
+
+    std::string tmp = checkpoint_path_ + ".tmp";
+    int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return fail("open " + tmp);
+    }
+    bool ok = write_all(fd, &header, sizeof(header)) && write_all(fd, blob.data(), blob.size()) &&
+              fsync(fd) == 0;
+    close(fd);
+    if (!ok) {
+        return fail("write " + tmp);
+    }
+    if (rename(tmp.c_str(), checkpoint_path_.c_str()) != 0) {
+        return fail("rename " + tmp);
+    }
+    if (!sync_dir()) {
+        return false;
+    }
+    stats_.checkpoint_bytes += sizeof(header) + blob.size();
+    stats_.checkpoints++;
+    return true;
+}
+
+bool SessionJournal::checkpoint(const EnergyMeter& meter) {
+    if (!sync_journal()) {
+        return false;
+    }
+    std::string blob;
+    meter.save(blob);
+    return write_checkpoint(blob);
+}
+
+bool SessionJournal::begin(int64_t start_ms, int start_type) {
+    unlink(checkpoint_path_.c_str());
+    if (!open_journal(true)) {
+        return false;
+    }
+    next_ = 0;
+    synced_ = 0;
+    session_id_ = static_cast<uint64_t>(start_ms);
+    last_checkpoint_ms_ = start_ms;
+
+    JournalHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kJournalMagic, sizeof(header.magic));
+    header.record_size = sizeof(Record);
+    header.session_id = session_id_;
+    std::memcpy(map_, &header, sizeof(header));
+    stats_.journal_bytes += sizeof(header);
+
+    // 旧检查点的删除与新日志的创建一起落盘
+    return append(RECORD_START, start_ms, start_type) && sync_journal() && sync_dir();
+}
+
+bool SessionJournal::append_sample(int64_t unix_ms, double power_kw, const EnergyMeter& meter) {
+    if (!append(RECORD_SAMPLE, unix_ms, power_kw)) {
+        return false;
+    }
+    if (unix_ms - last_checkpoint_ms_ >= options_.checkpoint_interval_ms) {
+        last_checkpoint_ms_ = unix_ms;
+        return checkpoint(meter);
+    }
+    return true;
+}
+
+bool SessionJournal::end(int64_t unix_ms) {
+    bool ok = append(RECORD_STOP, unix_ms, 0) && sync_journal();
+    unlink(checkpoint_path_.c_str());
+    ok = sync_dir() && ok;
+    close_journal();
+    return ok;
+}
+
+bool SessionJournal::recover(const PriceTable& table, EnergyMeter& meter, RecoveredSession& session) {
+    if (access(journal_path_.c_str(), F_OK) != 0 || !open_journal(false)) {
+        return false;
+    }
+    JournalHeader header;
+    std::memcpy(&header, map_, sizeof(header));
+    if (std::memcmp(header.magic, kJournalMagic, sizeof(header.magic)) != 0 ||
+        header.record_size != sizeof(Record)) {
+        close_journal();
+        return false;
+    }
+
+    // 找到有效记录的末尾
+    const Record* records = reinterpret_cast<const Record*>(map_ + kHeaderSize);
+    uint64_t count = 0;
+    while (count < capacity_) {
+        const Record& r = records[count];
+        if (r.type == 0 || r.seq != count || r.crc != r.compute_crc()) {
+            break;
+        }
+        count++;
+    }
+    if (count == 0 || records[0].type != RECORD_START || records[count - 1].type == RECORD_STOP) {
+        close_journal();
+        return false;
+    }
+
+    session_id_ = header.session_id;
+    session.start_type = static_cast<int>(records[0].value);
+    session.start_ms = records[0].unix_ms;
+    session.records = count;
+    session.from_checkpoint = false;
+
+    // 检查点必须属于同一会话，且不超过日志中的有效记录
+    uint64_t replay_from = 1;
+    std::string content;
+    if (read_file(checkpoint_path_, content) && content.size() >= sizeof(CheckpointHeader)) {
+        CheckpointHeader ckpt;
+        std::memcpy(&ckpt, content.data(), sizeof(ckpt));
+        const char* blob = content.data() + sizeof(ckpt);
+        if (std::memcmp(ckpt.magic, kCheckpointMagic, sizeof(ckpt.magic)) == 0 &&
+            ckpt.session_id == session_id_ && ckpt.records <= count &&
+            ckpt.blob_size == content.size() - sizeof(ckpt) &&
+            ckpt.blob_crc == crc32(blob, ckpt.blob_size) &&
+            meter.restore(table, session.start_type == START_TYPE_COMMERCIAL, blob, ckpt.blob_size)) {
+            replay_from = ckpt.records;
+            session.from_checkpoint = true;
+        }
+    }
+    if (!session.from_checkpoint) {
+        meter.reset(table, session.start_type == START_TYPE_COMMERCIAL);
+    }
+
+    session.replayed = 0;
+    for (uint64_t i = replay_from; i < count; i++) {
+        if (records[i].type == RECORD_SAMPLE) {
+            meter.add_sample(records[i].unix_ms, records[i].value);
+            session.replayed++;
+        }
+    }
+
+    // 截掉未写完的尾部，之后继续追加
+    next_ = count;
+    synced_ = count;
+    last_checkpoint_ms_ = count > 1 ? records[count - 1].unix_ms : session.start_ms;
+    std::memset(map_ + kHeaderSize + count * sizeof(Record), 0,
+                (capacity_ - count) * sizeof(Record));
+    return true;
+}
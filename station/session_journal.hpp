@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class EnergyMeter;
+class PriceTable;
+
+/**
+ * @brief 充电会话日志（崩溃恢复）
+ *
+ * 每个连接器一个只追加的内存映射文件 <prefix>.journal：
+ * 64字节文件头 + 每个计量采样一条32字节定长记录（带CRC与序号），文件按块预分配。
+ * 按固定间隔把完整积分状态写入检查点 <prefix>.ckpt（临时文件+fsync+rename）。
+ * rename、创建日志与删除检查点之后都fsync所在目录，目录项的变化掉电后也不会丢失。
+ * 写检查点前先msync日志，所以检查点覆盖的记录一定已落盘。
+ *
+ * 启动时读取检查点恢复积分器，再重放检查点之后的有效记录；
+ * 遇到CRC或序号不符的记录即认为是崩溃时未写完的尾部，停止重放。
+ * 进程崩溃不会丢数据（映射页在页缓存中）；掉电最多丢失一个检查点间隔。
+ * 非线程安全，由调用方加锁。
+ */
+class SessionJournal {
+public:
+    struct Options {
+        int64_t checkpoint_interval_ms;
+        size_t grow_records;     // 每次扩展文件的记录数
+
+        Options() : checkpoint_interval_ms(60 * 1000), grow_records(32768) {}
+    };
+
+    struct RecoveredSession {
+        int start_type;
+        int64_t start_ms;
+        uint64_t records;        // 日志中有效的记录数
+        uint64_t replayed;       // 检查点之后重放的采样数
+        bool from_checkpoint;
+    };
+
+    struct Statistics {
+        uint64_t records;
+        uint64_t journal_bytes;     // 写入日志的字节数（含文件头）
+        uint64_t checkpoint_bytes;  // 写入检查点的字节数
+        uint64_t checkpoints;
+    };
+
+    explicit SessionJournal(const std::string& path_prefix, const Options& options = Options());
+    ~SessionJournal();
+
+    SessionJournal(const SessionJournal&) = delete;
+    SessionJournal& operator=(const SessionJournal&) = delete;
+
+    // 恢复未结束的会话到meter；没有未结束的会话时返回false
+    bool recover(const PriceTable& table, EnergyMeter& meter, RecoveredSession& session);
+
+    // 开始新会话（清空旧日志与检查点）
+    bool begin(int64_t start_ms, int start_type);
+    // 记录一个采样，检查点到期时自动写检查点
+    bool append_sample(int64_t unix_ms, double power_kw, const EnergyMeter& meter);
+    // 结束会话
+    bool end(int64_t unix_ms);
+    bool checkpoint(const EnergyMeter& meter);
+
+    bool is_open() const { return map_ != nullptr; }
+    const Statistics& statistics() const { return stats_; }
+    const std::string& last_error() const { return last_error_; }
+
+private:
+    struct Record;
+
+    bool open_journal(bool truncate);
+    void close_journal();
+    bool ensure_capacity(uint64_t records);
+    bool append(uint16_t type, int64_t unix_ms, double value);
+    bool sync_journal();
+    bool write_checkpoint(const std::string& blob);
+    bool sync_dir();
+    bool fail(const std::string& error);
+
+    const std::string journal_path_;
+    const std::string checkpoint_path_;
+    const std::string dir_path_;  // 日志与检查点所在目录
+    const Options options_;
+
+    int fd_;
+    char* map_;
+    size_t map_size_;
+    uint64_t capacity_;        // 已映射可写入的记录数
+    uint64_t next_;            // 下一条记录序号
+    uint64_t synced_;          // 已msync的记录数
+    uint64_t session_id_;
+    int64_t last_checkpoint_ms_;
+
+    Statistics stats_;
+    std::string last_error_;
+};
@@ -0,0 +1,72 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <vector>
+#include <utility>
+
+/**
+ * @brief 有界单生产者单消费者无锁环形队列
+ *
+ * 仅允许一个线程调用try_push、一个线程调用try_pop。
+ * 容量向上取整为2的幂，满时try_push返回false由调用方决定丢弃或重试。
+ * 读写下标之间及与其他成员之间用整条缓存行显式填充，而不用alignas：C++14的operator new
+ * 不保证超对齐，填充在栈、堆或容器中都能让两个下标落在不同的缓存行上。
+ */
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity)
+        : mask_(round_up(capacity) - 1), slots_(mask_ + 1), head_(0), tail_(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // 生产者线程调用
+    bool try_push(T&& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - head_.load(std::memory_order_acquire) > mask_) {
+            return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 消费者线程调用
+    bool try_pop(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+    size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const { return mask_ + 1; }
+
+private:
+    static size_t round_up(size_t n) {
+        size_t v = 1;
+        while (v < n) v <<= 1;
+        return v;
+    }
+
+    static const size_t kCacheLine = 64;
+
+    const size_t mask_;
+    std::vector<T> slots_;
+    char pad0_[kCacheLine];
+    std::atomic<size_t> head_;  // 消费者写
+    char pad1_[kCacheLine - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail_;  // 生产者写
+    char pad2_[kCacheLine - sizeof(std::atomic<size_t>)];
+};
@@ -0,0 +1,242 @@
+#include "station_runtime.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <sys/stat.h>
+#include "tools/trace/trace.hpp"
+
+namespace {
+const std::chrono::milliseconds kMinSampleInterval(10);
+const std::chrono::milliseconds kMaxSampleInterval(100);
+}  // namespace
+
+StationRuntime::StationRuntime(const PriceStore& prices, Publisher publisher)
+    : prices_(prices), publisher_(std::move(publisher)),
+      sample_interval_(std::chrono::milliseconds(100)), running_(false) {
+}
+
+StationRuntime::~StationRuntime() {
+    stop();
+}
+
+Connector& StationRuntime::add_connector(const std::string& id, std::unique_ptr<DeviceBase> device,
+                                         double rated_kw) {
+    connectors_.emplace_back(new Connector(id, std::move(device), prices_, publisher_, &site_));
+    Connector& connector = *connectors_.back();
+    connector.set_rated_power(rated_kw);
+    connector.device().set_executor(device_executor_.get());
+    connector.set_self_check_cache(self_check_options_);
+    index_[id] = &connector;
+    manual_groups_.clear();
+    return connector;
+}
+
+size_t StationRuntime::enable_journal(const std::string& dir) {
+    mkdir(dir.c_str(), 0755);
+    size_t recovered = 0;
+    for (auto& connector : connectors_) {
+        if (connector->enable_journal(dir + "/" + connector->id())) {
+            recovered++;
+        }
+    }
+    return recovered;
+}
+
+void StationRuntime::enable_async_devices(size_t thread_count) {
+    if (device_executor_) {
+        return;
+    }
+    device_executor_.reset(new DeviceExecutor(thread_count));
+    for (auto& connector : connectors_) {
+        connector->device().set_executor(device_executor_.get());
+    }
+}
+
+void StationRuntime::set_self_check_cache(const SelfCheckCache::Options& options) {
+    self_check_options_ = options;
+    for (auto& connector : connectors_) {
+        connector->set_self_check_cache(options);
+    }
+}
+
+void StationRuntime::refresh_self_checks() {
+    for (auto& connector : connectors_) {
+        connector->refresh_self_check();
+    }
+}
+
+void StationRuntime::start(size_t worker_count, std::chrono::milliseconds sample_interval) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    sample_interval_ = std::max(kMinSampleInterval, std::min(sample_interval, kMaxSampleInterval));
+
+    // 采样分组轮流分配到各工作线程，同一控制器的通道总在同一线程上读取
+    std::vector<SampleGroup> groups = make_groups();
+    worker_count = std::max<size_t>(1, std::min(worker_count, groups.size()));
+    workers_.clear();
+    for (size_t i = 0; i < worker_count; i++) {
+        workers_.emplace_back(new Worker());
+    }
+    for (size_t i = 0; i < groups.size(); i++) {
+        workers_[i % worker_count]->groups.push_back(std::move(groups[i]));
+    }
+    for (size_t i = 0; i < workers_.size(); i++) {
+        Worker* w = workers_[i].get();
+        w->thread = std::thread([this, w, i] {
+            char name[32];
+            snprintf(name, sizeof(name), "meter-%zu", i);
+            Trace::set_thread_name(name);
+            worker_loop(*w);
+        });
+    }
+}
+
+void StationRuntime::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    for (auto& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+}
+
+// 固定频率采样，超时的周期直接跳过而不是补跑（积分器按实际时间戳计算，不会丢能量）
+void StationRuntime::worker_loop(Worker& worker) {
+    auto next = std::chrono::steady_clock::now() + sample_interval_;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (running_) {
+        if (cv_.wait_until(lock, next, [this] { return !running_; })) {
+            break;
+        }
+        lock.unlock();
+
+        int64_t now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        for (SampleGroup& group : worker.groups) {
+            sample(group, now_ms);
+        }
+
+        next += sample_interval_;
+        auto current = std::chrono::steady_clock::now();
+        if (next <= current) {
+            next = current + sample_interval_;
+        }
+        lock.lock();
+    }
+}
+
+void StationRuntime::tick(int64_t now_ms) {
+    if (manual_groups_.empty()) {
+        manual_groups_ = make_groups();
+    }
+    for (SampleGroup& group : manual_groups_) {
+        sample(group, now_ms);
+    }
+}
+
+// 按SampleGroup归组，保持连接器的添加顺序
+std::vector<StationRuntime::SampleGroup> StationRuntime::make_groups() const {
+    std::vector<SampleGroup> groups;
+    std::unordered_map<const void*, size_t> index;
+    for (const auto& connector : connectors_) {
+        DeviceBase& device = connector->device().device();
+        auto it = index.emplace(device.SampleGroup(), groups.size()).first;
+        if (it->second == groups.size()) {
+            groups.emplace_back();
+        }
+        SampleGroup& group = groups[it->second];
+        group.connectors.push_back(connector.get());
+        group.channels.push_back(device.SampleChannel());
+    }
+    for (SampleGroup& group : groups) {
+        size_t n = group.connectors.size();
+        group.active.resize(n);
+        group.channel.resize(n);
+        group.voltage_v.resize(n);
+        group.current_a.resize(n);
+        group.power_kw.resize(n);
+        group.timestamp_ms.resize(n);
+    }
+    return groups;
+}
+
+// 只读取在充电的通道；读取失败时本周期不采样（积分器按下一个采样点的时间戳计算区间）
+void StationRuntime::sample(SampleGroup& group, int64_t now_ms) {
+    size_t n = 0;
+    for (size_t i = 0; i < group.connectors.size(); i++) {
+        if (group.connectors[i]->is_charging()) {
+            group.active[n] = group.connectors[i];
+            group.channel[n] = group.channels[i];
+            n++;
+        }
+    }
+    if (n == 0) {
+        return;
+    }
+    SampleSpan samples{n, group.channel.data(), group.voltage_v.data(), group.current_a.data(),
+                       group.power_kw.data(), group.timestamp_ms.data()};
+    if (!group.active[0]->device().device().ReadSamples(samples, now_ms)) {
+        return;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (samples.timestamp_ms[i] < 0) {
+            continue;
+        }
+        group.active[i]->add_sample(samples.timestamp_ms[i], samples.power_kw[i]);
+    }
+}
+
+bool StationRuntime::dispatch(const Command& command) {
+    Connector* connector = find(command.device_id);
+    if (!connector) {
+        return false;
+    }
+    connector->handle_command(command);
+    return true;
+}
+
+void StationRuntime::send_heartbeats() {
+    for (auto& connector : connectors_) {
+        connector->send_heartbeat();
+    }
+}
+
+SelfCheckCache::Statistics StationRuntime::self_check_statistics() const {
+    SelfCheckCache::Statistics total;
+    for (const auto& connector : connectors_) {
+        SelfCheckCache::Statistics stats = connector->self_check_cache().get_statistics();
+        total.hits += stats.hits;
+        total.checks += stats.checks;
+        total.refreshes += stats.refreshes;
+        total.failures += stats.failures;
+        total.stale += stats.stale;
+        total.max_check_us = std::max(total.max_check_us, stats.max_check_us);
+    }
+    return total;
+}
+
+void StationRuntime::set_status(uint64_t pos) {
+    for (auto& connector : connectors_) {
+        connector->set_status(pos);
+    }
+}
+
+void StationRuntime::clear_status(uint64_t pos) {
+    for (auto& connector : connectors_) {
+        connector->clear_status(pos);
+    }
+}
+
+Connector* StationRuntime::find(const std::string& id) const {
+    auto it = index_.find(id);
+    return it == index_.end() ? nullptr : it->second;
+}
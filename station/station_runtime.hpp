@@ -0,0 +1,114 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "connector.hpp"
+
+/**
+ * @brief 多连接器站点运行时
+ *
+ * 托管N个Connector，连接器按采样分组（DeviceBase::SampleGroup，同一控制器的各通道为一组）
+ * 轮流分片到少量工作线程，每个工作线程按固定采样周期（10~100Hz）为分片内的每个分组调用一次
+ * ReadSamples，再把结构数组中的读数逐个交给连接器计量；单通道设备各自一组，经默认适配调用GetPower。
+ * 所有连接器共享一个出站Publisher（即一条MQTT连接），使用各自的主题，
+ * 并共享站点级的并发会话数与功率预算。
+ * 启用设备执行器后，各连接器的设备命令由少量设备线程异步执行，
+ * 一个连接器自检或启动期间，其他连接器的命令与计量不受影响。
+ * 启用自检缓存后，主循环定期调用refresh_self_checks，空闲连接器的自检在后台完成，启动时直接使用。
+ */
+class StationRuntime {
+public:
+    using Publisher = Connector::Publisher;
+
+    // 电价由prices提供，更新后各连接器在下一次采样时切换
+    StationRuntime(const PriceStore& prices, Publisher publisher);
+    ~StationRuntime();
+
+    StationRuntime(const StationRuntime&) = delete;
+    StationRuntime& operator=(const StationRuntime&) = delete;
+
+    // 启动前添加连接器，rated_kw为额定功率（准入时从站点功率预算中预留）
+    Connector& add_connector(const std::string& id, std::unique_ptr<DeviceBase> device,
+                             double rated_kw = Connector::kDefaultRatedKw);
+
+    // 站点限额（并发会话数、功率预算），0表示不限，可随时调整
+    void set_site_limits(const SiteBudget::Limits& limits) { site_.set_limits(limits); }
+    const SiteBudget& site() const { return site_; }
+
+    // 启用各连接器的会话日志（<dir>/<连接器ID>.journal），返回恢复的会话数
+    // 需在start之前调用
+    size_t enable_journal(const std::string& dir);
+
+    // 启用设备执行器（thread_count个设备线程），之后添加的连接器同样生效；需在start之前调用
+    void enable_async_devices(size_t thread_count);
+    const DeviceExecutor* device_executor() const { return device_executor_.get(); }
+
+    // 各连接器的自检结果缓存，之后添加的连接器同样生效
+    void set_self_check_cache(const SelfCheckCache::Options& options);
+    // 为空闲且缓存需要刷新的连接器排后台自检，由主循环定期调用
+    void refresh_self_checks();
+
+    // 采样周期限制在[10ms, 100ms]
+    void start(size_t worker_count, std::chrono::milliseconds sample_interval = std::chrono::milliseconds(100));
+    void stop();
+    // 以外部时钟手动驱动一次采样（仿真用），不可与start同时使用
+    void tick(int64_t now_ms);
+
+    // 按device_id分发命令，没有对应连接器时返回false
+    bool dispatch(const Command& command);
+
+    // 站点级操作
+    void send_heartbeats();
+    // 各连接器自检缓存统计之和（max_check_us取最大值）
+    SelfCheckCache::Statistics self_check_statistics() const;
+    void set_status(uint64_t pos);
+    void clear_status(uint64_t pos);
+
+    Connector* find(const std::string& id) const;
+    const std::vector<std::unique_ptr<Connector>>& connectors() const { return connectors_; }
+    size_t connector_count() const { return connectors_.size(); }
+    size_t worker_count() const { return workers_.size(); }
+    std::chrono::milliseconds sample_interval() const { return sample_interval_; }
+
+private:
+    // 一个采样分组及其结构数组缓冲（容量为分组内的连接器数）
+    struct SampleGroup {
+        std::vector<Connector*> connectors;
+        std::vector<uint32_t> channels;  // 与connectors对应
+        std::vector<Connector*> active;  // 本周期在充电的连接器
+        std::vector<uint32_t> channel;
+        std::vector<float> voltage_v;
+        std::vector<float> current_a;
+        std::vector<float> power_kw;
+        std::vector<int64_t> timestamp_ms;
+    };
+
+    struct Worker {
+        std::vector<SampleGroup> groups;
+        std::thread thread;
+    };
+
+    std::vector<SampleGroup> make_groups() const;
+    static void sample(SampleGroup& group, int64_t now_ms);
+    void worker_loop(Worker& worker);
+
+    const PriceStore& prices_;
+    Publisher publisher_;
+    SiteBudget site_;  // 所有连接器共享
+    std::unique_ptr<DeviceExecutor> device_executor_;  // 在连接器之后销毁
+    SelfCheckCache::Options self_check_options_;
+    std::vector<std::unique_ptr<Connector>> connectors_;
+    std::unordered_map<std::string, Connector*> index_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<SampleGroup> manual_groups_;  // tick()使用，添加连接器后重建
+    std::chrono::milliseconds sample_interval_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool running_;
+};
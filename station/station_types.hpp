@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdio>
+#include <ctime>
+#include <string>
+#include <vector>
+#include "nlohmann/json.hpp"
+
+// 主题前缀，完整主题为 前缀 + 连接器ID
+#define TOPIC_CMD "GreenEnergy/CMD/"
+#define TOPIC_STATUS "GreenEnergy/STATUS/"
+#define TOPIC_HEARTBEAT "GreenEnergy/HEARTBEAT/"
+// 站点级电价推送主题（内容与price.json相同）
+#define TOPIC_TARIFF "GreenEnergy/TARIFF"
+
+enum DEVICE_STATUS_CODE{
+    DEVICE_STATUS_ERROR_CONFIG = 0,
+    DEVICE_STATUS_ERROR_EMPTY_CONFIG = 1,
+    DEVICE_STATUS_SELF_CHECK_FAIL = 2,
+    DEVICE_STATUS_START = 3,
+    DEVICE_STATUS_STOP = 4,
+    DEVICE_STATUS_ONLINE = 5, //在线
+    DEVICE_STATUS_BUSY = 6, //忙碌
+    DEVICE_STATUS_FORRBIDDEN = 7, //禁止所有充电
+    DEVICE_STATUS_FORRBIDDEN_REMOTE = 8, //禁止远程充电
+    DEVICE_STATUS_FORRBIDDEN_COMMERCIAL = 9, //禁止商用充电
+};
+
+enum DEVICE_CMD{
+    DEVICE_CMD_REMOTE_START = 1,
+    DEVICE_CMD_COMMERCIAL_START = 2,
+    DEVICE_CMD_STOP = 3,
+    DEVICE_CMD_PAUSE = 4,
+    DEVICE_CMD_CHARGE_INFO = 5, //获取充电信息
+};
+
+enum RESULT_CODE{
+    RESULT_FAIL = 0,
+    RESULT_OK = 1, 
+};
+
+enum START_TYPE{
+    START_TYPE_NFC = 0, //正常NFC启动
+    START_TYPE_BLUETOOTH = 1, //正常蓝牙启动
+    START_TYPE_REMOTE = 2, //远程启动
+    START_TYPE_COMMERCIAL = 3, //商用启动
+};
+
+// 连接器ID：0000-00001 起按序号递增
+inline std::string make_connector_id(size_t index){
+    char id[32];
+    snprintf(id, sizeof(id), "0000-%05zu", index + 1);
+    return id;
+}
+
+struct ChargeInfo{
+    int start_type; //启动类型
+    std::string describe; //描述
+    std::string start_time; //开始时间
+    std::string end_time; //结束时间
+    float total; //价格
+    float all_energy; //总电量
+    std::vector<float> period_stats; // 各电价时段充电统计（kWh），下标为电价时段ID，最后一个为其他时段
+
+    ChargeInfo(){
+        start_type = -1;
+        describe = "";
+        start_time = "";
+        end_time = "";
+        total = 0;
+        all_energy = 0;
+    }
+    ChargeInfo(int start_type,std::string describe,std::string start_time,std::string end_time){
+        this->start_type = start_type;
+        this->describe = describe;
+        this->start_time = start_time;
+        this->end_time = end_time;
+        this->total = 0;
+        this->all_energy = 0;
+    }
+
+    void clear(){
+        start_type = -1;
+        describe = "";
+        start_time = "";
+        end_time = "";
+        total = 0;
+        all_energy = 0;
+        //初始化电量统计时间段
+        for(size_t i = 0;i < period_stats.size();i++){
+            period_stats[i] = 0;
+        }
+    }
+
+    float get_all_energy(){
+        float total = 0;
+        for(size_t i = 0;i < period_stats.size();i++){
+            total = total + period_stats[i];
+        }
+        all_energy = total;
+        return total;
+    }
+    
+    NLOHMANN_DEFINE_TYPE_INTRUSIVE(ChargeInfo,start_type, describe, start_time, end_time, total,all_energy,period_stats)
+};
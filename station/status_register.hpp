@@ -0,0 +1,65 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief 无锁设备状态字
+ *
+ * 单个位的置位/清除使用fetch_or/fetch_and，不再需要互斥锁。
+ * 需要"检查若干位后再修改"的场景使用transition：
+ * 在一次CAS中确认blocked_mask中的位全部为0，然后置位set_mask、清除clear_mask，
+ * 检查与修改之间不会被其他线程插入。
+ */
+class StatusRegister {
+public:
+    StatusRegister() : bits_(0) {}
+
+    StatusRegister(const StatusRegister&) = delete;
+    StatusRegister& operator=(const StatusRegister&) = delete;
+
+    static constexpr uint64_t bit(uint64_t pos) { return 1ULL << pos; }
+
+    // 返回修改前的值
+    uint64_t set(uint64_t pos) {
+        return bits_.fetch_or(bit(pos), std::memory_order_acq_rel);
+    }
+    uint64_t clear(uint64_t pos) {
+        return bits_.fetch_and(~bit(pos), std::memory_order_acq_rel);
+    }
+    bool test(uint64_t pos) const {
+        return (bits_.load(std::memory_order_acquire) & bit(pos)) != 0;
+    }
+    uint64_t load() const {
+        return bits_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief 条件状态转换
+     * @param blocked_mask 任一位为1时转换失败
+     * @param set_mask     转换成功时置位
+     * @param clear_mask   转换成功时清除
+     * @param observed     输出转换时（成功）或拒绝时（失败）看到的状态字，可为空
+     * @return 转换是否成功
+     */
+    bool transition(uint64_t blocked_mask, uint64_t set_mask, uint64_t clear_mask = 0,
+                    uint64_t* observed = nullptr) {
+        uint64_t current = bits_.load(std::memory_order_acquire);
+        for (;;) {
+            if (current & blocked_mask) {
+                if (observed) *observed = current;
+                return false;
+            }
+            uint64_t next = (current | set_mask) & ~clear_mask;
+            if (next == current ||
+                bits_.compare_exchange_weak(current, next,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+                if (observed) *observed = current;
+                return true;
+            }
+        }
+    }
+
+private:
+    std::atomic<uint64_t> bits_;
+};
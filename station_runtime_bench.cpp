@@ -0,0 +1,104 @@
+#include "station/station_runtime.hpp"
+#include "device/device.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/resource.h>
+
+// 当前进程常驻内存（KB）
+static long rss_kb() {
+    long pages = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) {
+        return 0;
+    }
+    if (fscanf(f, "%ld %ld", &pages, &resident) != 2) {
+        resident = 0;
+    }
+    fclose(f);
+    return resident * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+// 进程累计CPU时间（用户+系统，微秒）
+static long long cpu_us() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static void run(size_t connector_count, size_t worker_count, int seconds, const PriceStore& prices) {
+    std::atomic<unsigned long long> messages(0);
+    std::atomic<unsigned long long> bytes(0);
+
+    long rss_before = rss_kb();
+    StationRuntime runtime(prices,
+        [&](const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+            // 模拟出站序列化开销
+            bytes += topic.size() + content.dump().size();
+            messages++;
+        });
+    for (size_t i = 0; i < connector_count; i++) {
+        runtime.add_connector(make_connector_id(i), std::unique_ptr<DeviceBase>(new Device()));
+    }
+
+    // 所有连接器以商用方式启动充电
+    for (const auto& connector : runtime.connectors()) {
+        Command command;
+        command.cmd = DEVICE_CMD_COMMERCIAL_START;
+        command.device_id = connector->id();
+        command.topic = connector->topic(TOPIC_CMD);
+        runtime.dispatch(command);
+    }
+
+    long long cpu_before = cpu_us();
+    runtime.start(worker_count);
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    runtime.stop();
+    long long cpu_used = cpu_us() - cpu_before;
+    long rss_after = rss_kb();
+
+    unsigned long long reports = messages.load();
+    std::cout << std::setw(6) << connector_count
+              << std::setw(9) << runtime.worker_count()
+              << std::setw(10) << reports
+              << std::setw(12) << std::fixed << std::setprecision(2)
+              << static_cast<double>(rss_after - rss_before) / connector_count
+              << std::setw(14) << (reports ? static_cast<double>(cpu_used) / reports : 0.0)
+              << std::setw(12) << 100.0 * cpu_used / (seconds * 1000000.0)
+              << std::setw(12) << (reports ? static_cast<double>(bytes.load()) / reports : 0.0)
+              << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    int seconds = argc > 2 ? std::max(1, atoi(argv[2])) : 10;
+    size_t worker_count = 4;
+
+    PriceStore prices;
+    if (prices.load_file(price_path) != PriceStore::RELOAD_OK) {
+        std::cerr << "加载价格表失败: " << price_path << "\n";
+        return 1;
+    }
+
+    std::cout << std::setfill(' ');
+    std::cout << "10Hz采样、1Hz上报，每组运行" << seconds << "秒，工作线程上限" << worker_count << "\n";
+    std::cout << std::setw(6) << "conn"
+              << std::setw(9) << "workers"
+              << std::setw(10) << "reports"
+              << std::setw(12) << "KB/conn"
+              << std::setw(14) << "cpu us/rep"
+              << std::setw(12) << "cpu %"
+              << std::setw(12) << "bytes/msg"
+              << "\n";
+    const size_t counts[] = {1, 64, 1024};
+    for (size_t count : counts) {
+        run(count, worker_count, seconds, prices);
+    }
+    return 0;
+}
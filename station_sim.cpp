@@ -0,0 +1,415 @@
+#include "station/station_runtime.hpp"
+#include "station/command_pipeline.hpp"
+#include "station/outbound_queue.hpp"
+#include "device/sim_device.hpp"
+#include "tools/mqtt/subscription_registry.hpp"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <sys/resource.h>
+
+/**
+ * 站点仿真与负载生成器（容量规划）
+ *
+ * - 进程内实例化若干站点，每个站点一个StationRuntime与出站队列，设备为SimDevice（CC/CV曲线、噪声、故障）
+ * - 所有站点连接本地代理桩，云端负载生成器按确定性的场景下发启动/停止命令并订阅状态主题
+ * - 计量由仿真时钟驱动（StationRuntime::tick），不依赖墙钟，同一seed的电量/费用结果完全一致
+ * - 命令经真实的CommandPipeline执行，延迟为墙钟时间：
+ *   执行延迟 = 云端发布 -> 设备动作完成；结果延迟 = 云端发布 -> 收到结果报文（停止与启动失败才有结果报文，
+ *   启动成功以随后的充电信息确认）
+ *
+ * 用法: station_sim <price.json> [站点数=1000] [每站连接器数=1] [仿真秒数=600] [采样Hz=10] [seed=1] [执行线程数=2]
+ */
+
+namespace {
+
+// 仿真起点：2024-06-10 00:00:00 UTC
+const int64_t kSimEpochMs = 1717977600000LL;
+
+// 场景参数
+const int64_t kRampMs = 60000;            // 首次启动分布在前60秒
+const int64_t kMinSessionMs = 120000;     // 会话时长范围
+const int64_t kMaxSessionMs = 1800000;
+const int64_t kMinIdleMs = 30000;         // 两次会话之间的空闲
+const int64_t kMaxIdleMs = 300000;
+const int64_t kExecuteTimeoutMs = 5000;   // 等待命令执行完成的墙钟超时
+
+int64_t thread_cpu_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+long long process_cpu_us() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// 从JSON文本中取 "key": 后的数值（云端只关心少数字段，不做完整解析）
+bool scan_number(const std::string& payload, const char* key, double& value) {
+    size_t pos = payload.find(key);
+    if (pos == std::string::npos) {
+        return false;
+    }
+    value = std::strtod(payload.c_str() + pos + strlen(key), nullptr);
+    return true;
+}
+
+// 设备功率曲线组合：交流7kW、交流22kW、直流60kW
+SimDevice::Profile make_profile(std::mt19937& rng) {
+    std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+    SimDevice::Profile profile;
+    float kind = uniform(rng);
+    if (kind < 0.6f) {
+        profile.max_kw = 7.0f;
+        profile.capacity_kwh = 50.0f;
+    } else if (kind < 0.9f) {
+        profile.max_kw = 22.0f;
+        profile.capacity_kwh = 75.0f;
+    } else {
+        profile.max_kw = 60.0f;
+        profile.capacity_kwh = 80.0f;
+    }
+    profile.initial_soc = 0.1f + 0.5f * uniform(rng);
+    profile.cv_soc = 0.75f + 0.1f * uniform(rng);
+    profile.noise = 0.02f;
+    profile.self_check_fail_rate = 0.01f;
+    profile.dropout_per_hour = 0.5f;
+    return profile;
+}
+
+}  // namespace
+
+/**
+ * @brief 本地代理桩
+ *
+ * 精确主题走哈希表，通配符过滤器逐个匹配，消息同步投递给订阅者。
+ * 订阅在启动前完成，发布只在仿真主线程进行。
+ */
+class BrokerStub {
+public:
+    using Handler = SubscriptionRegistry::MessageHandler;
+
+    void subscribe(const std::string& filter, Handler handler) {
+        if (filter.find_first_of("+#") == std::string::npos) {
+            exact_[filter].push_back(std::move(handler));
+        } else {
+            wildcard_.emplace_back(filter, std::move(handler));
+        }
+    }
+
+    void publish(const std::string& topic, const std::string& payload, uint8_t qos, bool retain) {
+        messages_++;
+        bytes_ += topic.size() + payload.size();
+        auto it = exact_.find(topic);
+        if (it != exact_.end()) {
+            for (const auto& handler : it->second) {
+                handler(topic, payload, qos, retain);
+            }
+        }
+        for (const auto& entry : wildcard_) {
+            if (SubscriptionRegistry::topic_matches(entry.first, topic)) {
+                entry.second(topic, payload, qos, retain);
+            }
+        }
+    }
+
+    uint64_t messages() const { return messages_; }
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    std::unordered_map<std::string, std::vector<Handler>> exact_;
+    std::vector<std::pair<std::string, Handler>> wildcard_;
+    uint64_t messages_ = 0;
+    uint64_t bytes_ = 0;
+};
+
+// 一个仿真站点：运行时 + 出站队列（相当于一条MQTT连接）
+struct SimStation {
+    OutboundQueue outbound;
+    std::atomic<bool> has_output{false};
+    std::unique_ptr<StationRuntime> runtime;
+};
+
+// 云端下发的命令
+struct SimEvent {
+    uint32_t connector;
+    int cmd;
+};
+
+// 云端对每个连接器的视图
+struct ConnectorView {
+    std::string id;
+    std::string cmd_topic;
+    size_t station;
+    SimDevice* device;
+    int pending_cmd = 0;  // 等待结果报文的命令，0表示无
+    std::chrono::steady_clock::time_point sent_at;
+    double execute_us = 0;  // 执行线程写入，仿真线程在执行计数到达后读取
+    double all_energy = 0;  // 最近一次充电信息
+    double total = 0;
+};
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << "用法: " << argv[0]
+                  << " <price.json> [站点数=1000] [每站连接器数=1] [仿真秒数=600] [采样Hz=10] [seed=1] [执行线程数=2]\n";
+        return 1;
+    }
+    const size_t station_count = argc > 2 ? std::max(1, atoi(argv[2])) : 1000;
+    const size_t per_station = argc > 3 ? std::max(1, atoi(argv[3])) : 1;
+    const int64_t duration_ms = (argc > 4 ? std::max(1, atoi(argv[4])) : 600) * 1000LL;
+    const int sample_hz = argc > 5 ? std::max(10, std::min(100, atoi(argv[5]))) : 10;
+    const uint32_t seed = argc > 6 ? static_cast<uint32_t>(strtoul(argv[6], nullptr, 10)) : 1;
+    const size_t executor_count = argc > 7 ? std::max(1, std::min(16, atoi(argv[7]))) : 2;
+    const int64_t interval_ms = 1000 / sample_hz;
+
+    PriceStore prices;
+    if (prices.load_file(argv[1]) != PriceStore::RELOAD_OK) {
+        return 1;
+    }
+
+    SimClock clock(kSimEpochMs);
+    BrokerStub broker;
+    std::mt19937 rng(seed);
+
+    // ---------- 站点与连接器 ----------
+    const size_t connector_count = station_count * per_station;
+    std::vector<std::unique_ptr<SimStation>> stations;
+    std::vector<ConnectorView> views(connector_count);
+    std::unordered_map<std::string, size_t> view_index;
+    std::unordered_map<std::string, StationRuntime*> runtime_index;
+    for (size_t s = 0; s < station_count; s++) {
+        stations.emplace_back(new SimStation());
+        SimStation* station = stations.back().get();
+        station->runtime.reset(new StationRuntime(prices,
+            [station](const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+                station->outbound.push(topic, content, qos, retain);
+                station->has_output.store(true, std::memory_order_release);
+            }));
+        for (size_t c = 0; c < per_station; c++) {
+            size_t index = s * per_station + c;
+            ConnectorView& view = views[index];
+            view.id = make_connector_id(index);
+            view.cmd_topic = std::string(TOPIC_CMD) + view.id;
+            view.station = s;
+            SimDevice::Profile profile = make_profile(rng);
+            view.device = new SimDevice(view.id, clock, profile, seed * 2654435761u + static_cast<uint32_t>(index));
+            station->runtime->add_connector(view.id, std::unique_ptr<DeviceBase>(view.device), profile.max_kw);
+            view_index[view.id] = index;
+            runtime_index[view.id] = station->runtime.get();
+        }
+    }
+
+    // ---------- 站点侧命令流水线 ----------
+    std::atomic<uint64_t> parse_errors(0);
+    std::atomic<uint64_t> executed(0);
+    CommandPipeline pipeline(executor_count, 4096);
+    pipeline.set_executor([&](const Command& command) {
+        auto it = runtime_index.find(command.device_id);
+        if (it != runtime_index.end()) {
+            it->second->dispatch(command);
+            ConnectorView& view = views[view_index.at(command.device_id)];
+            view.execute_us = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now() - view.sent_at).count() / 1000.0;
+        }
+        executed.fetch_add(1, std::memory_order_release);
+    });
+    pipeline.set_error_handler([&parse_errors](const std::string&, const std::string&) {
+        parse_errors++;
+    });
+    pipeline.start();
+
+    uint64_t dropped = 0;
+    for (const auto& view : views) {
+        broker.subscribe(view.cmd_topic, [&pipeline, &dropped](const std::string& topic, const std::string& payload, uint8_t, bool) {
+            if (!pipeline.submit(topic, payload)) {
+                dropped++;
+            }
+        });
+    }
+
+    // ---------- 云端：订阅状态主题，统计结果与延迟 ----------
+    std::vector<double> execute_latencies_us;
+    std::vector<double> result_latencies_us;
+    uint64_t results = 0, failed = 0, charge_infos = 0;
+    broker.subscribe(std::string(TOPIC_STATUS) + "+",
+        [&](const std::string& topic, const std::string& payload, uint8_t, bool) {
+            auto it = view_index.find(topic.substr(strlen(TOPIC_STATUS)));
+            if (it == view_index.end()) {
+                return;
+            }
+            ConnectorView& view = views[it->second];
+            double cmd = 0, result = 0;
+            scan_number(payload, "\"cmd\":", cmd);
+            if (static_cast<int>(cmd) == DEVICE_CMD_CHARGE_INFO) {
+                charge_infos++;
+                scan_number(payload, "\"all_energy\":", view.all_energy);
+                scan_number(payload, "\"total\":", view.total);
+                return;
+            }
+            if (view.pending_cmd != 0 && static_cast<int>(cmd) == view.pending_cmd) {
+                result_latencies_us.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now() - view.sent_at).count() / 1000.0);
+                view.pending_cmd = 0;
+                results++;
+                if (scan_number(payload, "\"result\":", result) && static_cast<int>(result) != RESULT_OK) {
+                    failed++;
+                }
+            }
+        });
+
+    // ---------- 确定性场景：每个连接器若干次会话，按仿真步分桶 ----------
+    const size_t steps = static_cast<size_t>(duration_ms / interval_ms);
+    std::vector<std::vector<SimEvent>> schedule(steps + 1);
+    size_t sessions = 0;
+    {
+        std::uniform_int_distribution<int64_t> ramp(0, kRampMs);
+        std::uniform_int_distribution<int64_t> session_len(kMinSessionMs, kMaxSessionMs);
+        std::uniform_int_distribution<int64_t> idle_len(kMinIdleMs, kMaxIdleMs);
+        std::uniform_real_distribution<float> uniform(0.0f, 1.0f);
+        for (uint32_t i = 0; i < connector_count; i++) {
+            int64_t t = ramp(rng);
+            while (t + kMinSessionMs < duration_ms) {
+                int start_cmd = uniform(rng) < 0.8f ? DEVICE_CMD_COMMERCIAL_START : DEVICE_CMD_REMOTE_START;
+                int64_t stop = std::min(t + session_len(rng), duration_ms);
+                schedule[t / interval_ms].push_back(SimEvent{i, start_cmd});
+                schedule[stop / interval_ms].push_back(SimEvent{i, DEVICE_CMD_STOP});
+                sessions++;
+                t = stop + idle_len(rng);
+            }
+        }
+    }
+
+    // ---------- 主循环 ----------
+    std::vector<OutboundMessage> batch;
+    auto drain_all = [&]() {
+        bool any = false;
+        for (auto& station : stations) {
+            if (!station->has_output.exchange(false, std::memory_order_acquire)) {
+                continue;
+            }
+            if (!station->outbound.drain(batch)) {
+                continue;
+            }
+            for (const auto& msg : batch) {
+                broker.publish(msg.topic, msg.payload, msg.qos, msg.retain);
+            }
+            station->outbound.release(batch);
+            any = true;
+        }
+        return any;
+    };
+
+    std::cout << std::setfill(' ');
+    std::cout << "=== 站点仿真: " << station_count << " 站 x " << per_station << " 连接器, 仿真 "
+              << duration_ms / 1000 << "s @ " << sample_hz << "Hz, seed " << seed
+              << ", 执行线程 " << executor_count << ", 会话 " << sessions << " ===\n";
+
+    uint64_t issued = 0, timeouts = 0;
+    int64_t tick_cpu_ns = 0;
+    long long cpu_before = process_cpu_us();
+    auto wall_begin = std::chrono::steady_clock::now();
+    char payload[128];
+    for (size_t step = 0; step <= steps; step++) {
+        if (step > 0) {
+            clock.advance(interval_ms);
+        }
+
+        // 下发本步命令，并等待全部执行完成后再推进计量，保证计量结果与线程调度无关
+        uint64_t expected = executed.load(std::memory_order_acquire);
+        for (const SimEvent& event : schedule[step]) {
+            ConnectorView& view = views[event.connector];
+            snprintf(payload, sizeof(payload), "{\"cmd\":%d,\"timestamp\":\"%lld\",\"device_id\":\"%s\"}",
+                     event.cmd, static_cast<long long>(clock.now() / 1000), view.id.c_str());
+            view.pending_cmd = event.cmd;
+            view.sent_at = std::chrono::steady_clock::now();
+            broker.publish(view.cmd_topic, payload, 1, false);
+            issued++;
+            expected++;
+        }
+        if (!schedule[step].empty()) {
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(kExecuteTimeoutMs);
+            while (executed.load(std::memory_order_acquire) < expected) {
+                if (!drain_all()) {
+                    if (std::chrono::steady_clock::now() > deadline) {
+                        timeouts += expected - executed.load(std::memory_order_acquire);
+                        break;
+                    }
+                    std::this_thread::yield();
+                }
+            }
+            drain_all();
+            for (const SimEvent& event : schedule[step]) {
+                ConnectorView& view = views[event.connector];
+                execute_latencies_us.push_back(view.execute_us);
+                view.pending_cmd = 0;
+            }
+        }
+
+        int64_t t0 = thread_cpu_ns();
+        for (auto& station : stations) {
+            station->runtime->tick(clock.now());
+        }
+        tick_cpu_ns += thread_cpu_ns() - t0;
+        drain_all();
+    }
+    pipeline.stop();
+    drain_all();
+
+    double wall_s = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - wall_begin).count() / 1e6;
+    double cpu_s = (process_cpu_us() - cpu_before) / 1e6;
+    double sim_s = duration_ms / 1000.0;
+
+    // ---------- 报告 ----------
+    auto print_latency = [](const char* name, std::vector<double>& latencies) {
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&latencies](double p) {
+            return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+        };
+        std::cout << name << "(us, " << latencies.size() << "条): p50 " << std::setprecision(0) << percentile(0.5)
+                  << "  p90 " << percentile(0.9)
+                  << "  p99 " << percentile(0.99)
+                  << "  max " << percentile(1.0) << "\n";
+    };
+    double energy = 0, cost = 0;
+    uint64_t dropouts = 0;
+    for (const auto& view : views) {
+        energy += view.all_energy;
+        cost += view.total;
+        dropouts += view.device->dropouts();
+    }
+    CommandPipeline::Statistics pipeline_stats = pipeline.get_statistics();
+
+    std::cout << std::fixed;
+    std::cout << "墙钟 " << std::setprecision(2) << wall_s << "s，加速比 " << std::setprecision(1) << sim_s / wall_s << "x\n";
+    std::cout << "命令: 下发 " << issued << "，执行 " << executed.load() << "，结果报文 " << results << "（失败 " << failed
+              << "），丢弃 " << dropped << "，超时 " << timeouts << "，解析错误 " << parse_errors.load() << "\n";
+    print_latency("执行延迟", execute_latencies_us);
+    print_latency("结果延迟", result_latencies_us);
+    std::cout << "流水线阶段(avg us): 排队 " << std::chrono::duration_cast<std::chrono::microseconds>(pipeline_stats.queue_wait.average()).count()
+              << "  解析 " << std::chrono::duration_cast<std::chrono::microseconds>(pipeline_stats.parse.average()).count()
+              << "  分发 " << std::chrono::duration_cast<std::chrono::microseconds>(pipeline_stats.dispatch_wait.average()).count()
+              << "  执行 " << std::chrono::duration_cast<std::chrono::microseconds>(pipeline_stats.execute.average()).count() << "\n";
+    std::cout << "端到端: 代理投递 " << broker.messages() << " 条 / " << std::setprecision(1) << broker.bytes() / 1048576.0
+              << " MB，" << std::setprecision(0) << broker.messages() / wall_s << " 条/s，充电信息 " << charge_infos << " 条\n";
+    std::cout << "结果校验: 总电量 " << std::setprecision(3) << energy << " kWh，总费用 " << cost
+              << "，充电中断 " << dropouts << " 次\n";
+    double per_station_us = cpu_s * 1e6 / station_count / sim_s;
+    double tick_per_station_us = tick_cpu_ns / 1000.0 / station_count / sim_s;
+    std::cout << "CPU: 进程 " << std::setprecision(2) << cpu_s << "s（计量 " << tick_cpu_ns / 1e9 << "s）\n";
+    std::cout << "每站CPU: " << std::setprecision(1) << per_station_us << " us/仿真秒（计量 " << tick_per_station_us
+              << "），实时运行时单核约可承载 " << std::setprecision(0) << 1e6 / per_station_us << " 站\n";
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include "station/status_register.hpp"
+#include "station/station_types.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <cstdlib>
+
+// 旧实现：每次位操作都加锁，检查与置位分开进行
+class MutexStatus {
+public:
+    void set(uint64_t pos) {
+        std::lock_guard<std::mutex> lck(mutex_);
+        bits_ = bits_ | (1ULL << pos);
+    }
+    void clear(uint64_t pos) {
+        std::lock_guard<std::mutex> lck(mutex_);
+        bits_ = bits_ & ~(1ULL << pos);
+    }
+    int get(uint64_t pos) {
+        std::lock_guard<std::mutex> lck(mutex_);
+        return bits_ & (1ULL << pos) ? 1 : 0;
+    }
+
+    // 与原check_start_condition相同的加锁顺序（商用启动）
+    bool try_acquire() {
+        if (get(DEVICE_STATUS_FORRBIDDEN)) return false;
+        if (get(DEVICE_STATUS_BUSY)) return false;
+        set(DEVICE_STATUS_BUSY);
+        if (get(DEVICE_STATUS_FORRBIDDEN_COMMERCIAL) || get(DEVICE_STATUS_ERROR_CONFIG)) {
+            clear(DEVICE_STATUS_BUSY);
+            return false;
+        }
+        return true;
+    }
+    void release() { clear(DEVICE_STATUS_BUSY); }
+    int read() { return get(DEVICE_STATUS_ONLINE); }
+
+private:
+    std::mutex mutex_;
+    uint64_t bits_ = 0;
+};
+
+class AtomicStatus {
+public:
+    bool try_acquire() {
+        const uint64_t blocked = StatusRegister::bit(DEVICE_STATUS_FORRBIDDEN) |
+                                 StatusRegister::bit(DEVICE_STATUS_BUSY) |
+                                 StatusRegister::bit(DEVICE_STATUS_FORRBIDDEN_COMMERCIAL) |
+                                 StatusRegister::bit(DEVICE_STATUS_ERROR_CONFIG);
+        return status_.transition(blocked, StatusRegister::bit(DEVICE_STATUS_BUSY));
+    }
+    void release() { status_.clear(DEVICE_STATUS_BUSY); }
+    int read() { return status_.test(DEVICE_STATUS_ONLINE) ? 1 : 0; }
+
+private:
+    StatusRegister status_;
+};
+
+struct Result {
+    double ns_per_op;
+    unsigned long long acquired;
+    unsigned long long violations;  // 同时有多个线程认为自己拿到了BUSY
+};
+
+// 每个线程循环：启动检查 -> 释放，穿插状态读取（心跳/日志）
+template <typename Status>
+static Result run(size_t threads, size_t iterations) {
+    Status status;
+    std::atomic<int> holders(0);
+    std::atomic<unsigned long long> acquired(0);
+    std::atomic<unsigned long long> violations(0);
+    std::atomic<bool> go(false);
+    std::vector<std::thread> workers;
+
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            unsigned long long local = 0;
+            int sink = 0;
+            for (size_t i = 0; i < iterations; i++) {
+                if (status.try_acquire()) {
+                    if (holders.fetch_add(1) != 0) {
+                        violations++;
+                    }
+                    local++;
+                    holders.fetch_sub(1);
+                    status.release();
+                }
+                sink += status.read();
+            }
+            acquired += local;
+            if (sink < 0) std::cout << sink;
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+
+    Result result;
+    result.ns_per_op = static_cast<double>(elapsed) / (threads * iterations);
+    result.acquired = acquired.load();
+    result.violations = violations.load();
+    return result;
+}
+
+static void print(const char* name, size_t threads, const Result& r) {
+    std::cout << std::setw(8) << name
+              << std::setw(9) << threads
+              << std::setw(12) << std::fixed << std::setprecision(1) << r.ns_per_op
+              << std::setw(12) << r.acquired
+              << std::setw(12) << r.violations
+              << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+    std::cout << "每线程" << iterations << "次（启动检查+释放+读取），硬件线程数"
+              << std::thread::hardware_concurrency() << "\n";
+    std::cout << std::setw(8) << "impl"
+              << std::setw(9) << "threads"
+              << std::setw(12) << "ns/iter"
+              << std::setw(12) << "acquired"
+              << std::setw(12) << "violations"
+              << "\n";
+    const size_t thread_counts[] = {1, 2, 4, 8};
+    for (size_t threads : thread_counts) {
+        print("mutex", threads, run<MutexStatus>(threads, iterations));
+        print("atomic", threads, run<AtomicStatus>(threads, iterations));
+    }
+    return 0;
+}
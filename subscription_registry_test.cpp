@@ -0,0 +1,104 @@
+#include "tools/mqtt/subscription_registry.hpp"
+#include <iostream>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <string>
+#include <chrono>
+
+// 订阅注册表并发压力测试：订阅、取消订阅与消息分发同时进行
+int main() {
+    std::cout << "=== 订阅注册表并发测试 ===" << std::endl;
+    int failures = 0;
+
+    // 测试1: 通配符匹配
+    std::cout << "\n--- 测试1: 主题过滤器匹配 ---" << std::endl;
+    {
+        struct Case { const char* filter; const char* topic; bool expect; };
+        const Case cases[] = {
+            {"GreenEnergy/CMD/0000-00001", "GreenEnergy/CMD/0000-00001", true},
+            {"GreenEnergy/CMD/+", "GreenEnergy/CMD/0000-00001", true},
+            {"GreenEnergy/+/0000-00001", "GreenEnergy/STATUS/0000-00001", true},
+            {"GreenEnergy/#", "GreenEnergy/CMD/0000-00001", true},
+            {"GreenEnergy/CMD/#", "GreenEnergy/CMD", true},
+            {"GreenEnergy/CMD/+", "GreenEnergy/CMD", false},
+            {"GreenEnergy/CMD", "GreenEnergy/CMD/0000-00001", false},
+            {"GreenEnergy/CMD/0000-00001", "GreenEnergy/CMD/0000-00002", false},
+            {"#", "any/topic", true},
+        };
+        for (const auto& c : cases) {
+            bool result = SubscriptionRegistry::topic_matches(c.filter, c.topic);
+            if (result != c.expect) {
+                std::cout << "   匹配错误: " << c.filter << " <-> " << c.topic << std::endl;
+                failures++;
+            }
+        }
+        std::cout << "   完成" << std::endl;
+    }
+
+    // 测试2: 并发订阅/取消订阅/分发
+    std::cout << "\n--- 测试2: 并发订阅/取消订阅/分发 ---" << std::endl;
+    {
+        SubscriptionRegistry registry;
+        std::atomic<int> stable_hits(0);
+        registry.add("GreenEnergy/CMD/#", 1,
+                     [&stable_hits](const std::string&, const std::string&, uint8_t, bool) { stable_hits++; });
+
+        const int writers = 4;
+        const int readers = 4;
+        const int iterations = 20000;
+        std::atomic<bool> writers_done(false);
+        std::atomic<int> linearizability_errors(0);
+        std::atomic<long> dispatched(0);
+        std::atomic<int> snapshot_errors(0);
+
+        std::vector<std::thread> threads;
+        for (int w = 0; w < writers; w++) {
+            threads.emplace_back([&, w] {
+                for (int i = 0; i < iterations; i++) {
+                    std::string topic = "GreenEnergy/STATUS/" + std::to_string(w) + "/" + std::to_string(i % 64);
+                    registry.add(topic, 1);
+                    // 写操作返回后立即对所有读者可见
+                    if (!registry.contains(topic)) linearizability_errors++;
+                    if (!registry.remove(topic)) linearizability_errors++;
+                    if (registry.contains(topic)) linearizability_errors++;
+                }
+            });
+        }
+        for (int r = 0; r < readers; r++) {
+            threads.emplace_back([&] {
+                while (!writers_done) {
+                    SubscriptionRegistry::Snapshot snapshot = registry.snapshot();
+                    // 常驻订阅在任何快照中都必须存在
+                    if (snapshot->find("GreenEnergy/CMD/#") == snapshot->end()) snapshot_errors++;
+                    for (const auto& entry : *snapshot) {
+                        if (entry.second.handler &&
+                            SubscriptionRegistry::topic_matches(entry.first, "GreenEnergy/CMD/0000-00001")) {
+                            entry.second.handler("GreenEnergy/CMD/0000-00001", "{}", 1, false);
+                            dispatched++;
+                        }
+                    }
+                }
+            });
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (int w = 0; w < writers; w++) threads[w].join();
+        writers_done = true;
+        for (size_t t = writers; t < threads.size(); t++) threads[t].join();
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+        std::cout << "   写操作: " << writers * iterations * 2 << " 次, 分发: " << dispatched
+                  << " 次, 耗时: " << elapsed << "ms" << std::endl;
+        if (linearizability_errors || snapshot_errors || stable_hits != dispatched || registry.size() != 1) {
+            std::cout << "   失败: 线性化错误 " << linearizability_errors
+                      << ", 快照错误 " << snapshot_errors
+                      << ", 剩余订阅 " << registry.size() << std::endl;
+            failures++;
+        }
+    }
+
+    std::cout << "\n=== " << (failures ? "测试失败" : "所有测试通过") << " ===" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,220 @@
+#include "config/price_table.hpp"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+/**
+ * 日历电价性能测试
+ *
+ * 工作日/周末/夏季/冬季/节假日五套日程，规则含星期、每年月日范围（含跨年）、绝对日期范围与节假日日历。
+ * 对照实现按"每次查询localtime_r + 逐条规则判断 + 逐项扫描节假日与时段"计算，
+ * 与编译后的分钟表逐分钟核对两年，再比较连续时间（充电会话）与两年内随机时间两种访问方式的查询耗时。
+ */
+
+namespace {
+
+struct Period {
+    const char* start;
+    const char* end;
+    double price;
+};
+
+struct Schedule {
+    const char* name;
+    std::vector<Period> periods;
+    double other;
+};
+
+struct Rule {
+    const char* day_type;
+    std::vector<int> weekdays;  // 空表示不限
+    bool holiday;
+    const char* season_from;    // "MM-DD"，nullptr表示不限
+    const char* season_to;
+    const char* from;           // "YYYY-MM-DD"
+    const char* to;
+};
+
+const double kServiceFee = 0.1;
+
+const std::vector<Schedule> kSchedules = {
+    {"default", {{"00:00", "07:00", 0.5}, {"07:00", "19:00", 0.8}, {"19:00", "23:00", 1.0}}, 0.6},
+    {"holiday", {{"00:00", "24:00", 0.45}}, 0.45},
+    {"summer", {{"00:00", "07:00", 0.5}, {"07:00", "11:00", 1.0}, {"11:00", "14:00", 1.4},
+                {"14:00", "19:00", 1.0}, {"19:00", "23:00", 1.2}}, 0.6},
+    {"weekend", {{"00:00", "08:00", 0.4}, {"08:00", "22:00", 0.7}}, 0.5},
+    {"winter", {{"00:00", "06:30", 0.55}, {"06:30", "17:30", 0.85}, {"17:30", "21:30", 1.25}}, 0.65},
+};
+
+const std::vector<std::string> kHolidays = {
+    "2024-01-01", "2024-04-04", "2024-04-05", "2024-05-01", "2024-05-02", "2024-05-03", "2024-06-10",
+    "2024-09-17", "2024-10-01", "2024-10-02", "2024-10-03", "2024-10-04", "2024-10-07",
+    "2025-01-01", "2025-04-04", "2025-05-01", "2025-05-02", "2025-05-05", "2025-06-02",
+    "2025-10-01", "2025-10-02", "2025-10-03", "2025-10-06", "2025-10-07", "2025-10-08",
+};
+
+const std::vector<Rule> kRules = {
+    {"holiday", {}, true, nullptr, nullptr, nullptr, nullptr},
+    {"holiday", {}, false, nullptr, nullptr, "2024-02-10", "2024-02-17"},
+    {"holiday", {}, false, nullptr, nullptr, "2025-01-28", "2025-02-04"},
+    {"weekend", {0, 6}, false, nullptr, nullptr, nullptr, nullptr},
+    {"summer", {}, false, "06-15", "09-15", nullptr, nullptr},
+    {"winter", {}, false, "12-01", "02-28", nullptr, nullptr},
+};
+
+int to_minutes(const char* text) {
+    int h = 0, m = 0;
+    sscanf(text, "%d:%d", &h, &m);
+    return h * 60 + m;
+}
+
+nlohmann::json schedule_json(const Schedule& s) {
+    nlohmann::json j;
+    j["price_list"] = nlohmann::json::array();
+    for (const Period& p : s.periods) {
+        j["price_list"].push_back({{"start", p.start}, {"end", p.end}, {"price", p.price}, {"service_fee", kServiceFee}});
+    }
+    j["other_price"] = s.other;
+    j["other_service_fee"] = kServiceFee;
+    return j;
+}
+
+std::string tariff_json() {
+    nlohmann::json j = schedule_json(kSchedules[0]);
+    for (size_t i = 1; i < kSchedules.size(); i++) {
+        j["day_types"][kSchedules[i].name] = schedule_json(kSchedules[i]);
+    }
+    j["holidays"] = kHolidays;
+    for (const Rule& r : kRules) {
+        nlohmann::json rule;
+        rule["day_type"] = r.day_type;
+        if (!r.weekdays.empty()) rule["weekdays"] = r.weekdays;
+        if (r.holiday) rule["holiday"] = true;
+        if (r.season_from) rule["season"] = {r.season_from, r.season_to};
+        if (r.from) rule["from"] = r.from;
+        if (r.to) rule["to"] = r.to;
+        j["rules"].push_back(rule);
+    }
+    return j.dump();
+}
+
+// 对照实现：每次查询都换算本地时间并逐条判断
+double reference_price(time_t unix_time) {
+    struct tm tm_time;
+    localtime_r(&unix_time, &tm_time);
+    char date[36];
+    snprintf(date, sizeof(date), "%04d-%02d-%02d", tm_time.tm_year + 1900, tm_time.tm_mon + 1, tm_time.tm_mday);
+    const char* month_day = date + 5;
+    bool holiday = false;
+    for (const std::string& h : kHolidays) {
+        if (h == date) {
+            holiday = true;
+            break;
+        }
+    }
+    const char* day_type = "default";
+    for (const Rule& r : kRules) {
+        bool weekday_ok = r.weekdays.empty();
+        for (int w : r.weekdays) {
+            weekday_ok = weekday_ok || w == tm_time.tm_wday;
+        }
+        if (!weekday_ok || (r.holiday && !holiday)) continue;
+        if (r.from && std::string(date) < r.from) continue;
+        if (r.to && std::string(date) > r.to) continue;
+        if (r.season_from) {
+            std::string md(month_day), from(r.season_from), to(r.season_to);
+            bool in = from <= to ? (md >= from && md <= to) : (md >= from || md <= to);
+            if (!in) continue;
+        }
+        day_type = r.day_type;
+        break;
+    }
+    int minutes = tm_time.tm_hour * 60 + tm_time.tm_min;
+    for (const Schedule& s : kSchedules) {
+        if (std::string(s.name) != day_type) continue;
+        for (const Period& p : s.periods) {
+            if (to_minutes(p.start) <= minutes && minutes < to_minutes(p.end)) {
+                return p.price + kServiceFee;
+            }
+        }
+        return s.other + kServiceFee;
+    }
+    return 0;
+}
+
+template <typename Lookup>
+double measure(const char* name, const std::vector<time_t>& times, size_t lookups, Lookup lookup) {
+    double checksum = 0;
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < lookups; i++) {
+        checksum += lookup(times[i % times.size()]);
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count();
+    std::cout << "  " << std::left << std::setw(18) << name << std::right << std::fixed
+              << std::setprecision(1) << std::setw(9) << ns / lookups << " ns/次"
+              << std::setw(10) << lookups / (ns / 1e9) / 1e6 << " M次/s"
+              << "   checksum " << std::setprecision(2) << checksum << "\n";
+    return ns;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    const size_t lookups = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+    PriceTable table;
+    if (!table.parse(tariff_json())) {
+        return 1;
+    }
+    table.print_all();
+    std::cout << std::setfill(' ');
+
+    // 2024-01-01 00:00 UTC起两年，逐分钟核对（偏移逐分钟刷新，与主循环定期刷新等价）
+    const time_t base = 1704067200;
+    const time_t span = 731 * 86400;
+    size_t mismatches = 0, checked = 0;
+    std::vector<size_t> day_type_minutes(table.day_type_count(), 0);
+    for (time_t t = base; t < base + span; t += 60) {
+        table.refresh_utc_offset(t);
+        if (reference_price(t) != table.get_price(t)) {
+            mismatches++;
+        }
+        day_type_minutes[table.day_type_at(t)]++;
+        checked++;
+    }
+    std::cout << "\n=== 日历电价: " << table.day_type_count() << " 套日程, " << kRules.size() << " 条规则, "
+              << kHolidays.size() << " 个节假日, " << table.period_count() << " 个时段 ===\n";
+    std::cout << "逐分钟核对两年 " << checked << " 分钟: " << (mismatches == 0 ? "一致" : "不一致")
+              << " (" << mismatches << " 处差异); 天数分布";
+    for (size_t i = 0; i < day_type_minutes.size(); i++) {
+        std::cout << " " << table.day_type_name(static_cast<int>(i)) << ":" << day_type_minutes[i] / 1440;
+    }
+    std::cout << "\n";
+
+    // 连续访问：会话按秒推进（偏移取起点时刻）；随机访问：两年内任意时间，日期缓存频繁替换
+    table.refresh_utc_offset(base);
+    std::vector<time_t> sequential(1 << 20), random(1 << 20);
+    uint64_t state = 88172645463325252ULL;
+    for (size_t i = 0; i < sequential.size(); i++) {
+        sequential[i] = base + static_cast<time_t>(i) * 10;
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        random[i] = base + static_cast<time_t>(state % span);
+    }
+    const std::vector<time_t>* patterns[2] = {&sequential, &random};
+    const char* pattern_names[2] = {"连续（10秒步长，约121天）", "随机（两年内）"};
+    for (int p = 0; p < 2; p++) {
+        std::cout << pattern_names[p] << ", " << lookups << " 次查询\n";
+        double ref_ns = measure("localtime_r + 扫描", *patterns[p], lookups, reference_price);
+        uint64_t misses_before = table.day_cache_misses();
+        double table_ns = measure("编译分钟表", *patterns[p], lookups, [&table](time_t t) { return table.get_price(t); });
+        std::cout << "  加速 " << std::setprecision(1) << ref_ns / table_ns << "x, 日期缓存未命中 "
+                  << table.day_cache_misses() - misses_before << " 次\n";
+    }
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,216 @@
+#include "config/price_store.hpp"
+#include <nlohmann/json.hpp>
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+/**
+ * 二进制电价镜像加载测试
+ *
+ * 对比三种启动加载方式的耗时（中位数与最大值）：
+ *   1. PriceTable::load：读JSON、解析、编译，并打印整张表（原有方式，输出重定向到空缓冲区）
+ *   2. PriceStore::load_file读JSON：解析与编译，不打印
+ *   3. PriceStore::load_file读镜像：mmap后校验头部与校验和，原地使用
+ * 表为price.json与生成的大型日历电价（12个日程共252个时段、节假日与日期规则），
+ * 核对两种格式两年内逐分钟的电价一致，并验证损坏、截断的镜像会被拒绝。
+ */
+
+namespace {
+
+const int kRounds = 200;
+
+struct Timing {
+    double median_us;
+    double max_us;
+};
+
+template <typename F>
+Timing measure(F load) {
+    std::vector<double> samples;
+    for (int i = 0; i < kRounds; i++) {
+        auto begin = std::chrono::steady_clock::now();
+        if (!load()) {
+            std::cerr << "加载失败" << std::endl;
+            exit(1);
+        }
+        samples.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+    }
+    std::sort(samples.begin(), samples.end());
+    return {samples[samples.size() / 2], samples.back()};
+}
+
+std::string format_hm(int minutes) {
+    char text[24];
+    snprintf(text, sizeof(text), "%02d:%02d", minutes / 60, minutes % 60);
+    return text;
+}
+
+// 12个日程，每个20个时段（72分钟一段），加上每年的节假日与调休规则
+std::string large_calendar_tariff() {
+    nlohmann::json j;
+    auto schedule = [](int seed) {
+        nlohmann::json s;
+        s["price_list"] = nlohmann::json::array();
+        for (int p = 0; p < 20; p++) {
+            s["price_list"].push_back({{"start", format_hm(p * 72)}, {"end", format_hm((p + 1) * 72)},
+                                       {"price", 0.3 + 0.01 * ((seed * 7 + p * 13) % 100)},
+                                       {"service_fee", 0.1}});
+        }
+        s["other_price"] = 0.6;
+        s["other_service_fee"] = 0.1;
+        return s;
+    };
+    j = schedule(0);
+    for (int d = 1; d < 12; d++) {
+        char name[16];
+        snprintf(name, sizeof(name), "type%02d", d);
+        j["day_types"][name] = schedule(d);
+    }
+    j["holidays"] = nlohmann::json::array();
+    j["rules"] = nlohmann::json::array();
+    for (int year = 2024; year <= 2028; year++) {
+        for (int month = 1; month <= 12; month++) {
+            char date[16];
+            snprintf(date, sizeof(date), "%04d-%02d-%02d", year, month, 1 + (year + month) % 27);
+            j["holidays"].push_back(date);
+            char from[16], to[16];
+            snprintf(from, sizeof(from), "%04d-%02d-10", year, month);
+            snprintf(to, sizeof(to), "%04d-%02d-12", year, month);
+            char name[16];
+            snprintf(name, sizeof(name), "type%02d", 1 + month % 11);
+            j["rules"].push_back({{"day_type", name}, {"from", from}, {"to", to}});
+        }
+    }
+    j["rules"].push_back({{"day_type", "type01"}, {"holiday", true}});
+    j["rules"].push_back({{"day_type", "type02"}, {"weekdays", {0, 6}}});
+    j["rules"].push_back({{"day_type", "type03"}, {"season", {"06-15", "09-15"}}});
+    j["rules"].push_back({{"day_type", "type04"}, {"season", {"12-01", "02-28"}}});
+    return j.dump(2);
+}
+
+std::string read_file(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    return buffer.str();
+}
+
+void write_file(const std::string& path, const std::string& data) {
+    std::ofstream(path, std::ios::binary) << data;
+}
+
+long compare_tables(const PriceTable& a, const PriceTable& b, time_t from, int days) {
+    long mismatches = 0;
+    for (time_t t = from; t < from + days * 86400L; t += 60) {
+        if (a.get_price(t) != b.get_price(t) || a.period_at(t) != b.period_at(t) ||
+            a.day_type_at(t) != b.day_type_at(t)) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+void run(const std::string& name, const std::string& json_path, const std::string& image_path) {
+    PriceTable source;
+    if (!source.parse(read_file(json_path)) || !source.write_image(image_path)) {
+        exit(1);
+    }
+    const size_t json_bytes = read_file(json_path).size();
+    const size_t image_bytes = read_file(image_path).size();
+
+    // 原有方式打印整张表，输出丢弃
+    std::ostringstream sink;
+    std::streambuf* saved = std::cout.rdbuf(sink.rdbuf());
+    Timing legacy = measure([&] {
+        PriceTable table;
+        sink.str("");
+        return table.load(json_path);
+    });
+    std::cout.rdbuf(saved);
+    std::cout << std::setfill(' ');  // print_all会修改填充字符
+    Timing json = measure([&] {
+        PriceStore store;
+        return store.load_file(json_path) == PriceStore::RELOAD_OK;
+    });
+    Timing image = measure([&] {
+        PriceStore store;
+        return store.load_file(image_path) == PriceStore::RELOAD_OK;
+    });
+
+    PriceStore store;
+    store.load_file(image_path);
+    PriceSnapshotPtr mapped = store.current();
+    const time_t from = 1704067200;  // 2024-01-01
+    long mismatches = compare_tables(source, mapped->table, from, 730);
+
+    std::cout << std::fixed << std::setprecision(1)
+              << "=== " << name << ": " << source.day_type_count() << " 个日程, " << source.period_count()
+              << " 个时段, JSON " << json_bytes << " 字节, 镜像 " << image_bytes << " 字节 ===" << std::endl
+              << std::left << std::setw(28) << "方式" << std::right << std::setw(14) << "中位数 us"
+              << std::setw(14) << "最大 us" << std::endl;
+    auto row = [](const char* label, const Timing& t) {
+        std::cout << std::left << std::setw(28) << label << std::right << std::setw(12) << t.median_us
+                  << std::setw(14) << t.max_us << std::endl;
+    };
+    row("JSON load（解析+打印）", legacy);
+    row("JSON load_file（解析）", json);
+    row("镜像 load_file（mmap）", image);
+    std::cout << "加速比 " << std::setprecision(1) << legacy.median_us / image.median_us << "x（对原有方式）, "
+              << json.median_us / image.median_us << "x（对不打印的JSON）, 两年逐分钟核对不一致 "
+              << mismatches << " 分钟" << std::endl;
+}
+
+// 损坏或截断的镜像必须被拒绝
+bool check_rejects(const std::string& image_path) {
+    const std::string image = read_file(image_path);
+    const std::string bad_path = image_path + ".bad";
+    bool ok = true;
+    std::ostringstream sink;
+    std::streambuf* saved = std::cerr.rdbuf(sink.rdbuf());
+    for (size_t offset : {size_t(8), size_t(20), image.size() / 2, image.size() - 1}) {
+        std::string corrupted = image;
+        corrupted[offset] ^= 0x40;
+        write_file(bad_path, corrupted);
+        PriceStore store;
+        ok = ok && store.load_file(bad_path) == PriceStore::RELOAD_ERROR;
+    }
+    write_file(bad_path, image.substr(0, image.size() - 8));
+    PriceStore store;
+    ok = ok && store.load_file(bad_path) == PriceStore::RELOAD_ERROR;
+    std::cerr.rdbuf(saved);
+    unlink(bad_path.c_str());
+    std::cout << "损坏/截断的镜像: " << (ok ? "全部拒绝" : "未能全部拒绝") << std::endl;
+    return ok;
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    char dir_template[] = "/tmp/tariff_image_XXXXXX";
+    if (!mkdtemp(dir_template)) {
+        perror("mkdtemp");
+        return 1;
+    }
+    const std::string dir = dir_template;
+    const std::string large_path = dir + "/calendar.json";
+    write_file(large_path, large_calendar_tariff());
+
+    run("price.json", price_path, dir + "/price.tariff");
+    run("大型日历电价", large_path, dir + "/calendar.tariff");
+    bool ok = check_rejects(dir + "/calendar.tariff");
+
+    for (const char* file : {"/calendar.json", "/price.tariff", "/calendar.tariff"}) {
+        unlink((dir + file).c_str());
+    }
+    rmdir(dir.c_str());
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+#include "config/price_table.hpp"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <cstdio>
+#include <unistd.h>
+
+// 电价表归一化测试：排序、合并、补空档、跨午夜与重叠诊断，随机时段表与逐项扫描对照
+namespace {
+
+struct Item {
+    int start;  // 分钟
+    int end;
+    double price;
+};
+
+std::string hm(int minutes) {
+    char text[24];
+    snprintf(text, sizeof(text), "%02d:%02d", minutes / 60, minutes % 60);
+    return text;
+}
+
+std::string tariff_json(const std::vector<Item>& items, double other = 0.6) {
+    std::ostringstream out;
+    out << "{\"price_list\": [";
+    for (size_t i = 0; i < items.size(); i++) {
+        out << (i ? ", " : "") << "{\"start\": \"" << hm(items[i].start) << "\", \"end\": \"" << hm(items[i].end)
+            << "\", \"price\": " << items[i].price << ", \"service_fee\": 0.1}";
+    }
+    out << "], \"other_price\": " << other << ", \"other_service_fee\": 0.1}";
+    return out.str();
+}
+
+// 解析失败的原因，成功时为空
+std::string parse_error(PriceTable& table, const std::string& text) {
+    std::ostringstream sink;
+    std::streambuf* saved = std::cerr.rdbuf(sink.rdbuf());
+    bool ok = table.parse(text);
+    std::cerr.rdbuf(saved);
+    return ok ? std::string() : table.error();
+}
+
+// 对照：逐项扫描原始列表（跨午夜的条目按两段处理），都不匹配时为其他时段
+double reference_price(const std::vector<Item>& items, double other, int minute) {
+    for (const Item& item : items) {
+        bool hit = item.start < item.end ? item.start <= minute && minute < item.end
+                                         : minute >= item.start || minute < item.end;
+        if (hit) {
+            return item.price + 0.1;
+        }
+    }
+    return other + 0.1;
+}
+
+// 区间首尾相接覆盖全天，相邻区间时段不同，且与分钟表一致
+bool intervals_consistent(const PriceTable& table) {
+    const std::vector<PriceInterval>& intervals = table.intervals();
+    int cursor = 0;
+    for (size_t i = 0; i < intervals.size(); i++) {
+        const PriceInterval& in = intervals[i];
+        if (in.start_minutes != cursor || in.end_minutes <= in.start_minutes ||
+            (i > 0 && intervals[i - 1].period == in.period)) {
+            return false;
+        }
+        for (int m = in.start_minutes; m < in.end_minutes; m++) {
+            if (table.period_at_minute(m) != in.period) {
+                return false;
+            }
+        }
+        cursor = in.end_minutes;
+    }
+    return cursor == PriceTable::kMinutesPerDay;
+}
+
+bool prices_match(const PriceTable& table, const std::vector<Item>& items, double other) {
+    for (int m = 0; m < PriceTable::kMinutesPerDay; m++) {
+        if (table.get_price(static_cast<time_t>(m) * 60) != reference_price(items, other, m)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+int main() {
+    std::cout << "=== 电价表归一化测试 ===" << std::endl;
+    int failures = 0;
+    auto check = [&failures](bool ok, const std::string& what) {
+        if (!ok) {
+            std::cout << "   失败: " << what << std::endl;
+            failures++;
+        }
+    };
+
+    // 测试1: 乱序条目按开始时间排序，空档以其他时段补齐
+    std::cout << "\n--- 测试1: 排序与补空档 ---" << std::endl;
+    {
+        PriceTable table;
+        table.set_utc_offset(0);
+        const std::vector<Item> items = {{1140, 1380, 1.0}, {0, 420, 0.5}, {480, 1140, 0.8}};
+        check(parse_error(table, tariff_json(items)).empty(), "乱序条目被拒绝");
+        table.set_utc_offset(0);
+        check(table.period_at_minute(0) == 0 && table.period_at_minute(500) == 1 &&
+                  table.period_at_minute(1200) == 2, "时段ID未按开始时间排序");
+        check(table.period_at_minute(450) == table.other_period() &&
+                  table.period_at_minute(1400) == table.other_period(), "空档不是其他时段");
+        check(table.intervals().size() == 5, "区间数应为5（含两段空档）");
+        check(intervals_consistent(table), "区间与分钟表不一致");
+        check(prices_match(table, items, 0.6), "电价与逐项扫描不一致");
+        std::cout << "   完成" << std::endl;
+    }
+
+    // 测试2: 首尾相接且费率相同的条目合并
+    std::cout << "\n--- 测试2: 合并相邻同价时段 ---" << std::endl;
+    {
+        PriceTable table;
+        const std::vector<Item> items = {{0, 420, 0.5}, {420, 720, 0.8}, {720, 1140, 0.8}, {1200, 1260, 0.8}};
+        check(parse_error(table, tariff_json(items)).empty(), "合法条目被拒绝");
+        table.set_utc_offset(0);
+        check(table.other_period() == 3, "07:00-12:00与12:00-19:00应合并，19:00起有空档不应合并");
+        check(table.period_at_minute(420) == table.period_at_minute(1000), "合并后不是同一时段");
+        check(intervals_consistent(table), "区间与分钟表不一致");
+        check(prices_match(table, items, 0.6), "电价与逐项扫描不一致");
+        std::cout << "   完成" << std::endl;
+    }
+
+    // 测试3: 结束早于开始的时段跨午夜
+    std::cout << "\n--- 测试3: 跨午夜时段 ---" << std::endl;
+    {
+        PriceTable table;
+        const std::vector<Item> items = {{1320, 360, 0.3}, {360, 1320, 0.9}};
+        check(parse_error(table, tariff_json(items)).empty(), "跨午夜时段被拒绝");
+        table.set_utc_offset(0);
+        check(table.period_at_minute(1400) == 0 && table.period_at_minute(100) == 0, "跨午夜时段的两段不是同一时段");
+        check(table.intervals().size() == 3, "区间数应为3");
+        check(intervals_consistent(table), "区间与分钟表不一致");
+        check(prices_match(table, items, 0.6), "电价与逐项扫描不一致");
+        std::cout << "   完成" << std::endl;
+    }
+
+    // 测试4: 格式错误与重叠给出精确诊断，且不修改当前内容
+    std::cout << "\n--- 测试4: 诊断 ---" << std::endl;
+    {
+        PriceTable table;
+        check(parse_error(table, tariff_json({{0, 420, 0.5}})).empty(), "合法条目被拒绝");
+        struct Case {
+            std::string text;
+            std::string expect;  // 诊断中须包含的内容
+        };
+        const std::string valid = "{\"start\": \"00:00\", \"end\": \"07:00\", \"price\": 0.5, \"service_fee\": 0.1}";
+        auto with = [&valid](const std::string& item) {
+            return "{\"price_list\": [" + valid + ", " + item + "], \"other_price\": 0.6, \"other_service_fee\": 0.1}";
+        };
+        const std::vector<Case> cases = {
+            {tariff_json({{420, 1140, 0.8}, {1080, 1200, 1.0}}), "default: 第1项(07:00-19:00)与第2项(18:00-20:00)在18:00-19:00重叠"},
+            {tariff_json({{0, 1440, 0.8}, {600, 660, 1.0}}), "第1项(00:00-24:00)与第2项(10:00-11:00)在10:00-11:00重叠"},
+            {tariff_json({{1320, 360, 0.3}, {300, 600, 0.8}}), "第1项(22:00-06:00)与第2项(05:00-10:00)在05:00-06:00重叠"},
+            {tariff_json({{600, 600, 0.8}}), "第1项(10:00-10:00)长度为0"},
+            {with("{\"start\": \"25:00\", \"end\": \"26:00\", \"price\": 1, \"service_fee\": 0}"), "第2项时间格式错误: 25:00-26:00"},
+            {with("{\"start\": \"07:60\", \"end\": \"08:00\", \"price\": 1, \"service_fee\": 0}"), "第2项时间格式错误"},
+            {with("{\"start\": \"07:00x\", \"end\": \"08:00\", \"price\": 1, \"service_fee\": 0}"), "第2项时间格式错误"},
+            {with("{\"start\": \"24:00\", \"end\": \"08:00\", \"price\": 1, \"service_fee\": 0}"), "第2项(24:00-08:00)开始时间须早于24:00"},
+            {with("{\"start\": \"07:00\", \"end\": \"08:00\", \"price\": -1, \"service_fee\": 0}"), "第2项(07:00-08:00)电价或服务费无效"},
+            {"{\"price_list\": [], \"day_types\": {\"weekend\": {\"price_list\": [" + valid + ", " + valid + "]}}}",
+             "weekend: 第1项(00:00-07:00)与第2项(00:00-07:00)在00:00-07:00重叠"},
+        };
+        for (const Case& c : cases) {
+            std::string error = parse_error(table, c.text);
+            if (error.find(c.expect) == std::string::npos) {
+                std::cout << "   诊断不符: 期望包含 \"" << c.expect << "\", 实际 \"" << error << "\"" << std::endl;
+                failures++;
+            }
+        }
+        check(table.other_period() == 1 && table.period_price(0) == 0.5 + 0.1, "失败的加载修改了当前内容");
+        std::cout << "   完成" << std::endl;
+    }
+
+    // 测试5: 随机时段表（乱序、相邻同价、空档、跨午夜）与逐项扫描对照，并经镜像往返
+    std::cout << "\n--- 测试5: 随机时段表 ---" << std::endl;
+    {
+        std::mt19937 rng(46);
+        const std::string image_path = "/tmp/tariff_normalize_test.tariff";
+        int tables = 0, merged = 0;
+        for (int round = 0; round < 2000; round++) {
+            // 在全天上取不重叠的切分点，每段随机保留为时段或留作空档，电价只取少数几种以产生可合并的相邻项
+            std::vector<int> cuts = {0, PriceTable::kMinutesPerDay};
+            int count = 1 + static_cast<int>(rng() % 12);
+            for (int i = 0; i < count; i++) {
+                cuts.push_back(static_cast<int>(rng() % PriceTable::kMinutesPerDay));
+            }
+            std::sort(cuts.begin(), cuts.end());
+            cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+            std::vector<Item> items;
+            for (size_t i = 0; i + 1 < cuts.size(); i++) {
+                if (rng() % 4 != 0) {
+                    items.push_back({cuts[i], cuts[i + 1], 0.5 + 0.25 * (rng() % 3)});
+                }
+            }
+            // 首尾两段都保留时改成一个跨午夜条目（中间须留有时段，否则成为长度为0的条目）
+            if (items.size() >= 2 && items.front().start == 0 && items.back().end == PriceTable::kMinutesPerDay &&
+                items.front().end < items.back().start && rng() % 2 == 0) {
+                items.front().start = items.back().start;
+                items.pop_back();
+            }
+            std::shuffle(items.begin(), items.end(), rng);
+            PriceTable table;
+            std::string error = parse_error(table, tariff_json(items));
+            if (!error.empty()) {
+                std::cout << "   合法条目被拒绝: " << error << std::endl;
+                failures++;
+                continue;
+            }
+            table.set_utc_offset(0);
+            tables++;
+            merged += static_cast<int>(items.size()) - table.other_period();
+            if (!intervals_consistent(table) || !prices_match(table, items, 0.6)) {
+                std::cout << "   不一致: " << tariff_json(items) << std::endl;
+                failures++;
+                continue;
+            }
+            PriceTable image;
+            if (!table.write_image(image_path) || !image.map_image(image_path)) {
+                std::cout << "   镜像往返失败: " << tariff_json(items) << std::endl;
+                failures++;
+                continue;
+            }
+            image.set_utc_offset(0);
+            if (image.intervals().size() != table.intervals().size() || !prices_match(image, items, 0.6)) {
+                std::cout << "   镜像不一致: " << tariff_json(items) << std::endl;
+                failures++;
+            }
+        }
+        unlink(image_path.c_str());
+        std::cout << "   " << tables << " 张表, 合并 " << merged << " 个条目, 完成" << std::endl;
+    }
+
+    std::cout << "\n=== " << (failures ? "测试失败" : "所有测试通过") << " ===" << std::endl;
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,81 @@
+#include "config/price_table.hpp"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
+
+namespace {
+
+// 逐分钟比较两张表在from起days天内的电价与时段ID，返回不一致的分钟数
+long compare_tables(const PriceTable& a, const PriceTable& b, time_t from, int days) {
+    long mismatches = 0;
+    for (time_t t = from; t < from + days * 86400L; t += 60) {
+        if (a.get_price(t) != b.get_price(t) || a.period_at(t) != b.period_at(t)) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+void print_summary(const PriceTable& table) {
+    std::cout << table.day_type_count() << " 个日程, " << table.period_count() << " 个时段";
+    if (table.image_checksum()) {
+        char checksum[16];
+        snprintf(checksum, sizeof(checksum), "%08x", table.image_checksum());
+        std::cout << ", 校验和 " << checksum;
+    }
+    std::cout << std::endl;
+}
+
+}  // namespace
+
+// 把price.json编译为二进制电价镜像（charging_station可直接mmap加载），或打印已有镜像的内容
+int main(int argc, char* argv[]) {
+    if (argc == 3 && std::strcmp(argv[1], "--dump") == 0) {
+        PriceTable table;
+        if (!table.map_image(argv[2])) {
+            return 1;
+        }
+        print_summary(table);
+        table.print_all();
+        return 0;
+    }
+    if (argc != 3) {
+        std::cerr << "用法: " << argv[0] << " <price.json> <price.tariff>\n"
+                  << "      " << argv[0] << " --dump <price.tariff>\n";
+        return 1;
+    }
+    std::ifstream in(argv[1]);
+    if (!in) {
+        std::cerr << "无法打开价格表文件: " << argv[1] << "\n";
+        return 1;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    PriceTable source;
+    if (!source.parse(buffer.str())) {
+        return 1;
+    }
+    if (!source.write_image(argv[2])) {
+        return 1;
+    }
+    // 读回校验：两年内逐分钟与JSON编译的结果一致
+    PriceTable image;
+    if (!image.map_image(argv[2])) {
+        return 1;
+    }
+    const time_t now = time(nullptr);
+    image.set_utc_offset(source.utc_offset());
+    long mismatches = compare_tables(source, image, now - 365 * 86400L, 730);
+    if (mismatches != 0) {
+        std::cerr << "镜像与源文件不一致: " << mismatches << " 分钟\n";
+        unlink(argv[2]);
+        return 1;
+    }
+    std::ifstream written(argv[2], std::ios::binary | std::ios::ate);
+    std::cout << argv[1] << " -> " << argv[2] << " (" << written.tellg() << " 字节), ";
+    print_summary(image);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// CRC-32（IEEE 802.3，反射多项式0xEDB88320），slicing-by-8：每次查8张表处理8字节，结果与逐字节查表相同
+inline uint32_t crc32(const void* data, size_t size) {
+    struct Table {
+        uint32_t entries[8][256];
+        Table() {
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) {
+                    c = c & 1 ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                }
+                entries[0][i] = c;
+            }
+            for (uint32_t i = 0; i < 256; i++) {
+                for (int t = 1; t < 8; t++) {
+                    entries[t][i] = entries[0][entries[t - 1][i] & 0xFF] ^ (entries[t - 1][i] >> 8);
+                }
+            }
+        }
+    };
+    static const Table table;
+    const uint32_t (*e)[256] = table.entries;
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint32_t c = 0xFFFFFFFFu;
+    for (; size >= 8; p += 8, size -= 8) {
+        uint32_t lo, hi;
+        std::memcpy(&lo, p, 4);
+        std::memcpy(&hi, p + 4, 4);
+        lo ^= c;  // 小端
+        c = e[7][lo & 0xFF] ^ e[6][(lo >> 8) & 0xFF] ^ e[5][(lo >> 16) & 0xFF] ^ e[4][lo >> 24] ^
+            e[3][hi & 0xFF] ^ e[2][(hi >> 8) & 0xFF] ^ e[1][(hi >> 16) & 0xFF] ^ e[0][hi >> 24];
+    }
+    for (; size > 0; p++, size--) {
+        c = e[0][(c ^ *p) & 0xFF] ^ (c >> 8);
+    }
+    return c ^ 0xFFFFFFFFu;
+}
@@ -0,0 +1,234 @@
+#include "modbus.hpp"
+#include <cstring>
+
+namespace {
+
+const size_t kMbapSize = 7;       // 事务ID(2) + 协议ID(2) + 长度(2) + 单元ID(1)
+const size_t kMaxPduSize = 253;
+const size_t kRtuExceptionSize = 5;
+const size_t kRtuFixedSize = 8;   // 读请求与写请求/写响应：地址 + 功能码 + 4字节 + CRC
+
+void put16(std::vector<uint8_t>& out, uint16_t value) {
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value & 0xFF));
+}
+
+uint16_t get16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+ModbusFrame make_frame(uint8_t unit, uint8_t function) {
+    ModbusFrame frame;
+    frame.unit = unit;
+    frame.function = function;
+    return frame;
+}
+
+}  // namespace
+
+uint16_t modbus_crc16(const uint8_t* data, size_t size) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < size; i++) {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? static_cast<uint16_t>((crc >> 1) ^ 0xA001) : static_cast<uint16_t>(crc >> 1);
+        }
+    }
+    return crc;
+}
+
+void modbus_encode(ModbusFraming framing, const ModbusFrame& frame, std::vector<uint8_t>& out) {
+    size_t begin = out.size();
+    if (framing == MODBUS_TCP) {
+        put16(out, frame.transaction);
+        put16(out, 0);
+        put16(out, static_cast<uint16_t>(2 + frame.data.size()));
+    }
+    out.push_back(frame.unit);
+    out.push_back(frame.function);
+    out.insert(out.end(), frame.data.begin(), frame.data.end());
+    if (framing == MODBUS_RTU) {
+        uint16_t crc = modbus_crc16(out.data() + begin, out.size() - begin);
+        out.push_back(static_cast<uint8_t>(crc & 0xFF));
+        out.push_back(static_cast<uint8_t>(crc >> 8));
+    }
+}
+
+ModbusFrame modbus_read_request(uint8_t unit, uint8_t function, uint16_t address, uint16_t count) {
+    ModbusFrame frame = make_frame(unit, function);
+    put16(frame.data, address);
+    put16(frame.data, count);
+    return frame;
+}
+
+ModbusFrame modbus_write_coil_request(uint8_t unit, uint16_t address, bool on) {
+    ModbusFrame frame = make_frame(unit, MODBUS_WRITE_COIL);
+    put16(frame.data, address);
+    put16(frame.data, on ? 0xFF00 : 0x0000);
+    return frame;
+}
+
+ModbusFrame modbus_write_register_request(uint8_t unit, uint16_t address, uint16_t value) {
+    ModbusFrame frame = make_frame(unit, MODBUS_WRITE_REGISTER);
+    put16(frame.data, address);
+    put16(frame.data, value);
+    return frame;
+}
+
+ModbusFrame modbus_registers_response(const ModbusFrame& request, const uint16_t* registers, uint16_t count) {
+    ModbusFrame frame = make_frame(request.unit, request.function);
+    frame.transaction = request.transaction;
+    frame.data.reserve(1 + 2 * count);
+    frame.data.push_back(static_cast<uint8_t>(2 * count));
+    for (uint16_t i = 0; i < count; i++) {
+        put16(frame.data, registers[i]);
+    }
+    return frame;
+}
+
+ModbusFrame modbus_exception_response(const ModbusFrame& request, uint8_t code) {
+    ModbusFrame frame = make_frame(request.unit, static_cast<uint8_t>(request.function | 0x80));
+    frame.transaction = request.transaction;
+    frame.data.push_back(code);
+    return frame;
+}
+
+bool modbus_request_fields(const ModbusFrame& request, uint16_t& address, uint16_t& value) {
+    if (request.data.size() != 4) {
+        return false;
+    }
+    address = get16(request.data.data());
+    value = get16(request.data.data() + 2);
+    return true;
+}
+
+bool modbus_response_registers(const ModbusFrame& response, uint16_t count, uint16_t* registers) {
+    if (response.is_exception() || response.data.size() != 1u + 2u * count || response.data[0] != 2 * count) {
+        return false;
+    }
+    for (uint16_t i = 0; i < count; i++) {
+        registers[i] = get16(response.data.data() + 1 + 2 * i);
+    }
+    return true;
+}
+
+float modbus_registers_to_float(const uint16_t* registers) {
+    uint32_t bits = (static_cast<uint32_t>(registers[0]) << 16) | registers[1];
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void modbus_float_to_registers(float value, uint16_t* registers) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    registers[0] = static_cast<uint16_t>(bits >> 16);
+    registers[1] = static_cast<uint16_t>(bits & 0xFFFF);
+}
+
+ModbusDecoder::ModbusDecoder(ModbusFraming framing, bool requests)
+    : framing_(framing), requests_(requests), head_(0), errors_(0) {
+}
+
+void ModbusDecoder::feed(const uint8_t* data, size_t size) {
+    // 已消费的前缀超过一半时再整理，避免每帧移动缓冲区
+    if (head_ > 0 && head_ * 2 >= buffer_.size()) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + head_);
+        head_ = 0;
+    }
+    buffer_.insert(buffer_.end(), data, data + size);
+}
+
+void ModbusDecoder::reset() {
+    buffer_.clear();
+    head_ = 0;
+}
+
+void ModbusDecoder::drop(size_t size) {
+    head_ += size;
+    if (head_ == buffer_.size()) {
+        reset();
+    }
+}
+
+int ModbusDecoder::rtu_frame_size() const {
+    size_t available = buffer_.size() - head_;
+    if (available < 2) {
+        return 0;
+    }
+    uint8_t function = buffer_[head_ + 1];
+    if (function & 0x80) {
+        return requests_ ? -1 : static_cast<int>(kRtuExceptionSize);
+    }
+    switch (function) {
+    case MODBUS_READ_HOLDING:
+    case MODBUS_READ_INPUT:
+        if (requests_) {
+            return static_cast<int>(kRtuFixedSize);
+        }
+        if (available < 3) {
+            return 0;
+        }
+        return 3 + buffer_[head_ + 2] + 2;
+    case MODBUS_WRITE_COIL:
+    case MODBUS_WRITE_REGISTER:
+        return static_cast<int>(kRtuFixedSize);
+    default:
+        return -1;
+    }
+}
+
+bool ModbusDecoder::next(ModbusFrame& frame) {
+    while (buffered() > 0) {
+        const uint8_t* p = buffer_.data() + head_;
+        size_t available = buffered();
+        if (framing_ == MODBUS_TCP) {
+            if (available < kMbapSize) {
+                return false;
+            }
+            uint16_t length = get16(p + 4);
+            if (get16(p + 2) != 0 || length < 2 || length > kMaxPduSize + 1) {
+                // TCP流上没有可靠的重新同步点，丢弃全部缓冲
+                errors_++;
+                reset();
+                return false;
+            }
+            size_t size = 6 + length;
+            if (available < size) {
+                return false;
+            }
+            frame.transaction = get16(p);
+            frame.unit = p[6];
+            frame.function = p[7];
+            frame.data.assign(p + 8, p + size);
+            drop(size);
+            return true;
+        }
+
+        int size = rtu_frame_size();
+        if (size == 0) {
+            return false;
+        }
+        if (size < 0) {
+            errors_++;
+            drop(1);
+            continue;
+        }
+        if (available < static_cast<size_t>(size)) {
+            return false;
+        }
+        uint16_t crc = static_cast<uint16_t>(p[size - 2] | (p[size - 1] << 8));
+        if (modbus_crc16(p, size - 2) != crc) {
+            errors_++;
+            drop(1);
+            continue;
+        }
+        frame.transaction = 0;
+        frame.unit = p[0];
+        frame.function = p[1];
+        frame.data.assign(p + 2, p + size - 2);
+        drop(size);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Modbus报文编解码（RTU与TCP两种帧格式）
+ *
+ * 只实现电表采集用到的功能码：03/04读寄存器、05写单个线圈、06写单个寄存器及异常响应。
+ * RTU帧：单元地址 + PDU + CRC16（低字节在前）；帧长由功能码推算，不依赖字符间隔。
+ * TCP帧：MBAP头（事务ID、协议ID 0、长度、单元ID）+ PDU，事务ID用于请求流水线时匹配响应。
+ * 解码器按字节流增量解析，半帧留到下次；RTU的CRC错误或无法识别的功能码丢弃一个字节后重新同步。
+ */
+enum ModbusFraming {
+    MODBUS_RTU = 0,
+    MODBUS_TCP = 1,
+};
+
+enum ModbusFunction {
+    MODBUS_READ_HOLDING = 0x03,
+    MODBUS_READ_INPUT = 0x04,
+    MODBUS_WRITE_COIL = 0x05,
+    MODBUS_WRITE_REGISTER = 0x06,
+};
+
+enum ModbusException {
+    MODBUS_ILLEGAL_FUNCTION = 0x01,
+    MODBUS_ILLEGAL_ADDRESS = 0x02,
+    MODBUS_ILLEGAL_VALUE = 0x03,
+    MODBUS_DEVICE_FAILURE = 0x04,
+};
+
+// 单元地址：0为广播（所有从站执行且不应答），从站可用1-247
+const uint8_t MODBUS_BROADCAST_UNIT = 0;
+const uint8_t MODBUS_MAX_UNIT = 247;
+
+// 一帧请求或响应
+struct ModbusFrame {
+    uint16_t transaction = 0;   // 仅TCP
+    uint8_t unit = 0;
+    uint8_t function = 0;       // 异常响应为功能码 | 0x80
+    std::vector<uint8_t> data;  // PDU中功能码之后的部分
+
+    bool is_exception() const { return (function & 0x80) != 0; }
+    uint8_t exception_code() const { return data.empty() ? 0 : data[0]; }
+};
+
+uint16_t modbus_crc16(const uint8_t* data, size_t size);
+
+// 编码一帧并追加到out
+void modbus_encode(ModbusFraming framing, const ModbusFrame& frame, std::vector<uint8_t>& out);
+
+// 请求
+ModbusFrame modbus_read_request(uint8_t unit, uint8_t function, uint16_t address, uint16_t count);
+ModbusFrame modbus_write_coil_request(uint8_t unit, uint16_t address, bool on);
+ModbusFrame modbus_write_register_request(uint8_t unit, uint16_t address, uint16_t value);
+
+// 响应
+ModbusFrame modbus_registers_response(const ModbusFrame& request, const uint16_t* registers, uint16_t count);
+ModbusFrame modbus_exception_response(const ModbusFrame& request, uint8_t code);
+
+// 从03/04请求或写请求中取地址与数量（写请求的第二个字为写入值）
+bool modbus_request_fields(const ModbusFrame& request, uint16_t& address, uint16_t& value);
+// 从03/04响应中取count个寄存器，字节数不符返回false
+bool modbus_response_registers(const ModbusFrame& response, uint16_t count, uint16_t* registers);
+
+// IEEE754单精度与两个寄存器互转，高字在前（ABCD）
+float modbus_registers_to_float(const uint16_t* registers);
+void modbus_float_to_registers(float value, uint16_t* registers);
+
+/**
+ * @brief 字节流解码器
+ *
+ * requests为true时按请求格式推算RTU帧长（从站一侧），否则按响应格式（主站一侧）。
+ */
+class ModbusDecoder {
+public:
+    ModbusDecoder(ModbusFraming framing, bool requests);
+
+    void feed(const uint8_t* data, size_t size);
+    // 取出下一个完整帧，没有完整帧时返回false
+    bool next(ModbusFrame& frame);
+    // 丢弃未解析的字节（超时后重新同步）
+    void reset();
+
+    size_t buffered() const { return buffer_.size() - head_; }
+    uint64_t errors() const { return errors_; }  // 丢弃的坏帧
+
+private:
+    // 当前位置的RTU帧长，字节不足时返回0，无法识别返回-1
+    int rtu_frame_size() const;
+    void drop(size_t size);
+
+    const ModbusFraming framing_;
+    const bool requests_;
+    std::vector<uint8_t> buffer_;
+    size_t head_;
+    uint64_t errors_;
+};
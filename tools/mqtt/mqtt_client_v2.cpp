@@ -5,16 +5,49 @@
 #include <fcntl.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <poll.h>
 #include <errno.h>
 #include <algorithm>
+#include <ctime>
+
+namespace {
+
+// 同步出错时的重试间隔，避免在失效的socket上空转
+const int kErrorRetryMs = 100;
+
+// RFC 8305 推荐的相邻连接尝试间隔
+const std::chrono::milliseconds kConnectAttemptDelay(250);
+// DNS解析结果缓存有效期
+const std::chrono::seconds kResolverCacheTtl(60);
+
+// 距离截止时间的剩余毫秒数，供poll使用（-1表示无限等待）
+int remaining_ms(std::chrono::steady_clock::time_point deadline) {
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+        return -1;
+    }
+    auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+        deadline - std::chrono::steady_clock::now()).count();
+    return left > 0 ? static_cast<int>(left) + 1 : 0;
+}
+
+} // namespace
 
 // 构造函数
 MQTTClientV2::MQTTClientV2(const std::string& broker_address, int port)
     : broker_address_(broker_address), port_(port), socket_fd_(-1), 
       connected_(false), connecting_(false), auto_reconnect_(false),
-      reconnect_attempts_(0), max_reconnect_attempts_(-1),
+      reconnect_attempts_(0), max_reconnect_attempts_(-1), wakeups_(0),
       error_code_(0), response_timeout_(30) {
     
+    // 唤醒管道：publish等操作写入一个字节，refresher线程立即处理
+    wake_pipe_[0] = wake_pipe_[1] = -1;
+    if (pipe(wake_pipe_) == 0) {
+        for (int fd : wake_pipe_) {
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+            fcntl(fd, F_SETFD, FD_CLOEXEC);
+        }
+    }
+    
     // 初始化MQTT客户端 - 使用-1作为socketfd，因为我们还没有连接
     mqtt_init(&client_, 
               -1,  // socketfd
@@ -34,12 +67,18 @@ MQTTClientV2::~MQTTClientV2() {
     stop_auto_reconnect();
     disconnect();
     
+    if (connect_thread_.joinable()) {
+        connect_thread_.join();
+    }
     if (reconnect_thread_.joinable()) {
         reconnect_thread_.join();
     }
     if (sync_thread_.joinable()) {
         sync_thread_.join();
     }
+    for (int fd : wake_pipe_) {
+        if (fd >= 0) close(fd);
+    }
 }
 
 // 移动构造函数
@@ -53,6 +92,7 @@ MQTTClientV2::MQTTClientV2(MQTTClientV2&& other) noexcept
     , auto_reconnect_(other.auto_reconnect_.load())
     , reconnect_attempts_(other.reconnect_attempts_.load())
     , max_reconnect_attempts_(other.max_reconnect_attempts_.load())
+    , wakeups_(other.wakeups_.load())
     , message_callback_(std::move(other.message_callback_))
     , connect_callback_(std::move(other.connect_callback_))
     , disconnect_callback_(std::move(other.disconnect_callback_))
@@ -65,11 +105,15 @@ MQTTClientV2::MQTTClientV2(MQTTClientV2&& other) noexcept
     , reconnect_interval_(other.reconnect_interval_)
     , response_timeout_(other.response_timeout_) {
     
+    wake_pipe_[0] = other.wake_pipe_[0];
+    wake_pipe_[1] = other.wake_pipe_[1];
+    
     // 重置other的状态
     other.socket_fd_ = -1;
     other.connected_ = false;
     other.connecting_ = false;
     other.auto_reconnect_ = false;
+    other.wake_pipe_[0] = other.wake_pipe_[1] = -1;
     
     // 更新回调状态指针
     client_.publish_response_callback_state = this;
@@ -103,6 +147,9 @@ MQTTClientV2& MQTTClientV2::operator=(MQTTClientV2&& other) noexcept {
         error_code_ = other.error_code_;
         reconnect_interval_ = other.reconnect_interval_;
         response_timeout_ = other.response_timeout_;
+        wakeups_ = other.wakeups_.load();
+        std::swap(wake_pipe_[0], other.wake_pipe_[0]);
+        std::swap(wake_pipe_[1], other.wake_pipe_[1]);
         
         // 重置other的状态
         other.socket_fd_ = -1;
@@ -118,8 +165,20 @@ MQTTClientV2& MQTTClientV2::operator=(MQTTClientV2&& other) noexcept {
 
 // 连接服务器
 bool MQTTClientV2::connect(const ConnectionOptions& options) {
+    if (!begin_connect()) {
+        return false;
+    }
+    if (!run_connect(options)) {
+        connecting_ = false;
+        return false;
+    }
+    return true;
+}
+
+// 检查与置位在同一把锁下完成，并发的连接请求只有一个能通过
+bool MQTTClientV2::begin_connect() {
     std::lock_guard<std::mutex> lock(mutex_);
-    
+
     if (connected_ || connecting_) {
         set_error("Already connected or connecting");
         return false;
@@ -127,17 +186,26 @@ bool MQTTClientV2::connect(const ConnectionOptions& options) {
 
     connecting_ = true;
     clear_error_state();
-    
-    // 创建Socket
-    socket_fd_ = create_socket();
-    if (socket_fd_ < 0) {
-        connecting_ = false;
+    return true;
+}
+
+bool MQTTClientV2::run_connect(const ConnectionOptions& options) {
+    // DNS解析与TCP握手不持有mutex_，避免失效的代理地址阻塞其他接口
+    auto deadline = std::chrono::steady_clock::time_point::max();
+    if (options.connect_timeout > 0) {
+        deadline = std::chrono::steady_clock::now() + std::chrono::seconds(options.connect_timeout);
+    }
+    int sockfd = create_socket(deadline);
+    if (sockfd < 0) {
         return false;
     }
 
+    std::lock_guard<std::mutex> lock(mutex_);
+    close_socket();
+    socket_fd_ = sockfd;
+
     // 初始化MQTT客户端
     if (!initialize_client()) {
-        connecting_ = false;
         return false;
     }
 
@@ -166,7 +234,6 @@ bool MQTTClientV2::connect(const ConnectionOptions& options) {
     
     // 检查连接错误
     if (client_.error != MQTT_OK) {
-        connecting_ = false;
         set_error("Failed to send connect packet: " + std::string(mqtt_error_str(client_.error)));
         return false;
     }
@@ -180,6 +247,7 @@ bool MQTTClientV2::connect(const ConnectionOptions& options) {
     // 等待连接完成
     connecting_ = false;
     connected_ = true;
+    connect_cv_.notify_all();
     
     if (connect_callback_) {
         connect_callback_(true, "Connected successfully");
@@ -188,15 +256,30 @@ bool MQTTClientV2::connect(const ConnectionOptions& options) {
     return true;
 }
 
-// 异步连接
+// 异步连接：解析与握手在独立的连接线程中完成，调用方立即返回
 bool MQTTClientV2::connect_async(const ConnectionOptions& options) {
     std::lock_guard<std::mutex> lock(async_queue_mutex_);
-    
-    AsyncOperation op;
-    op.type = AsyncOperation::CONNECT;
-    op.conn_options = options;
-    async_queue_.push(op);
-    
+
+    // 在调用线程上置connecting_：连接进行中的重复调用直接返回false，不等待、不回调
+    if (!begin_connect()) {
+        return false;
+    }
+
+    // 上一次尝试已清除connecting_，其线程至多还在执行失败回调，回收不会等待连接超时
+    if (connect_thread_.joinable()) {
+        connect_thread_.join();
+    }
+    connect_thread_ = std::thread([this, options] {
+        if (!run_connect(options)) {
+            // 先取出原因再清除connecting_，之后新的连接尝试会清空错误状态
+            std::string error = get_last_error();
+            connecting_ = false;
+            if (connect_callback_) {
+                connect_callback_(false, error);
+            }
+        }
+    });
+
     return true;
 }
 
@@ -214,6 +297,7 @@ void MQTTClientV2::disconnect() {
     }
     
     close_socket();
+    wake_refresher();
 }
 
 // 检查连接状态
@@ -250,6 +334,7 @@ bool MQTTClientV2::publish(const std::string& topic, const std::string& payload,
         return false;
     }
     
+    wake_refresher();
     return true;
 }
 
@@ -270,6 +355,12 @@ bool MQTTClientV2::publish_async(const std::string& topic, const std::string& pa
 
 // 订阅主题
 bool MQTTClientV2::subscribe(const std::string& topic, const SubscribeOptions& options) {
+    return subscribe(topic, options, nullptr);
+}
+
+// 订阅主题，并为匹配该过滤器的消息注册专属处理函数
+bool MQTTClientV2::subscribe(const std::string& topic, const SubscribeOptions& options,
+                             MessageCallback handler) {
     std::lock_guard<std::mutex> lock(mutex_);
     
     if (!connected_) {
@@ -285,11 +376,9 @@ bool MQTTClientV2::subscribe(const std::string& topic, const SubscribeOptions& o
     }
     
     // 记录订阅
-    {
-        std::lock_guard<std::mutex> sub_lock(subscriptions_mutex_);
-        subscriptions_[topic] = options.qos;
-    }
+    subscriptions_.add(topic, options.qos, std::move(handler));
     
+    wake_refresher();
     return true;
 }
 
@@ -323,11 +412,9 @@ bool MQTTClientV2::unsubscribe(const std::string& topic) {
     }
     
     // 移除订阅记录
-    {
-        std::lock_guard<std::mutex> sub_lock(subscriptions_mutex_);
-        subscriptions_.erase(topic);
-    }
+    subscriptions_.remove(topic);
     
+    wake_refresher();
     return true;
 }
 
@@ -345,15 +432,7 @@ bool MQTTClientV2::unsubscribe_async(const std::string& topic) {
 
 // 获取订阅主题列表
 std::vector<std::string> MQTTClientV2::get_subscribed_topics() const {
-    std::lock_guard<std::mutex> lock(subscriptions_mutex_);
-    std::vector<std::string> topics;
-    topics.reserve(subscriptions_.size());
-    
-    for (const auto& pair : subscriptions_) {
-        topics.push_back(pair.first);
-    }
-    
-    return topics;
+    return subscriptions_.topics();
 }
 
 // 设置回调函数
@@ -470,15 +549,31 @@ int MQTTClientV2::get_response_timeout() const {
     return response_timeout_;
 }
 
+// 获取网络线程唤醒次数
+uint64_t MQTTClientV2::get_wakeup_count() const noexcept {
+    return wakeups_.load(std::memory_order_relaxed);
+}
+
 // MQTT-C 回调适配器
 void MQTTClientV2::on_message(void** state, struct mqtt_response_publish* msg) {
     MQTTClientV2* self = static_cast<MQTTClientV2*>(*state);
-    if (!self || !self->message_callback_) return;
+    if (!self) return;
     
     std::string topic(static_cast<const char*>(msg->topic_name), msg->topic_name_size);
     std::string payload(static_cast<const char*>(msg->application_message), msg->application_message_size);
     
-    self->message_callback_(topic, payload, msg->qos_level, msg->retain_flag);
+    // 分发给匹配的订阅处理函数（无锁读取快照）
+    SubscriptionRegistry::Snapshot subscriptions = self->subscriptions_.snapshot();
+    for (const auto& subscription : *subscriptions) {
+        if (subscription.second.handler &&
+            SubscriptionRegistry::topic_matches(subscription.first, topic)) {
+            subscription.second.handler(topic, payload, msg->qos_level, msg->retain_flag);
+        }
+    }
+    
+    if (self->message_callback_) {
+        self->message_callback_(topic, payload, msg->qos_level, msg->retain_flag);
+    }
 }
 
 void MQTTClientV2::on_connect(void** state, struct mqtt_response_connack* connack) {
@@ -497,8 +592,9 @@ void MQTTClientV2::on_connect(void** state, struct mqtt_response_connack* connac
         self->connect_cv_.notify_all();
         
         // 重新订阅之前的主题
-        for (const auto& subscription : self->subscriptions_) {
-            mqtt_subscribe(&self->client_, subscription.first.c_str(), subscription.second);
+        SubscriptionRegistry::Snapshot subscriptions = self->subscriptions_.snapshot();
+        for (const auto& subscription : *subscriptions) {
+            mqtt_subscribe(&self->client_, subscription.first.c_str(), subscription.second.qos);
         }
     } else {
         self->connected_ = false;
@@ -608,45 +704,194 @@ void MQTTClientV2::handle_reconnect() {
     }
 }
 
-// 创建Socket
-int MQTTClientV2::create_socket() {
-    struct addrinfo hints;
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family = AF_UNSPEC; /* IPv4 or IPv6 */
-    hints.ai_socktype = SOCK_STREAM; /* Must be TCP */
-    
-    int sockfd = -1;
-    int rv;
-    struct addrinfo *p, *servinfo;
+// 解析代理地址，结果缓存kResolverCacheTtl
+bool MQTTClientV2::resolve_broker(std::vector<ResolvedAddress>& addresses,
+                                  std::chrono::steady_clock::time_point deadline) {
+    {
+        std::lock_guard<std::mutex> lock(resolver_mutex_);
+        if (!resolved_addresses_.empty() &&
+            std::chrono::steady_clock::now() - resolved_at_ < kResolverCacheTtl) {
+            addresses = resolved_addresses_;
+            return true;
+        }
+    }
+
+    // getaddrinfo无法取消，放在解析线程中执行；超时后由解析线程自行释放结果
+    struct ResolveJob {
+        std::mutex mutex;
+        std::condition_variable cv;
+        bool done = false;
+        int rv = 0;
+        std::vector<ResolvedAddress> addresses;
+    };
+    auto job = std::make_shared<ResolveJob>();
+    std::string host = broker_address_;
+    std::string service = std::to_string(port_);
+
+    std::thread([job, host, service] {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC; /* IPv4 or IPv6 */
+        hints.ai_socktype = SOCK_STREAM; /* Must be TCP */
+
+        struct addrinfo *p, *servinfo = nullptr;
+        std::vector<ResolvedAddress> result;
+        int rv = getaddrinfo(host.c_str(), service.c_str(), &hints, &servinfo);
+        if (rv == 0) {
+            for (p = servinfo; p != NULL; p = p->ai_next) {
+                ResolvedAddress addr;
+                addr.family = p->ai_family;
+                addr.socktype = p->ai_socktype;
+                addr.protocol = p->ai_protocol;
+                addr.addrlen = p->ai_addrlen;
+                memcpy(&addr.addr, p->ai_addr, p->ai_addrlen);
+                result.push_back(addr);
+            }
+            freeaddrinfo(servinfo);
+        }
+
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->rv = rv;
+        job->addresses = std::move(result);
+        job->done = true;
+        job->cv.notify_all();
+    }).detach();
+
+    std::unique_lock<std::mutex> lock(job->mutex);
+    if (deadline == std::chrono::steady_clock::time_point::max()) {
+        job->cv.wait(lock, [&job] { return job->done; });
+    } else if (!job->cv.wait_until(lock, deadline, [&job] { return job->done; })) {
+        set_error("Failed to open socket (getaddrinfo): timeout");
+        return false;
+    }
+
+    if (job->rv != 0) {
+        set_error("Failed to open socket (getaddrinfo): " + std::string(gai_strerror(job->rv)));
+        return false;
+    }
+    if (job->addresses.empty()) {
+        set_error("Failed to open socket (getaddrinfo): no address");
+        return false;
+    }
+
+    addresses = job->addresses;
+    std::lock_guard<std::mutex> cache_lock(resolver_mutex_);
+    resolved_addresses_ = std::move(job->addresses);
+    resolved_at_ = std::chrono::steady_clock::now();
+    return true;
+}
+
+// 清除DNS缓存，下次连接重新解析
+void MQTTClientV2::invalidate_resolver_cache() {
+    std::lock_guard<std::mutex> lock(resolver_mutex_);
+    resolved_addresses_.clear();
+}
 
-    /* get address information */
-    rv = getaddrinfo(broker_address_.c_str(), std::to_string(port_).c_str(), &hints, &servinfo);
-    if(rv != 0) {
-        set_error("Failed to open socket (getaddrinfo): " + std::string(gai_strerror(rv)));
+// 创建Socket：非阻塞connect，按Happy Eyeballs(RFC 8305)在多个地址间竞速
+int MQTTClientV2::create_socket(std::chrono::steady_clock::time_point deadline) {
+    std::vector<ResolvedAddress> resolved;
+    if (!resolve_broker(resolved, deadline)) {
         return -1;
     }
 
-    /* open the first possible socket */
-    for(p = servinfo; p != NULL; p = p->ai_next) {
-        sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
-        if (sockfd == -1) continue;
+    /* 按地址族交替排列，首个返回的地址族优先 */
+    std::vector<ResolvedAddress> preferred, others;
+    for (const auto& addr : resolved) {
+        (addr.family == resolved.front().family ? preferred : others).push_back(addr);
+    }
+    std::vector<ResolvedAddress> candidates;
+    for (size_t i = 0; i < preferred.size() || i < others.size(); i++) {
+        if (i < preferred.size()) candidates.push_back(preferred[i]);
+        if (i < others.size()) candidates.push_back(others[i]);
+    }
+
+    std::vector<struct pollfd> pending;
+    size_t next = 0;
+    int sockfd = -1;
+    int last_errno = 0;
+    auto next_attempt_at = std::chrono::steady_clock::now();
+
+    while (sockfd < 0) {
+        auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            last_errno = ETIMEDOUT;
+            break;
+        }
+
+        /* 没有进行中的尝试，或上一个尝试已超过间隔，则发起下一个 */
+        if (next < candidates.size() && (pending.empty() || now >= next_attempt_at)) {
+            const ResolvedAddress& addr = candidates[next++];
+            int fd = socket(addr.family, addr.socktype, addr.protocol);
+            if (fd == -1) {
+                last_errno = errno;
+                continue;
+            }
+            fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
 
-        /* connect to server */
-        rv = ::connect(sockfd, p->ai_addr, p->ai_addrlen);
-        if(rv == -1) {
-            close(sockfd);
-            sockfd = -1;
+            int rv = ::connect(fd, reinterpret_cast<const struct sockaddr*>(&addr.addr), addr.addrlen);
+            if (rv == 0) {
+                sockfd = fd;
+                break;
+            }
+            if (errno != EINPROGRESS) {
+                last_errno = errno;
+                close(fd);
+                continue;
+            }
+            struct pollfd pfd;
+            pfd.fd = fd;
+            pfd.events = POLLOUT;
+            pfd.revents = 0;
+            pending.push_back(pfd);
+            next_attempt_at = now + kConnectAttemptDelay;
             continue;
         }
-        break;
-    }  
 
-    /* free servinfo */
-    freeaddrinfo(servinfo);
+        if (pending.empty()) {
+            break;  /* 所有地址均已失败 */
+        }
+
+        auto wake = deadline;
+        if (next < candidates.size()) {
+            wake = std::min(wake, next_attempt_at);
+        }
+        int rc = poll(pending.data(), pending.size(), remaining_ms(wake));
+        if (rc < 0) {
+            if (errno == EINTR) continue;
+            last_errno = errno;
+            break;
+        }
+
+        for (auto it = pending.begin(); it != pending.end();) {
+            if (it->revents == 0) {
+                ++it;
+                continue;
+            }
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(it->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err == 0 && (it->revents & POLLOUT)) {
+                sockfd = it->fd;
+                it = pending.erase(it);
+                break;
+            }
+            /* 失败的尝试立即让位给下一个地址 */
+            last_errno = err != 0 ? err : ECONNREFUSED;
+            close(it->fd);
+            it = pending.erase(it);
+            next_attempt_at = now;
+        }
+    }
+
+    /* 关闭竞速失败的连接 */
+    for (const auto& pfd : pending) {
+        close(pfd.fd);
+    }
 
-    /* make non-blocking */
-    if (sockfd != -1) {
-        fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL) | O_NONBLOCK);
+    if (sockfd < 0) {
+        invalidate_resolver_cache();
+        set_error("Failed to open socket (connect): " + std::string(strerror(last_errno)),
+                  last_errno);
     }
 
     return sockfd;
@@ -719,10 +964,76 @@ bool MQTTClientV2::is_socket_valid() const {
     return socket_fd_ >= 0;
 }
 
-// Client refresher线程（参考官网例子）
+// Client refresher线程
+// 空闲时只在socket可读、有待发送数据（唤醒管道）或保活/重传截止时间到达时醒来
 void MQTTClientV2::client_refresher() {
     while (connected_ || connecting_) {
-        mqtt_sync(&client_);
-        usleep(100000U); // 100ms，参考官网例子
+        bool sync_ok = mqtt_sync(&client_) == MQTT_OK;
+        wait_for_activity(sync_ok);
+        wakeups_.fetch_add(1, std::memory_order_relaxed);
     }
-}
\ No newline at end of file
+}
+
+// 等待下一次需要处理网络的时刻
+void MQTTClientV2::wait_for_activity(bool sync_ok) {
+    struct pollfd fds[2];
+    nfds_t count = 0;
+    fds[count].fd = wake_pipe_[0];
+    fds[count].events = POLLIN;
+    fds[count].revents = 0;
+    count++;
+
+    // 同步出错时socket可能持续处于HUP/ERR状态，只等待唤醒或短暂退避
+    int timeout_ms = kErrorRetryMs;
+    if (sync_ok && socket_fd_ >= 0) {
+        fds[count].fd = socket_fd_;
+        // 发送缓冲区满（EAGAIN）时报文留在MQTT-C队列中，socket可写后立即重新同步
+        fds[count].events = has_unsent() ? (POLLIN | POLLOUT) : POLLIN;
+        fds[count].revents = 0;
+        count++;
+        timeout_ms = idle_timeout_ms();
+    }
+
+    if (poll(fds, count, timeout_ms) > 0 && (fds[0].revents & POLLIN)) {
+        char buf[64];
+        while (read(wake_pipe_[0], buf, sizeof(buf)) > 0) {
+        }
+    }
+}
+
+// MQTT-C队列中是否还有未发出的报文
+bool MQTTClientV2::has_unsent() {
+    bool unsent = false;
+    MQTT_PAL_MUTEX_LOCK(&client_.mutex);
+    size_t length = mqtt_mq_length(&client_.mq);
+    for (size_t i = 0; i < length && !unsent; i++) {
+        unsent = mqtt_mq_get(&client_.mq, i)->state == MQTT_QUEUED_UNSENT;
+    }
+    MQTT_PAL_MUTEX_UNLOCK(&client_.mutex);
+    return unsent;
+}
+
+// 空闲等待上限：下一次PINGREQ截止时间与QoS重传超时中较早者
+int MQTTClientV2::idle_timeout_ms() {
+    long wait_s = response_timeout_ > 0 ? response_timeout_ : 30;
+    // time_of_last_send由MQTT-C在发送时（publish/sync）于client_.mutex下更新
+    MQTT_PAL_MUTEX_LOCK(&client_.mutex);
+    uint16_t keep_alive = client_.keep_alive;
+    time_t last_send = client_.time_of_last_send;
+    MQTT_PAL_MUTEX_UNLOCK(&client_.mutex);
+    if (keep_alive > 0) {
+        // MQTT-C 在 now > time_of_last_send + keep_alive 时发送PINGREQ
+        long until_ping = static_cast<long>(last_send + keep_alive + 1 - time(nullptr));
+        wait_s = std::min(wait_s, std::max(until_ping, 1L));
+    }
+    return static_cast<int>(wait_s * 1000);
+}
+
+// 唤醒refresher线程
+void MQTTClientV2::wake_refresher() {
+    if (wake_pipe_[1] >= 0) {
+        char c = 1;
+        ssize_t n = write(wake_pipe_[1], &c, 1);
+        (void)n;
+    }
+}
@@ -13,6 +13,8 @@
 #include <condition_variable>
 #include <queue>
 #include <future>
+#include <sys/socket.h>
+#include "subscription_registry.hpp"
 
 /**
  * @brief 改进的MQTT客户端类，支持C++14语法
@@ -105,6 +107,7 @@ public:
     
     // 主题订阅与取消订阅
     bool subscribe(const std::string& topic, const SubscribeOptions& options = SubscribeOptions());
+    bool subscribe(const std::string& topic, const SubscribeOptions& options, MessageCallback handler);
     bool subscribe_async(const std::string& topic, const SubscribeOptions& options = SubscribeOptions());
     bool unsubscribe(const std::string& topic);
     bool unsubscribe_async(const std::string& topic);
@@ -141,6 +144,9 @@ public:
     void set_response_timeout(int seconds);
     int get_response_timeout() const;
 
+    // 网络线程唤醒次数（用于评估空闲功耗）
+    uint64_t get_wakeup_count() const noexcept;
+
 private:
     // MQTT-C 回调适配器
     static void on_message(void** state, struct mqtt_response_publish* msg);
@@ -154,8 +160,24 @@ private:
     bool attempt_reconnect();
     void handle_reconnect();
     
+    // 解析得到的候选地址（DNS缓存与Happy Eyeballs使用）
+    struct ResolvedAddress {
+        int family;
+        int socktype;
+        int protocol;
+        struct sockaddr_storage addr;
+        socklen_t addrlen;
+    };
+
+    // 连接：begin_connect在mutex_下检查并置connecting_，run_connect完成连接，失败时由调用方清除connecting_
+    bool begin_connect();
+    bool run_connect(const ConnectionOptions& options);
+
     // 网络操作
-    int create_socket();
+    bool resolve_broker(std::vector<ResolvedAddress>& addresses,
+                        std::chrono::steady_clock::time_point deadline);
+    void invalidate_resolver_cache();
+    int create_socket(std::chrono::steady_clock::time_point deadline);
     void close_socket();
     bool initialize_client();
     
@@ -167,6 +189,10 @@ private:
     
     // Client refresher线程
     void client_refresher();
+    void wait_for_activity(bool sync_ok);
+    int idle_timeout_ms();
+    bool has_unsent();
+    void wake_refresher();
     
     // 成员变量
     std::string broker_address_;
@@ -189,7 +215,10 @@ private:
     mutable std::mutex mutex_;
     std::thread reconnect_thread_;
     std::thread sync_thread_;
+    std::thread connect_thread_;
     std::condition_variable connect_cv_;
+    int wake_pipe_[2];                  // 唤醒refresher线程（有待发数据或断开）
+    std::atomic<uint64_t> wakeups_;
     
     // 回调函数
     MessageCallback message_callback_;
@@ -199,9 +228,8 @@ private:
     PublishCallback publish_callback_;
     ErrorCallback error_callback_;
     
-    // 订阅管理
-    std::unordered_map<std::string, uint8_t> subscriptions_;
-    mutable std::mutex subscriptions_mutex_;
+    // 订阅管理（写时复制，分发与重新订阅无锁读取）
+    SubscriptionRegistry subscriptions_;
     
     // 错误处理
     std::string last_error_;
@@ -211,6 +239,11 @@ private:
     // 重连配置
     std::chrono::milliseconds reconnect_interval_;
     
+    // DNS解析缓存
+    std::vector<ResolvedAddress> resolved_addresses_;
+    std::chrono::steady_clock::time_point resolved_at_;
+    std::mutex resolver_mutex_;
+    
     // 异步操作队列
     struct AsyncOperation {
         enum Type { CONNECT, PUBLISH, SUBSCRIBE, UNSUBSCRIBE } type;
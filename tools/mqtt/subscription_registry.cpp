@@ -0,0 +1,108 @@
+#include "subscription_registry.hpp"
+
+SubscriptionRegistry::SubscriptionRegistry()
+    : current_(std::make_shared<const Map>()) {
+}
+
+SubscriptionRegistry::SubscriptionRegistry(SubscriptionRegistry&& other) noexcept
+    : current_(std::make_shared<const Map>()) {
+    std::lock_guard<std::mutex> lock(other.write_mutex_);
+    publish(std::atomic_exchange(&other.current_, std::make_shared<const Map>()));
+}
+
+SubscriptionRegistry& SubscriptionRegistry::operator=(SubscriptionRegistry&& other) noexcept {
+    if (this != &other) {
+        std::lock(write_mutex_, other.write_mutex_);
+        std::lock_guard<std::mutex> lock(write_mutex_, std::adopt_lock);
+        std::lock_guard<std::mutex> other_lock(other.write_mutex_, std::adopt_lock);
+        publish(std::atomic_exchange(&other.current_, std::make_shared<const Map>()));
+    }
+    return *this;
+}
+
+// 添加或更新订阅
+void SubscriptionRegistry::add(const std::string& filter, uint8_t qos, MessageHandler handler) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    auto next = std::make_shared<Map>(*std::atomic_load(&current_));
+    Entry& entry = (*next)[filter];
+    entry.qos = qos;
+    entry.handler = std::move(handler);
+    publish(std::move(next));
+}
+
+// 移除订阅，不存在时返回false
+bool SubscriptionRegistry::remove(const std::string& filter) {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    Snapshot current = std::atomic_load(&current_);
+    if (current->find(filter) == current->end()) {
+        return false;
+    }
+    auto next = std::make_shared<Map>(*current);
+    next->erase(filter);
+    publish(std::move(next));
+    return true;
+}
+
+// 清空所有订阅
+void SubscriptionRegistry::clear() {
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    publish(std::make_shared<const Map>());
+}
+
+// 获取当前快照
+SubscriptionRegistry::Snapshot SubscriptionRegistry::snapshot() const {
+    return std::atomic_load(&current_);
+}
+
+bool SubscriptionRegistry::contains(const std::string& filter) const {
+    Snapshot current = snapshot();
+    return current->find(filter) != current->end();
+}
+
+size_t SubscriptionRegistry::size() const {
+    return snapshot()->size();
+}
+
+std::vector<std::string> SubscriptionRegistry::topics() const {
+    Snapshot current = snapshot();
+    std::vector<std::string> result;
+    result.reserve(current->size());
+    for (const auto& pair : *current) {
+        result.push_back(pair.first);
+    }
+    return result;
+}
+
+// 主题过滤器匹配：逐级比较，+ 匹配单级，# 匹配剩余所有级
+bool SubscriptionRegistry::topic_matches(const std::string& filter, const std::string& topic) {
+    size_t f = 0, t = 0;
+    while (f < filter.size()) {
+        size_t f_end = filter.find('/', f);
+        if (f_end == std::string::npos) f_end = filter.size();
+
+        if (filter.compare(f, f_end - f, "#") == 0) {
+            return true;
+        }
+        if (t > topic.size()) {
+            return false;
+        }
+
+        size_t t_end = topic.find('/', t);
+        if (t_end == std::string::npos) t_end = topic.size();
+
+        if (filter.compare(f, f_end - f, "+") != 0 &&
+            filter.compare(f, f_end - f, topic, t, t_end - t) != 0) {
+            return false;
+        }
+
+        f = f_end + 1;
+        t = t_end + 1;
+    }
+    // 过滤器与主题同时结束才算匹配
+    return f == filter.size() + 1 && t == topic.size() + 1;
+}
+
+// 原子发布新快照（调用方持有write_mutex_）
+void SubscriptionRegistry::publish(Snapshot next) {
+    std::atomic_store(&current_, std::move(next));
+}
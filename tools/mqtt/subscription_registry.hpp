@@ -0,0 +1,58 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <memory>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <cstdint>
+
+/**
+ * @brief 订阅注册表（写时复制快照）
+ *
+ * 读多写少：订阅/取消订阅在写锁内复制当前表、修改后原子发布新快照，
+ * 保证写操作可线性化；消息分发与重连后的重新订阅只原子加载快照，
+ * 不获取任何锁，读到的快照在其生命周期内不会被修改。
+ */
+class SubscriptionRegistry {
+public:
+    using MessageHandler = std::function<void(const std::string& topic, const std::string& payload, uint8_t qos, bool retain)>;
+
+    // 单条订阅
+    struct Entry {
+        uint8_t qos;
+        MessageHandler handler;  // 可为空，仅使用全局消息回调
+    };
+
+    using Map = std::unordered_map<std::string, Entry>;
+    using Snapshot = std::shared_ptr<const Map>;
+
+    SubscriptionRegistry();
+
+    // 禁用拷贝，允许移动
+    SubscriptionRegistry(const SubscriptionRegistry&) = delete;
+    SubscriptionRegistry& operator=(const SubscriptionRegistry&) = delete;
+    SubscriptionRegistry(SubscriptionRegistry&& other) noexcept;
+    SubscriptionRegistry& operator=(SubscriptionRegistry&& other) noexcept;
+
+    // 写操作（串行化）
+    void add(const std::string& filter, uint8_t qos, MessageHandler handler = nullptr);
+    bool remove(const std::string& filter);
+    void clear();
+
+    // 读操作（无锁）
+    Snapshot snapshot() const;
+    bool contains(const std::string& filter) const;
+    size_t size() const;
+    std::vector<std::string> topics() const;
+
+    // MQTT主题过滤器匹配（支持 + 与 # 通配符）
+    static bool topic_matches(const std::string& filter, const std::string& topic);
+
+private:
+    void publish(Snapshot next);
+
+    Snapshot current_;
+    std::mutex write_mutex_;
+};
@@ -0,0 +1,374 @@
+#include "trace.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+namespace {
+
+const char kBinaryMagic[8] = {'C', 'S', 'T', 'R', 'A', 'C', 'E', '1'};
+
+// 环形缓冲区槽位：seq = 2n+1 表示第n条正在写入，2n+2 表示第n条已写完
+struct Slot {
+    std::atomic<uint64_t> seq{0};
+    std::atomic<uint64_t> begin_ns{0};
+    std::atomic<uint64_t> dur_ns{0};
+    std::atomic<uint64_t> id{0};
+    std::atomic<const char*> name{nullptr};
+};
+
+struct ThreadRing {
+    uint32_t tid = 0;
+    std::atomic<uint64_t> head{0};  // 已写入的记录总数
+    std::atomic<bool> exited{false};
+    Slot slots[Trace::kRingCapacity];
+    std::mutex name_mutex;
+    std::string name;
+};
+
+// 线程退出后环形缓冲区仍保留在注册表中，直到下一次导出带上其记录后才释放
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+};
+
+Registry& registry() {
+    static Registry instance;
+    return instance;
+}
+
+// 线程退出时标记其环形缓冲区，交由导出释放
+struct RingOwner {
+    std::shared_ptr<ThreadRing> ring;
+    ~RingOwner() {
+        if (ring) {
+            ring->exited.store(true, std::memory_order_release);
+        }
+    }
+};
+
+std::atomic<uint64_t> g_next_id(1);
+thread_local uint64_t t_current_id = 0;
+thread_local ThreadRing* t_ring = nullptr;
+thread_local RingOwner t_ring_owner;
+thread_local std::string t_thread_name;
+
+// 首次写入记录时才分配（约160KB），跟踪关闭时线程不占用缓冲区
+ThreadRing& local_ring() {
+    if (!t_ring) {
+        std::shared_ptr<ThreadRing> ring = std::make_shared<ThreadRing>();
+        ring->tid = static_cast<uint32_t>(syscall(SYS_gettid));
+        ring->name = t_thread_name;
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.rings.push_back(ring);
+        t_ring_owner.ring = ring;
+        t_ring = ring.get();
+    }
+    return *t_ring;
+}
+
+void json_escape(FILE* f, const std::string& text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            fputc('\\', f);
+            fputc(c, f);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            fprintf(f, "\\u%04x", c);
+        } else {
+            fputc(c, f);
+        }
+    }
+}
+
+template <typename T>
+bool write_value(FILE* f, const T& value) {
+    return fwrite(&value, sizeof(T), 1, f) == 1;
+}
+
+template <typename T>
+bool read_value(FILE* f, T& value) {
+    return fread(&value, sizeof(T), 1, f) == 1;
+}
+
+bool write_string(FILE* f, const std::string& text) {
+    uint16_t size = static_cast<uint16_t>(std::min<size_t>(text.size(), 0xffff));
+    return write_value(f, size) && fwrite(text.data(), 1, size, f) == size;
+}
+
+bool read_string(FILE* f, std::string& text) {
+    uint16_t size = 0;
+    if (!read_value(f, size)) {
+        return false;
+    }
+    text.resize(size);
+    return size == 0 || fread(&text[0], 1, size, f) == size;
+}
+
+}  // namespace
+
+std::atomic<bool> Trace::enabled_(false);
+
+void Trace::set_enabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void Trace::set_thread_name(const char* name) {
+    t_thread_name = name;
+    if (t_ring) {
+        std::lock_guard<std::mutex> lock(t_ring->name_mutex);
+        t_ring->name = name;
+    }
+}
+
+uint64_t Trace::next_id() {
+    return g_next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t Trace::current_id() {
+    return t_current_id;
+}
+
+uint64_t Trace::now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::record(const char* name, uint64_t id, uint64_t begin_ns, uint64_t end_ns) {
+    ThreadRing& ring = local_ring();
+    uint64_t n = ring.head.load(std::memory_order_relaxed);
+    Slot& slot = ring.slots[n & (kRingCapacity - 1)];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    slot.dur_ns.store(end_ns - begin_ns, std::memory_order_relaxed);
+    slot.id.store(id, std::memory_order_relaxed);
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    ring.head.store(n + 1, std::memory_order_release);
+}
+
+void Trace::instant(const char* name, uint64_t id) {
+    if (!enabled()) {
+        return;
+    }
+    uint64_t now = now_ns();
+    record(name, id ? id : t_current_id, now, now);
+}
+
+Trace::Snapshot Trace::snapshot() {
+    std::vector<std::shared_ptr<ThreadRing>> rings;
+    {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        rings = reg.rings;
+    }
+
+    Snapshot result;
+    std::unordered_map<const char*, uint32_t> name_index;
+    std::vector<ThreadRing*> exited;
+    for (const auto& ring : rings) {
+        // 先确认线程已退出再读取，保证导出的是其全部记录
+        if (ring->exited.load(std::memory_order_acquire)) {
+            exited.push_back(ring.get());
+        }
+        ThreadRecords thread;
+        thread.tid = ring->tid;
+        {
+            std::lock_guard<std::mutex> lock(ring->name_mutex);
+            thread.name = ring->name;
+        }
+        uint64_t head = ring->head.load(std::memory_order_acquire);
+        uint64_t first = head > kRingCapacity ? head - kRingCapacity : 0;
+        result.overwritten += first;
+        thread.records.reserve(head - first);
+        for (uint64_t n = first; n < head; n++) {
+            const Slot& slot = ring->slots[n & (kRingCapacity - 1)];
+            uint64_t before = slot.seq.load(std::memory_order_acquire);
+            Record record;
+            record.begin_ns = slot.begin_ns.load(std::memory_order_relaxed);
+            record.dur_ns = slot.dur_ns.load(std::memory_order_relaxed);
+            record.id = slot.id.load(std::memory_order_relaxed);
+            const char* name = slot.name.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint64_t after = slot.seq.load(std::memory_order_relaxed);
+            if (before != 2 * n + 2 || after != before || !name) {
+                // 读取期间被覆盖
+                result.overwritten++;
+                continue;
+            }
+            auto it = name_index.find(name);
+            if (it == name_index.end()) {
+                it = name_index.emplace(name, static_cast<uint32_t>(result.names.size())).first;
+                result.names.push_back(name);
+            }
+            record.name = it->second;
+            thread.records.push_back(record);
+        }
+        if (!thread.records.empty()) {
+            result.threads.push_back(std::move(thread));
+        }
+    }
+    if (!exited.empty()) {
+        Registry& reg = registry();
+        std::lock_guard<std::mutex> lock(reg.mutex);
+        reg.rings.erase(std::remove_if(reg.rings.begin(), reg.rings.end(),
+                                       [&exited](const std::shared_ptr<ThreadRing>& ring) {
+                                           return std::find(exited.begin(), exited.end(), ring.get()) != exited.end();
+                                       }),
+                        reg.rings.end());
+    }
+    return result;
+}
+
+// 每条记录一个"X"事件；同一跟踪ID的记录按时间以flow事件（s/t/f）相连
+bool Trace::write_chrome_json(const Snapshot& snapshot, const std::string& path) {
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+    uint64_t base_ns = UINT64_MAX;
+    for (const auto& thread : snapshot.threads) {
+        for (const auto& record : thread.records) {
+            base_ns = std::min(base_ns, record.begin_ns);
+        }
+    }
+    if (base_ns == UINT64_MAX) {
+        base_ns = 0;
+    }
+
+    const int pid = static_cast<int>(getpid());
+    bool first = true;
+    auto separator = [&]() {
+        fputs(first ? "\n" : ",\n", f);
+        first = false;
+    };
+
+    fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", f);
+    struct FlowPoint {
+        uint64_t begin_ns;
+        uint32_t tid;
+    };
+    std::map<uint64_t, std::vector<FlowPoint>> flows;
+    for (const auto& thread : snapshot.threads) {
+        separator();
+        fprintf(f, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"",
+                pid, thread.tid);
+        json_escape(f, thread.name.empty() ? "thread-" + std::to_string(thread.tid) : thread.name);
+        fputs("\"}}", f);
+        for (const auto& record : thread.records) {
+            separator();
+            fputs("{\"ph\":\"X\",\"name\":\"", f);
+            json_escape(f, snapshot.names[record.name]);
+            fprintf(f, "\",\"cat\":\"station\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f",
+                    pid, thread.tid, (record.begin_ns - base_ns) / 1000.0, record.dur_ns / 1000.0);
+            if (record.id) {
+                fprintf(f, ",\"args\":{\"trace_id\":%llu}", static_cast<unsigned long long>(record.id));
+                flows[record.id].push_back(FlowPoint{record.begin_ns, thread.tid});
+            }
+            fputc('}', f);
+        }
+    }
+    for (auto& flow : flows) {
+        std::vector<FlowPoint>& points = flow.second;
+        if (points.size() < 2) {
+            continue;
+        }
+        std::sort(points.begin(), points.end(),
+                  [](const FlowPoint& a, const FlowPoint& b) { return a.begin_ns < b.begin_ns; });
+        for (size_t i = 0; i < points.size(); i++) {
+            const char* phase = i == 0 ? "s" : (i + 1 == points.size() ? "f" : "t");
+            separator();
+            fprintf(f, "{\"ph\":\"%s\",\"name\":\"command\",\"cat\":\"flow\",\"id\":%llu,\"pid\":%d,\"tid\":%u,\"ts\":%.3f%s}",
+                    phase, static_cast<unsigned long long>(flow.first), pid, points[i].tid,
+                    (points[i].begin_ns - base_ns) / 1000.0, i == 0 ? "" : ",\"bp\":\"e\"");
+        }
+    }
+    fputs("\n]}\n", f);
+    bool ok = !ferror(f);
+    return fclose(f) == 0 && ok;
+}
+
+// 二进制格式（小端）：
+//   magic[8] u32:name数 {u16长度 字节}... u32:线程数
+//   每线程: u32 tid, u16长度 名字, u32 记录数, 记录{u64 begin_ns, u64 dur_ns, u64 id, u32 name}...
+bool Trace::write_binary(const Snapshot& snapshot, const std::string& path) {
+    FILE* f = fopen(path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(kBinaryMagic, 1, sizeof(kBinaryMagic), f) == sizeof(kBinaryMagic);
+    ok = ok && write_value(f, static_cast<uint32_t>(snapshot.names.size()));
+    for (const auto& name : snapshot.names) {
+        ok = ok && write_string(f, name);
+    }
+    ok = ok && write_value(f, static_cast<uint32_t>(snapshot.threads.size()));
+    for (const auto& thread : snapshot.threads) {
+        ok = ok && write_value(f, thread.tid) && write_string(f, thread.name);
+        ok = ok && write_value(f, static_cast<uint32_t>(thread.records.size()));
+        for (const auto& record : thread.records) {
+            ok = ok && write_value(f, record.begin_ns) && write_value(f, record.dur_ns) &&
+                 write_value(f, record.id) && write_value(f, record.name);
+        }
+    }
+    ok = ok && !ferror(f);
+    return fclose(f) == 0 && ok;
+}
+
+bool Trace::read_binary(const std::string& path, Snapshot& snapshot) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    snapshot = Snapshot();
+    char magic[sizeof(kBinaryMagic)];
+    bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+              memcmp(magic, kBinaryMagic, sizeof(magic)) == 0;
+    uint32_t name_count = 0, thread_count = 0;
+    ok = ok && read_value(f, name_count);
+    for (uint32_t i = 0; ok && i < name_count; i++) {
+        std::string name;
+        ok = read_string(f, name);
+        snapshot.names.push_back(name);
+    }
+    ok = ok && read_value(f, thread_count);
+    for (uint32_t i = 0; ok && i < thread_count; i++) {
+        ThreadRecords thread;
+        uint32_t record_count = 0;
+        ok = read_value(f, thread.tid) && read_string(f, thread.name) && read_value(f, record_count);
+        for (uint32_t j = 0; ok && j < record_count; j++) {
+            Record record;
+            ok = read_value(f, record.begin_ns) && read_value(f, record.dur_ns) &&
+                 read_value(f, record.id) && read_value(f, record.name) && record.name < name_count;
+            thread.records.push_back(record);
+        }
+        snapshot.threads.push_back(std::move(thread));
+    }
+    fclose(f);
+    return ok;
+}
+
+TraceSpan::TraceSpan(const char* name, uint64_t id)
+    : name_(name), id_(0), parent_id_(t_current_id), begin_ns_(0) {
+    if (!name_ || !Trace::enabled()) {
+        name_ = nullptr;
+        return;
+    }
+    id_ = id ? id : parent_id_;
+    t_current_id = id_;
+    begin_ns_ = Trace::now_ns();
+}
+
+TraceSpan::~TraceSpan() {
+    if (!name_) {
+        return;
+    }
+    Trace::record(name_, id_, begin_ns_, Trace::now_ns());
+    t_current_id = parent_id_;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief 轻量级跟踪（飞行记录器）
+ *
+ * - 每个线程一个固定容量的环形缓冲区，只有所属线程写入，写入无锁、不分配内存，写满后覆盖最旧的记录
+ * - 缓冲区在线程首次写入记录时分配，线程退出后由下一次导出带出其记录并释放
+ * - 导出时逐槽位按序号校验（seqlock），正在被覆盖的槽位直接跳过，不阻塞写入线程
+ * - 跟踪ID在线程内随TraceSpan作用域传递：嵌套的span、出站消息等自动继承当前ID，
+ *   跨线程时由调用方随数据携带（Command::trace_id、OutboundMessage::trace_id）
+ * - 导出为Chrome trace JSON（chrome://tracing、Perfetto可直接打开，同一ID的span以flow箭头相连）
+ *   或紧凑二进制文件（可用trace_convert转换为JSON）
+ *
+ * span名必须是字符串字面量（只保存指针）。
+ */
+class Trace {
+public:
+    static const size_t kRingCapacity = 4096;  // 每线程保留的最近记录数
+
+    // 单条记录（导出快照中的形式）
+    struct Record {
+        uint64_t begin_ns;  // 单调时钟
+        uint64_t dur_ns;
+        uint64_t id;        // 跟踪ID，0表示不属于任何命令
+        uint32_t name;      // Snapshot::names下标
+    };
+
+    struct ThreadRecords {
+        uint32_t tid;
+        std::string name;
+        std::vector<Record> records;
+    };
+
+    struct Snapshot {
+        std::vector<std::string> names;
+        std::vector<ThreadRecords> threads;
+        uint64_t overwritten = 0;  // 因环形缓冲区写满而丢失的记录数
+    };
+
+    // 默认关闭；关闭时span只有一次原子读的开销
+    static void set_enabled(bool enabled);
+    static bool enabled() { return enabled_.load(std::memory_order_relaxed); }
+
+    // 为当前线程命名（导出时显示）
+    static void set_thread_name(const char* name);
+
+    // 分配新的跟踪ID（非0）
+    static uint64_t next_id();
+    // 当前线程所在span的跟踪ID，不在span中时为0
+    static uint64_t current_id();
+
+    static uint64_t now_ns();
+
+    // 写入一条完整记录（TraceSpan析构时调用）
+    static void record(const char* name, uint64_t id, uint64_t begin_ns, uint64_t end_ns);
+    // 瞬时事件
+    static void instant(const char* name, uint64_t id = 0);
+
+    // 导出所有线程当前缓冲区的内容，不清空
+    static Snapshot snapshot();
+
+    static bool write_chrome_json(const Snapshot& snapshot, const std::string& path);
+    static bool write_binary(const Snapshot& snapshot, const std::string& path);
+    static bool read_binary(const std::string& path, Snapshot& snapshot);
+
+private:
+    friend class TraceSpan;
+    static std::atomic<bool> enabled_;
+};
+
+/**
+ * @brief 作用域span：构造时记开始时间，析构时写入记录
+ *
+ * id为0时继承当前线程的跟踪ID；作用域内current_id()返回本span的ID。
+ * name为nullptr或跟踪关闭时不记录。
+ */
+class TraceSpan {
+public:
+    explicit TraceSpan(const char* name, uint64_t id = 0);
+    ~TraceSpan();
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+
+    uint64_t id() const { return id_; }
+
+private:
+    const char* name_;
+    uint64_t id_;
+    uint64_t parent_id_;
+    uint64_t begin_ns_;
+};
@@ -0,0 +1,233 @@
+#include "tools/trace/trace.hpp"
+#include "station/station_runtime.hpp"
+#include "station/command_pipeline.hpp"
+#include "station/outbound_queue.hpp"
+#include "device/device.hpp"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <map>
+#include <cstdio>
+#include <sys/stat.h>
+
+static double ns_per(std::chrono::steady_clock::time_point begin, size_t count) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - begin).count() / static_cast<double>(count);
+}
+
+static long file_size(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? static_cast<long>(st.st_size) : -1;
+}
+
+// 单线程span开销
+static void bench_overhead(size_t count) {
+    std::cout << "=== span开销 (" << count << " 次) ===\n";
+    Trace::set_enabled(false);
+    auto begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        TraceSpan span("bench.disabled", 1);
+    }
+    std::cout << "关闭:         " << std::fixed << std::setprecision(1) << ns_per(begin, count) << " ns/span\n";
+
+    Trace::set_enabled(true);
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        TraceSpan span("bench.enabled", 1);
+    }
+    std::cout << "开启:         " << ns_per(begin, count) << " ns/span\n";
+
+    begin = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++) {
+        TraceSpan outer("bench.outer", i + 1);
+        TraceSpan inner("bench.inner");
+    }
+    std::cout << "开启(嵌套2层): " << ns_per(begin, count) << " ns/次\n";
+}
+
+// 多线程写入的同时反复导出，校验读到的记录没有撕裂
+static void bench_concurrent_snapshot(size_t threads, int seconds) {
+    std::atomic<bool> stop(false);
+    std::vector<std::thread> writers;
+    std::atomic<unsigned long long> written(0);
+    for (size_t t = 0; t < threads; t++) {
+        writers.emplace_back([&, t]() {
+            char name[32];
+            snprintf(name, sizeof(name), "writer-%zu", t);
+            Trace::set_thread_name(name);
+            unsigned long long n = 0;
+            while (!stop.load(std::memory_order_relaxed)) {
+                // id与开始时间绑定，导出后可校验一致性
+                uint64_t begin = Trace::now_ns();
+                Trace::record("bench.concurrent", begin ^ 0x5a5a5a5a, begin, begin + 100);
+                n++;
+            }
+            written += n;
+        });
+    }
+    size_t snapshots = 0, records = 0, torn = 0;
+    double snapshot_us = 0;
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < end) {
+        auto begin = std::chrono::steady_clock::now();
+        Trace::Snapshot snapshot = Trace::snapshot();
+        snapshot_us += std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - begin).count();
+        snapshots++;
+        for (const auto& thread : snapshot.threads) {
+            for (const auto& record : thread.records) {
+                if (snapshot.names[record.name] != "bench.concurrent") {
+                    continue;
+                }
+                records++;
+                if (record.id != (record.begin_ns ^ 0x5a5a5a5a) || record.dur_ns != 100) {
+                    torn++;
+                }
+            }
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stop = true;
+    for (auto& writer : writers) {
+        writer.join();
+    }
+    std::cout << "\n=== 并发写入 + 导出 (" << threads << " 个写线程, " << seconds << "s) ===\n";
+    std::cout << "写入 " << written.load() << " 条, 导出 " << snapshots << " 次, 平均 "
+              << std::setprecision(0) << snapshot_us / snapshots << " us/次, 校验 " << records
+              << " 条, 撕裂 " << torn << " 条\n";
+}
+
+// 线程只命名不写入时不分配缓冲区；已退出线程的缓冲区在导出一次后释放
+static void bench_thread_lifecycle() {
+    auto count_thread = [](const Trace::Snapshot& snapshot, const char* name) {
+        size_t records = 0;
+        for (const auto& thread : snapshot.threads) {
+            if (thread.name == name) {
+                records += thread.records.size();
+            }
+        }
+        return records;
+    };
+    Trace::set_enabled(false);
+    std::thread([]() {
+        Trace::set_thread_name("lifecycle-idle");
+        TraceSpan span("bench.lifecycle");
+    }).join();
+    Trace::set_enabled(true);
+    std::thread([]() {
+        Trace::set_thread_name("lifecycle-exited");
+        TraceSpan span("bench.lifecycle");
+    }).join();
+    Trace::Snapshot first = Trace::snapshot();
+    Trace::Snapshot second = Trace::snapshot();
+    bool ok = count_thread(first, "lifecycle-idle") == 0 && count_thread(first, "lifecycle-exited") == 1 &&
+              count_thread(second, "lifecycle-exited") == 0;
+    std::cout << "\n=== 线程缓冲区生命周期 ===\n";
+    std::cout << "关闭时命名不分配、退出线程导出一次后释放: " << (ok ? "一致" : "失败") << "\n";
+}
+
+// 真实链路：MQTT回调 -> 流水线 -> 连接器 -> 出站队列 -> 发送
+static void bench_command_path(const PriceStore& prices, size_t commands) {
+    OutboundQueue outbound;
+    StationRuntime runtime(prices,
+        [&outbound](const std::string& topic, const nlohmann::json& content, uint8_t qos, bool retain) {
+            outbound.push(topic, content, qos, retain);
+        });
+    Connector& connector = runtime.add_connector(make_connector_id(0), std::unique_ptr<DeviceBase>(new Device()));
+    CommandPipeline pipeline(1);
+    pipeline.set_executor([&runtime](const Command& command) { runtime.dispatch(command); });
+    pipeline.start();
+
+    const std::string topic = connector.topic(TOPIC_CMD);
+    char payload[128];
+    std::vector<OutboundMessage> batch;
+    int64_t now_ms = 1717977600000LL;
+    for (size_t i = 0; i < commands; i++) {
+        int cmd = i % 2 == 0 ? DEVICE_CMD_REMOTE_START : DEVICE_CMD_STOP;
+        snprintf(payload, sizeof(payload), "{\"cmd\":%d,\"timestamp\":\"%zu\",\"device_id\":\"%s\"}",
+                 cmd, i, connector.id().c_str());
+        {
+            TraceSpan span("mqtt.receive", Trace::next_id());
+            pipeline.submit(topic, payload);
+        }
+        // 等待执行后推进两个上报周期，使启动命令产生首条充电信息
+        while (cmd == DEVICE_CMD_REMOTE_START && !connector.is_charging()) {
+            std::this_thread::yield();
+        }
+        if (cmd == DEVICE_CMD_REMOTE_START) {
+            for (int k = 0; k < 3; k++) {
+                now_ms += Connector::kReportIntervalMs;
+                connector.tick(now_ms);
+            }
+        } else {
+            while (connector.is_charging()) {
+                std::this_thread::yield();
+            }
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        if (outbound.drain(batch)) {
+            for (const auto& msg : batch) {
+                TraceSpan span(msg.trace_id ? "publish.flush" : nullptr, msg.trace_id);
+            }
+            outbound.release(batch);
+        }
+    }
+    pipeline.stop();
+
+    Trace::Snapshot snapshot = Trace::snapshot();
+    struct Stat {
+        size_t count = 0;
+        double total_us = 0;
+    };
+    std::map<std::string, Stat> stats;
+    for (const auto& thread : snapshot.threads) {
+        for (const auto& record : thread.records) {
+            const std::string& name = snapshot.names[record.name];
+            if (name.compare(0, 6, "bench.") == 0 || !record.id) {
+                continue;
+            }
+            Stat& stat = stats[name];
+            stat.count++;
+            stat.total_us += record.dur_ns / 1000.0;
+        }
+    }
+    std::cout << "\n=== 命令链路各阶段 (" << commands << " 条启动/停止命令, Device桩) ===\n";
+    for (const auto& entry : stats) {
+        std::cout << "  " << std::left << std::setw(24) << entry.first << std::right
+                  << std::setw(8) << entry.second.count
+                  << std::setw(10) << std::setprecision(1) << entry.second.total_us / entry.second.count << " us\n";
+    }
+
+    auto begin = std::chrono::steady_clock::now();
+    Trace::write_chrome_json(snapshot, "trace_bench.json");
+    double json_ms = ns_per(begin, 1) / 1e6;
+    begin = std::chrono::steady_clock::now();
+    Trace::write_binary(snapshot, "trace_bench.bin");
+    double bin_ms = ns_per(begin, 1) / 1e6;
+    size_t records = 0;
+    for (const auto& thread : snapshot.threads) {
+        records += thread.records.size();
+    }
+    Trace::Snapshot decoded;
+    bool roundtrip = Trace::read_binary("trace_bench.bin", decoded) && decoded.threads.size() == snapshot.threads.size();
+    std::cout << "导出 " << records << " 条记录: JSON " << file_size("trace_bench.json") / 1024 << " KB ("
+              << std::setprecision(1) << json_ms << " ms), 二进制 " << file_size("trace_bench.bin") / 1024 << " KB ("
+              << bin_ms << " ms), 二进制回读" << (roundtrip ? "一致" : "失败") << "\n";
+}
+
+int main(int argc, char* argv[]) {
+    std::string price_path = argc > 1 ? argv[1] : "../config/price.json";
+    PriceStore prices;
+    if (prices.load_file(price_path) != PriceStore::RELOAD_OK) {
+        return 1;
+    }
+    std::cout << std::setfill(' ');
+    Trace::set_thread_name("main");
+    bench_overhead(10000000);
+    bench_concurrent_snapshot(4, 2);
+    bench_thread_lifecycle();
+    bench_command_path(prices, 200);
+    return 0;
+}
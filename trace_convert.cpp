@@ -0,0 +1,25 @@
+#include "tools/trace/trace.hpp"
+#include <iostream>
+
+// 把charging_station导出的二进制跟踪（SIGUSR2）转换为Chrome trace JSON
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cerr << "用法: " << argv[0] << " <trace.bin> <trace.json>\n";
+        return 1;
+    }
+    Trace::Snapshot snapshot;
+    if (!Trace::read_binary(argv[1], snapshot)) {
+        std::cerr << "读取失败: " << argv[1] << "\n";
+        return 1;
+    }
+    if (!Trace::write_chrome_json(snapshot, argv[2])) {
+        std::cerr << "写入失败: " << argv[2] << "\n";
+        return 1;
+    }
+    size_t records = 0;
+    for (const auto& thread : snapshot.threads) {
+        records += thread.records.size();
+    }
+    std::cout << snapshot.threads.size() << " 个线程, " << records << " 条记录 -> " << argv[2] << "\n";
+    return 0;
+}